@@ -0,0 +1,62 @@
+// Check that a design written in the binary form with vvp -B runs the
+// same when it is loaded from the binary file. The test list runs this
+// once with -B, and once more from the binary file, and the output of
+// the two runs must match. The design uses a mix of functors, arrays,
+// threads, real values and strings, so most kinds of tokens are in
+// the binary file.
+module adder #(parameter W = 8) (input [W-1:0] a, b, output [W:0] s);
+
+  assign #1 s = a + b;
+
+endmodule // adder
+
+module test;
+
+  reg   [7:0] a, b;
+  wire  [8:0] s;
+  wire        n, x;
+  reg   [7:0] mem [0:15];
+  real        r;
+  string      str;
+  event       ev;
+  integer     i;
+
+  adder #(.W(8)) u1(a, b, s);
+
+  nand g1 (n, a[0], b[0]);
+  xor  g2 (x, s[8], n);
+
+  function [7:0] mix(input [7:0] v, input integer k);
+    mix = {v[3:0], v[7:4]} ^ k[7:0];
+  endfunction
+
+  task show(input [8*16:1] tag);
+    $display("%0t %m %0s: a=%h b=%h s=%h n=%b x=%b", $time, tag, a, b, s, n, x);
+  endtask
+
+  always @(ev) show("event");
+
+  initial begin
+    str = "tab\there \"quoted\" back\\slash";
+    r = 1.5e-3;
+    for (i = 0 ; i < 16 ; i = i + 1)
+      mem[i] = mix(i * 17, i);
+    a = 8'hzx;
+    b = 0;
+    #2 show("x and z");
+    for (i = 0 ; i < 8 ; i = i + 1) begin
+      a = mem[i];
+      b = mem[15-i];
+      r = r * -2.25 + i;
+      #2 show("step");
+      $display("r=%g %e", r, r);
+    end
+    fork
+      #3 -> ev;
+      #1 $display("%0t fork %s", $time, str);
+    join
+    $display("len=%0d %s", str.len(), str.toupper());
+    $finish(0);
+  end
+
+endmodule // test
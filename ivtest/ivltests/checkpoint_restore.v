@@ -0,0 +1,68 @@
+// Check that a run resumed with vvp -R from a $save checkpoint goes on
+// like the run that wrote it. The test list runs this once to write the
+// checkpoint and the output of the whole run, and once more from the
+// checkpoint, and the output of the two runs must match. Only output
+// after the checkpoint is printed, so both runs print the same, and the
+// second run has a +resumed argument, which only code before the
+// checkpoint checks, so that it fails if it runs from time 0. The
+// checkpoint has nonblocking assignments, a delayed net, waiting
+// threads, a real variable and an open file pending.
+module test;
+
+  reg         clk;
+  reg   [7:0] count, d;
+  reg  [15:0] lfsr;
+  real        acc;
+  wire  [7:0] q;
+  integer     fd, n, ft, fc;
+  reg  [15:0] fl;
+
+  assign #3 q = d;
+
+  initial begin
+    clk = 0;
+    forever #5 clk = ~clk;
+  end
+
+  always @(posedge clk) begin
+    count <= count + 1;
+    lfsr <= {lfsr[14:0], lfsr[15] ^ lfsr[13] ^ lfsr[12] ^ lfsr[10]};
+    acc = acc * 0.5 + count;
+    $fdisplay(fd, "%0t %0d %h", $time, count, lfsr);
+  end
+
+  always @(q)
+    if ($time > 21) $display("%0t q=%0d", $time, q);
+
+  initial begin
+    if ($test$plusargs("resumed"))
+      $display("FAILED - not resumed from the checkpoint");
+    count = 0;
+    lfsr = 16'hace1;
+    acc = 0.0;
+    d = 1;
+    fd = $fopen("work/checkpoint_restore.txt", "w");
+    #21 d = 2;
+    $save("work/checkpoint_restore.ckpt");
+    #1 $display("%0t saved q=%0d", $time, q);
+    repeat (8) begin
+      @(negedge clk) d = d + count;
+      $display("%0t count=%0d lfsr=%h acc=%g", $time, count, lfsr, acc);
+    end
+    fork
+      #7 $display("%0t fork a", $time);
+      #2 $display("%0t fork b", $time);
+    join
+    $fclose(fd);
+      // The file has the lines of both sides of the checkpoint.
+    fd = $fopen("work/checkpoint_restore.txt", "r");
+    n = $fscanf(fd, "%d %d %h", ft, fc, fl);
+    while (n == 3) begin
+      $display("file %0d %0d %h", ft, fc, fl);
+      n = $fscanf(fd, "%d %d %h", ft, fc, fl);
+    end
+    $fclose(fd);
+    $finish(0);
+  end
+
+endmodule
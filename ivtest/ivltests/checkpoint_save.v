@@ -0,0 +1,45 @@
+// Check that $save writes a checkpoint in the middle of a simulation
+// with pending delays, waiting threads and an open file, and that the
+// simulation carries on unchanged afterwards.
+module test;
+
+  reg        clk;
+  reg  [7:0] count, d;
+  wire [7:0] q;
+  integer    fd;
+  reg        failed;
+
+  assign #3 q = d;
+
+  initial begin
+    clk = 0;
+    forever #5 clk = ~clk;
+  end
+
+  always @(posedge clk) begin
+    count <= count + 1;
+    $fdisplay(fd, "%0t %0d", $time, count);
+  end
+
+  initial begin
+    failed = 0;
+    count = 0;
+    d = 1;
+    fd = $fopen("work/checkpoint_save.txt", "w");
+    #21 d = 2;
+    $save("work/checkpoint_save.ckpt");
+    #1;
+    if (q !== 1) failed = 1;
+    #3;
+    if (q !== 2) failed = 1;
+    #76;
+    if (count !== 10) failed = 1;
+    $fclose(fd);
+    if (failed)
+      $display("FAILED");
+    else
+      $display("PASSED");
+    $finish;
+  end
+
+endmodule
@@ -0,0 +1,53 @@
+// Check that the processes that wait on a clock edge, each on an
+// event of its own, all wake up on each edge and see the values
+// written by the processes that woke before them.
+module main;
+
+   reg clk;
+   integer count, order, fail;
+   integer seen [0:7];
+
+   always @(posedge clk) begin count = count + 1; seen[0] = order; order = order + 1; end
+   always @(posedge clk) begin count = count + 1; seen[1] = order; order = order + 1; end
+   always @(posedge clk) begin count = count + 1; seen[2] = order; order = order + 1; end
+   always @(posedge clk) begin count = count + 1; seen[3] = order; order = order + 1; end
+   always @(negedge clk) begin count = count + 1; seen[4] = order; order = order + 1; end
+   always @(posedge clk) begin count = count + 1; seen[5] = order; order = order + 1; end
+   always @(posedge clk) begin count = count + 1; seen[6] = order; order = order + 1; end
+   always @(posedge clk) begin count = count + 1; seen[7] = order; order = order + 1; end
+
+   integer idx, cycle, sum;
+
+   initial begin
+      fail = 0;
+      clk = 0;
+      #1;
+      for (cycle = 0 ; cycle < 4 ; cycle = cycle + 1) begin
+	 count = 0;
+	 order = 0;
+	 clk = 1;
+	 #1 if (count !== 7) begin
+	    $display("FAILED -- %0d processes woke on posedge %0d", count, cycle);
+	    fail = 1;
+	 end
+	   // Each process saw a different place in the order.
+	 sum = 0;
+	 for (idx = 0 ; idx < 8 ; idx = idx + 1)
+	   if (idx != 4) sum = sum + (1 << seen[idx]);
+	 if (sum !== 127) begin
+	    $display("FAILED -- the processes saw the orders %b", sum);
+	    fail = 1;
+	 end
+	 count = 0;
+	 clk = 0;
+	 #1 if (count !== 1 || seen[4] !== order - 1) begin
+	    $display("FAILED -- %0d processes woke on negedge %0d", count, cycle);
+	    fail = 1;
+	 end
+      end
+
+      if (fail == 0)
+	$display("PASSED");
+   end
+
+endmodule // main
@@ -0,0 +1,75 @@
+// Check that the values of nets with a large fan-out reach all of the
+// receivers when the fan-outs are flat arrays (vvp -f), also when the
+// nets are forced and continuously assigned at run time.
+module main;
+
+   reg clk, src;
+   reg [7:0] q;
+   reg       r;
+   wire [7:0] a;
+   integer    fail;
+
+   always @(posedge clk) q[0] <= src;
+   always @(posedge clk) q[1] <= ~src;
+   always @(posedge clk) q[2] <= src;
+   always @(posedge clk) q[3] <= ~src;
+   always @(posedge clk) q[4] <= src;
+   always @(posedge clk) q[5] <= ~src;
+   always @(posedge clk) q[6] <= src;
+   always @(posedge clk) q[7] <= ~src;
+
+   assign a[0] = src & 1'b1;
+   assign a[1] = src | 1'b0;
+   assign a[2] = src ^ 1'b1;
+   assign a[3] = ~src;
+   assign a[4] = src & 1'b1;
+   assign a[5] = src | 1'b0;
+   assign a[6] = src ^ 1'b1;
+   assign a[7] = ~src;
+
+   task check(input [7:0] qval, input [7:0] aval, input rval);
+      if (q !== qval || a !== aval || r !== rval) begin
+	 $display("FAILED -- q=%b a=%b r=%b, expected %b %b %b",
+		  q, a, r, qval, aval, rval);
+	 fail = 1;
+      end
+   endtask
+
+   initial begin
+      fail = 0;
+      clk = 0;
+      src = 1;
+      r = 0;
+      #1 clk = 1;
+      #1 check(8'b01010101, 8'b00110011, 1'b0);
+
+      src = 0;
+      clk = 0;
+      #1 clk = 1;
+      #1 check(8'b10101010, 8'b11001100, 1'b0);
+
+	// A forced source reaches the receivers, and so does the
+	// source again once it is released.
+      force src = 1;
+      #1 check(8'b10101010, 8'b00110011, 1'b0);
+      clk = 0;
+      #1 clk = 1;
+      #1 check(8'b01010101, 8'b00110011, 1'b0);
+      release src;
+      src = 0;
+      #1 check(8'b01010101, 8'b11001100, 1'b0);
+
+	// A continuous assign links one more receiver to the source,
+	// and unlinks it again on deassign.
+      assign r = src;
+      src = 1;
+      #1 check(8'b01010101, 8'b00110011, 1'b1);
+      deassign r;
+      src = 0;
+      #1 check(8'b01010101, 8'b11001100, 1'b1);
+
+      if (fail == 0)
+	$display("PASSED");
+   end
+
+endmodule // main
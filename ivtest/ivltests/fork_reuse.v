@@ -0,0 +1,77 @@
+// Create and reap many threads, so that thread objects are recycled,
+// and check that fork/join, join_none, wait fork, disable fork and
+// recursive automatic tasks still see the right state each time.
+module test;
+
+  integer count, idx, depth_sum;
+  reg     failed;
+
+  task automatic recurse(input integer depth, output integer sum);
+    integer sub;
+    begin
+      if (depth == 0) begin
+        sum = 0;
+      end else begin
+        recurse(depth-1, sub);
+        sum = sub + depth;
+      end
+    end
+  endtask
+
+  initial begin
+    failed = 0;
+    count = 0;
+
+    for (idx = 0 ; idx < 1000 ; idx = idx + 1) begin
+      fork
+        count = count + 1;
+        #1 count = count + 2;
+        begin : blk
+          #2 count = count + 4;
+        end
+      join
+    end
+    if (count !== 7000) begin
+      $display("FAILED: fork/join count = %0d", count);
+      failed = 1;
+    end
+
+    count = 0;
+    for (idx = 0 ; idx < 100 ; idx = idx + 1) begin
+      fork
+        #1 count = count + 1;
+        #2 count = count + 1;
+      join_none
+    end
+    wait fork;
+    if (count !== 200) begin
+      $display("FAILED: join_none count = %0d", count);
+      failed = 1;
+    end
+
+    count = 0;
+    for (idx = 0 ; idx < 100 ; idx = idx + 1) begin
+      fork
+        count = count + 1;
+        #5 count = count + 100;
+      join_any
+      disable fork;
+    end
+    #10;
+    if (count !== 100) begin
+      $display("FAILED: disable fork count = %0d", count);
+      failed = 1;
+    end
+
+    for (idx = 0 ; idx < 100 ; idx = idx + 1) begin
+      recurse(idx % 10, depth_sum);
+      if (depth_sum !== (idx % 10) * (idx % 10 + 1) / 2) begin
+        $display("FAILED: recurse(%0d) = %0d", idx % 10, depth_sum);
+        failed = 1;
+      end
+    end
+
+    if (!failed) $display("PASSED");
+  end
+
+endmodule
@@ -0,0 +1,17 @@
+// Check the extended arguments that set up the FST writer. The test
+// lists run this with good and bad values for them, and the gold files
+// hold the messages about the settings.
+
+module main;
+
+  reg [31:0] count;
+  integer i;
+
+  initial begin
+    $dumpvars(0, main);
+    for (i = 0 ; i < 2000 ; i = i + 1)
+      #1 count = i * 7;
+    $finish(0);
+  end
+
+endmodule // main
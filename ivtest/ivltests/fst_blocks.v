@@ -0,0 +1,79 @@
+// Check that the FST writer settings take effect. The design reads
+// back the dump file while it is still being written, and prints the
+// pack type of the first value change block. The -fst-blocksize
+// argument makes the writer end blocks during the simulation, and
+// -fst-compress sets the pack type. Without -fst-blocksize, no value
+// change block is written until the end of the simulation. The dump
+// file name is passed in with +fst=<file>.
+
+module main;
+
+  reg [31:0] count;
+  reg [8*64-1:0] name;
+  integer fd, i, typ, len, clen, pack;
+
+  // Read a 64 bit big endian number that fits in an integer.
+  task get_u64(output integer val);
+    integer idx;
+    begin
+      val = 0;
+      for (idx = 0 ; idx < 8 ; idx = idx + 1)
+        val = (val << 8) | $fgetc(fd);
+    end
+  endtask
+
+  // Read a variable length number, 7 bits per byte, low bits first.
+  task get_varint(output integer val);
+    integer ch, shift;
+    begin
+      val = 0;
+      shift = 0;
+      ch = 8'h80;
+      while (ch & 8'h80) begin
+        ch = $fgetc(fd);
+        val = val | ((ch & 8'h7f) << shift);
+        shift = shift + 7;
+      end
+    end
+  endtask
+
+  initial begin
+    if (!$value$plusargs("fst=%s", name)) begin
+      $display("FAILED: no +fst=<file> argument");
+      $finish(0);
+    end
+
+    $dumpvars(0, main);
+    for (i = 0 ; i < 2000 ; i = i + 1)
+      #1 count = i * 7;
+
+    fd = $fopen(name, "rb");
+    // Skip the header block to the first value change block. The
+    // writer tags a block that it has not finished with 255.
+    typ = $fgetc(fd);
+    get_u64(len);
+    $fseek(fd, 1 + len, 0);
+    typ = $fgetc(fd);
+    if (typ == 255 || typ == -1) begin
+      $display("No value change block written yet.");
+    end else begin
+      // The block length, the start and end times and the memory
+      // needed to read it back.
+      for (i = 0 ; i < 4 ; i = i + 1)
+        get_u64(len);
+      // The initial values, which are always compressed with zlib.
+      get_varint(len);
+      get_varint(clen);
+      get_varint(len);
+      $fseek(fd, clen, 1);
+      // The value changes, with their pack type.
+      get_varint(len);
+      pack = $fgetc(fd);
+      $display("First value change block (type %0d) has pack type %s.",
+               typ, pack[7:0]);
+    end
+    $fclose(fd);
+    $finish(0);
+  end
+
+endmodule // main
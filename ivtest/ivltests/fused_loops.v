@@ -0,0 +1,92 @@
+// Check the loop and condition idioms that vvp replaces with fused
+// instructions: compare a variable with a constant and branch, and
+// add a constant to a variable in place.
+
+module test;
+
+  integer i;
+  integer count;
+  reg [7:0] u;
+  reg signed [7:0] s;
+  reg [3:0] x;
+  reg [39:0] wide;
+  reg failed;
+
+  function automatic integer sum_to(input integer n);
+    integer k;
+    begin
+      sum_to = 0;
+      for (k = 1 ; k <= n ; k = k + 1)
+        sum_to = sum_to + k;
+    end
+  endfunction
+
+  initial begin
+    failed = 0;
+
+    count = 0;
+    for (i = 0 ; i < 100 ; i = i + 1)
+      count = count + 1;
+    if (count !== 100 || i !== 100) begin
+      $display("FAILED: signed loop count=%0d i=%0d", count, i);
+      failed = 1;
+    end
+
+    count = 0;
+    for (u = 8'd250 ; u != 8'd4 ; u = u + 8'd1)
+      count = count + 1;
+    if (count !== 10) begin
+      $display("FAILED: unsigned wrap count=%0d", count);
+      failed = 1;
+    end
+
+    count = 0;
+    for (s = -8'sd5 ; s < 8'sd5 ; s = s + 8'sd1)
+      count = count + 1;
+    if (count !== 10) begin
+      $display("FAILED: signed byte count=%0d", count);
+      failed = 1;
+    end
+
+    count = 0;
+    for (u = 0 ; u < 8'd200 ; u = u + 8'd3)
+      count = count + 1;
+    if (count !== 67) begin
+      $display("FAILED: unsigned compare count=%0d", count);
+      failed = 1;
+    end
+
+    x = 4'b1x01;
+    if (x == 4'b1101) begin
+      $display("FAILED: x == 4'b1101 was true");
+      failed = 1;
+    end
+    if (x === 4'b1x01) ; else begin
+      $display("FAILED: x === 4'b1x01 was false");
+      failed = 1;
+    end
+    x = x + 4'd1;
+    if (x !== 4'bxxxx) begin
+      $display("FAILED: x + 1 = %b", x);
+      failed = 1;
+    end
+
+    count = 0;
+    for (wide = 40'hff_ffff_fff0 ; wide != 40'h0 ; wide = wide + 40'd1)
+      count = count + 1;
+    if (count !== 16) begin
+      $display("FAILED: wide loop count=%0d", count);
+      failed = 1;
+    end
+
+    if (sum_to(10) !== 55 || sum_to(100) !== 5050) begin
+      $display("FAILED: sum_to(10)=%0d sum_to(100)=%0d",
+               sum_to(10), sum_to(100));
+      failed = 1;
+    end
+
+    if (!failed)
+      $display("PASSED");
+  end
+
+endmodule
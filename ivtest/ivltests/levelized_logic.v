@@ -0,0 +1,70 @@
+// Check gate level logic run with levelized evaluation (vvp -L),
+// including a combinational loop that must keep its own events.
+module test;
+
+  reg  [15:0] a, b;
+  reg         cin;
+  wire [15:0] sum;
+  wire [16:0] carry;
+  reg         set, reset;
+  wire        q, qn;
+  reg         failed;
+  integer     idx;
+
+  assign carry[0] = cin;
+
+  genvar i;
+  generate
+    for (i = 0 ; i < 16 ; i = i + 1) begin : bit
+      wire p, g, t;
+      xor (p, a[i], b[i]);
+      and (g, a[i], b[i]);
+      xor (sum[i], p, carry[i]);
+      and (t, p, carry[i]);
+      or  (carry[i+1], g, t);
+    end
+  endgenerate
+
+  nor (q, reset, qn);
+  nor (qn, set, q);
+
+  initial begin
+    failed = 0;
+
+    for (idx = 0 ; idx < 1000 ; idx = idx + 1) begin
+      a = $random;
+      b = $random;
+      cin = idx[0];
+      #1;
+      if ({carry[16], sum} !== a + b + cin) begin
+        $display("FAILED: %h + %h + %b gave %h", a, b, cin, {carry[16], sum});
+        failed = 1;
+      end
+    end
+
+    a = 16'h00x0;
+    b = 16'h0000;
+    cin = 0;
+    #1;
+    if (sum !== 16'h00x0) begin
+      $display("FAILED: x input gave %b", sum);
+      failed = 1;
+    end
+
+    set = 1; reset = 0;
+    #1 set = 0;
+    #1 if ({q, qn} !== 2'b10) begin
+      $display("FAILED: latch set gave %b", {q, qn});
+      failed = 1;
+    end
+    reset = 1;
+    #1 reset = 0;
+    #1 if ({q, qn} !== 2'b01) begin
+      $display("FAILED: latch reset gave %b", {q, qn});
+      failed = 1;
+    end
+
+    if (!failed) $display("PASSED");
+  end
+
+endmodule
@@ -0,0 +1,49 @@
+// Check levelized logic evaluated on several threads (vvp -j). The
+// gate levels are wide enough to be split between the threads, and
+// a wide vector gate in the same level is evaluated on the main
+// thread.
+module test;
+
+  localparam N = 512;
+
+  reg  [N-1:0] a, b, c;
+  wire [N-1:0] y;
+  wire [127:0] w;
+  reg          failed;
+  integer      idx, jdx;
+
+  genvar i;
+  generate
+    for (i = 0 ; i < N ; i = i + 1) begin : bit
+      wire x;
+      xor (x, a[i], b[i]);
+      and (y[i], x, c[i]);
+    end
+  endgenerate
+
+  assign w = ~(a[127:0] ^ c[127:0]);
+
+  initial begin
+    failed = 0;
+
+    for (idx = 0 ; idx < 200 ; idx = idx + 1) begin
+      for (jdx = 0 ; jdx < N ; jdx = jdx + 32) begin
+        a[jdx +: 32] = $random;
+        b[jdx +: 32] = $random;
+        c[jdx +: 32] = $random;
+      end
+      #1;
+      if (y !== ((a ^ b) & c)) begin
+        $display("FAILED: y=%h", y);
+        failed = 1;
+      end
+      if (w !== ~(a[127:0] ^ c[127:0])) begin
+        $display("FAILED: w=%h", w);
+        failed = 1;
+      end
+    end
+
+    if (!failed) $display("PASSED");
+  end
+
+endmodule
@@ -0,0 +1,35 @@
+// Check that levelized logic evaluated on several threads (vvp -j)
+// gives the same output as the serial run. The levelized_parallel2
+// and levelized_parallel2_j4 tests run this with and without -j and
+// compare both runs against the same gold file.
+module test;
+
+  localparam N = 1024;
+
+  reg  [N-1:0] a, b, c;
+  wire [N-1:0] y, z;
+  integer      idx;
+
+  genvar i;
+  generate
+    for (i = 0 ; i < N ; i = i + 1) begin : bit
+      wire x;
+      xor (x, a[i], b[i]);
+      and (y[i], x, c[i]);
+      nor (z[i], y[i], y[(i+1)%N]);
+    end
+  endgenerate
+
+  initial begin
+    a = {32{32'd305419896}};
+    b = {32{32'd2596069104}};
+    c = {32{32'd4042322160}};
+    for (idx = 0 ; idx < 16 ; idx = idx + 1) begin
+      a = a * 32'd1103515245 + 32'd12345;
+      b = b * 32'd1664525 + 32'd1013904223;
+      c = c * 32'd22695477 + 32'd1;
+      #1 $display("%0t %h %h", $time, y, z);
+    end
+  end
+
+endmodule
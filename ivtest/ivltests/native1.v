@@ -0,0 +1,43 @@
+// Check that a design runs the same with native thread code. The test
+// list writes the native code of this design with vvp -A, compiles it
+// with the C++ compiler, and runs the design again with vvp -a. The
+// first two loops are lowered to plain integer code. The x bits in xv,
+// the 100 bit vector and the delay in the last loop take the paths
+// through the native code that are not lowered.
+module main;
+
+  integer      i, acc, sacc, n;
+  reg [3:0]    xv;
+  reg [99:0]   wide;
+
+  initial begin
+    acc = 0;
+    for (i = 0 ; i < 1000 ; i = i + 1)
+      acc = acc + i * 3 - (i ^ 5);
+
+    sacc = 0;
+    for (i = 10 ; i > -10 ; i = i - 1)
+      sacc = sacc + i;
+
+    xv = 4'b1x01;
+    n = 0;
+    for (i = 0 ; i < 3 ; i = i + 1)
+      if (xv == 4'b1001)
+        n = n + 1;
+      else
+        n = n + 10;
+
+    wide = 1;
+    for (i = 0 ; i < 70 ; i = i + 1)
+      wide = wide + wide;
+
+    for (i = 0 ; i < 5 ; i = i + 1)
+      #1 n = n + i;
+
+    if (acc !== 999000 || sacc !== 10 || n !== 40 || wide !== (100'd1 << 70))
+      $display("FAILED: acc=%0d sacc=%0d n=%0d wide=%h", acc, sacc, n, wide);
+    else
+      $display("PASSED");
+  end
+
+endmodule // main
@@ -0,0 +1,47 @@
+// Check that non-blocking assignments of the bits of a vector, which
+// vvp merges into one update, still give the right value, and that
+// repeated non-blocking assignments to a variable in the same time
+// step are still done in order, so that a pulse is seen.
+module test;
+
+  reg  [15:0] q;
+  reg   [3:0] d;
+  reg         p;
+  reg         failed;
+  integer     changes, pulses, i;
+
+  always @(q) changes = changes + 1;
+  always @(posedge p) pulses = pulses + 1;
+
+  initial begin
+    failed = 0;
+    changes = 0;
+    pulses = 0;
+    q = 16'h0000;
+    p = 0;
+    #1 changes = 0;
+
+    for (i = 0 ; i < 16 ; i = i + 1)
+      q[i] <= i[0];
+    #1 if (q !== 16'haaaa) failed = 1;
+    if (changes !== 1) failed = 1;
+
+    for (i = 15 ; i >= 0 ; i = i - 4)
+      q[i -: 4] <= i[7:4] + i[3:0];
+    d = 4'b1x0z;
+    q[5] <= 1'b0;
+    q[7:4] <= d;
+    #1 if (q !== 16'b1111_1011_1x0z_0011) failed = 1;
+
+    p <= 1;
+    p <= 0;
+    #1 if (p !== 0) failed = 1;
+    if (pulses !== 1) failed = 1;
+
+    if (failed)
+      $display("FAILED");
+    else
+      $display("PASSED");
+  end
+
+endmodule
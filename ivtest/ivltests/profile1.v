@@ -0,0 +1,45 @@
+// Check that a simulation runs the same with the profiler on (vvp -P),
+// with processes that call functions and tasks, fork and are woken by
+// events, and with logic that propagates values.
+module test;
+
+  reg         clk;
+  reg   [7:0] count;
+  wire  [7:0] inv;
+  reg  [15:0] sum;
+  integer     i;
+
+  assign inv = ~count;
+
+  function [15:0] add(input [15:0] a, input [7:0] b);
+    add = a + b;
+  endfunction
+
+  task tick;
+    begin
+      #1 clk = 1;
+      #1 clk = 0;
+    end
+  endtask
+
+  always @(posedge clk) begin
+    count <= count + 1;
+    sum <= add(sum, inv);
+  end
+
+  initial begin
+    clk = 0;
+    count = 0;
+    sum = 0;
+    for (i = 0 ; i < 10 ; i = i + 1)
+      fork
+        tick;
+      join
+    #1;
+    if (count === 10 && sum === 16'd2505)
+      $display("PASSED");
+    else
+      $display("FAILED: count=%d, sum=%d", count, sum);
+  end
+
+endmodule
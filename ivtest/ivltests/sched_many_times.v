@@ -0,0 +1,57 @@
+// Check that events scheduled for many distinct future times, including
+// times that need more than 32 bits, are executed in time order.
+
+module test;
+
+  localparam N = 2000;
+
+  reg [63:0] fire;
+  reg [63:0] delay;
+  reg [63:0] last;
+  reg [63:0] latest;
+  integer seed;
+  integer idx;
+  integer count;
+  reg failed;
+
+  initial begin
+    failed = 0;
+    count = 0;
+    last = 0;
+    latest = 0;
+    seed = 1;
+    for (idx = 0 ; idx < N ; idx = idx + 1) begin
+      delay = {$random(seed)} % 100000;
+      if (idx % 4 == 1) delay = delay + ((64'd1 + idx % 7) << 40);
+      if (idx % 4 == 2) delay = delay << 16;
+      if (delay > latest) latest = delay;
+      fire <= #(delay) delay;
+    end
+  end
+
+  always @(fire) begin
+    count = count + 1;
+    if ($time != fire) begin
+      $display("FAILED: event for %0d ran at %0t", fire, $time);
+      failed = 1;
+    end
+    if ($time < last) begin
+      $display("FAILED: time went from %0d back to %0t", last, $time);
+      failed = 1;
+    end
+    last = $time;
+  end
+
+  final begin
+    if (last != latest) begin
+      $display("FAILED: last event at %0d, expected %0d", last, latest);
+      failed = 1;
+    end
+    if (count < N/2) begin
+      $display("FAILED: only %0d events", count);
+      failed = 1;
+    end
+    if (!failed) $display("PASSED");
+  end
+
+endmodule
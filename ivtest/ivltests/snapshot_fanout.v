@@ -0,0 +1,31 @@
+// Check that vvp -F fans the simulation out at $ivl_snapshot. The test
+// list runs this with the runs in snapshot_fanout.runs and a -l log
+// file. Each run prints its number, its arguments and a value computed
+// before the snapshot, and starts its own waveform dump. The output of
+// each run, and its log file, is compared with a gold file.
+module test;
+
+  reg    [31:0] x;
+  integer       i, child, seed;
+  reg  [8*40:1] name;
+
+  initial begin
+    x = 1;
+    for (i = 0 ; i < 10 ; i = i + 1)
+      #1 x = x * 3 + 1;
+    $display("%0t before x=%0d", $time, x);
+    $ivl_snapshot;
+    #1;
+    if (!$value$plusargs("ivl_snapshot_child=%d", child)) child = 0;
+    if (!$value$plusargs("seed=%d", seed)) seed = 0;
+    $sformat(name, "work/snapshot_fanout%0d.vcd", child);
+    $dumpfile(name);
+    $dumpvars(0, test);
+    $display("%0t run %0d seed=%0d x=%0d", $time, child, seed, x + seed);
+    if ($test$plusargs("extra"))
+      $display("%0t run %0d has +extra", $time, child);
+    #5 x = x + 1;
+    $finish(0);
+  end
+
+endmodule
@@ -0,0 +1,22 @@
+// Check that vvp -F refuses to fan out at $ivl_snapshot when the runs
+// would share a waveform dump (+dump) or a file opened with $fopen
+// (+file), and that the simulation carries on as a single run.
+module test;
+
+  integer fd;
+
+  initial begin
+    if ($test$plusargs("dump"))
+      $dumpvars(0, test);
+    if ($test$plusargs("file"))
+      fd = $fopen("work/snapshot_refuse.txt", "w");
+    #1 $ivl_snapshot;
+    #1;
+    if ($test$plusargs("ivl_snapshot_child"))
+      $display("FAILED - the simulation was fanned out");
+    else
+      $display("PASSED");
+    $finish(0);
+  end
+
+endmodule
@@ -0,0 +1,40 @@
+// Check that arrays of narrow words, which are packed into small
+// integers, keep X and Z bits in 4-state arrays, drop them in 2-state
+// arrays, and handle part selects of their words.
+module test;
+
+  reg   [4:0] m4 [0:99];
+  bit   [5:1] m2 [0:99];
+  bit  [40:0] m3 [0:99];
+  reg  [31:0] m5 [0:99];
+  reg         failed;
+
+  initial begin
+    failed = 0;
+
+    if (m4[0] !== 5'bx) failed = 1;
+    if (m2[0] !== 5'b0) failed = 1;
+    if (m3[0] !== 41'b0) failed = 1;
+    if (m5[0] !== 32'bx) failed = 1;
+
+    m4[3] = 5'b1z0x1;
+    m2[3] = 5'b1z0x1;
+    m3[3] = {9'h1ff, 32'hxxxx_0123};
+    m5[3] = 32'hzzzz_4567;
+    if (m4[3] !== 5'b1z0x1) failed = 1;
+    if (m2[3] !== 5'b10001) failed = 1;
+    if (m3[3] !== {9'h1ff, 32'h0000_0123}) failed = 1;
+    if (m5[3] !== 32'hzzzz_4567) failed = 1;
+
+    m4[3][2:1] = 2'b11;
+    m2[3][3:2] = 2'b11;
+    if (m4[3] !== 5'b1z111) failed = 1;
+    if (m2[3] !== 5'b10111) failed = 1;
+
+    if (failed)
+      $display("FAILED");
+    else
+      $display("PASSED");
+  end
+
+endmodule
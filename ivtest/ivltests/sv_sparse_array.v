@@ -0,0 +1,44 @@
+// Check that very large memories, which get sparse storage, read as X
+// (or 0 for 2-state) where they were not written and keep the words
+// that were, including those at the far ends of the address range.
+module test;
+
+  reg  [63:0] mem  [0:2**28-1];
+  bit  [63:0] mem2 [0:2**28-1];
+  reg  [19:0] wide [0:2**22-1];
+  integer     idx;
+  reg         failed;
+
+  initial begin
+    failed = 0;
+
+    mem[0] = 64'h0123_4567_89ab_cdef;
+    mem[2**28-1] = 64'hdead_beef;
+    for (idx = 0 ; idx < 1000 ; idx = idx + 1)
+      mem[idx*262139 + 7] = idx;
+
+    if (mem[0] !== 64'h0123_4567_89ab_cdef) failed = 1;
+    if (mem[1] !== 64'bx) failed = 1;
+    if (mem[2**28-1] !== 64'hdead_beef) failed = 1;
+    if (mem[2**27] !== 64'bx) failed = 1;
+    for (idx = 0 ; idx < 1000 ; idx = idx + 1) begin
+      if (mem[idx*262139 + 7] !== idx) failed = 1;
+      if (mem[idx*262139 + 8] !== 64'bx) failed = 1;
+    end
+
+    mem2[12345678] = 64'h55;
+    if (mem2[12345678] !== 64'h55) failed = 1;
+    if (mem2[12345679] !== 64'h0) failed = 1;
+    if (mem2[2**28-1] !== 64'h0) failed = 1;
+
+    wide[2**22-1] = 20'h1x2z3;
+    if (wide[2**22-1] !== 20'h1x2z3) failed = 1;
+    if (wide[2**21] !== 20'bx) failed = 1;
+
+    if (failed)
+      $display("FAILED");
+    else
+      $display("PASSED");
+  end
+
+endmodule
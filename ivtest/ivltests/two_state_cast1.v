@@ -0,0 +1,75 @@
+// Check that a 2-state value that carries X bits, here an array word
+// read with an X index, still loses them when it is stored into an
+// automatic variable or a function return value. Static 2-state
+// variables drop the X bits themselves.
+module main;
+
+  bit [7:0] arr [0:3];
+  bit [7:0] s;
+  integer   idx;
+  reg       failed;
+
+  function bit [7:0] ret_add(input integer i);
+    begin
+      ret_add = 1;
+      ret_add += arr[i];
+    end
+  endfunction
+
+  function automatic bit [7:0] auto_add(input integer i);
+    bit [7:0] acc;
+    begin
+      acc = 1;
+      acc += arr[i];
+      if ($isunknown(acc)) begin
+        $display("FAILED: automatic function variable acc=%b", acc);
+        failed = 1;
+      end
+      auto_add = acc;
+    end
+  endfunction
+
+  task automatic auto_sub(input integer i);
+    bit [7:0] v;
+    begin
+      v = 5;
+      v -= arr[i];
+      if ($isunknown(v)) begin
+        $display("FAILED: automatic task variable v=%b", v);
+        failed = 1;
+      end
+    end
+  endtask
+
+  reg [7:0] r;
+
+  initial begin
+    failed = 0;
+    idx = 'bx;
+
+    s = 3;
+    s += arr[idx];
+    if ($isunknown(s)) begin
+      $display("FAILED: static variable s=%b", s);
+      failed = 1;
+    end
+
+    r = ret_add(idx);
+    if ($isunknown(r)) begin
+      $display("FAILED: static function return value %b", r);
+      failed = 1;
+    end
+
+    r = auto_add(idx);
+    if ($isunknown(r)) begin
+      $display("FAILED: automatic function return value %b", r);
+      failed = 1;
+    end
+
+    auto_sub(idx);
+
+    if (!failed)
+      $display("PASSED");
+  end
+
+endmodule // main
@@ -0,0 +1,36 @@
+// Check that with vvp -2 the vector variables and arrays start at 0
+// and drop the X and Z bits that are written to them.
+module main;
+
+  reg [7:0]  r;
+  reg [99:0] w;
+  reg [7:0]  mem [0:3];
+  integer    k;
+
+  initial begin
+    #1;
+    if (r !== 8'd0 || w !== 100'd0 || mem[2] !== 8'd0 || k !== 0) begin
+      $display("FAILED: initial r=%b w=%h mem[2]=%b k=%b", r, w, mem[2], k);
+      $finish;
+    end
+
+    r = 8'b1x0z1100;
+    w = {4'bx1z1, 96'd5};
+    mem[1] = 8'bxxxx0101;
+    k = 'bx;
+    if (r !== 8'b10001100 || w !== {4'b0101, 96'd5} || mem[1] !== 8'b00000101
+        || k !== 0) begin
+      $display("FAILED: r=%b w=%h mem[1]=%b k=%b", r, w, mem[1], k);
+      $finish;
+    end
+
+    r[3:0] = 4'bzz11;
+    if (r !== 8'b10000011) begin
+      $display("FAILED: part r=%b", r);
+      $finish;
+    end
+
+    $display("PASSED");
+  end
+
+endmodule
@@ -0,0 +1,114 @@
+// Check the word-level bitwise operators and the two-state compare
+// shortcuts against bit-by-bit reference results, for vectors that
+// fit in a word and vectors that do not.
+module test;
+
+  reg [7:0]   a8, b8;
+  reg [99:0]  a100, b100;
+  reg signed [7:0]  s8, t8;
+  reg signed [63:0] s64, t64;
+  reg [63:0]  u64, v64;
+  reg [0:0]   u1, v1;
+  reg signed [0:0] s1, t1;
+  integer     idx;
+  reg         failed;
+
+  task check8(input [7:0] got, input [7:0] exp, input [8*8-1:0] op);
+    if (got !== exp) begin
+      $display("FAILED: %0s %b,%b got %b, expected %b", op, a8, b8, got, exp);
+      failed = 1;
+    end
+  endtask
+
+  task check100(input [99:0] got, input [99:0] exp, input [8*8-1:0] op);
+    if (got !== exp) begin
+      $display("FAILED: %0s 100 bit got %b, expected %b", op, got, exp);
+      failed = 1;
+    end
+  endtask
+
+  function [1:0] bxor(input x, input y);
+    bxor = (x === 1'bx || x === 1'bz || y === 1'bx || y === 1'bz) ? 2'b1x : {1'b0, x != y};
+  endfunction
+
+  reg [7:0]  exp8;
+  reg [99:0] exp100;
+  reg [1:0]  tmp;
+
+  initial begin
+    failed = 0;
+
+    a8 = 8'b01xz_01xz;
+    b8 = 8'b0000_1111;
+    for (idx = 0 ; idx < 8 ; idx = idx + 1) begin
+      tmp = bxor(a8[idx], b8[idx]);
+      exp8[idx] = tmp[1] ? 1'bx : tmp[0];
+    end
+    check8(a8 ^ b8, exp8, "xor");
+    check8(a8 ~^ b8, ~exp8, "xnor");
+    check8(a8 ~& b8, 8'b1111_10xx, "nand");
+    check8(a8 ~| b8, 8'b10xx_0000, "nor");
+
+    a8 = 8'b1010_1100;
+    b8 = 8'b0110_0101;
+    check8(a8 ^ b8, 8'b1100_1001, "xor");
+    check8(a8 ~^ b8, 8'b0011_0110, "xnor");
+    check8(a8 ~& b8, 8'b1101_1011, "nand");
+    check8(a8 ~| b8, 8'b0001_0010, "nor");
+
+    a100 = {25{4'b01xz}};
+    b100 = {50{2'b01}};
+    for (idx = 0 ; idx < 100 ; idx = idx + 1) begin
+      tmp = bxor(a100[idx], b100[idx]);
+      exp100[idx] = tmp[1] ? 1'bx : tmp[0];
+    end
+    check100(a100 ^ b100, exp100, "xor");
+    check100(a100 ~^ b100, ~exp100, "xnor");
+
+    a100 = {100{1'b1}} / 3;
+    b100 = {100{1'b1}} / 5;
+    for (idx = 0 ; idx < 100 ; idx = idx + 1)
+      exp100[idx] = a100[idx] != b100[idx];
+    check100(a100 ^ b100, exp100, "xor");
+    check100(a100 ~^ b100, ~exp100, "xnor");
+
+    // Signed and unsigned compares that take the two-state path.
+    s8 = -8'sd3; t8 = 8'sd2;
+    if (!(s8 < t8) || (s8 >= t8) || (t8 <= s8) || !(t8 > s8)) begin
+      $display("FAILED: signed 8 bit compare"); failed = 1;
+    end
+    s8 = -8'sd3; t8 = -8'sd100;
+    if ((s8 < t8) || !(s8 > t8) || (s8 == t8)) begin
+      $display("FAILED: signed 8 bit negative compare"); failed = 1;
+    end
+    s64 = -64'sd1; t64 = 64'sh7fffffffffffffff;
+    if (!(s64 < t64) || (s64 > t64)) begin
+      $display("FAILED: signed 64 bit compare"); failed = 1;
+    end
+    u64 = -64'd1; v64 = 64'h7fffffffffffffff;
+    if ((u64 < v64) || !(u64 > v64) || (u64 == v64)) begin
+      $display("FAILED: unsigned 64 bit compare"); failed = 1;
+    end
+    s1 = 1'b1; t1 = 1'b0;
+    if (!(s1 < t1)) begin
+      $display("FAILED: signed 1 bit compare"); failed = 1;
+    end
+    u1 = 1'b1; v1 = 1'b0;
+    if (!(u1 > v1)) begin
+      $display("FAILED: unsigned 1 bit compare"); failed = 1;
+    end
+    u64 = 64'd5; v64 = 64'd5;
+    if (!(u64 <= v64) || !(u64 >= v64) || (u64 < v64) || (u64 != v64)) begin
+      $display("FAILED: unsigned 64 bit equal compare"); failed = 1;
+    end
+
+    // X still poisons the relational result.
+    s8 = 8'sbx000_0001; t8 = 8'sd2;
+    if ((s8 < t8) !== 1'bx) begin
+      $display("FAILED: signed compare with X"); failed = 1;
+    end
+
+    if (!failed) $display("PASSED");
+  end
+
+endmodule
@@ -0,0 +1,68 @@
+// Check the VCD writer thread. The test list runs this twice, writing
+// a plain and a gzip compressed dump, and both must match the gold
+// file, which was written by the VCD dumper before it had a thread.
+// The design calls $dumpflush, $dumpoff, $dumpon and $dumpall, and has
+// one signal of each kind in a scope so that the order of the $var
+// records is fixed.
+
+module sub3;
+
+  parameter W = 4;
+
+  reg [W-1:0] xz;
+  wire b0 = main.cnt[0];
+
+endmodule // sub3
+
+module sub2;
+
+  reg [63:0] wide;
+
+  sub3 u3();
+
+endmodule // sub2
+
+module sub1;
+
+  wire [8:0] sum = main.cnt + 9'd1;
+
+  sub2 u2();
+
+endmodule // sub1
+
+module main;
+
+  reg [7:0] cnt;
+  real r;
+  event ev;
+
+  sub1 u1();
+
+  initial begin
+    $dumpvars(0, main);
+    cnt = 8'd0;
+    r = 0.0;
+    u1.u2.wide = {16'hzzzz, 16'h0000, 16'hxxxx, 16'h0001};
+    u1.u2.u3.xz = 4'bxz10;
+    repeat (400) begin
+      #5;
+      cnt = cnt + 8'd3;
+      r = r + 0.25;
+      if (cnt[0]) begin
+        -> ev;
+        u1.u2.u3.xz = {u1.u2.u3.xz[2:0], u1.u2.u3.xz[3]};
+      end
+      if ($time == 300)
+        u1.u2.wide = 64'h8000_0000_0000_0001;
+      else if ($time > 300)
+        u1.u2.wide = {u1.u2.wide[62:0],
+                      u1.u2.wide[63] ^ u1.u2.wide[60] ^ cnt[1]};
+      if ($time % 250 == 0) $dumpflush;
+      if ($time == 500) $dumpoff;
+      if ($time == 750) $dumpon;
+      if ($time == 1500) $dumpall;
+    end
+    $finish(0);
+  end
+
+endmodule // main
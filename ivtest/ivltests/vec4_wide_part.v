@@ -0,0 +1,73 @@
+// Check part selects from and part assignments to wide vectors, at
+// aligned and unaligned offsets, with widths on both sides of the
+// widths where vvp hands the words of a part over to its word kernels.
+
+module part_check #(parameter W = 1);
+
+  reg [W-1:0] got, exp, val;
+  reg [639:0] dst, dexp;
+  integer off, idx;
+  reg failed;
+
+  task check(input [639:0] src);
+    begin
+      failed = 0;
+      for (off = 0 ; off + W <= 640 ; off = off + 7) begin
+        got = src[off +: W];
+        for (idx = 0 ; idx < W ; idx = idx + 1)
+          exp[idx] = src[off+idx];
+        if (got !== exp) begin
+          $display("FAILED: width %0d select at %0d", W, off);
+          failed = 1;
+        end
+
+        val = src[639 -: W];
+        dst = {src[319:0], src[639:320]};
+        dexp = dst;
+        dst[off +: W] = val;
+        for (idx = 0 ; idx < W ; idx = idx + 1)
+          dexp[off+idx] = val[idx];
+        if (dst !== dexp) begin
+          $display("FAILED: width %0d assign at %0d", W, off);
+          failed = 1;
+        end
+      end
+    end
+  endtask
+
+endmodule
+
+module test;
+
+  reg [639:0] src;
+  reg failed;
+
+  part_check #(65)  w65();
+  part_check #(191) w191();
+  part_check #(255) w255();
+  part_check #(256) w256();
+  part_check #(257) w257();
+  part_check #(319) w319();
+  part_check #(320) w320();
+  part_check #(321) w321();
+  part_check #(385) w385();
+
+  initial begin
+    src = {20{32'b01xz_1100_zx10_0110_1x0z_0011_z1x0_1001}};
+    failed = 0;
+
+    w65.check(src);  failed = failed | w65.failed;
+    w191.check(src); failed = failed | w191.failed;
+    w255.check(src); failed = failed | w255.failed;
+    w256.check(src); failed = failed | w256.failed;
+    w257.check(src); failed = failed | w257.failed;
+    w319.check(src); failed = failed | w319.failed;
+    w320.check(src); failed = failed | w320.failed;
+    w321.check(src); failed = failed | w321.failed;
+    w385.check(src); failed = failed | w385.failed;
+
+    if (!failed)
+      $display("PASSED");
+  end
+
+endmodule
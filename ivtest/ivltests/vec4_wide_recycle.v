@@ -0,0 +1,94 @@
+// Check values wider than a machine word as they go through the
+// thread stack, variables, functions, arrays and resizes many times
+// over, which moves them and frees and reuses their storage. The
+// widths take up from two words to more words than vvp recycles.
+
+module test;
+
+  reg [64:0]  n;
+  reg [128:0] a, b, c;
+  reg [255:0] w;
+  reg [299:0] h;
+  reg [128:0] mem [0:7];
+  reg [128:0] last [0:7];
+  integer i, k;
+  reg failed;
+
+  function automatic [128:0] reverse(input [128:0] val);
+    integer j;
+    begin
+      for (j = 0 ; j < 129 ; j = j + 1)
+        reverse[j] = val[128-j];
+    end
+  endfunction
+
+  initial begin
+    failed = 0;
+
+    for (i = 0 ; i < 2000 ; i = i + 1) begin
+      a = {i[31:0], ~i[31:0], i[15:0], i[31:16], i[31:0] * 32'd7, 1'b1};
+      b = a ^ {a[63:0], a[128:64]};
+
+      c = (a + b) - b;
+      if (c !== a) begin
+        $display("FAILED: %0d: (a + b) - b = %h, expected %h", i, c, a);
+        failed = 1;
+      end
+
+      w = {b, a[126:0]};
+      h = {w, a[43:0]};
+      n = h[299:235];
+      if (n !== b[128:64]) begin
+        $display("FAILED: %0d: part of h = %h, expected %h", i, n, b[128:64]);
+        failed = 1;
+      end
+
+        // Resizes down and back up.
+      n = a;
+      if (n !== a[64:0]) begin
+        $display("FAILED: %0d: a truncated = %h", i, n);
+        failed = 1;
+      end
+      c = n;
+      if (c !== {64'd0, a[64:0]}) begin
+        $display("FAILED: %0d: n extended = %h", i, c);
+        failed = 1;
+      end
+
+        // X and Z bits.
+      c = a;
+      c[i % 129] = 1'bx;
+      c[(i + 64) % 129] = 1'bz;
+      if (c[i % 129] !== 1'bx || c[(i + 64) % 129] !== 1'bz) begin
+        $display("FAILED: %0d: c = %b", i, c);
+        failed = 1;
+      end
+      c[i % 129] = a[i % 129];
+      c[(i + 64) % 129] = a[(i + 64) % 129];
+      if (c !== a) begin
+        $display("FAILED: %0d: c restored = %h", i, c);
+        failed = 1;
+      end
+
+      if (reverse(reverse(a)) !== a) begin
+        $display("FAILED: %0d: reverse(reverse(a)) = %h", i,
+                 reverse(reverse(a)));
+        failed = 1;
+      end
+
+      mem[i % 8] = reverse(b);
+      last[i % 8] = b;
+    end
+
+    for (k = 0 ; k < 8 ; k = k + 1) begin
+      if (reverse(mem[k]) !== last[k]) begin
+        $display("FAILED: mem[%0d] = %h", k, mem[k]);
+        failed = 1;
+      end
+    end
+
+    if (!failed)
+      $display("PASSED");
+  end
+
+endmodule
@@ -4,6 +4,7 @@
 
 import subprocess
 import difflib
+import gzip
 import os
 import sys
 import re
@@ -17,10 +18,12 @@ def assemble_iverilog_cmd(source: str, it_dir: str, args: list, outfile = "a.out
     return res
 
 
-def assemble_vvp_cmd(args: list = [], plusargs: list = []) -> list:
+def assemble_vvp_cmd(args: list = [], plusargs: list = [], vvp_input: str = None) -> list:
     res = ["vvp"]
     res = res + args
-    res.append(os.path.join("work", "a.out"))
+    if vvp_input is None:
+        vvp_input = os.path.join("work", "a.out")
+    res.append(vvp_input)
     res = res + plusargs
     return res
 
@@ -114,6 +117,42 @@ def run_cmd(cmd: list) -> subprocess.CompletedProcess:
     res = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
     return res
 
+def run_prepare(options : dict) -> list:
+    '''Run the prepare steps of a test.
+
+    These run after the compile and before the final vvp command, each
+    either a vvp run of the compiled design with its own arguments, or
+    some other command. Return None if they all succeed, or the failed
+    result of the test.'''
+
+    it_key = options['key']
+    for idx, step in enumerate(options['prepare']):
+        if 'command' in step:
+            cmd = step['command']
+        else:
+            cmd = assemble_vvp_cmd(step.get('vvp-args', [ ]),
+                                   step.get('vvp-args-extended', [ ]))
+        res = run_cmd(cmd)
+        log_results(it_key, "prepare{n}".format(n=idx+1), res)
+        if res.returncode != 0:
+            return [1, "Failed - Prepare step {n} failed".format(n=idx+1)]
+
+    return None
+
+def read_diff_file(name : str, skip : int) -> str:
+    '''Read a file for a diff, without its first skip lines.
+
+    Files with a .gz suffix are uncompressed.'''
+
+    if name.endswith(".gz"):
+        fd = gzip.open(name, 'rt')
+    else:
+        fd = open(name, 'rt')
+    with fd:
+        for idx in range(skip):
+            fd.readline()
+        return fd.read()
+
 def check_gold(it_key : str, it_gold : str, log_list : list) -> bool:
     compared = True
     for log_name in log_list:
@@ -178,32 +217,34 @@ def check_run_outputs(options : dict, expected_fail : bool, it_stdout : str, log
                 return [1, "Failed - Gold output doesn't match actual output."]
 
     # If there is a diff description, then compare named files instead of
-    # the log and a gold file.
+    # the log and a gold file. The description is a list of the two file
+    # names and the number of lines to skip, or a list of those.
     if it_diff is not None:
-        diff_name1 = it_diff[0]
-        diff_name2 = it_diff[1]
-        diff_skip = int(it_diff[2])
+        if not isinstance(it_diff[0], list):
+            it_diff = [it_diff]
 
-        with open(diff_name1) as fd:
-            for idx in range(diff_skip):
-                fd.readline()
-            diff_data1 = fd.read()
+        differ = None
+        for diff_item in it_diff:
+            diff_name1 = diff_item[0]
+            diff_name2 = diff_item[1]
+            diff_skip = int(diff_item[2])
 
-        with open(diff_name2) as fd:
-            for idx in range(diff_skip):
-                fd.readline()
-            diff_data2 = fd.read()
+            diff_data1 = read_diff_file(diff_name1, diff_skip)
+            diff_data2 = read_diff_file(diff_name2, diff_skip)
+            if diff_data1 != diff_data2:
+                differ = diff_item
+                break
 
         if expected_fail:
-            if diff_data1 == diff_data2:
+            if differ is None:
                 return [1, "Failed - Passed, but expected failure"]
             else:
                 return [0, "Passed"]
         else:
-            if diff_data1 == diff_data2:
+            if differ is None:
                 return [0, "Passed"]
             else:
-                return [1, "Failed - Files {name1} and {name2} differ.".format(name1=diff_name1, name2=diff_name2)]
+                return [1, "Failed - Files {name1} and {name2} differ.".format(name1=differ[0], name2=differ[1])]
 
 
     # Otherwise, look for the PASSED output string in stdout.
@@ -254,8 +295,13 @@ def do_run_normal_vlog95(options : dict, expected_fail : bool) -> list:
     if ivl2_res.returncode != 0:
         return [1, "Failed - Compile of generated code failed"]
 
+    res = run_prepare(options)
+    if res is not None:
+        return res
+
     # Run the vvp command
-    vvp_cmd = assemble_vvp_cmd(it_vvp_args, it_vvp_args_extended)
+    vvp_cmd = assemble_vvp_cmd(it_vvp_args, it_vvp_args_extended,
+                               options['vvp_input'])
     vvp_res = run_cmd(vvp_cmd)
     log_results(it_key, "vvp", vvp_res);
 
@@ -293,8 +339,13 @@ def do_run_normal(options : dict, expected_fail : bool) -> list:
     if ivl_res.returncode != 0:
         return [1, "Failed - Compile failed"]
 
+    res = run_prepare(options)
+    if res is not None:
+        return res
+
     # run the vvp command
-    vvp_cmd = assemble_vvp_cmd(it_vvp_args, it_vvp_args_extended)
+    vvp_cmd = assemble_vvp_cmd(it_vvp_args, it_vvp_args_extended,
+                               options['vvp_input'])
     vvp_res = run_cmd(vvp_cmd)
     log_results(it_key, "vvp", vvp_res);
 
@@ -0,0 +1,82 @@
+# include  <vpi_user.h>
+# include  <assert.h>
+
+/*
+ * $dump_watch(<var>, ...) registers the variables with the native dump
+ * engine of vvp. At the end of each time step with changes, show the
+ * final values the engine passes in its buffer.
+ */
+static PLI_INT32 dump_step(p_cb_data cb)
+{
+      p_ivl_dump_buf buf = (p_ivl_dump_buf)cb->value->value.misc;
+      PLI_INT32 idx, bit;
+
+      assert(cb->time->type == vpiSimTime);
+      vpi_printf("%u:", cb->time->low);
+      for (idx = 0 ; idx < buf->count ; idx += 1) {
+	    p_ivl_dump_rec rec = buf->recs + idx;
+	    vpiHandle item = (vpiHandle)rec->user_data;
+
+	    vpi_printf(" %s=", vpi_get_str(vpiName, item));
+	    if (rec->format == vpiRealVal) {
+		  vpi_printf("%g", rec->value.real);
+		  continue;
+	    }
+
+	    assert(rec->format == vpiVectorVal);
+	    assert(rec->size == vpi_get(vpiSize, item));
+	    for (bit = rec->size ; bit > 0 ; bit -= 1) {
+		  p_vpi_vecval word = rec->value.vector + (bit-1)/32;
+		  int a = (word->aval >> ((bit-1)%32)) & 1;
+		  int b = (word->bval >> ((bit-1)%32)) & 1;
+		  vpi_printf("%c", "01zx"[b*2 + a]);
+	    }
+      }
+      vpi_printf("\n");
+
+      return 0;
+}
+
+static PLI_INT32 dump_watch_calltf(char*xx)
+{
+      s_cb_data cb;
+      vpiHandle sys = vpi_handle(vpiSysTfCall, 0);
+      vpiHandle argv = vpi_iterate(vpiArgument, sys);
+      vpiHandle arg;
+
+      (void)xx;  /* Parameter is not used. */
+
+      assert(argv);
+      while ((arg = vpi_scan(argv))) {
+	    cb.reason = __ivl_cbDumpChange;
+	    cb.cb_rtn = dump_step;
+	    cb.obj = arg;
+	    cb.time = 0;
+	    cb.value = 0;
+	    cb.index = 0;
+	    cb.user_data = (char*)arg;
+	    if (vpi_register_cb(&cb) == 0)
+		  vpi_printf("no dump engine for %s\n",
+			     vpi_get_str(vpiName, arg));
+      }
+
+      return 0;
+}
+
+static void dump_watch_register(void)
+{
+      s_vpi_systf_data tf_data;
+
+      tf_data.type        = vpiSysTask;
+      tf_data.tfname      = "$dump_watch";
+      tf_data.calltf      = dump_watch_calltf;
+      tf_data.compiletf   = 0;
+      tf_data.sizetf      = 0;
+      tf_data.user_data   = 0;
+      vpi_register_systf(&tf_data);
+}
+
+void (*vlog_startup_routines[])(void) = {
+      dump_watch_register,
+      0
+};
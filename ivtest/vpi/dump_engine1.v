@@ -0,0 +1,29 @@
+// Check the values that the native dump engine of vvp gives to VPI code.
+module main;
+
+   reg [3:0] a;
+   reg [39:0] w;
+   real r;
+   wire [1:0] n = a[2:1];
+   reg [3:0] mem [0:1];
+
+   initial begin
+      a = 0;
+      w = 0;
+      r = 0.0;
+      #1 $dump_watch(a, w, r, n, mem[0]);
+	// Only the final value of a time step is passed on, even
+	// when it is the value from the start of the step.
+      #1 a = 4'b0001;
+      a = 4'b1x1z;
+      w = 40'h80_0000_0001;
+      #1 r = 2.5;
+      w = 40'hff_ffff_fffe;
+      a = 4'b0x1z;
+      a = 4'b1x1z;
+	// Storing the same value is no change at all.
+      #1 a = 4'b1x1z;
+      #1 ;
+   end
+
+endmodule // main
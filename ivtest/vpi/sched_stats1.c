@@ -0,0 +1,147 @@
+# include  <vpi_user.h>
+# include  <string.h>
+# include  <assert.h>
+
+/*
+ * $sched_stat("<name>") returns one of the scheduler statistics that
+ * vvp gives as global properties.
+ */
+static const struct {
+      const char*name;
+      PLI_INT32 property;
+} stat_table[] = {
+      { "time_steps",  _vpiSchedTimeSteps },
+      { "active",      _vpiSchedActive },
+      { "inactive",    _vpiSchedInactive },
+      { "nbassign",    _vpiSchedNbassign },
+      { "deltas",      _vpiSchedDeltas },
+      { "step_deltas", _vpiSchedStepDeltas },
+      { "max_deltas",  _vpiSchedMaxDeltas },
+      { "thread_wakes", _vpiSchedThreadWakes },
+      { "pending",     _vpiSchedPending },
+      { "pool_thread", _vpiSchedPoolThread },
+      { 0, 0 }
+};
+
+static PLI_INT32 sched_stat_calltf(char*xx)
+{
+      s_vpi_value value;
+      vpiHandle sys = vpi_handle(vpiSysTfCall, 0);
+      vpiHandle argv = vpi_iterate(vpiArgument, sys);
+      vpiHandle arg;
+      unsigned idx;
+
+      (void)xx;  /* Parameter is not used. */
+
+      assert(argv);
+      arg = vpi_scan(argv);
+      assert(arg);
+      vpi_free_object(argv);
+
+      value.format = vpiStringVal;
+      vpi_get_value(arg, &value);
+
+      for (idx = 0 ; stat_table[idx].name ; idx += 1) {
+	    if (strcmp(stat_table[idx].name, value.value.str) == 0)
+		  break;
+      }
+      assert(stat_table[idx].name);
+
+      value.format = vpiIntVal;
+      value.value.integer = vpi_get(stat_table[idx].property, 0);
+      vpi_put_value(sys, &value, 0, vpiNoDelay);
+
+      return 0;
+}
+
+static PLI_INT32 sched_stat_sizetf(char*xx)
+{
+      (void)xx;  /* Parameter is not used. */
+      return 32;
+}
+
+/*
+ * $sched_stat_at_end(<steps>, <pending>) gives the number of time
+ * steps and pending time steps that the scheduler statistics should
+ * have when the simulation ends, including the time step that ends
+ * it. These are checked by the end of simulation callback.
+ */
+static PLI_INT32 end_steps = -1;
+static PLI_INT32 end_pending = -1;
+
+static PLI_INT32 sched_stat_at_end_calltf(char*xx)
+{
+      s_vpi_value value;
+      vpiHandle sys = vpi_handle(vpiSysTfCall, 0);
+      vpiHandle argv = vpi_iterate(vpiArgument, sys);
+
+      (void)xx;  /* Parameter is not used. */
+
+      assert(argv);
+      value.format = vpiIntVal;
+      vpi_get_value(vpi_scan(argv), &value);
+      end_steps = value.value.integer;
+      vpi_get_value(vpi_scan(argv), &value);
+      end_pending = value.value.integer;
+      vpi_free_object(argv);
+
+      return 0;
+}
+
+static PLI_INT32 sched_stat_end_cb(p_cb_data cb)
+{
+      PLI_INT32 steps = vpi_get(_vpiSchedTimeSteps, 0);
+      PLI_INT32 pending = vpi_get(_vpiSchedPending, 0);
+
+      (void)cb;  /* Parameter is not used. */
+
+      if (end_steps < 0)
+	    return 0;
+
+      if (steps != end_steps)
+	    vpi_printf("FAILED -- %d time steps at the end, expected %d\n",
+		       (int)steps, (int)end_steps);
+      if (pending != end_pending)
+	    vpi_printf("FAILED -- %d time steps pending at the end, "
+		       "expected %d\n", (int)pending, (int)end_pending);
+
+      return 0;
+}
+
+static void sched_stat_register(void)
+{
+      s_vpi_systf_data tf_data;
+      s_cb_data cb_data;
+
+      tf_data.type        = vpiSysFunc;
+      tf_data.sysfunctype = vpiIntFunc;
+      tf_data.tfname      = "$sched_stat";
+      tf_data.calltf      = sched_stat_calltf;
+      tf_data.compiletf   = 0;
+      tf_data.sizetf      = sched_stat_sizetf;
+      tf_data.user_data   = 0;
+      vpi_register_systf(&tf_data);
+
+      tf_data.type        = vpiSysTask;
+      tf_data.sysfunctype = 0;
+      tf_data.tfname      = "$sched_stat_at_end";
+      tf_data.calltf      = sched_stat_at_end_calltf;
+      tf_data.compiletf   = 0;
+      tf_data.sizetf      = 0;
+      tf_data.user_data   = 0;
+      vpi_register_systf(&tf_data);
+
+      cb_data.reason    = cbEndOfSimulation;
+      cb_data.cb_rtn    = sched_stat_end_cb;
+      cb_data.obj       = 0;
+      cb_data.time      = 0;
+      cb_data.value     = 0;
+      cb_data.index     = 0;
+      cb_data.user_data = 0;
+      vpi_register_cb(&cb_data);
+}
+
+void (*vlog_startup_routines[])(void) = {
+      sched_stat_register,
+      0
+};
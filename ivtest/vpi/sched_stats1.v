@@ -0,0 +1,69 @@
+// Check the scheduler statistics that vvp gives to VPI code.
+module main;
+
+   reg flag;
+   reg x;
+   integer steps, deltas, wakes, fail;
+
+   initial begin
+      fail = 0;
+      flag = 0;
+      #1 steps = $sched_stat("time_steps");
+      if ($sched_stat("step_deltas") !== 0) begin
+	 $display("FAILED -- %0d delta cycles at the start of a time step",
+		  $sched_stat("step_deltas"));
+	 fail = 1;
+      end
+
+	// A non-blocking assignment wakes this thread in the next delta
+	// cycle, and a #0 in the delta cycle after that.
+      x <= 1;
+      @(x) ;
+      if ($sched_stat("step_deltas") !== 1) begin
+	 $display("FAILED -- %0d delta cycles after the NBA",
+		  $sched_stat("step_deltas"));
+	 fail = 1;
+      end
+      #0;
+      if ($sched_stat("step_deltas") !== 2) begin
+	 $display("FAILED -- %0d delta cycles after #0",
+		  $sched_stat("step_deltas"));
+	 fail = 1;
+      end
+
+      wakes = $sched_stat("thread_wakes");
+      #1;
+      #1;
+      if ($sched_stat("time_steps") - steps !== 2) begin
+	 $display("FAILED -- %0d time steps done, expected 2",
+		  $sched_stat("time_steps") - steps);
+	 fail = 1;
+      end
+      if ($sched_stat("thread_wakes") - wakes !== 2) begin
+	 $display("FAILED -- %0d thread wakes, expected 2",
+		  $sched_stat("thread_wakes") - wakes);
+	 fail = 1;
+      end
+      if ($sched_stat("max_deltas") < 2) begin
+	 $display("FAILED -- at most %0d delta cycles in a time step",
+		  $sched_stat("max_deltas"));
+	 fail = 1;
+      end
+      if ($sched_stat("pending") < 1) begin
+	 $display("FAILED -- %0d time steps pending",
+		  $sched_stat("pending"));
+	 fail = 1;
+      end
+
+      if (fail == 0)
+	$display("PASSED");
+
+	// The time step that calls $finish is the last one accounted,
+	// with the time step of the flag still pending.
+      $sched_stat_at_end($sched_stat("time_steps") + 2, 1);
+      #1 $finish(0);
+   end
+
+   initial #10 flag = 1;
+
+endmodule // main
@@ -268,7 +268,7 @@ static void put_vec_to_ret_slice(ivl_signal_t sig, struct vec_slice_info*slice,
 }
 
 static void put_vec_to_lval_slice(ivl_lval_t lval, struct vec_slice_info*slice,
-				  unsigned wid)
+				  unsigned wid, int is_bool)
 {
 	//unsigned skip_set = transient_id++;
       ivl_signal_t sig = ivl_lval_sig(lval);
@@ -285,7 +285,7 @@ static void put_vec_to_lval_slice(ivl_lval_t lval, struct vec_slice_info*slice,
 
 	/* If the slice of the l-value is a BOOL variable, then cast
 	   the data to a BOOL vector so that the stores can be valid. */
-      if (ivl_signal_data_type(sig) == IVL_VT_BOOL) {
+      if (ivl_signal_data_type(sig) == IVL_VT_BOOL && !is_bool) {
 	    fprintf(vvp_out, "    %%cast2;\n");
       }
 
@@ -342,12 +342,40 @@ static void put_vec_to_lval_slice(ivl_lval_t lval, struct vec_slice_info*slice,
       }
 }
 
+/*
+ * A static BOOL variable drops X and Z bits itself when it is written,
+ * so a value stored whole into it needs no %cast2 first. Automatic
+ * variables and function return values are kept in 4-state storage,
+ * and a BOOL r-value can still carry X bits (for example from an array
+ * read with an X index), so those still get the %cast2.
+ */
+static int lvals_are_static_bool(ivl_statement_t net,
+				 const struct vec_slice_info*slices)
+{
+      unsigned lidx;
+
+      for (lidx = 0 ; lidx < ivl_stmt_lvals(net) ; lidx += 1) {
+	    ivl_signal_t sig = ivl_lval_sig(ivl_stmt_lval(net, lidx));
+	    if (slices[lidx].type != SLICE_SIMPLE_VECTOR)
+		  return 0;
+	    if (sig == 0 || ivl_signal_data_type(sig) != IVL_VT_BOOL)
+		  return 0;
+	    if (signal_is_return_value(sig))
+		  return 0;
+	    if (ivl_scope_is_auto(ivl_signal_scope(sig)))
+		  return 0;
+      }
+
+      return 1;
+}
+
 static void put_vec_to_lval(ivl_statement_t net, struct vec_slice_info*slices)
 {
       unsigned lidx;
       unsigned cur_bit;
 
       unsigned wid = ivl_stmt_lwidth(net);
+      int is_bool = lvals_are_static_bool(net, slices);
 
       cur_bit = 0;
       for (lidx = 0 ; lidx < ivl_stmt_lvals(net) ; lidx += 1) {
@@ -362,7 +390,7 @@ static void put_vec_to_lval(ivl_statement_t net, struct vec_slice_info*slices)
 	    if (lidx+1 < ivl_stmt_lvals(net))
 		  fprintf(vvp_out, "    %%split/vec4 %u;\n", bit_limit);
 
-	    put_vec_to_lval_slice(lval, slices+lidx, bit_limit);
+	    put_vec_to_lval_slice(lval, slices+lidx, bit_limit, is_bool);
 
 	    cur_bit += bit_limit;
       }
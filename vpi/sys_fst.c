@@ -29,6 +29,7 @@
 # include  <stdlib.h>
 # include  <string.h>
 # include  <assert.h>
+# include  <errno.h>
 # include  <time.h>
 # include  "ivl_alloc.h"
 
@@ -55,6 +56,15 @@ static enum lxm_optimum_mode_e {
       LXM_BOTH = 3
 } lxm_optimum_mode = LXM_NONE;
 
+/* The writer settings from the -fst-parallel, -fst-blocksize=<n> and
+   -fst-compress=<type> extended arguments. The block fill counts the
+   bytes of value changes given to the writer since the last block. */
+static int fst_parallel = 0;
+static size_t fst_block_size = 0;
+static size_t fst_block_fill = 0;
+static int fst_pack_type = -1;
+static const char*fst_pack_names[] = { "zlib", "fastlz", "lz4" };
+
 static const char*units_names[] = {
       "s",
       "ms",
@@ -64,6 +74,21 @@ static const char*units_names[] = {
       "fs"
 };
 
+/*
+ * The FST library has no setting for its block size, but it ends the
+ * block at the next time change when asked to flush. So for
+ * -fst-blocksize, count the bytes of the value changes (a byte per
+ * bit) and ask for a flush once a block worth has been emitted.
+ */
+static void emit_time_change(PLI_UINT64 now)
+{
+      if (fst_block_size && (fst_block_fill >= fst_block_size)) {
+	    fstWriterFlushContext(dump_file);
+	    fst_block_fill = 0;
+      }
+      fstWriterEmitTimeChange(dump_file, now);
+}
+
 static void show_this_item(struct vcd_info*info)
 {
       s_vpi_value value;
@@ -82,6 +107,7 @@ static void show_this_item(struct vcd_info*info)
 	    vpi_get_value(info->item, &value);
 	    fstWriterEmitValueChange(dump_file, info->ident, (type != vpiNamedEvent) ? value.value.str : "1");
       }
+      fst_block_fill += vpi_get(vpiSize, info->item);
 }
 
 /* Dump values for a $dumpoff. */
@@ -125,7 +151,7 @@ static PLI_INT32 variable_cb_2(p_cb_data cause)
       PLI_UINT64 now = timerec_to_time64(cause->time);
 
       if (now != vcd_cur_time) {
-	    fstWriterEmitTimeChange(dump_file, now);
+	    emit_time_change(now);
 	    vcd_cur_time = now;
       }
 
@@ -139,6 +165,54 @@ static PLI_INT32 variable_cb_2(p_cb_data cause)
       return 0;
 }
 
+/*
+ * The vcd_emit_step hooks pass the values of a native dump engine
+ * time step to the FST writer, and count them toward the block fill.
+ */
+static int step_begin(PLI_UINT64 now)
+{
+      if (dump_is_full) return 0;
+      if (dump_is_off) return 0;
+      if (dump_header_pending()) return 0;
+	/* The $dumpvars checkpoint has the values of its time step. */
+      if (now == dumpvars_time) return 0;
+
+      if ((dump_limit > 0) && fstWriterGetDumpSizeLimitReached(dump_file)) {
+            dump_is_full = 1;
+            vpi_printf("WARNING: Dump file limit (%ld bytes) "
+                               "exceeded.\n", dump_limit);
+            return 0;
+      }
+
+      if (now != vcd_cur_time) {
+	    emit_time_change(now);
+	    vcd_cur_time = now;
+      }
+
+      return 1;
+}
+
+static void step_emit_real(void*info, double val)
+{
+      fstWriterEmitValueChange(dump_file, ((struct vcd_info*)info)->ident,
+			       &val);
+      fst_block_fill += sizeof(double);
+}
+
+static void step_emit_vector(void*info, PLI_INT32 size,
+			     const s_vpi_vecval*vec)
+{
+      fstWriterEmitValueChange(dump_file, ((struct vcd_info*)info)->ident,
+			       vcd_vecval_to_bits(size, vec));
+      fst_block_fill += size;
+}
+
+static PLI_INT32 variable_step_cb(p_cb_data cause)
+{
+      return vcd_emit_step(cause, step_begin, step_emit_real,
+			   step_emit_vector);
+}
+
 static PLI_INT32 variable_cb_1(p_cb_data cause)
 {
       struct t_cb_data cb;
@@ -385,8 +459,10 @@ static void open_dumpfile(vpiHandle callh)
 	    sprintf(scale_buf, "\t%u%s\n", scale, units_names[udx]);
 	    fstWriterSetTimescaleFromString(dump_file, scale_buf);
 	      /* Set the faster dump type when requested. */
-	    if ((lxm_optimum_mode == LXM_SPEED) ||
-	        (lxm_optimum_mode == LXM_BOTH)) {
+	    if (fst_pack_type >= 0) {
+		  fstWriterSetPackType(dump_file, fst_pack_type);
+	    } else if ((lxm_optimum_mode == LXM_SPEED) ||
+	               (lxm_optimum_mode == LXM_BOTH)) {
 		  fstWriterSetPackType(dump_file, 1);
 	    }
 	      /* Set the most effective compression when requested. */
@@ -394,9 +470,59 @@ static void open_dumpfile(vpiHandle callh)
 	        (lxm_optimum_mode == LXM_BOTH)) {
 		  fstWriterSetRepackOnClose(dump_file, 1);
 	    }
+	      /* Compress and write the blocks in a separate thread. */
+	    if (fst_parallel) fstWriterSetParallelMode(dump_file, 1);
+	    fst_block_fill = 0;
+
+	    if (fst_pack_type >= 0) {
+		  vpi_printf("FST info: compressing with %s.\n",
+		             fst_pack_names[fst_pack_type]);
+	    }
+	    if (fst_block_size) {
+		  vpi_printf("FST info: writing blocks of %lu bytes.\n",
+		             (unsigned long)fst_block_size);
+	    }
+	    if (fst_parallel) {
+		  vpi_printf("FST info: writing blocks in parallel.\n");
+	    }
+	      /* The threaded writer of the FST library can break the
+	         file when a block ends before the previous block has
+	         been written, which small blocks make likely. */
+	    if (fst_parallel && fst_block_size) {
+		  vpi_printf("FST warning: -fst-parallel with -fst-blocksize "
+		             "may write a broken file.\n");
+	    }
       }
 }
 
+/*
+ * Parse the size of -fst-blocksize=<n>, which may end in k or M. This
+ * returns 0 for a size that is not a number or does not fit.
+ */
+static size_t parse_block_size(const char*text)
+{
+      char*end;
+      unsigned long val;
+      size_t scale = 1;
+
+      if (*text < '0' || *text > '9') return 0;
+      errno = 0;
+      val = strtoul(text, &end, 10);
+      if (errno == ERANGE) return 0;
+
+      if (*end == 'k' || *end == 'K') {
+	    scale = 1024;
+	    end += 1;
+      } else if (*end == 'm' || *end == 'M') {
+	    scale = 1024*1024;
+	    end += 1;
+      }
+      if (*end != 0) return 0;
+      if (val > (size_t)-1 / scale) return 0;
+
+      return val * scale;
+}
+
 static PLI_INT32 sys_dumpfile_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       (void)name;
@@ -431,7 +557,6 @@ static PLI_INT32 sys_dumplimit_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 
 static void scan_item(unsigned depth, vpiHandle item, int skip)
 {
-      struct t_cb_data cb;
       struct vcd_info* info;
 
       enum fstVarType type = FST_VT_MAX;
@@ -601,18 +726,13 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  info->ident = new_ident;
 		  info->scheduled = 0;
 
-		  cb.time      = &info->time;
-		  cb.user_data = (char*)info;
-		  cb.value     = NULL;
-		  cb.obj       = item;
-		  cb.reason    = cbValueChange;
-		  cb.cb_rtn    = variable_cb_1;
-
 		  info->dmp_next = 0;
 		  info->next  = vcd_list;
 		  vcd_list    = info;
 
-		  info->cb    = vpi_register_cb(&cb);
+		  info->cb    = vcd_register_value_cb(item, info, &info->time,
+							variable_cb_1,
+							variable_step_cb);
 	    }
 
 	    break;
@@ -903,6 +1023,34 @@ void sys_fst_register(void)
 		  lxm_optimum_mode = LXM_BOTH;
 	    } else if (strcmp(vlog_info.argv[idx],"-fst-speed-space") == 0) {
 		  lxm_optimum_mode = LXM_BOTH;
+	    } else if (strcmp(vlog_info.argv[idx],"-fst-parallel") == 0) {
+#ifdef FST_WRITER_PARALLEL
+		  fst_parallel = 1;
+#else
+		  vpi_printf("FST warning: This build has no threads, "
+		             "ignoring -fst-parallel.\n");
+#endif
+
+	    } else if (strncmp(vlog_info.argv[idx],"-fst-blocksize=",15) == 0) {
+		  fst_block_size = parse_block_size(vlog_info.argv[idx]+15);
+		  if (fst_block_size == 0) {
+			vpi_printf("FST warning: Invalid block size in %s, "
+			           "using the default.\n", vlog_info.argv[idx]);
+		  }
+
+	    } else if (strncmp(vlog_info.argv[idx],"-fst-compress=",14) == 0) {
+		  const char*type = vlog_info.argv[idx]+14;
+		  if (strcmp(type, "zlib") == 0) {
+			fst_pack_type = FST_WR_PT_ZLIB;
+		  } else if (strcmp(type, "fastlz") == 0) {
+			fst_pack_type = FST_WR_PT_FASTLZ;
+		  } else if (strcmp(type, "lz4") == 0) {
+			fst_pack_type = FST_WR_PT_LZ4;
+		  } else {
+			vpi_printf("FST warning: Unknown compression type "
+			           "in %s, using the default.\n",
+			           vlog_info.argv[idx]);
+		  }
 		} else if (strcmp(vlog_info.argv[idx],"-no-date") == 0) {
 		  dump_no_date = 1;
 		}
@@ -17,7 +17,9 @@
  */
 
 #include "sys_priv.h"
+#include "vcd_priv.h"
 #include <assert.h>
+#include <stdlib.h>
 
 static PLI_INT32 finish_and_return_calltf(ICARUS_VPI_CONST PLI_BYTE8* name)
 {
@@ -69,6 +71,43 @@ static PLI_INT32 missing_optional_compiletf(ICARUS_VPI_CONST PLI_BYTE8* name)
       return 0;
 }
 
+/*
+ * $save writes a checkpoint of the simulation to the named file at the
+ * end of the current time step. A later run of the same design can be
+ * started from it with the vvp -R flag.
+ */
+static PLI_INT32 save_calltf(ICARUS_VPI_CONST PLI_BYTE8* name)
+{
+      vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
+      vpiHandle argv = vpi_iterate(vpiArgument, callh);
+      char *fname = get_filename(callh, name, vpi_scan(argv));
+      vpi_free_object(argv);
+
+      if (fname == 0) return 0;
+
+      vpi_control(__ivl_vpiSave, fname);
+      free(fname);
+      return 0;
+}
+
+/*
+ * $ivl_snapshot fans the simulation out into the runs of the vvp -F
+ * file at the end of the current time step. The runs cannot share a
+ * waveform dump, whose file and writer threads belong to one process,
+ * so tell vvp to refuse if one was started.
+ */
+static PLI_INT32 snapshot_calltf(ICARUS_VPI_CONST PLI_BYTE8* name)
+{
+      const char*why = 0;
+      (void) name;  /* Not used! */
+
+      if (dumpvars_status != 0)
+	    why = "a waveform dump is open";
+
+      vpi_control(__ivl_vpiSnapshot, why);
+      return 0;
+}
+
 /*
  * Register the function with Verilog.
  */
@@ -84,6 +123,20 @@ void sys_special_register(void)
       tf_data.tfname      = "$finish_and_return";
       tf_data.user_data   = "$finish_and_return";
       res = vpi_register_systf(&tf_data);
+      vpip_make_systf_system_defined(res);
+
+      tf_data.calltf      = save_calltf;
+      tf_data.compiletf   = sys_one_string_arg_compiletf;
+      tf_data.tfname      = "$save";
+      tf_data.user_data   = "$save";
+      res = vpi_register_systf(&tf_data);
+      vpip_make_systf_system_defined(res);
+
+      tf_data.calltf      = snapshot_calltf;
+      tf_data.compiletf   = sys_no_arg_compiletf;
+      tf_data.tfname      = "$ivl_snapshot";
+      tf_data.user_data   = "$ivl_snapshot";
+      res = vpi_register_systf(&tf_data);
       vpip_make_systf_system_defined(res);
 
 	/* These tasks are not currently implemented. */
@@ -259,11 +312,6 @@ void sys_special_register(void)
       res = vpi_register_systf(&tf_data);
       vpip_make_systf_system_defined(res);
 
-      tf_data.tfname      = "$save";
-      tf_data.user_data   = "$save";
-      res = vpi_register_systf(&tf_data);
-      vpip_make_systf_system_defined(res);
-
       tf_data.tfname      = "$restart";
       tf_data.user_data   = "$restart";
       res = vpi_register_systf(&tf_data);
@@ -283,6 +283,51 @@ static PLI_INT32 variable_cb_2(p_cb_data cause)
       return 0;
 }
 
+/*
+ * The vcd_emit_step hooks queue the values of a native dump engine
+ * time step for the LXT2 work thread.
+ */
+static int step_begin(PLI_UINT64 now)
+{
+      if (dump_is_full) return 0;
+      if (dump_is_off) return 0;
+      if (dump_header_pending()) return 0;
+	/* The $dumpvars checkpoint has the values of its time step. */
+      if (now == dumpvars_time) return 0;
+
+      if ((dump_limit > 0) && (ftell(dump_file->handle) > dump_limit)) {
+            dump_is_full = 1;
+            vpi_printf("WARNING: Dump file limit (%ld bytes) "
+                       "exceeded.\n", dump_limit);
+            return 0;
+      }
+
+      if (now != vcd_cur_time) {
+	    vcd_work_set_time(now);
+	    vcd_cur_time = now;
+      }
+
+      return 1;
+}
+
+static void step_emit_real(void*info, double val)
+{
+      vcd_work_emit_double(((struct vcd_info*)info)->sym, val);
+}
+
+static void step_emit_vector(void*info, PLI_INT32 size,
+			     const s_vpi_vecval*vec)
+{
+      vcd_work_emit_bits(((struct vcd_info*)info)->sym,
+			 vcd_vecval_to_bits(size, vec));
+}
+
+static PLI_INT32 variable_step_cb(p_cb_data cause)
+{
+      return vcd_emit_step(cause, step_begin, step_emit_real,
+			   step_emit_vector);
+}
+
 static PLI_INT32 variable_cb_1(p_cb_data cause)
 {
       struct t_cb_data cb;
@@ -561,7 +606,6 @@ static PLI_INT32 sys_dumplimit_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 
 static void scan_item(unsigned depth, vpiHandle item, int skip)
 {
-      struct t_cb_data cb;
       struct vcd_info* info;
 
       const char* name;
@@ -625,14 +669,9 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		                                   LXT2_WR_SYM_F_BITS);
 		  info->dmp_next = 0;
 
-		  cb.time      = 0;
-		  cb.user_data = (char*)info;
-		  cb.value     = NULL;
-		  cb.obj       = item;
-		  cb.reason    = cbValueChange;
-		  cb.cb_rtn    = variable_cb_1;
-
-		  info->cb    = vpi_register_cb(&cb);
+		  info->cb    = vcd_register_value_cb(item, info, 0,
+							variable_cb_1,
+							variable_step_cb);
 
 	    } else {
 		  char *n = create_full_name(name);
@@ -661,14 +700,9 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 	                                    0, LXT2_WR_SYM_F_DOUBLE);
 	    info->dmp_next = 0;
 
-	    cb.time      = 0;
-	    cb.user_data = (char*)info;
-	    cb.value     = NULL;
-	    cb.obj       = item;
-	    cb.reason    = cbValueChange;
-	    cb.cb_rtn    = variable_cb_1;
-
-	    info->cb    = vpi_register_cb(&cb);
+	    info->cb    = vcd_register_value_cb(item, info, 0,
+						  variable_cb_1,
+						  variable_step_cb);
 
 	    break;
 
@@ -832,6 +866,7 @@ static void* lxt2_thread(void*arg)
 
 	    switch (cell->type) {
 		case WT_NONE:
+		case WT_WRITE:
 		  break;
 		case WT_FLUSH:
 		  lxt2_wr_flush(dump_file);
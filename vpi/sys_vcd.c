@@ -26,9 +26,13 @@
 
 # include  <stdio.h>
 # include  <stdlib.h>
+# include  <stdarg.h>
 # include  <string.h>
 # include  <assert.h>
 # include  <time.h>
+#ifdef HAVE_LIBZ
+# include  <zlib.h>
+#endif
 # include  "ivl_alloc.h"
 
 static FILE *dump_file = NULL;
@@ -103,6 +107,147 @@ static char *truncate_bitvec(char *s)
       }
 }
 
+/*
+ * The output is formatted into a large buffer in the simulation
+ * thread, and each full buffer is passed to the work thread (see
+ * vcd_writer_thread), which compresses it if needed and writes it to
+ * the dump file. The simulation thread does not wait for the file,
+ * only for the work thread if it falls far behind. The value changes,
+ * which are most of the output, are formatted by hand instead of
+ * with printf.
+ */
+#define VCD_OUT_SIZE (256*1024)
+static char*vcd_out = 0;
+static size_t vcd_out_fill = 0;
+static size_t vcd_out_alloc = 0;
+  /* The size of the output so far, for the $dumplimit. */
+static long vcd_out_bytes = 0;
+
+static void vcd_out_flush(void)
+{
+      if (vcd_out_fill == 0) return;
+
+      vcd_work_write(vcd_out, vcd_out_fill);
+      vcd_out = 0;
+      vcd_out_fill = 0;
+      vcd_out_alloc = 0;
+}
+
+/* Return a pointer to room for cnt more bytes in the buffer. */
+static char* vcd_out_reserve(size_t cnt)
+{
+      if (vcd_out_fill + cnt > vcd_out_alloc) {
+	    vcd_out_flush();
+	    vcd_out_alloc = cnt > VCD_OUT_SIZE ? cnt : VCD_OUT_SIZE;
+	    vcd_out = malloc(vcd_out_alloc);
+      }
+      return vcd_out + vcd_out_fill;
+}
+
+static void vcd_out_commit(size_t cnt)
+{
+      vcd_out_fill += cnt;
+      vcd_out_bytes += cnt;
+}
+
+static void vcd_puts(const char*str)
+{
+      size_t cnt = strlen(str);
+      memcpy(vcd_out_reserve(cnt), str, cnt);
+      vcd_out_commit(cnt);
+}
+
+static void vcd_printf(const char*fmt, ...)
+{
+      va_list ap;
+      char*dst = vcd_out_reserve(256);
+      size_t room = vcd_out_alloc - vcd_out_fill;
+      int cnt;
+
+      va_start(ap, fmt);
+      cnt = vsnprintf(dst, room, fmt, ap);
+      va_end(ap);
+      assert(cnt >= 0);
+
+      if ((size_t)cnt >= room) {
+	    dst = vcd_out_reserve(cnt + 1);
+	    va_start(ap, fmt);
+	    vsnprintf(dst, cnt + 1, fmt, ap);
+	    va_end(ap);
+      }
+      vcd_out_commit(cnt);
+}
+
+/* Write a "#<time>" line. */
+static void vcd_put_time(PLI_UINT64 now)
+{
+      char digits[24];
+      size_t cnt = 0;
+      char*dst;
+
+      do {
+	    digits[cnt++] = '0' + (char)(now % 10);
+	    now /= 10;
+      } while (now);
+
+      dst = vcd_out_reserve(cnt + 2);
+      vcd_out_commit(cnt + 2);
+      *dst++ = '#';
+      while (cnt > 0)
+	    *dst++ = digits[--cnt];
+      *dst = '\n';
+}
+
+static __inline__ char vcd_vecval_bit(const s_vpi_vecval*vec, PLI_INT32 bit)
+{
+      static const char bit_chars[4] = { '0', '1', 'z', 'x' };
+      unsigned aval = (vec[bit/32].aval >> (bit%32)) & 1;
+      unsigned bval = (vec[bit/32].bval >> (bit%32)) & 1;
+      return bit_chars[(bval << 1) | aval];
+}
+
+/*
+ * Write the value change of a raw vector value. The leading bits are
+ * truncated like truncate_bitvec does, without making the bit string
+ * first.
+ */
+static void vcd_put_vector(PLI_INT32 size, const s_vpi_vecval*vec,
+                           const char*ident)
+{
+      size_t ilen = strlen(ident);
+      PLI_INT32 msb = size - 1;
+      char first;
+      char*dst;
+
+      if (size == 1) {
+	    dst = vcd_out_reserve(ilen + 2);
+	    *dst++ = vcd_vecval_bit(vec, 0);
+	    memcpy(dst, ident, ilen);
+	    dst[ilen] = '\n';
+	    vcd_out_commit(ilen + 2);
+	    return;
+      }
+
+	/* Keep one bit of a leading run of 0, x or z bits, or none if
+	   it is a run of 0 bits followed by a 1. */
+      first = vcd_vecval_bit(vec, msb);
+      if (first != '1') {
+	    while (msb > 0 && vcd_vecval_bit(vec, msb-1) == first)
+		  msb -= 1;
+	    if (msb > 0 && first == '0' && vcd_vecval_bit(vec, msb-1) == '1')
+		  msb -= 1;
+      }
+
+      dst = vcd_out_reserve(msb + ilen + 4);
+      vcd_out_commit(msb + ilen + 4);
+      *dst++ = 'b';
+      for ( ; msb >= 0 ; msb -= 1)
+	    *dst++ = vcd_vecval_bit(vec, msb);
+      *dst++ = ' ';
+      memcpy(dst, ident, ilen);
+      dst[ilen] = '\n';
+}
+
 static void show_this_item(struct vcd_info*info)
 {
       s_vpi_value value;
@@ -111,22 +256,22 @@ static void show_this_item(struct vcd_info*info)
       if (type == vpiRealVar) {
 	    value.format = vpiRealVal;
 	    vpi_get_value(info->item, &value);
-	    fprintf(dump_file, "r%.16g %s\n", value.value.real, info->ident);
+	    vcd_printf("r%.16g %s\n", value.value.real, info->ident);
       } else if (type == vpiNamedEvent) {
-	    fprintf(dump_file, "1%s\n", info->ident);
+	    vcd_printf("1%s\n", info->ident);
       } else if (type == vpiParameter && vpi_get(vpiConstType, info->item) == vpiRealConst) {
 
 	    value.format = vpiRealVal;
 	    vpi_get_value(info->item, &value);
-	    fprintf(dump_file, "r%.16g %s\n", value.value.real, info->ident);
+	    vcd_printf("r%.16g %s\n", value.value.real, info->ident);
       } else if (vpi_get(vpiSize, info->item) == 1) {
 	    value.format = vpiBinStrVal;
 	    vpi_get_value(info->item, &value);
-	    fprintf(dump_file, "%s%s\n", value.value.str, info->ident);
+	    vcd_printf("%s%s\n", value.value.str, info->ident);
       } else {
 	    value.format = vpiBinStrVal;
 	    vpi_get_value(info->item, &value);
-	    fprintf(dump_file, "b%s %s\n", truncate_bitvec(value.value.str),
+	    vcd_printf("b%s %s\n", truncate_bitvec(value.value.str),
 		    info->ident);
       }
 }
@@ -138,13 +283,13 @@ static void show_this_item_x(struct vcd_info*info)
 
       if (type == vpiRealVar) {
 	      /* Some tools dump nothing here...? */
-	    fprintf(dump_file, "rNaN %s\n", info->ident);
+	    vcd_printf("rNaN %s\n", info->ident);
       } else if (type == vpiNamedEvent) {
 	    /* Do nothing for named events. */
       } else if (vpi_get(vpiSize, info->item) == 1) {
-	    fprintf(dump_file, "x%s\n", info->ident);
+	    vcd_printf("x%s\n", info->ident);
       } else {
-	    fprintf(dump_file, "bx %s\n", info->ident);
+	    vcd_printf("bx %s\n", info->ident);
       }
 }
 
@@ -170,7 +315,7 @@ static PLI_INT32 variable_cb_2(p_cb_data cause)
       PLI_UINT64 now = timerec_to_time64(cause->time);
 
       if (now != vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now);
+	    vcd_put_time(now);
 	    vcd_cur_time = now;
       }
 
@@ -184,6 +329,52 @@ static PLI_INT32 variable_cb_2(p_cb_data cause)
       return 0;
 }
 
+/*
+ * The vcd_emit_step hooks write the values of a native dump engine
+ * time step as VCD text.
+ */
+static int step_begin(PLI_UINT64 now)
+{
+      if (dump_is_full) return 0;
+      if (dump_is_off) return 0;
+      if (dump_header_pending()) return 0;
+	/* The $dumpvars checkpoint has the values of its time step. */
+      if (now == dumpvars_time) return 0;
+
+      if ((dump_limit > 0) && (vcd_out_bytes > dump_limit)) {
+            dump_is_full = 1;
+            vpi_printf("WARNING: Dump file limit (%ld bytes) "
+                               "exceeded.\n", dump_limit);
+            vcd_printf("$comment Dump file limit (%ld bytes) "
+                               "exceeded. $end\n", dump_limit);
+            return 0;
+      }
+
+      if (now != vcd_cur_time) {
+	    vcd_put_time(now);
+	    vcd_cur_time = now;
+      }
+
+      return 1;
+}
+
+static void step_emit_real(void*info, double val)
+{
+      vcd_printf("r%.16g %s\n", val, ((struct vcd_info*)info)->ident);
+}
+
+static void step_emit_vector(void*info, PLI_INT32 size,
+			     const s_vpi_vecval*vec)
+{
+      vcd_put_vector(size, vec, ((struct vcd_info*)info)->ident);
+}
+
+static PLI_INT32 variable_step_cb(p_cb_data cause)
+{
+      return vcd_emit_step(cause, step_begin, step_emit_real,
+			   step_emit_vector);
+}
+
 static PLI_INT32 variable_cb_1(p_cb_data cause)
 {
       struct t_cb_data cb;
@@ -194,11 +385,11 @@ static PLI_INT32 variable_cb_1(p_cb_data cause)
       if (dump_header_pending()) return 0;
       if (info->scheduled) return 0;
 
-      if ((dump_limit > 0) && (ftell(dump_file) > dump_limit)) {
+      if ((dump_limit > 0) && (vcd_out_bytes > dump_limit)) {
             dump_is_full = 1;
             vpi_printf("WARNING: Dump file limit (%ld bytes) "
                                "exceeded.\n", dump_limit);
-            fprintf(dump_file, "$comment Dump file limit (%ld bytes) "
+            vcd_printf("$comment Dump file limit (%ld bytes) "
                                "exceeded. $end\n", dump_limit);
             return 0;
       }
@@ -232,19 +423,19 @@ static PLI_INT32 dumpvars_cb(p_cb_data cause)
       dumpvars_time = timerec_to_time64(cause->time);
       vcd_cur_time = dumpvars_time;
 
-      fprintf(dump_file, "$enddefinitions $end\n");
+      vcd_puts("$enddefinitions $end\n");
 
       if (!dump_is_off) {
-	    fprintf(dump_file, "$comment Show the parameter values. $end\n");
-	    fprintf(dump_file, "$dumpall\n");
+	    vcd_puts("$comment Show the parameter values. $end\n");
+	    vcd_puts("$dumpall\n");
 	    ITERATE_VCD_INFO(vcd_const_list, vcd_info, next, show_this_item);
-	    fprintf(dump_file, "$end\n");
+	    vcd_puts("$end\n");
 
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", dumpvars_time);
+	    vcd_put_time(dumpvars_time);
 
-	    fprintf(dump_file, "$dumpvars\n");
+	    vcd_puts("$dumpvars\n");
 	    ITERATE_VCD_INFO(vcd_list, vcd_info, next, show_this_item);
-	    fprintf(dump_file, "$end\n");
+	    vcd_puts("$end\n");
       }
 
       return 0;
@@ -261,9 +452,11 @@ static PLI_INT32 finish_cb(p_cb_data cause)
       dumpvars_time = timerec_to_time64(cause->time);
 
       if (!dump_is_off && !dump_is_full && dumpvars_time != vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", dumpvars_time);
+	    vcd_put_time(dumpvars_time);
       }
 
+      vcd_out_flush();
+      vcd_work_terminate();
       fclose(dump_file);
 
       for (cur = vcd_list ;  cur ;  cur = next) {
@@ -335,13 +528,13 @@ static PLI_INT32 sys_dumpoff_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       now64 = timerec_to_time64(&now);
 
       if (now64 > vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now64);
+	    vcd_put_time(now64);
 	    vcd_cur_time = now64;
       }
 
-      fprintf(dump_file, "$dumpoff\n");
+      vcd_puts("$dumpoff\n");
       ITERATE_VCD_INFO(vcd_list, vcd_info, next, show_this_item_x);
-      fprintf(dump_file, "$end\n");
+      vcd_puts("$end\n");
 
       return 0;
 }
@@ -365,13 +558,13 @@ static PLI_INT32 sys_dumpon_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       now64 = timerec_to_time64(&now);
 
       if (now64 > vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now64);
+	    vcd_put_time(now64);
 	    vcd_cur_time = now64;
       }
 
-      fprintf(dump_file, "$dumpon\n");
+      vcd_puts("$dumpon\n");
       ITERATE_VCD_INFO(vcd_list, vcd_info, next, show_this_item);
-      fprintf(dump_file, "$end\n");
+      vcd_puts("$end\n");
 
       return 0;
 }
@@ -392,13 +585,82 @@ static PLI_INT32 sys_dumpall_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       now64 = timerec_to_time64(&now);
 
       if (now64 > vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now64);
+	    vcd_put_time(now64);
 	    vcd_cur_time = now64;
       }
 
-      fprintf(dump_file, "$dumpall\n");
+      vcd_puts("$dumpall\n");
       ITERATE_VCD_INFO(vcd_list, vcd_info, next, show_this_item);
-      fprintf(dump_file, "$end\n");
+      vcd_puts("$end\n");
+
+      return 0;
+}
+
+#ifdef HAVE_LIBZ
+/* Set when the dump file name ends in ".gz". */
+static int vcd_gzip = 0;
+static z_stream vcd_zstream;
+
+static void vcd_gzip_write(int flush)
+{
+      unsigned char out[64*1024];
+
+      do {
+	    vcd_zstream.next_out = out;
+	    vcd_zstream.avail_out = sizeof out;
+	    deflate(&vcd_zstream, flush);
+	    fwrite(out, 1, sizeof out - vcd_zstream.avail_out, dump_file);
+      } while (vcd_zstream.avail_out == 0);
+}
+#endif
+
+/*
+ * This is the work thread that writes the output buffers to the dump
+ * file, compressing them with gzip first if the file name ends in
+ * ".gz".
+ */
+static void* vcd_writer_thread(void*arg)
+{
+      int run_flag = 1;
+
+      (void)arg; /* Parameter is not used. */
+
+      while (run_flag) {
+	    struct vcd_work_item_s*cell = vcd_work_thread_peek();
+
+	    switch (cell->type) {
+		case WT_WRITE:
+#ifdef HAVE_LIBZ
+		  if (vcd_gzip) {
+			vcd_zstream.next_in = (Bytef*)cell->op_.val_char;
+			vcd_zstream.avail_in = cell->len;
+			vcd_gzip_write(Z_NO_FLUSH);
+			break;
+		  }
+#endif
+		  fwrite(cell->op_.val_char, 1, cell->len, dump_file);
+		  break;
+		case WT_FLUSH:
+#ifdef HAVE_LIBZ
+		  if (vcd_gzip) vcd_gzip_write(Z_SYNC_FLUSH);
+#endif
+		  fflush(dump_file);
+		  break;
+		case WT_TERMINATE:
+#ifdef HAVE_LIBZ
+		  if (vcd_gzip) {
+			vcd_gzip_write(Z_FINISH);
+			deflateEnd(&vcd_zstream);
+		  }
+#endif
+		  run_flag = 0;
+		  break;
+		default:
+		  break;
+	    }
+
+	    vcd_work_thread_pop();
+      }
 
       return 0;
 }
@@ -406,8 +668,14 @@ static PLI_INT32 sys_dumpall_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 static void open_dumpfile(vpiHandle callh)
 {
       char* use_dump_path = vcd_get_dump_path("vcd");
+#ifdef HAVE_LIBZ
+      size_t len = strlen(use_dump_path);
 
+      vcd_gzip = (len > 3) && (strcmp(use_dump_path + len - 3, ".gz") == 0);
+      dump_file = fopen(use_dump_path, vcd_gzip ? "wb" : "w");
+#else
       dump_file = fopen(use_dump_path, "w");
+#endif
 
       if (dump_file == 0) {
 	    vpi_printf("VCD Error: %s:%d: ", vpi_get_str(vpiFile, callh),
@@ -426,6 +694,16 @@ static void open_dumpfile(vpiHandle callh)
 	    vpi_printf("VCD info: dumpfile %s opened for output.\n",
 	               use_dump_path);
 
+#ifdef HAVE_LIBZ
+	    if (vcd_gzip) {
+		  memset(&vcd_zstream, 0, sizeof vcd_zstream);
+		    /* Add 16 to the window bits for a gzip wrapper. */
+		  deflateInit2(&vcd_zstream, Z_DEFAULT_COMPRESSION,
+		               Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+	    }
+#endif
+	    vcd_work_start(vcd_writer_thread, 0);
+
 	    time(&walltime);
 
 	    assert(prec >= -15);
@@ -439,16 +717,16 @@ static void open_dumpfile(vpiHandle callh)
 	    }
 
 		if (!dump_no_date) {
-			fprintf(dump_file, "$date\n");
-			fprintf(dump_file, "\t%s",asctime(localtime(&walltime)));
-			fprintf(dump_file, "$end\n");
+			vcd_puts("$date\n");
+			vcd_printf("\t%s",asctime(localtime(&walltime)));
+			vcd_puts("$end\n");
 		}
-	    fprintf(dump_file, "$version\n");
-	    fprintf(dump_file, "\tIcarus Verilog\n");
-	    fprintf(dump_file, "$end\n");
-	    fprintf(dump_file, "$timescale\n");
-	    fprintf(dump_file, "\t%u%s\n", scale, units_names[udx]);
-	    fprintf(dump_file, "$end\n");
+	    vcd_puts("$version\n");
+	    vcd_puts("\tIcarus Verilog\n");
+	    vcd_puts("$end\n");
+	    vcd_puts("$timescale\n");
+	    vcd_printf("\t%u%s\n", scale, units_names[udx]);
+	    vcd_puts("$end\n");
       }
 }
 
@@ -461,7 +739,11 @@ static PLI_INT32 sys_dumpfile_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 static PLI_INT32 sys_dumpflush_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       (void)name; /* Parameter is not used. */
-      if (dump_file) fflush(dump_file);
+      if (dump_file) {
+	    vcd_out_flush();
+	    vcd_work_flush();
+	    vcd_work_sync();
+      }
 
       return 0;
 }
@@ -485,7 +767,6 @@ static PLI_INT32 sys_dumplimit_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 
 static void scan_item(unsigned depth, vpiHandle item, int skip)
 {
-      struct t_cb_data cb;
       struct vcd_info* info;
 
       const char *type;
@@ -624,18 +905,13 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  info->ident = ident;
 		  info->scheduled = 0;
 
-		  cb.time      = &info->time;
-		  cb.user_data = (char*)info;
-		  cb.value     = NULL;
-		  cb.obj       = item;
-		  cb.reason    = cbValueChange;
-		  cb.cb_rtn    = variable_cb_1;
-
 		  info->dmp_next = 0;
 		  info->next  = vcd_list;
 		  vcd_list    = info;
 
-		  info->cb    = vpi_register_cb(&cb);
+		  info->cb    = vcd_register_value_cb(item, info, &info->time,
+							variable_cb_1,
+							variable_step_cb);
 	    }
 
 	      /* Named events do not have a size, but other tools use
@@ -644,17 +920,17 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 	    if (item_type == vpiNamedEvent) size = 1;
 	    else size = vpi_get(vpiSize, item);
 
-	    fprintf(dump_file, "$var %s %u %s %s%s",
+	    vcd_printf("$var %s %u %s %s%s",
 		    type, size, ident, prefix, name);
 
 	      /* Add a range for vectored values. */
 	    if (size > 1 || vpi_get(vpiLeftRange, item) != 0) {
-		  fprintf(dump_file, " [%i:%i]",
+		  vcd_printf(" [%i:%i]",
 			  (int)vpi_get(vpiLeftRange, item),
 			  (int)vpi_get(vpiRightRange, item));
 	    }
 
-	    fprintf(dump_file, " $end\n");
+	    vcd_puts(" $end\n");
 	    break;
 
 	  case vpiParameter:
@@ -682,7 +958,7 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 	    info->cb = NULL;
 
 	    /* Generate the $var record. Now the parameter is declared. */
-	    fprintf(dump_file, "$var %s %u %s %s%s $end\n",
+	    vcd_printf("$var %s %u %s %s%s $end\n",
 		    type, size, ident, prefix, name);
 	    break;
 
@@ -724,7 +1000,7 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  }
 
 		  name = vpi_get_str(vpiName, item);
-		  fprintf(dump_file, "$scope %s %s $end\n", type, name);
+		  vcd_printf("$scope %s %s $end\n", type, name);
 
 		  for (i=0; types[i]>0; i++) {
 			vpiHandle hand;
@@ -735,7 +1011,7 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  }
 
 		    /* Sort any signals that we added above. */
-		  fprintf(dump_file, "$upscope $end\n");
+		  vcd_puts("$upscope $end\n");
 	    }
 	    break;
 
@@ -774,7 +1050,7 @@ static int draw_scope(vpiHandle item, vpiHandle callh)
             assert(0);
       }
 
-      fprintf(dump_file, "$scope %s %s $end\n", type, name);
+      vcd_printf("$scope %s %s $end\n", type, name);
 
       return depth;
 }
@@ -867,7 +1143,7 @@ static PLI_INT32 sys_dumpvars_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	      /* The scope list must be sorted after we scan an item.  */
 	    vcd_names_sort(&vcd_tab);
 
-	    while (dep--) fprintf(dump_file, "$upscope $end\n");
+	    while (dep--) vcd_puts("$upscope $end\n");
 
 	      /* Add this signal to the variable list so we can verify it
 	       * is not included twice. This must be done after it has
@@ -225,6 +225,77 @@ PLI_INT32 sys_dumpvars_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name)
       return 0;
 }
 
+vpiHandle vcd_register_value_cb(vpiHandle item, void*info, p_vpi_time time,
+				PLI_INT32 (*change_rtn)(p_cb_data),
+				PLI_INT32 (*step_rtn)(p_cb_data))
+{
+      struct t_cb_data cb;
+      vpiHandle res;
+
+      cb.time      = time;
+      cb.user_data = (char*)info;
+      cb.value     = NULL;
+      cb.obj       = item;
+      cb.index     = 0;
+      cb.reason    = __ivl_cbDumpChange;
+      cb.cb_rtn    = step_rtn;
+
+      res = vpi_register_cb(&cb);
+      if (res) return res;
+
+      cb.reason    = cbValueChange;
+      cb.cb_rtn    = change_rtn;
+      return vpi_register_cb(&cb);
+}
+
+/*
+ * The buffer is in order of first change, so walk it backwards to get
+ * the values in the same order as the vcd_dmp_list.
+ */
+PLI_INT32 vcd_emit_step(p_cb_data cause,
+			int (*begin_rtn)(PLI_UINT64 now),
+			void (*real_rtn)(void*info, double val),
+			void (*vector_rtn)(void*info, PLI_INT32 size,
+					   const s_vpi_vecval*vec))
+{
+      p_ivl_dump_buf buf = (p_ivl_dump_buf)cause->value->value.misc;
+      PLI_INT32 idx;
+
+      if (! begin_rtn(timerec_to_time64(cause->time))) return 0;
+
+      for (idx = buf->count ; idx > 0 ; idx -= 1) {
+	    p_ivl_dump_rec rec = buf->recs + idx - 1;
+
+	    if (rec->format == vpiRealVal)
+		  real_rtn((void*)rec->user_data, rec->value.real);
+	    else
+		  vector_rtn((void*)rec->user_data, rec->size, rec->value.vector);
+      }
+
+      return 0;
+}
+
+char* vcd_vecval_to_bits(PLI_INT32 size, const s_vpi_vecval*vec)
+{
+      static char*bits = 0;
+      static PLI_INT32 bits_size = 0;
+      PLI_INT32 idx;
+
+      if (bits == 0 || size > bits_size) {
+	    bits = realloc(bits, size+1);
+	    bits_size = size;
+      }
+
+      for (idx = 0 ; idx < size ; idx += 1) {
+	    PLI_INT32 a = (vec[idx/32].aval >> (idx%32)) & 1;
+	    PLI_INT32 b = (vec[idx/32].bval >> (idx%32)) & 1;
+	    bits[size-idx-1] = "01zx"[(b << 1) | a];
+      }
+      bits[size] = 0;
+
+      return bits;
+}
+
 void vcd_set_dump_path_default(const char*text)
 {
       vcd_dump_path_default = text;
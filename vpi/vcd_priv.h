@@ -74,6 +74,7 @@ typedef enum vcd_work_item_type_e {
       WT_DUMPON,
       WT_DUMPOFF,
       WT_FLUSH,
+      WT_WRITE,
       WT_TERMINATE
 } vcd_work_item_type_t;
 
@@ -90,6 +91,8 @@ struct vcd_work_item_s {
 	    double val_double;
 	    char*val_char;
       } op_;
+	/* The byte count of op_.val_char for WT_WRITE. */
+      size_t len;
 };
 
 /*
@@ -125,6 +128,12 @@ EXTERN void vcd_work_dumpon(void);
 EXTERN void vcd_work_dumpoff(void);
 EXTERN void vcd_work_emit_double(struct lxt2_wr_symbol*sym, double val);
 EXTERN void vcd_work_emit_bits(struct lxt2_wr_symbol*sym, const char*bits);
+/*
+ * Pass a buffer of formatted output to the work thread, which takes
+ * ownership of it and frees it when it is written. This blocks if
+ * too many buffers are already waiting to be written.
+ */
+EXTERN void vcd_work_write(char*buf, size_t len);
 
 /* The compiletf routines are common for the VCD, LXT and LXT2 dumpers. */
 EXTERN PLI_INT32 sys_dumpvars_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name);
@@ -138,6 +147,38 @@ EXTERN char* vcd_get_dump_path(const char*suffix);
 EXTERN void  vcd_free_dump_path(void);
 EXTERN int dumpvars_status;
 
+/*
+ * Register the value change callback of a dumped variable. Variables
+ * that the native dump engine of vvp handles (__ivl_cbDumpChange) are
+ * collected over the time step and passed to step_rtn once at the end
+ * of the step, with their raw values in a s_ivl_dump_buf. All others
+ * get a plain cbValueChange that calls change_rtn.
+ */
+EXTERN vpiHandle vcd_register_value_cb(vpiHandle item, void*info,
+				       p_vpi_time time,
+				       PLI_INT32 (*change_rtn)(p_cb_data),
+				       PLI_INT32 (*step_rtn)(p_cb_data));
+
+/*
+ * Handle the step callback (the step_rtn above) of a dumper. The
+ * begin_rtn is called first with the time of the step, and returns
+ * false if the dumper is not writing values. Otherwise the values in
+ * the buffer are passed to real_rtn or vector_rtn, along with the
+ * info of their variable, in the same order as the vcd_dmp_list.
+ */
+EXTERN PLI_INT32 vcd_emit_step(p_cb_data cause,
+			       int (*begin_rtn)(PLI_UINT64 now),
+			       void (*real_rtn)(void*info, double val),
+			       void (*vector_rtn)(void*info, PLI_INT32 size,
+						  const s_vpi_vecval*vec));
+
+/*
+ * Format a raw vector value from the dump buffer as a string of
+ * 0/1/x/z characters, MSB first, like vpiBinStrVal. The string is in
+ * a buffer that the next call reuses.
+ */
+EXTERN char* vcd_vecval_to_bits(PLI_INT32 size, const s_vpi_vecval*vec);
+
 /*
  * The vcd_list is the list of all the objects that are tracked for
  * dumping. The vcd_checkpoint goes through the list to dump the current
@@ -88,15 +88,18 @@ static pthread_t work_thread;
 static const unsigned WORK_QUEUE_SIZE = 128*1024;
 static const unsigned WORK_QUEUE_BATCH_MIN = 4*1024;
 static const unsigned WORK_QUEUE_BATCH_MAX = 32*1024;
+static const unsigned WORK_QUEUE_WRITE_MAX = 32;
 
 static struct vcd_work_item_s work_queue[WORK_QUEUE_SIZE];
 static volatile unsigned work_queue_next = 0;
 static volatile unsigned work_queue_fill = 0;
+static unsigned work_queue_writes = 0;
 
 static pthread_mutex_t work_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  work_queue_is_empty_sig = PTHREAD_COND_INITIALIZER;
 static pthread_cond_t  work_queue_notempty_sig = PTHREAD_COND_INITIALIZER;
 static pthread_cond_t  work_queue_minfree_sig = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  work_queue_write_room_sig = PTHREAD_COND_INITIALIZER;
 
 
 extern "C" struct vcd_work_item_s* vcd_work_thread_peek(void)
@@ -129,6 +132,12 @@ extern "C" void vcd_work_thread_pop(void)
       if (cell->type == WT_EMIT_BITS) {
 	    free(cell->op_.val_char);
       }
+      if (cell->type == WT_WRITE) {
+	    free(cell->op_.val_char);
+	    work_queue_writes -= 1;
+	    if (work_queue_writes == WORK_QUEUE_WRITE_MAX-1)
+		  pthread_cond_signal(&work_queue_write_room_sig);
+      }
 
       use_next += 1;
       if (use_next >= WORK_QUEUE_SIZE)
@@ -276,6 +285,24 @@ extern "C" void vcd_work_emit_bits(struct lxt2_wr_symbol*sym, const char* val)
       unlock_item();
 }
 
+extern "C" void vcd_work_write(char*buf, size_t len)
+{
+	// Each buffer may be large, so limit the number that are
+	// waiting for the work thread, instead of the number of
+	// work items.
+      pthread_mutex_lock(&work_queue_mutex);
+      while (work_queue_writes >= WORK_QUEUE_WRITE_MAX)
+	    pthread_cond_wait(&work_queue_write_room_sig, &work_queue_mutex);
+      work_queue_writes += 1;
+      pthread_mutex_unlock(&work_queue_mutex);
+
+      struct vcd_work_item_s*cell = grab_item();
+      cell->type = WT_WRITE;
+      cell->op_.val_char = buf;
+      cell->len = len;
+      unlock_item(true);
+}
+
 extern "C" void vcd_work_terminate(void)
 {
       struct vcd_work_item_s*cell = grab_item();
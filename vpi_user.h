@@ -408,6 +408,29 @@ typedef struct t_vpi_delay  {
 #  define _vpiDelaySelMaximum 3
 /* used in vvp/vpi_priv.h  0x1000003 */
 /* used in vvp/vpi_priv.h  0x1000004 */
+/* IVL private global properties, read with vpi_get(<property>, NULL).
+   These are the scheduler statistics of vvp, counted from the start of
+   the simulation and clipped to the largest PLI_INT32. */
+#define _vpiSchedTimeSteps    0x1000010 /* time steps done */
+#define _vpiSchedActive       0x1000011 /* events run by region */
+#define _vpiSchedInactive     0x1000012
+#define _vpiSchedNbassign     0x1000013
+#define _vpiSchedRwsync       0x1000014
+#define _vpiSchedRosync       0x1000015
+#define _vpiSchedDeltas       0x1000016 /* delta cycles */
+#define _vpiSchedStepDeltas   0x1000017 /* ... in the current time step */
+#define _vpiSchedMaxDeltas    0x1000018 /* ... in the busiest time step */
+#define _vpiSchedThreadWakes  0x1000019
+#define _vpiSchedPending      0x100001a /* time steps in the queue */
+#define _vpiSchedPoolTime     0x1000020 /* event pool sizes */
+#define _vpiSchedPoolThread   0x1000021
+#define _vpiSchedPoolAssign4  0x1000022
+#define _vpiSchedPoolAssign8  0x1000023
+#define _vpiSchedPoolAssignReal 0x1000024
+#define _vpiSchedPoolAssignWord 0x1000025
+#define _vpiSchedPoolAssignWordR 0x1000026
+#define _vpiSchedPoolForce4   0x1000027
+#define _vpiSchedPoolGen      0x1000028
 
 /* DELAY MODES */
 #define vpiNoDelay            1
@@ -501,6 +524,33 @@ typedef struct t_cb_data {
 #define cbInteractiveScopeChange 23
 #define cbUnresolvedSystf   24
 #define cbAtEndOfSimTime    31
+  /* Icarus extension: the native dump engine of vvp. A callback with
+     this reason on a variable or net does not call cb_rtn on every
+     value change. Instead the first change of the object in a time
+     step records it in a dump buffer, and at the end of the time
+     step (in the read-only synch region) cb_rtn is called once with
+     value->value.misc pointing to a s_ivl_dump_buf. The buffer holds
+     the final values of all the changed objects that were registered
+     with the same cb_rtn, in the order of their first change. The
+     buffer is only valid during the call. The result is NULL, without
+     an error, for objects that the engine does not handle; use
+     cbValueChange for those. */
+#define __ivl_cbDumpChange 0x1000200
+
+typedef struct t_ivl_dump_rec {
+      ICARUS_VPI_CONST PLI_BYTE8 *user_data; /* from the registration */
+      PLI_INT32 format;  /* vpiVectorVal or vpiRealVal */
+      PLI_INT32 size;    /* width of a vpiVectorVal value */
+      union {
+	    struct t_vpi_vecval *vector;
+	    double real;
+      } value;
+} s_ivl_dump_rec, *p_ivl_dump_rec;
+
+typedef struct t_ivl_dump_buf {
+      PLI_INT32 count;
+      p_ivl_dump_rec recs;
+} s_ivl_dump_buf, *p_ivl_dump_buf;
 
 extern vpiHandle vpi_register_cb(p_cb_data data);
 extern PLI_INT32 vpi_remove_cb(vpiHandle ref);
@@ -528,6 +578,13 @@ extern void vpi_control(PLI_INT32 operation, ...);
 #define vpiSetInteractiveScope 69  /* set simulator's interactive scope */
 #define __ivl_legacy_vpiStop 1
 #define __ivl_legacy_vpiFinish 2
+  /* Icarus extension: save a checkpoint of the simulation at the end
+     of the current time step. This takes the file name (a char*). */
+#define __ivl_vpiSave 0x1000100
+  /* Icarus extension: fork the snapshot runs (vvp -F) at the end of
+     the current time step. This takes the reason why the runs cannot
+     be forked (a char*), or nil if they can. */
+#define __ivl_vpiSnapshot 0x1000101
 
 /* vpi_sim_control is the incorrect name for vpi_control. */
 extern void vpi_sim_control(PLI_INT32 operation, ...);
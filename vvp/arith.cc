@@ -86,7 +86,7 @@ void vvp_arith_abs::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    break;
       }
 
-      ptr.ptr()->send_vec4(out, 0);
+      out_.send(ptr.ptr(), out);
 }
 
 void vvp_arith_abs::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
@@ -114,7 +114,7 @@ vvp_arith_cast_int::~vvp_arith_cast_int()
 void vvp_arith_cast_int::recv_real(vvp_net_ptr_t ptr, double bit,
                                    vvp_context_t)
 {
-      ptr.ptr()->send_vec4(vvp_vector4_t(wid_, bit), 0);
+      out_.send(ptr.ptr(), vvp_vector4_t(wid_, bit));
 }
 
 vvp_arith_cast_real::vvp_arith_cast_real(bool signed_flag)
@@ -153,14 +153,14 @@ vvp_arith_cast_vec2::~vvp_arith_cast_vec2()
 void vvp_arith_cast_vec2::recv_real(vvp_net_ptr_t ptr, double bit,
                                    vvp_context_t)
 {
-      ptr.ptr()->send_vec4(vvp_vector4_t(wid_, bit), 0);
+      out_.send(ptr.ptr(), vvp_vector4_t(wid_, bit));
 }
 
 void vvp_arith_cast_vec2::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
                                     vvp_context_t)
 {
       vvp_vector2_t tmp = vvp_vector2_t(bit);
-      ptr.ptr()->send_vec4(vector2_to_vector4(tmp,wid_), 0);
+      out_.send(ptr.ptr(), vector2_to_vector4(tmp,wid_));
 }
 
 void vvp_arith_cast_vec2::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
@@ -184,13 +184,13 @@ void vvp_arith_div::wide4_(vvp_net_ptr_t ptr)
 {
       vvp_vector2_t a2 (op_a_, true);
       if (a2.is_NaN()) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
       vvp_vector2_t b2 (op_b_, true);
       if (b2.is_NaN() || b2.is_zero()) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
@@ -207,7 +207,7 @@ void vvp_arith_div::wide4_(vvp_net_ptr_t ptr)
       }
       vvp_vector2_t res = a2 / b2;
       if (negate) res = -res;
-      ptr.ptr()->send_vec4(vector2_to_vector4(res, wid_), 0);
+      out_.send(ptr.ptr(), vector2_to_vector4(res, wid_));
 }
 
 void vvp_arith_div::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
@@ -222,13 +222,13 @@ void vvp_arith_div::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 
       unsigned long a;
       if (! vector4_to_value(op_a_, a)) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
       unsigned long b;
       if (! vector4_to_value(op_b_, b)) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
@@ -261,7 +261,7 @@ void vvp_arith_div::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1)
 		  xval.set_bit(idx, BIT4_X);
 
-	    ptr.ptr()->send_vec4(xval, 0);
+	    out_.send(ptr.ptr(), xval);
 	    return;
       }
 
@@ -281,7 +281,7 @@ void vvp_arith_div::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    val >>= 1;
       }
 
-      ptr.ptr()->send_vec4(vval, 0);
+      out_.send(ptr.ptr(), vval);
 }
 
 
@@ -298,13 +298,13 @@ void vvp_arith_mod::wide_(vvp_net_ptr_t ptr)
 {
       vvp_vector2_t a2 (op_a_, true);
       if (a2.is_NaN()) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
       vvp_vector2_t b2 (op_b_, true);
       if (b2.is_NaN() || b2.is_zero()) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
@@ -320,7 +320,7 @@ void vvp_arith_mod::wide_(vvp_net_ptr_t ptr)
       }
       vvp_vector2_t res = a2 % b2;
       if (negate) res = -res;
-      ptr.ptr()->send_vec4(vector2_to_vector4(res, res.size()), 0);
+      out_.send(ptr.ptr(), vector2_to_vector4(res, res.size()));
 }
 
 void vvp_arith_mod::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
@@ -335,13 +335,13 @@ void vvp_arith_mod::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 
       unsigned long a;
       if (! vector4_to_value(op_a_, a)) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
       unsigned long b;
       if (! vector4_to_value(op_b_, b)) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
@@ -373,7 +373,7 @@ void vvp_arith_mod::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    for (unsigned idx = 0 ;  idx < wid_ ;  idx += 1)
 		  xval.set_bit(idx, BIT4_X);
 
-	    ptr.ptr()->send_vec4(xval, 0);
+	    out_.send(ptr.ptr(), xval);
 	    return;
       }
 
@@ -393,7 +393,7 @@ void vvp_arith_mod::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    val >>= 1;
       }
 
-      ptr.ptr()->send_vec4(vval, 0);
+      out_.send(ptr.ptr(), vval);
 }
 
 
@@ -414,14 +414,14 @@ void vvp_arith_mult::wide_(vvp_net_ptr_t ptr)
       vvp_vector2_t b2 (op_b_, true);
 
       if (a2.is_NaN() || b2.is_NaN()) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
       vvp_vector2_t result = a2 * b2;
 
       vvp_vector4_t res4 = vector2_to_vector4(result, wid_);
-      ptr.ptr()->send_vec4(res4, 0);
+      out_.send(ptr.ptr(), res4);
 }
 
 void vvp_arith_mult::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
@@ -436,13 +436,13 @@ void vvp_arith_mult::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 
       int64_t a;
       if (! vector4_to_value(op_a_, a, false, true)) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
       int64_t b;
       if (! vector4_to_value(op_b_, b, false, true)) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
@@ -459,7 +459,7 @@ void vvp_arith_mult::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    val >>= 1;
       }
 
-      ptr.ptr()->send_vec4(vval, 0);
+      out_.send(ptr.ptr(), vval);
 }
 
 
@@ -484,7 +484,7 @@ void vvp_arith_pow::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 
         // If we have an X or Z in the arguments return X.
       if (a2.is_NaN() || b2.is_NaN()) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
@@ -495,7 +495,7 @@ void vvp_arith_pow::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    double r_val = 0.0;
 	    if (vector2_to_value(a2, a_val, true)) {
 		  if (a_val == 0) {
-			ptr.ptr()->send_vec4(x_val_, 0);
+			out_.send(ptr.ptr(), x_val_);
 			return;
 		  }
 		  if (a_val == 1) {
@@ -505,11 +505,11 @@ void vvp_arith_pow::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 			r_val = b2.value(0) ? -1.0 : 1.0;
 		  }
 	    }
-	    ptr.ptr()->send_vec4(vvp_vector4_t(wid_, r_val), 0);
+	    out_.send(ptr.ptr(), vvp_vector4_t(wid_, r_val));
 	    return;
       }
 
-      ptr.ptr()->send_vec4(vector2_to_vector4(pow(a2, b2), wid_), 0);
+      out_.send(ptr.ptr(), vector2_to_vector4(pow(a2, b2), wid_));
 }
 
 
@@ -544,14 +544,14 @@ void vvp_arith_sum::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    vvp_bit4_t cur = add_with_carry(a, b, carry);
 
 	    if (cur == BIT4_X) {
-		  net->send_vec4(x_val_, 0);
+		  out_.send(net, x_val_);
 		  return;
 	    }
 
 	    value.set_bit(idx, cur);
       }
 
-      net->send_vec4(value, 0);
+      out_.send(net, value);
 }
 
 vvp_arith_sub::vvp_arith_sub(unsigned wid)
@@ -589,14 +589,14 @@ void vvp_arith_sub::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    vvp_bit4_t cur = add_with_carry(a, b, carry);
 
 	    if (cur == BIT4_X) {
-		  net->send_vec4(x_val_, 0);
+		  out_.send(net, x_val_);
 		  return;
 	    }
 
 	    value.set_bit(idx, cur);
       }
 
-      net->send_vec4(value, 0);
+      out_.send(net, value);
 }
 
 vvp_cmp_eeq::vvp_cmp_eeq(unsigned wid)
@@ -621,7 +621,7 @@ void vvp_cmp_eeq::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 
 
       vvp_net_t*net = ptr.ptr();
-      net->send_vec4(eeq, 0);
+      out_.send(net, eeq);
 }
 
 vvp_cmp_nee::vvp_cmp_nee(unsigned wid)
@@ -646,7 +646,7 @@ void vvp_cmp_nee::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 
 
       vvp_net_t*net = ptr.ptr();
-      net->send_vec4(eeq, 0);
+      out_.send(net, eeq);
 }
 
 vvp_cmp_eq::vvp_cmp_eq(unsigned wid)
@@ -693,7 +693,7 @@ void vvp_cmp_eq::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       }
 
       vvp_net_t*net = ptr.ptr();
-      net->send_vec4(res, 0);
+      out_.send(net, res);
 }
 
 vvp_cmp_eqx::vvp_cmp_eqx(unsigned wid)
@@ -736,7 +736,7 @@ void vvp_cmp_eqx::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       }
 
       vvp_net_t*net = ptr.ptr();
-      net->send_vec4(res, 0);
+      out_.send(net, res);
 }
 
 vvp_cmp_eqz::vvp_cmp_eqz(unsigned wid)
@@ -771,7 +771,7 @@ void vvp_cmp_eqz::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       }
 
       vvp_net_t*net = ptr.ptr();
-      net->send_vec4(res, 0);
+      out_.send(net, res);
 }
 
 vvp_cmp_ne::vvp_cmp_ne(unsigned wid)
@@ -818,7 +818,7 @@ void vvp_cmp_ne::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       }
 
       vvp_net_t*net = ptr.ptr();
-      net->send_vec4(res, 0);
+      out_.send(net, res);
 }
 
 
@@ -839,7 +839,7 @@ void vvp_cmp_gtge_base_::recv_vec4_base_(vvp_net_ptr_t ptr,
 	    : compare_gtge(op_a_, op_b_, out_if_equal);
       vvp_vector4_t val (1);
       val.set_bit(0, out);
-      ptr.ptr()->send_vec4(val, 0);
+      out_.send(ptr.ptr(), val);
 
       return;
 }
@@ -899,7 +899,7 @@ void vvp_cmp_weq::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       }
 
       vvp_net_t*net = ptr.ptr();
-      net->send_vec4(eeq, 0);
+      out_.send(net, eeq);
 }
 
 vvp_cmp_wne::vvp_cmp_wne(unsigned wid)
@@ -934,7 +934,7 @@ void vvp_cmp_wne::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       }
 
       vvp_net_t*net = ptr.ptr();
-      net->send_vec4(eeq, 0);
+      out_.send(net, eeq);
 }
 
 
@@ -957,7 +957,7 @@ void vvp_shiftl::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       bool overflow_flag;
       unsigned long shift;
       if (! vector4_to_value(op_b_, overflow_flag, shift)) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
@@ -970,7 +970,7 @@ void vvp_shiftl::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       for (unsigned idx = shift ;  idx < out.size() ;  idx += 1)
 	    out.set_bit(idx, op_a_.value(idx-shift));
 
-      ptr.ptr()->send_vec4(out, 0);
+      out_.send(ptr.ptr(), out);
 }
 
 vvp_shiftr::vvp_shiftr(unsigned wid, bool signed_flag)
@@ -992,7 +992,7 @@ void vvp_shiftr::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       bool overflow_flag;
       unsigned long shift;
       if (! vector4_to_value(op_b_, overflow_flag, shift)) {
-	    ptr.ptr()->send_vec4(x_val_, 0);
+	    out_.send(ptr.ptr(), x_val_);
 	    return;
       }
 
@@ -1009,7 +1009,7 @@ void vvp_shiftr::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       for (unsigned idx = 0 ;  idx < shift ;  idx += 1)
 	    out.set_bit(idx+out.size()-shift, pad);
 
-      ptr.ptr()->send_vec4(out, 0);
+      out_.send(ptr.ptr(), out);
 }
 
 
@@ -1157,7 +1157,7 @@ void vvp_cmp_eq_real::recv_real(vvp_net_ptr_t ptr, const double bit,
       if (op_a_ == op_b_) res.set_bit(0, BIT4_1);
       else res.set_bit(0, BIT4_0);
 
-      ptr.ptr()->send_vec4(res, 0);
+      out_.send(ptr.ptr(), res);
 }
 
 /* Real compare not equal. */
@@ -1174,7 +1174,7 @@ void vvp_cmp_ne_real::recv_real(vvp_net_ptr_t ptr, const double bit,
       if (op_a_ != op_b_) res.set_bit(0, BIT4_1);
       else res.set_bit(0, BIT4_0);
 
-      ptr.ptr()->send_vec4(res, 0);
+      out_.send(ptr.ptr(), res);
 }
 
 /* Real compare greater than or equal. */
@@ -1191,7 +1191,7 @@ void vvp_cmp_ge_real::recv_real(vvp_net_ptr_t ptr, const double bit,
       if (op_a_ >= op_b_) res.set_bit(0, BIT4_1);
       else res.set_bit(0, BIT4_0);
 
-      ptr.ptr()->send_vec4(res, 0);
+      out_.send(ptr.ptr(), res);
 }
 
 /* Real compare greater than. */
@@ -1208,5 +1208,5 @@ void vvp_cmp_gt_real::recv_real(vvp_net_ptr_t ptr, const double bit,
       if (op_a_ > op_b_) res.set_bit(0, BIT4_1);
       else res.set_bit(0, BIT4_0);
 
-      ptr.ptr()->send_vec4(res, 0);
+      out_.send(ptr.ptr(), res);
 }
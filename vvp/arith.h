@@ -50,6 +50,9 @@ class vvp_arith_  : public vvp_net_fun_t {
       vvp_vector4_t op_b_;
 	// Precalculated X result for propagation.
       vvp_vector4_t x_val_;
+	// The output is recomputed from both operands when either
+	// changes, so it is often the same.
+      vvp_send_cache_vec4 out_;
 };
 
 class vvp_arith_abs : public vvp_net_fun_t {
@@ -66,6 +69,7 @@ class vvp_arith_abs : public vvp_net_fun_t {
 			unsigned base, unsigned vwid, vvp_context_t ctx);
 
     private:
+      vvp_send_cache_vec4 out_;
 };
 
 class vvp_arith_cast_int : public vvp_net_fun_t {
@@ -78,6 +82,7 @@ class vvp_arith_cast_int : public vvp_net_fun_t {
 
     private:
       unsigned wid_;
+      vvp_send_cache_vec4 out_;
 };
 
 class vvp_arith_cast_real : public vvp_net_fun_t {
@@ -110,6 +115,7 @@ class vvp_arith_cast_vec2 : public vvp_net_fun_t {
 
     private:
       unsigned wid_;
+      vvp_send_cache_vec4 out_;
 };
 
 class vvp_arith_div : public vvp_arith_ {
@@ -335,6 +341,8 @@ class vvp_arith_real_  : public vvp_net_fun_t {
     protected:
       double op_a_;
       double op_b_;
+	// For the compare functors, which have a vector output.
+      vvp_send_cache_vec4 out_;
 };
 
 
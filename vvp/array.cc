@@ -42,11 +42,35 @@ unsigned long count_net_arrays = 0;
 unsigned long count_net_array_words = 0;
 unsigned long count_var_arrays = 0;
 unsigned long count_var_array_words = 0;
+unsigned long count_var_sparse_arrays = 0;
 unsigned long count_real_arrays = 0;
 unsigned long count_real_array_words = 0;
 
 static symbol_map_s<struct __vpiArray>* array_table =0;
 
+/*
+ * Variable arrays that would take at least this many bytes of dense
+ * storage are given sparse storage, which only allocates the pages of
+ * words that are written. The size of a word is counted for one plane
+ * of bits, so 4-state arrays count it twice.
+ */
+static const uint64_t SPARSE_ARRAY_BYTES = 16 << 20;
+
+static bool array_is_sparse_(unsigned words, unsigned width, unsigned planes)
+{
+      uint64_t bytes;
+      if (width <= 8)
+	    bytes = 1;
+      else if (width <= 16)
+	    bytes = 2;
+      else if (width <= 32)
+	    bytes = 4;
+      else
+	    bytes = 8 * ((width + 63) / 64);
+
+      return (uint64_t)words * bytes * planes >= SPARSE_ARRAY_BYTES;
+}
+
 class vvp_fun_arrayport;
 static void array_attach_port(vvp_array_t, vvp_fun_arrayport*);
 
@@ -256,9 +280,7 @@ vpiHandle __vpiArray::get_iter_index(struct __vpiArrayIterator*, int idx)
 
       assert(vals4 || vals);
 
-      if (vals_words == 0) make_vals_words();
-
-      return &(vals_words[idx].as_word);
+      return &(vals_word(idx)->as_word);
 }
 
 int __vpiArray::vpi_get(int code)
@@ -324,10 +346,7 @@ vpiHandle __vpiArray::vpi_index(int index)
 	    return nets[index];
       }
 
-      if (vals_words == 0)
-	    make_vals_words();
-
-      return &(vals_words[index].as_word);
+      return &(vals_word(index)->as_word);
 }
 
 int __vpiArrayWord::as_word_t::vpi_get(int code)
@@ -822,6 +841,7 @@ vpiHandle vpip_make_array(char*label, const char*name,
       obj->vals  = 0;
       obj->vals_width = 0;
       obj->vals_words = 0;
+      obj->vals_pages = 0;
 
 	// Initialize (clear) the read-ports list.
       obj->ports_ = 0;
@@ -892,6 +912,12 @@ void __vpiArray::attach_word(unsigned addr, vpiHandle word)
 void compile_var_array(char*label, char*name, int last, int first,
 		   int msb, int lsb, char signed_flag)
 {
+      if (two_state_flag && ! vpip_peek_current_scope()->is_automatic()) {
+	    compile_var2_array(label, name, last, first, msb, lsb,
+			       signed_flag != 0);
+	    return;
+      }
+
       vpiHandle obj = vpip_make_array(label, name, first, last,
                                       signed_flag != 0);
 
@@ -902,6 +928,19 @@ void compile_var_array(char*label, char*name, int last, int first,
       if (vpip_peek_current_scope()->is_automatic()) {
             arr->vals4 = new vvp_vector4array_aa(arr->vals_width,
 						 arr->get_size());
+      } else if (array_is_sparse_(arr->get_size(), arr->vals_width, 2)) {
+            arr->vals4 = new vvp_vector4array_sparse(arr->vals_width,
+						     arr->get_size(), false);
+	    count_var_sparse_arrays += 1;
+      } else if (arr->vals_width <= 8) {
+            arr->vals4 = new vvp_vector4array_packed<uint8_t,false>(arr->vals_width,
+								    arr->get_size());
+      } else if (arr->vals_width <= 16) {
+            arr->vals4 = new vvp_vector4array_packed<uint16_t,false>(arr->vals_width,
+								     arr->get_size());
+      } else if (arr->vals_width <= 32) {
+            arr->vals4 = new vvp_vector4array_packed<uint32_t,false>(arr->vals_width,
+								     arr->get_size());
       } else {
             arr->vals4 = new vvp_vector4array_sa(arr->vals_width,
 						 arr->get_size());
@@ -929,7 +968,13 @@ void compile_var2_array(char*label, char*name, int last, int first,
       arr->vals_width = labs(msb-lsb) + 1;
 
       assert(! arr->nets);
-      if (lsb == 0 && msb == 7 && signed_flag) {
+      if (array_is_sparse_(arr->get_size(), arr->vals_width, 1)) {
+	      // A large 2-state array is kept as a sparse 4-state array
+	      // that reads 0 where it was not written and drops X and Z.
+	    arr->vals4 = new vvp_vector4array_sparse(arr->vals_width,
+						     arr->get_size(), true);
+	    count_var_sparse_arrays += 1;
+      } else if (lsb == 0 && msb == 7 && signed_flag) {
 	    arr->vals = new vvp_darray_atom<int8_t>(arr->get_size());
       } else if (lsb == 0 && msb == 7 && !signed_flag) {
 	    arr->vals = new vvp_darray_atom<uint8_t>(arr->get_size());
@@ -945,6 +990,19 @@ void compile_var2_array(char*label, char*name, int last, int first,
 	    arr->vals = new vvp_darray_atom<int64_t>(arr->get_size());
       } else if (lsb == 0 && msb == 63 && !signed_flag) {
 	    arr->vals = new vvp_darray_atom<uint64_t>(arr->get_size());
+      } else if (arr->vals_width <= 8) {
+	      // Other narrow 2-state arrays are packed one bit per bit.
+	    arr->vals4 = new vvp_vector4array_packed<uint8_t,true>(arr->vals_width,
+								   arr->get_size());
+      } else if (arr->vals_width <= 16) {
+	    arr->vals4 = new vvp_vector4array_packed<uint16_t,true>(arr->vals_width,
+								    arr->get_size());
+      } else if (arr->vals_width <= 32) {
+	    arr->vals4 = new vvp_vector4array_packed<uint32_t,true>(arr->vals_width,
+								    arr->get_size());
+      } else if (arr->vals_width <= 8*sizeof(unsigned long)) {
+	    arr->vals4 = new vvp_vector4array_packed<unsigned long,true>(arr->vals_width,
+									 arr->get_size());
       } else {
 	    arr->vals = new vvp_darray_vec2(arr->get_size(), arr->vals_width);
       }
@@ -1562,6 +1620,7 @@ void compile_array_alias(char*label, char*name, char*src)
       obj->vals  = mem->vals;
       obj->vals_width = mem->vals_width;
       obj->vals_words = mem->vals_words;
+      obj->vals_pages = mem->vals_pages;
 
       obj->ports_ = 0;
       obj->vpi_callbacks = 0;
@@ -1666,7 +1725,7 @@ void compile_array_cleanup(void)
 void memory_delete(vpiHandle item)
 {
       struct __vpiArray*arr = (struct __vpiArray*) item;
-      if (arr->vals_words) delete [] (arr->vals_words-1);
+      arr->delete_vals_words();
 
 //      if (arr->vals4) {}
 // Delete the individual words?
@@ -37,22 +37,64 @@ vpiHandle __vpiArrayBase::vpi_array_base_iterate(int code)
     return 0;
 }
 
-void __vpiArrayBase::make_vals_words()
+struct __vpiArrayWord*__vpiArrayBase::make_vals_words_(unsigned base, unsigned count)
 {
-    assert(vals_words == 0);
-    vals_words = new struct __vpiArrayWord[get_size() + 1];
+    struct __vpiArrayWord*words = new struct __vpiArrayWord[count + 2];
 
-    // Make word[-1] point to the parent.
-    vals_words->parent = this;
+    // Make word[-2] hold the base and word[-1] point to the parent.
+    words[0].base = base;
+    words[1].parent = this;
     // Now point to word-0
-    vals_words += 1;
+    words += 2;
 
-    struct __vpiArrayWord*words = vals_words;
-    for (unsigned idx = 0 ; idx < get_size() ; idx += 1) {
+    for (unsigned idx = 0 ; idx < count ; idx += 1) {
             words[idx].word0 = words;
     }
+    return words;
 }
 
+struct __vpiArrayWord*__vpiArrayBase::vals_word(unsigned idx)
+{
+    if (vals_words)
+            return vals_words + idx;
+
+    unsigned size = get_size();
+    if (vals_pages == 0 && size <= VALS_PAGE_WORDS) {
+            vals_words = make_vals_words_(0, size);
+            return vals_words + idx;
+    }
+
+    if (vals_pages == 0) {
+            unsigned npages = size / VALS_PAGE_WORDS + 1;
+            vals_pages = new struct __vpiArrayWord*[npages];
+            for (unsigned pdx = 0 ; pdx < npages ; pdx += 1)
+                    vals_pages[pdx] = 0;
+    }
+
+    unsigned page = idx / VALS_PAGE_WORDS;
+    if (vals_pages[page] == 0) {
+            unsigned base = page * VALS_PAGE_WORDS;
+            unsigned count = size - base;
+            if (count > VALS_PAGE_WORDS) count = VALS_PAGE_WORDS;
+            vals_pages[page] = make_vals_words_(base, count);
+    }
+
+    return vals_pages[page] + idx % VALS_PAGE_WORDS;
+}
+
+#ifdef CHECK_WITH_VALGRIND
+void __vpiArrayBase::delete_vals_words()
+{
+    if (vals_words) delete [] (vals_words-2);
+    if (vals_pages) {
+            unsigned npages = get_size() / VALS_PAGE_WORDS + 1;
+            for (unsigned pdx = 0 ; pdx < npages ; pdx += 1)
+                    if (vals_pages[pdx]) delete [] (vals_pages[pdx]-2);
+            delete [] vals_pages;
+    }
+}
+#endif
+
 vpiHandle __vpiArrayIterator::vpi_index(int)
 {
       if (next >= array->get_size()) {
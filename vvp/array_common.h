@@ -62,6 +62,14 @@ struct __vpiArrayIndex : public __vpiHandle {
  *
  * To then get to the parent, use word0[-1].parent.
  *
+ * Large arrays do not get all their words at once. They are instead
+ * made a page at a time (see __vpiArrayBase::vals_word) so that the
+ * handles cost memory only for the parts of the array that the vpi
+ * code looks at. Each page is an array of words of its own, and the
+ * word0[-2].base of the page holds the index of its first word, which
+ * is added to the position in the page. Arrays made of one page have
+ * a base of 0.
+ *
  * The vpiArrayWord is also used as a handle for the index (vpiIndex)
  * for the word. To make that work, return the pointer to the as_index
  * member instead of the as_word member. The result is a different set
@@ -86,9 +94,10 @@ struct __vpiArrayWord {
       union {
 	    struct __vpiArrayBase*parent;
 	    struct __vpiArrayWord*word0;
+	    unsigned base;
       };
 
-      inline unsigned get_index() const { return this - word0; }
+      inline unsigned get_index() const { return (this - word0) + (word0 - 2)->base; }
       inline struct __vpiArrayBase*get_parent() const { return (word0 - 1)->parent; }
 };
 
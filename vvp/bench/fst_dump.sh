@@ -0,0 +1,36 @@
+#!/bin/sh
+#
+# Run the fst_dump.v benchmark with each of the FST writer settings,
+# and print the wall clock time and the dump file size of each run.
+# The arguments are passed on to iverilog, to set the parameters of
+# the design. Set IVERILOG and VVP to use other builds of the tools.
+#
+# The first line is the run without a dump, for reference.
+
+IVERILOG=${IVERILOG:-iverilog}
+VVP=${VVP:-vvp}
+dir=$(dirname "$0")
+
+"$IVERILOG" -o fst_dump.vvp "$@" "$dir/fst_dump.v" || exit 1
+
+run() {
+      rm -f fst_dump.fst
+      start=$(date +%s.%N)
+      "$VVP" -n fst_dump.vvp -dumpfile=fst_dump "$@" > /dev/null || exit 1
+      end=$(date +%s.%N)
+      size=0
+      if [ -f fst_dump.fst ] ; then
+	    size=$(wc -c < fst_dump.fst)
+      fi
+      awk "BEGIN { printf \"%-40s %6.2fs %10d bytes\\n\", \"$*\", \
+			 $end - $start, $size }"
+}
+
+run -none
+run -fst
+run -fst -fst-compress=fastlz
+run -fst -fst-compress=lz4
+run -fst -fst-blocksize=4M
+run -fst -fst-parallel
+run -fst -fst-parallel -fst-compress=lz4
+rm -f fst_dump.vvp fst_dump.fst
@@ -0,0 +1,30 @@
+/*
+ * FST dump benchmark: N registers that all change in every time step,
+ * dumped to an FST file for STEPS time steps. This compares the run
+ * time and the file size of the FST writer settings. The fst_dump.sh
+ * script in this directory runs it with each of the settings, for
+ * example:
+ *
+ *   sh fst_dump.sh
+ *   sh fst_dump.sh -Pfst_dump.N=20000
+ */
+module fst_dump;
+
+  parameter N = 4000;
+  parameter STEPS = 2000;
+
+  genvar i;
+  generate
+    for (i = 0 ; i < N ; i = i + 1) begin : sig
+      reg [15:0] val;
+      initial val = i;
+      always #1 val = val * 16'd5 + 16'd1;
+    end
+  endgenerate
+
+  initial begin
+    $dumpvars(0, fst_dump);
+    #(STEPS) $finish(0);
+  end
+
+endmodule
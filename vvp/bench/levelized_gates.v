@@ -0,0 +1,46 @@
+/*
+ * Levelized logic benchmark: a wide gate level netlist where most of
+ * the gates change in every time step. This times the parallel gate
+ * evaluation of "vvp -j" against "vvp -L" alone. The network is N
+ * bits wide and DEPTH gates deep, and the input changes STEPS times.
+ * For example:
+ *
+ *   iverilog -o levelized_gates.vvp -Plevelized_gates.N=16384 levelized_gates.v
+ *   vvp -v -L levelized_gates.vvp
+ *   vvp -v -j4 levelized_gates.vvp
+ */
+module levelized_gates;
+
+  parameter N = 4096;
+  parameter DEPTH = 8;
+  parameter STEPS = 2000;
+
+  reg  [N-1:0] in;
+  wire [N*(DEPTH+1)-1:0] net;
+  integer idx;
+
+  assign net[N-1:0] = in;
+
+  genvar d, i;
+  generate
+    for (d = 0 ; d < DEPTH ; d = d + 1) begin : stage
+      for (i = 0 ; i < N ; i = i + 1) begin : bit
+	if (d % 2 == 0) begin : x
+	  xor (net[(d+1)*N+i], net[d*N+i], net[d*N+(i+1)%N]);
+	end else begin : xn
+	  xnor (net[(d+1)*N+i], net[d*N+i], net[d*N+(i+3)%N]);
+	end
+      end
+    end
+  endgenerate
+
+  initial begin
+    in = {N/32{32'h9e3779b9}};
+    for (idx = 0 ; idx < STEPS ; idx = idx + 1) begin
+      in = in * 32'd1103515245 + 32'd12345;
+      #1;
+    end
+    $display("out = %h", net[N*(DEPTH+1)-1 -: 32]);
+  end
+
+endmodule
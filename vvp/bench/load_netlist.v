@@ -0,0 +1,41 @@
+/*
+ * Load time benchmark: a gate level ripple carry adder of N bits,
+ * which is about 6*N functors and as many labels in the compiled
+ * design. Almost all of the time to load it goes into reading and
+ * linking the netlist, so this compares the load time of the text
+ * design file with that of the binary form that "vvp -B" writes:
+ *
+ *   iverilog -o load_netlist.vvp -Pload_netlist.N=30000 load_netlist.v
+ *   vvp -B load_netlist.vvpb load_netlist.vvp
+ *   vvp -v load_netlist.vvp
+ *   vvp -v load_netlist.vvpb
+ */
+module load_netlist;
+
+  parameter N = 10000;
+
+  reg  [N-1:0] a, b;
+  wire [N-1:0] sum;
+  wire [N:0]   carry;
+
+  assign carry[0] = 1'b0;
+
+  genvar i;
+  generate
+    for (i = 0 ; i < N ; i = i + 1) begin : bit
+      wire p, g, t;
+      xor (p, a[i], b[i]);
+      and (g, a[i], b[i]);
+      xor (sum[i], p, carry[i]);
+      and (t, p, carry[i]);
+      or  (carry[i+1], g, t);
+    end
+  endgenerate
+
+  initial begin
+    a = 1;
+    b = -1;
+    #1 $display("carry out %b", carry[N]);
+  end
+
+endmodule
@@ -0,0 +1,35 @@
+/*
+ * Scheduler benchmark: keep N events pending at N distinct future
+ * times. The cost of inserting into and pulling from the event queue
+ * dominates the run time, so this shows how the scheduler scales with
+ * the number of distinct pending times. Set N on the command line,
+ * for example:
+ *
+ *   iverilog -o sched_times.vvp -Psched_times.N=100000 sched_times.v
+ *   vvp -v sched_times.vvp
+ */
+module sched_times;
+
+  parameter N = 10000;
+  parameter ROUNDS = 4;
+
+  reg [31:0] sink;
+  integer seed;
+  integer idx;
+  integer round;
+  integer count;
+
+  initial begin
+    count = 0;
+    seed = 1;
+    for (round = 0 ; round < ROUNDS ; round = round + 1) begin
+      for (idx = 0 ; idx < N ; idx = idx + 1)
+	sink <= #({$random(seed)} % 1000000000 + 1) idx;
+      #1000000001;
+    end
+    $display("%0d events at %0d distinct times per round", count, N);
+  end
+
+  always @(sink) count = count + 1;
+
+endmodule
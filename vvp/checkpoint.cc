@@ -0,0 +1,976 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "version_base.h"
+# include  "checkpoint.h"
+# include  "codes.h"
+# include  "event.h"
+# include  "fanout.h"
+# include  "schedule.h"
+# include  "vpi_priv.h"
+# include  "vvp_darray.h"
+# include  "vvp_net_sig.h"
+# include  <cassert>
+# include  <cstdio>
+# include  <cstring>
+
+using namespace std;
+
+static const char checkpoint_magic[] = "vvp checkpoint";
+static const uint64_t checkpoint_version = 2;
+
+const char*checkpoint_restore_path = 0;
+
+/*
+ * Scopes and arrays are numbered in the order that a walk of the
+ * scope tree finds them, which is the same for every run of a design.
+ */
+static void checkpoint_walk_scope_(__vpiScope*scope,
+				   vector<__vpiScope*>&scopes,
+				   vector<__vpiArray*>&arrays)
+{
+      scopes.push_back(scope);
+      for (size_t idx = 0 ; idx < scope->intern.size() ; idx += 1) {
+	    vpiHandle item = scope->intern[idx];
+	    if (__vpiScope*sub = dynamic_cast<__vpiScope*>(item))
+		  checkpoint_walk_scope_(sub, scopes, arrays);
+	    else if (__vpiArray*arr = dynamic_cast<__vpiArray*>(item))
+		  arrays.push_back(arr);
+      }
+}
+
+static void checkpoint_design_tables_(vector<__vpiScope*>&scopes,
+				      vector<__vpiArray*>&arrays)
+{
+      __vpiHandle**table;
+      unsigned ntable;
+      vpip_make_root_iterator(table, ntable);
+      for (unsigned idx = 0 ; idx < ntable ; idx += 1) {
+	    if (__vpiScope*scope = dynamic_cast<__vpiScope*>(table[idx]))
+		  checkpoint_walk_scope_(scope, scopes, arrays);
+      }
+}
+
+/*
+ * The fanout nets (vvp -f) are made after the nets of the design, so
+ * they do not change the indices of those, and they are not counted,
+ * so a checkpoint can be restored with or without them.
+ */
+static void checkpoint_count_net_(vvp_net_t*net, void*cd)
+{
+      if (dynamic_cast<vvp_fun_fanout*>(net->fun))
+	    return;
+      *static_cast<uint64_t*>(cd) += 1;
+}
+
+static uint64_t checkpoint_hash_(uint64_t hash, const char*text)
+{
+      for ( ; *text ; text += 1) {
+	    hash ^= (unsigned char)*text;
+	    hash *= 0x100000001b3ULL;
+      }
+      return hash * 0x100000001b3ULL;
+}
+
+/*
+ * The fingerprint of a design covers the number of nets and the names
+ * and shapes of the scopes and arrays. It is not proof that the design
+ * is the same, but it catches a checkpoint given to the wrong design.
+ */
+static uint64_t checkpoint_fingerprint_(void)
+{
+      uint64_t nets = 0;
+      vvp_net_for_each(&checkpoint_count_net_, &nets);
+
+      vector<__vpiScope*> scopes;
+      vector<__vpiArray*> arrays;
+      checkpoint_design_tables_(scopes, arrays);
+
+      uint64_t hash = 0xcbf29ce484222325ULL ^ nets;
+      for (size_t idx = 0 ; idx < scopes.size() ; idx += 1)
+	    hash = checkpoint_hash_(hash, scopes[idx]->scope_name());
+      for (size_t idx = 0 ; idx < arrays.size() ; idx += 1) {
+	    hash = checkpoint_hash_(hash, arrays[idx]->name);
+	    hash ^= arrays[idx]->get_size();
+      }
+      return hash;
+}
+
+vvp_checkpoint_out::vvp_checkpoint_out()
+: root_(this), refused_(false), tables_loaded_(false)
+{
+}
+
+vvp_checkpoint_out::vvp_checkpoint_out(vvp_checkpoint_out&parent)
+: root_(parent.root_), refused_(false), tables_loaded_(false)
+{
+}
+
+vvp_checkpoint_out::~vvp_checkpoint_out()
+{
+}
+
+void vvp_checkpoint_out::put_uint(uint64_t val)
+{
+      while (val >= 0x80) {
+	    buf_.push_back((val & 0x7f) | 0x80);
+	    val >>= 7;
+      }
+      buf_.push_back(val);
+}
+
+void vvp_checkpoint_out::put_int(int64_t val)
+{
+      uint64_t tmp = val;
+      put_uint(val < 0? ~(tmp << 1) : tmp << 1);
+}
+
+void vvp_checkpoint_out::put_real(double val)
+{
+      uint64_t tmp;
+      memcpy(&tmp, &val, sizeof tmp);
+      for (unsigned idx = 0 ; idx < 8 ; idx += 1) {
+	    buf_.push_back(tmp & 0xff);
+	    tmp >>= 8;
+      }
+}
+
+void vvp_checkpoint_out::put_string(const string&val)
+{
+      put_uint(val.size());
+      buf_.insert(buf_.end(), val.begin(), val.end());
+}
+
+/*
+ * Vectors are written four bits to a byte.
+ */
+void vvp_checkpoint_out::put_vec4(const vvp_vector4_t&val)
+{
+      unsigned wid = val.size();
+      put_uint(wid);
+      for (unsigned idx = 0 ; idx < wid ; idx += 4) {
+	    unsigned char byte = 0;
+	    for (unsigned bit = 0 ; bit < 4 && idx+bit < wid ; bit += 1)
+		  byte |= val.value(idx+bit) << (2*bit);
+	    buf_.push_back(byte);
+      }
+}
+
+void vvp_checkpoint_out::put_vec8(const vvp_vector8_t&val)
+{
+      unsigned wid = val.size();
+      put_uint(wid);
+      for (unsigned idx = 0 ; idx < wid ; idx += 1)
+	    buf_.push_back(val.value(idx).raw());
+}
+
+void vvp_checkpoint_out::put_bits(const vvp_bit4_t*bits, unsigned count)
+{
+      for (unsigned idx = 0 ; idx < count ; idx += 4) {
+	    unsigned char byte = 0;
+	    for (unsigned bit = 0 ; bit < 4 && idx+bit < count ; bit += 1)
+		  byte |= bits[idx+bit] << (2*bit);
+	    buf_.push_back(byte);
+      }
+}
+
+void vvp_checkpoint_out::load_tables_()
+{
+      if (tables_loaded_)
+	    return;
+
+      vector<__vpiScope*> scopes;
+      vector<__vpiArray*> arrays;
+      checkpoint_design_tables_(scopes, arrays);
+      for (size_t idx = 0 ; idx < scopes.size() ; idx += 1)
+	    scope_map_[scopes[idx]] = idx;
+      for (size_t idx = 0 ; idx < arrays.size() ; idx += 1)
+	    array_map_[arrays[idx]] = idx;
+      tables_loaded_ = true;
+}
+
+/*
+ * Nets, scopes and arrays are written as their index plus one, so
+ * that 0 can stand for nil.
+ */
+void vvp_checkpoint_out::put_net(const vvp_net_t*net)
+{
+      if (net == 0) {
+	    put_uint(0);
+	    return;
+      }
+
+      size_t idx = vvp_net_index(net);
+      if (idx == (size_t)-1) {
+	    refuse("an event refers to an automatic net");
+	    put_uint(0);
+	    return;
+      }
+      put_uint(idx + 1);
+}
+
+void vvp_checkpoint_out::put_code(vvp_code_t code)
+{
+      put_uint(codespace_index(code));
+}
+
+void vvp_checkpoint_out::put_scope(__vpiScope*scope)
+{
+      if (scope == 0) {
+	    put_uint(0);
+	    return;
+      }
+
+      root_->load_tables_();
+      map<__vpiScope*,size_t>::const_iterator cur = root_->scope_map_.find(scope);
+      if (cur == root_->scope_map_.end()) {
+	    refuse(string("scope ") + scope->scope_name() + " is not in the design");
+	    put_uint(0);
+	    return;
+      }
+      put_uint(cur->second + 1);
+}
+
+void vvp_checkpoint_out::put_array(__vpiArray*array)
+{
+      if (array == 0) {
+	    put_uint(0);
+	    return;
+      }
+
+      root_->load_tables_();
+      map<__vpiArray*,size_t>::const_iterator cur = root_->array_map_.find(array);
+      if (cur == root_->array_map_.end()) {
+	    refuse(string("array ") + array->name + " is not in the design");
+	    put_uint(0);
+	    return;
+      }
+      put_uint(cur->second + 1);
+}
+
+void vvp_checkpoint_out::put_thread(vthread_t thr)
+{
+      map<vthread_t,size_t>::const_iterator cur = root_->thread_map_.find(thr);
+      if (cur != root_->thread_map_.end()) {
+	    put_uint(cur->second);
+	    return;
+      }
+
+      size_t idx = root_->thread_list_.size();
+      root_->thread_map_[thr] = idx;
+      root_->thread_list_.push_back(thr);
+      put_uint(idx);
+}
+
+size_t vvp_checkpoint_out::thread_count() const
+{
+      return root_->thread_list_.size();
+}
+
+vthread_t vvp_checkpoint_out::thread(size_t idx) const
+{
+      return root_->thread_list_[idx];
+}
+
+void vvp_checkpoint_out::append(const vvp_checkpoint_out&that)
+{
+      buf_.insert(buf_.end(), that.buf_.begin(), that.buf_.end());
+}
+
+void vvp_checkpoint_out::refuse(const string&why)
+{
+      if (root_->refused_)
+	    return;
+      root_->refused_ = true;
+      root_->reason_ = why;
+}
+
+bool vvp_checkpoint_out::write(const char*path) const
+{
+      FILE*fd = fopen(path, "wb");
+      if (fd == 0)
+	    return false;
+
+      size_t cnt = buf_.empty()? 0 : fwrite(&buf_[0], 1, buf_.size(), fd);
+      bool rc = cnt == buf_.size();
+      if (fclose(fd) != 0)
+	    rc = false;
+      return rc;
+}
+
+vvp_checkpoint_in::vvp_checkpoint_in()
+: pos_(0), bad_(false)
+{
+}
+
+vvp_checkpoint_in::~vvp_checkpoint_in()
+{
+}
+
+bool vvp_checkpoint_in::read(const char*path)
+{
+      FILE*fd = fopen(path, "rb");
+      if (fd == 0)
+	    return false;
+
+      unsigned char tmp[8192];
+      size_t cnt;
+      while ((cnt = fread(tmp, 1, sizeof tmp, fd)) > 0)
+	    buf_.insert(buf_.end(), tmp, tmp+cnt);
+
+      bool rc = ferror(fd) == 0;
+      fclose(fd);
+      pos_ = 0;
+      return rc;
+}
+
+uint64_t vvp_checkpoint_in::get_uint()
+{
+      uint64_t val = 0;
+      for (unsigned shift = 0 ; shift < 64 ; shift += 7) {
+	    if (pos_ >= buf_.size()) {
+		  error("the checkpoint is truncated");
+		  return 0;
+	    }
+	    unsigned char byte = buf_[pos_++];
+	    val |= (uint64_t)(byte & 0x7f) << shift;
+	    if ((byte & 0x80) == 0)
+		  return val;
+      }
+      error("bad number");
+      return 0;
+}
+
+int64_t vvp_checkpoint_in::get_int()
+{
+      uint64_t tmp = get_uint();
+      return (tmp & 1)? ~(tmp >> 1) : (tmp >> 1);
+}
+
+double vvp_checkpoint_in::get_real()
+{
+      if (buf_.size() - pos_ < 8) {
+	    error("the checkpoint is truncated");
+	    pos_ = buf_.size();
+	    return 0.0;
+      }
+
+      uint64_t tmp = 0;
+      for (unsigned idx = 0 ; idx < 8 ; idx += 1)
+	    tmp |= (uint64_t)buf_[pos_++] << (8*idx);
+
+      double val;
+      memcpy(&val, &tmp, sizeof val);
+      return val;
+}
+
+string vvp_checkpoint_in::get_string()
+{
+      uint64_t len = get_uint();
+      if (bad_ || buf_.size() - pos_ < len) {
+	    error("the checkpoint is truncated");
+	    pos_ = buf_.size();
+	    return string();
+      }
+
+      string val ((const char*)&buf_[pos_], len);
+      pos_ += len;
+      return val;
+}
+
+vvp_vector4_t vvp_checkpoint_in::get_vec4()
+{
+      uint64_t wid = get_uint();
+      if (bad_ || (buf_.size() - pos_) < (wid+3)/4) {
+	    error("the checkpoint is truncated");
+	    pos_ = buf_.size();
+	    return vvp_vector4_t();
+      }
+
+      vvp_vector4_t val (wid);
+      for (unsigned idx = 0 ; idx < wid ; idx += 4) {
+	    unsigned char byte = buf_[pos_++];
+	    for (unsigned bit = 0 ; bit < 4 && idx+bit < wid ; bit += 1)
+		  val.set_bit(idx+bit, (vvp_bit4_t)((byte >> (2*bit)) & 3));
+      }
+      return val;
+}
+
+vvp_vector8_t vvp_checkpoint_in::get_vec8()
+{
+      uint64_t wid = get_uint();
+      if (bad_ || (buf_.size() - pos_) < wid) {
+	    error("the checkpoint is truncated");
+	    pos_ = buf_.size();
+	    return vvp_vector8_t();
+      }
+
+      vvp_vector8_t val (wid);
+      for (unsigned idx = 0 ; idx < wid ; idx += 1)
+	    val.set_bit(idx, vvp_scalar_t(buf_[pos_++]));
+      return val;
+}
+
+void vvp_checkpoint_in::get_bits(vvp_bit4_t*bits, unsigned count)
+{
+      if ((buf_.size() - pos_) < (count+3)/4) {
+	    error("the checkpoint is truncated");
+	    pos_ = buf_.size();
+	    return;
+      }
+
+      for (unsigned idx = 0 ; idx < count ; idx += 4) {
+	    unsigned char byte = buf_[pos_++];
+	    for (unsigned bit = 0 ; bit < 4 && idx+bit < count ; bit += 1)
+		  bits[idx+bit] = (vvp_bit4_t)((byte >> (2*bit)) & 3);
+      }
+}
+
+vvp_net_t* vvp_checkpoint_in::get_net()
+{
+      uint64_t idx = get_uint();
+      if (idx == 0)
+	    return 0;
+
+      vvp_net_t*net = vvp_net_at(idx-1);
+      if (net == 0)
+	    error("bad net");
+      return net;
+}
+
+vvp_code_t vvp_checkpoint_in::get_code()
+{
+      vvp_code_t code = codespace_address(get_uint());
+      if (code == 0)
+	    error("bad code address");
+      return code;
+}
+
+void vvp_checkpoint_in::load_tables_()
+{
+      if (scopes_.empty())
+	    checkpoint_design_tables_(scopes_, arrays_);
+}
+
+__vpiScope* vvp_checkpoint_in::get_scope()
+{
+      uint64_t idx = get_uint();
+      if (idx == 0)
+	    return 0;
+
+      load_tables_();
+      if (idx > scopes_.size()) {
+	    error("bad scope");
+	    return 0;
+      }
+      return scopes_[idx-1];
+}
+
+__vpiArray* vvp_checkpoint_in::get_array()
+{
+      uint64_t idx = get_uint();
+      if (idx == 0)
+	    return 0;
+
+      load_tables_();
+      if (idx > arrays_.size()) {
+	    error("bad array");
+	    return 0;
+      }
+      return arrays_[idx-1];
+}
+
+void vvp_checkpoint_in::add_thread(vthread_t thr)
+{
+      threads_.push_back(thr);
+}
+
+vthread_t vvp_checkpoint_in::get_thread()
+{
+      uint64_t idx = get_uint();
+      if (idx >= threads_.size()) {
+	    error("bad thread");
+	    return 0;
+      }
+      return threads_[idx];
+}
+
+void vvp_checkpoint_in::send_later(vvp_net_t*net, const vvp_vector4_t&val)
+{
+      out4_.push_back(make_pair(net, val));
+}
+
+void vvp_checkpoint_in::send_later(vvp_net_t*net, const vvp_vector8_t&val)
+{
+      out8_.push_back(make_pair(net, val));
+}
+
+void vvp_checkpoint_in::send_later(vvp_net_t*net, double val)
+{
+      outr_.push_back(make_pair(net, val));
+}
+
+void vvp_checkpoint_in::send_outputs()
+{
+      for (size_t idx = 0 ; idx < out4_.size() ; idx += 1)
+	    out4_[idx].first->send_vec4(out4_[idx].second, 0);
+      for (size_t idx = 0 ; idx < out8_.size() ; idx += 1)
+	    out8_[idx].first->send_vec8(out8_[idx].second);
+      for (size_t idx = 0 ; idx < outr_.size() ; idx += 1)
+	    outr_[idx].first->send_real(outr_[idx].second, 0);
+      out4_.clear();
+      out8_.clear();
+      outr_.clear();
+}
+
+void vvp_checkpoint_in::error(const string&why)
+{
+      if (bad_)
+	    return;
+      bad_ = true;
+      reason_ = why;
+}
+
+/*
+ * The functor section has a record for each functor with state to
+ * save, as the net index plus one followed by whatever the functor
+ * writes. The nets are counted as they are visited so that the
+ * index does not need to be looked up.
+ */
+struct checkpoint_walk_s {
+      vvp_checkpoint_out*out;
+      size_t idx;
+};
+
+static void checkpoint_save_functor_(vvp_net_t*net, void*cd)
+{
+      checkpoint_walk_s*walk = static_cast<checkpoint_walk_s*>(cd);
+      size_t idx = walk->idx++;
+      if (net->fun == 0)
+	    return;
+
+      size_t mark = walk->out->size();
+      walk->out->put_uint(idx + 1);
+      if (! net->fun->save_state(*walk->out))
+	    walk->out->truncate(mark);
+}
+
+enum { CP_SIG_VEC4 = 1, CP_SIG_REAL, CP_SIG_STRING };
+
+/*
+ * Only the variables are saved. The values of the nets follow from
+ * the variables and the functors once they are restored, but a net
+ * that is forced cannot be expressed that way.
+ */
+static void checkpoint_save_signal_(vvp_net_t*net, void*cd)
+{
+      checkpoint_walk_s*walk = static_cast<checkpoint_walk_s*>(cd);
+      vvp_checkpoint_out&out = *walk->out;
+      size_t idx = walk->idx++;
+
+      if (net->fil && net->fil->is_forced()) {
+	    out.refuse("a signal is forced");
+	    return;
+      }
+
+      vvp_fun_signal_base*sig = dynamic_cast<vvp_fun_signal_base*>(net->fun);
+      if (sig == 0)
+	    return;
+      if (sig->is_assigned()) {
+	    out.refuse("a signal is procedurally assigned");
+	    return;
+      }
+
+      if (vvp_fun_signal4_sa*fun4 = dynamic_cast<vvp_fun_signal4_sa*>(sig)) {
+	    out.put_uint(idx + 1);
+	    out.put_uint(CP_SIG_VEC4);
+	    out.put_vec4(fun4->vec4_unfiltered_value());
+
+      } else if (vvp_fun_signal_real_sa*funr = dynamic_cast<vvp_fun_signal_real_sa*>(sig)) {
+	    out.put_uint(idx + 1);
+	    out.put_uint(CP_SIG_REAL);
+	    out.put_real(funr->real_unfiltered_value());
+
+      } else if (vvp_fun_signal_string_sa*funs = dynamic_cast<vvp_fun_signal_string_sa*>(sig)) {
+	    out.put_uint(idx + 1);
+	    out.put_uint(CP_SIG_STRING);
+	    out.put_string(funs->get_string());
+
+      } else if (vvp_fun_signal_object_sa*funo = dynamic_cast<vvp_fun_signal_object_sa*>(sig)) {
+	    if (! funo->get_object().test_nil())
+		  out.refuse("a class or dynamic array variable is not null");
+      }
+}
+
+static void checkpoint_save_arrays_(vvp_checkpoint_out&out,
+				    const vector<__vpiArray*>&arrays)
+{
+      for (size_t idx = 0 ; idx < arrays.size() ; idx += 1) {
+	    __vpiArray*arr = arrays[idx];
+	    unsigned size = arr->get_size();
+
+	    if (arr->vals4) {
+		    // Only the pages of a sparse array that were written
+		    // are saved, as runs of words that end with a 0.
+		  out.put_uint(idx + 1);
+		  out.put_uint(CP_SIG_VEC4);
+		  out.put_uint(size);
+		  unsigned adr = arr->vals4->next_stored(0);
+		  while (adr < size) {
+			unsigned end = adr + 1;
+			while (end < size && arr->vals4->next_stored(end) == end)
+			      end += 1;
+			out.put_uint(adr + 1);
+			out.put_uint(end - adr);
+			for ( ; adr < end ; adr += 1)
+			      out.put_vec4(arr->get_word(adr));
+			adr = arr->vals4->next_stored(end);
+		  }
+		  out.put_uint(0);
+
+	    } else if (dynamic_cast<vvp_darray_real*>(arr->vals)) {
+		  out.put_uint(idx + 1);
+		  out.put_uint(CP_SIG_REAL);
+		  out.put_uint(size);
+		  for (unsigned adr = 0 ; adr < size ; adr += 1)
+			out.put_real(arr->get_word_r(adr));
+
+	    } else if (dynamic_cast<vvp_darray_string*>(arr->vals)) {
+		  out.put_uint(idx + 1);
+		  out.put_uint(CP_SIG_STRING);
+		  out.put_uint(size);
+		  for (unsigned adr = 0 ; adr < size ; adr += 1)
+			out.put_string(arr->get_word_str(adr));
+
+	    } else if (arr->vals && ! dynamic_cast<vvp_darray_object*>(arr->vals)) {
+		    // A 2-state array.
+		  out.put_uint(idx + 1);
+		  out.put_uint(CP_SIG_VEC4);
+		  out.put_uint(size);
+		  if (size > 0) {
+			out.put_uint(1);
+			out.put_uint(size);
+			for (unsigned adr = 0 ; adr < size ; adr += 1)
+			      out.put_vec4(arr->get_word(adr));
+		  }
+		  out.put_uint(0);
+
+	    } else if (arr->vals) {
+		  for (unsigned adr = 0 ; adr < size ; adr += 1) {
+			vvp_object_t obj;
+			arr->get_word_obj(adr, obj);
+			if (! obj.test_nil()) {
+			      out.refuse("a class array word is not null");
+			      return;
+			}
+		  }
+	    }
+      }
+      out.put_uint(0);
+}
+
+static void checkpoint_save_waits_(vvp_net_t*net, void*cd)
+{
+      checkpoint_walk_s*walk = static_cast<checkpoint_walk_s*>(cd);
+      vvp_checkpoint_out&out = *walk->out;
+      size_t idx = walk->idx++;
+
+      waitable_hooks_s*ep = dynamic_cast<waitable_hooks_s*>(net->fun);
+      if (ep == 0)
+	    return;
+      if (ep->event_ctls) {
+	    out.refuse("an intra-assignment event control is pending");
+	    return;
+      }
+
+      vthread_t*list = ep->waiting_threads();
+      if (list == 0 || *list == 0)
+	    return;
+
+      out.put_uint(idx + 1);
+      vthread_checkpoint_put_list(out, *list);
+}
+
+static void checkpoint_put_header_(vvp_checkpoint_out&out)
+{
+      out.put_string(checkpoint_magic);
+      out.put_uint(checkpoint_version);
+      out.put_string(VERSION);
+      out.put_uint(checkpoint_fingerprint_());
+}
+
+static bool checkpoint_save_(const char*path, string&why)
+{
+      vvp_checkpoint_out out;
+      checkpoint_put_header_(out);
+      out.put_uint(schedule_simtime());
+
+      vector<__vpiScope*> scopes;
+      vector<__vpiArray*> arrays;
+      checkpoint_design_tables_(scopes, arrays);
+      for (size_t idx = 0 ; idx < scopes.size() ; idx += 1) {
+	    if (scopes[idx]->live_contexts)
+		  out.refuse("an automatic task or function is active");
+      }
+
+      checkpoint_walk_s walk;
+      walk.out = &out;
+      walk.idx = 0;
+      vvp_net_for_each(&checkpoint_save_functor_, &walk);
+      out.put_uint(0);
+
+      walk.idx = 0;
+      vvp_net_for_each(&checkpoint_save_signal_, &walk);
+      out.put_uint(0);
+
+      checkpoint_save_arrays_(out, arrays);
+
+	// The events and the waits name the threads that the thread
+	// table must hold, so they are written first and appended
+	// after the table.
+      vvp_checkpoint_out events (out);
+      schedule_checkpoint_save(events);
+
+      vvp_checkpoint_out waits (out);
+      walk.out = &waits;
+      walk.idx = 0;
+      vvp_net_for_each(&checkpoint_save_waits_, &walk);
+      waits.put_uint(0);
+
+      vthread_checkpoint_save(out);
+      out.append(events);
+      out.append(waits);
+
+      vpip_mcd_checkpoint_save(out);
+
+      if (out.refused()) {
+	    why = out.reason();
+	    return false;
+      }
+      if (! out.write(path)) {
+	    why = "cannot write the file";
+	    return false;
+      }
+      return true;
+}
+
+/*
+ * The save is an event in the read-only sync region of the time step
+ * of the $save call, so that the time step is complete when it runs.
+ */
+struct checkpoint_save_event_s : public vvp_gen_event_s {
+      explicit checkpoint_save_event_s(const char*p) : path(p) { }
+      void run_run();
+      string path;
+};
+
+void checkpoint_save_event_s::run_run()
+{
+      string why;
+      if (! checkpoint_save_(path.c_str(), why)) {
+	    fprintf(stderr, "Error: cannot save checkpoint %s: %s.\n",
+		    path.c_str(), why.c_str());
+      }
+}
+
+void checkpoint_schedule_save(const char*path)
+{
+      schedule_generic(new checkpoint_save_event_s(path), 0, true, true, true);
+}
+
+/*
+ * The threads waiting on events are put back at the end of the
+ * restore time step, so that the changes that restoring the values
+ * makes in that time step do not wake them.
+ */
+struct checkpoint_waits_event_s : public vvp_gen_event_s {
+      void run_run();
+      vector<pair<vthread_t*,vthread_t> > lists;
+};
+
+void checkpoint_waits_event_s::run_run()
+{
+      for (size_t idx = 0 ; idx < lists.size() ; idx += 1) {
+	    assert(*lists[idx].first == 0);
+	    *lists[idx].first = lists[idx].second;
+      }
+}
+
+static bool checkpoint_restore_signals_(vvp_checkpoint_in&in)
+{
+      while (vvp_net_t*net = in.get_net()) {
+	    vvp_net_ptr_t ptr (net, 0);
+	    switch (in.get_uint()) {
+		case CP_SIG_VEC4:
+		  if (dynamic_cast<vvp_fun_signal4_sa*>(net->fun) == 0)
+			break;
+		  vvp_send_vec4(ptr, in.get_vec4(), 0);
+		  continue;
+		case CP_SIG_REAL:
+		  if (dynamic_cast<vvp_fun_signal_real_sa*>(net->fun) == 0)
+			break;
+		  vvp_send_real(ptr, in.get_real(), 0);
+		  continue;
+		case CP_SIG_STRING:
+		  if (dynamic_cast<vvp_fun_signal_string_sa*>(net->fun) == 0)
+			break;
+		  vvp_send_string(ptr, in.get_string(), 0);
+		  continue;
+		default:
+		  break;
+	    }
+	    in.error("bad signal");
+	    return false;
+      }
+      return !in.bad();
+}
+
+static bool checkpoint_restore_arrays_(vvp_checkpoint_in&in)
+{
+      while (__vpiArray*arr = in.get_array()) {
+	    unsigned kind = in.get_uint();
+	    uint64_t size = in.get_uint();
+	    if (size != arr->get_size()) {
+		  in.error(string("array ") + arr->name + " has the wrong size");
+		  return false;
+	    }
+
+	    if (kind == CP_SIG_VEC4 && (arr->vals4 || arr->vals)) {
+		  while (uint64_t adr = in.get_uint()) {
+			uint64_t count = in.get_uint();
+			adr -= 1;
+			if (adr + count > size) {
+			      in.error(string("array ") + arr->name + " has a bad word");
+			      return false;
+			}
+			for (uint64_t end = adr + count ; adr < end && !in.bad() ; adr += 1)
+			      arr->set_word(adr, 0, in.get_vec4());
+		  }
+		  continue;
+	    }
+
+	    for (unsigned adr = 0 ; adr < size && !in.bad() ; adr += 1) {
+		  if (kind == CP_SIG_REAL && dynamic_cast<vvp_darray_real*>(arr->vals)) {
+			arr->set_word(adr, in.get_real());
+		  } else if (kind == CP_SIG_STRING && dynamic_cast<vvp_darray_string*>(arr->vals)) {
+			arr->set_word(adr, in.get_string());
+		  } else {
+			in.error(string("array ") + arr->name + " has the wrong type");
+			return false;
+		  }
+	    }
+      }
+      return !in.bad();
+}
+
+static bool checkpoint_restore_(vvp_checkpoint_in&in)
+{
+      if (in.get_string() != checkpoint_magic) {
+	    in.error("not a checkpoint file");
+	    return false;
+      }
+      if (in.get_uint() != checkpoint_version || in.get_string() != VERSION) {
+	    in.error("written by a different version of vvp");
+	    return false;
+      }
+      if (in.get_uint() != checkpoint_fingerprint_()) {
+	    in.error("written by a different design");
+	    return false;
+      }
+
+      vvp_time64_t time = in.get_uint();
+      if (in.bad())
+	    return false;
+      if (! schedule_checkpoint_start(time)) {
+	    in.error("events are already scheduled for later times");
+	    return false;
+      }
+
+	// Functor state first, then the outputs that go with it, so
+	// that the values that follow do not look like changes.
+      while (vvp_net_t*net = in.get_net()) {
+	    if (net->fun == 0) {
+		  in.error("bad functor");
+		  return false;
+	    }
+	    net->fun->restore_state(net, in);
+	    if (in.bad())
+		  return false;
+      }
+      if (in.bad())
+	    return false;
+      in.send_outputs();
+
+      if (! checkpoint_restore_signals_(in))
+	    return false;
+      if (! checkpoint_restore_arrays_(in))
+	    return false;
+
+      vthread_checkpoint_restore(in);
+      if (in.bad())
+	    return false;
+      schedule_checkpoint_restore(in);
+      if (in.bad())
+	    return false;
+
+      checkpoint_waits_event_s*waits = new checkpoint_waits_event_s;
+      while (vvp_net_t*net = in.get_net()) {
+	    waitable_hooks_s*ep = dynamic_cast<waitable_hooks_s*>(net->fun);
+	    vthread_t*list = ep? ep->waiting_threads() : 0;
+	    vthread_t head = vthread_checkpoint_get_list(in);
+	    if (list == 0 || head == 0) {
+		  in.error("bad event wait");
+		  break;
+	    }
+	    waits->lists.push_back(make_pair(list, head));
+      }
+      if (in.bad()) {
+	    delete waits;
+	    return false;
+      }
+      schedule_generic(waits, 0, true, true, true);
+
+      vpip_mcd_checkpoint_restore(in);
+      if (in.bad())
+	    return false;
+
+      if (! in.at_end()) {
+	    in.error("extra data at the end");
+	    return false;
+      }
+      return true;
+}
+
+bool checkpoint_restore(void)
+{
+      vvp_checkpoint_in in;
+      if (! in.read(checkpoint_restore_path)) {
+	    fprintf(stderr, "Error: cannot read checkpoint %s.\n",
+		    checkpoint_restore_path);
+	    return false;
+      }
+
+      if (! checkpoint_restore_(in)) {
+	    fprintf(stderr, "Error: cannot restore checkpoint %s: %s.\n",
+		    checkpoint_restore_path, in.reason().c_str());
+	    return false;
+      }
+      return true;
+}
@@ -0,0 +1,232 @@
+#ifndef IVL_checkpoint_H
+#define IVL_checkpoint_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "vvp_net.h"
+# include  <map>
+# include  <string>
+# include  <vector>
+
+/*
+ * A checkpoint holds the state of a simulation at the end of a time
+ * step. The $save system task writes one, and a later run of the same
+ * design with the -R flag resumes the simulation from it instead of
+ * from time 0. The state is made of:
+ *
+ *   - the values of the static variables and variable arrays,
+ *
+ *   - the state of the functors that remember more than their inputs,
+ *     such as delays, UDPs and flip-flops (see vvp_net_fun_t::save_state),
+ *
+ *   - the threads, with their program counters and stacks, and the
+ *     threads waiting on events,
+ *
+ *   - the events that are pending in future time steps, and
+ *
+ *   - the files opened with $fopen, with their positions.
+ *
+ * Everything else, such as the values of nets, is recomputed by
+ * propagating the restored values through the netlist at the restore
+ * time. The save is refused (with an error message and no file
+ * written) if the simulation is in a state that this cannot express,
+ * for example if a signal is forced or if automatic tasks are active.
+ *
+ * Nets, code addresses, scopes and arrays are written as indices into
+ * the design, so a checkpoint can only be restored by a run of the
+ * same design with the same version of vvp. The header carries a
+ * fingerprint of the design to check that.
+ */
+
+class __vpiScope;
+struct __vpiArray;
+typedef struct vthread_s* vthread_t;
+typedef struct vvp_code_s*vvp_code_t;
+
+/*
+ * The output side collects the checkpoint in memory, so that nothing
+ * is written if the save is refused part way through.
+ */
+class vvp_checkpoint_out {
+
+    public:
+      vvp_checkpoint_out();
+	// A section that is written separately and then appended to
+	// its parent. It shares the threads and tables of the parent.
+      explicit vvp_checkpoint_out(vvp_checkpoint_out&parent);
+      ~vvp_checkpoint_out();
+
+      void put_uint(uint64_t val);
+      void put_int(int64_t val);
+      void put_real(double val);
+      void put_string(const std::string&val);
+      void put_vec4(const vvp_vector4_t&val);
+      void put_vec8(const vvp_vector8_t&val);
+      void put_bits(const vvp_bit4_t*bits, unsigned count);
+
+      void put_net(const vvp_net_t*net);
+      void put_code(vvp_code_t code);
+      void put_scope(__vpiScope*scope);
+      void put_array(__vpiArray*array);
+
+	// Threads are written as small numbers, in the order that they
+	// are first seen. The thread table itself is written by
+	// vthread_checkpoint_save, which walks this list.
+      void put_thread(vthread_t thr);
+      size_t thread_count() const;
+      vthread_t thread(size_t idx) const;
+
+      void append(const vvp_checkpoint_out&that);
+      size_t size() const { return buf_.size(); }
+      void truncate(size_t mark) { buf_.resize(mark); }
+
+	// Refuse to save the checkpoint. The first reason is kept.
+      void refuse(const std::string&why);
+      bool refused() const { return root_->refused_; }
+      const std::string&reason() const { return root_->reason_; }
+
+      bool write(const char*path) const;
+
+    private:
+      void load_tables_();
+
+      vvp_checkpoint_out*root_;
+      std::vector<unsigned char> buf_;
+
+      bool refused_;
+      bool tables_loaded_;
+      std::string reason_;
+      std::map<vthread_t,size_t> thread_map_;
+      std::vector<vthread_t> thread_list_;
+      std::map<__vpiScope*,size_t> scope_map_;
+      std::map<__vpiArray*,size_t> array_map_;
+
+    private: // not implemented
+      vvp_checkpoint_out(const vvp_checkpoint_out&);
+      vvp_checkpoint_out& operator= (const vvp_checkpoint_out&);
+};
+
+/*
+ * The input side reads the whole checkpoint into memory and decodes
+ * it from there. A read past the end, or an index that does not fit
+ * the design, marks the checkpoint as bad and returns a zero value,
+ * so callers only need to check bad() now and then.
+ */
+class vvp_checkpoint_in {
+
+    public:
+      vvp_checkpoint_in();
+      ~vvp_checkpoint_in();
+
+      bool read(const char*path);
+
+      uint64_t get_uint();
+      int64_t get_int();
+      double get_real();
+      std::string get_string();
+      vvp_vector4_t get_vec4();
+      vvp_vector8_t get_vec8();
+      void get_bits(vvp_bit4_t*bits, unsigned count);
+
+      vvp_net_t*get_net();
+      vvp_code_t get_code();
+      __vpiScope*get_scope();
+      __vpiArray*get_array();
+
+	// The thread table is read by vthread_checkpoint_restore, which
+	// adds the threads here so that later sections can refer to them.
+      void add_thread(vthread_t thr);
+      vthread_t get_thread();
+
+	// Functors that restore their state usually need to send their
+	// output again, but only after all the functors have their
+	// state back, so that the outputs do not look like new edges.
+	// These queue the output to be sent by send_outputs().
+      void send_later(vvp_net_t*net, const vvp_vector4_t&val);
+      void send_later(vvp_net_t*net, const vvp_vector8_t&val);
+      void send_later(vvp_net_t*net, double val);
+      void send_outputs();
+
+      void error(const std::string&why);
+      bool bad() const { return bad_; }
+      const std::string&reason() const { return reason_; }
+      bool at_end() const { return pos_ == buf_.size(); }
+
+    private:
+      void load_tables_();
+
+      std::vector<unsigned char> buf_;
+      size_t pos_;
+      bool bad_;
+      std::string reason_;
+
+      std::vector<__vpiScope*> scopes_;
+      std::vector<__vpiArray*> arrays_;
+      std::vector<vthread_t> threads_;
+      std::vector<std::pair<vvp_net_t*,vvp_vector4_t> > out4_;
+      std::vector<std::pair<vvp_net_t*,vvp_vector8_t> > out8_;
+      std::vector<std::pair<vvp_net_t*,double> > outr_;
+
+    private: // not implemented
+      vvp_checkpoint_in(const vvp_checkpoint_in&);
+      vvp_checkpoint_in& operator= (const vvp_checkpoint_in&);
+};
+
+/*
+ * Arrange for a checkpoint to be written to the named file at the end
+ * of the current time step. This implements $save.
+ */
+extern void checkpoint_schedule_save(const char*path);
+
+/*
+ * This is the file given with the -R flag, or nil.
+ */
+extern const char*checkpoint_restore_path;
+
+/*
+ * Restore the checkpoint_restore_path file. This is called by the
+ * scheduler once the design is initialized, and leaves the simulation
+ * ready to run from the checkpoint time. Return false, after printing
+ * a message, if the checkpoint cannot be used.
+ */
+extern bool checkpoint_restore(void);
+
+/*
+ * These are the pieces of the checkpoint that other parts of the
+ * runtime save and restore.
+ */
+extern void schedule_checkpoint_save(vvp_checkpoint_out&out);
+extern void schedule_checkpoint_restore(vvp_checkpoint_in&in);
+  // Move the (initialized but not yet started) simulation to the
+  // given time, dropping the initial threads and the events that
+  // were waiting to start them.
+extern bool schedule_checkpoint_start(vvp_time64_t time);
+
+extern void vthread_checkpoint_save(vvp_checkpoint_out&out);
+extern void vthread_checkpoint_restore(vvp_checkpoint_in&in);
+  // Write/read a list of threads linked through their wait lists.
+extern void vthread_checkpoint_put_list(vvp_checkpoint_out&out, vthread_t list);
+extern vthread_t vthread_checkpoint_get_list(vvp_checkpoint_in&in);
+  // Delete the threads of a list that were never started.
+extern void vthread_checkpoint_drop_list(vthread_t list);
+
+extern void vpip_mcd_checkpoint_save(vvp_checkpoint_out&out);
+extern void vpip_mcd_checkpoint_restore(vvp_checkpoint_in&in);
+
+#endif /* IVL_checkpoint_H */
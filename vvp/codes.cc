@@ -18,6 +18,7 @@
  */
 
 # include  "codes.h"
+# include  "vvp_net_sig.h"
 # include  "statistics.h"
 # include  "config.h"
 #ifdef CHECK_WITH_VALGRIND
@@ -46,7 +47,7 @@ static unsigned current_within_chunk = 0;
 void codespace_init(void)
 {
       assert(current_chunk == 0);
-      first_chunk = new struct vvp_code_s [code_chunk_size];
+      first_chunk = new struct vvp_code_s [code_chunk_size]();
       current_chunk = first_chunk;
 
       current_chunk[0].opcode = &of_ZOMBIE;
@@ -64,7 +65,7 @@ vvp_code_t codespace_next(void)
 {
       if (current_within_chunk == (code_chunk_size-1)) {
 	    current_chunk[code_chunk_size-1].cptr
-		  = new struct vvp_code_s [code_chunk_size];
+		  = new struct vvp_code_s [code_chunk_size]();
 	    current_chunk = current_chunk[code_chunk_size-1].cptr;
 
 	      /* Put a link opcode on the end of the chunk. */
@@ -96,6 +97,143 @@ vvp_code_t codespace_null(void)
       return first_chunk + 0;
 }
 
+void codespace_for_each(void (*fun)(vvp_code_t code, void*cd), void*cd)
+{
+      for (vvp_code_t cur = first_chunk ; cur ; cur = cur[code_chunk_size-1].cptr) {
+	      /* The last chunk is only filled up to the next free
+		 instruction, but always has its link instruction. */
+	    unsigned cnt = code_chunk_size - 1;
+	    if (cur == current_chunk)
+		  cnt = current_within_chunk;
+
+	    for (unsigned idx = 0 ; idx < cnt ; idx += 1)
+		  fun(cur+idx, cd);
+	    fun(cur+code_chunk_size-1, cd);
+      }
+}
+
+size_t codespace_index(vvp_code_t code)
+{
+      size_t base = 0;
+      for (vvp_code_t cur = first_chunk ; cur ; cur = cur[code_chunk_size-1].cptr) {
+	    if (code >= cur && code < cur+code_chunk_size)
+		  return base + (code-cur);
+	    base += code_chunk_size;
+      }
+      assert(0);
+      return 0;
+}
+
+vvp_code_t codespace_address(size_t idx)
+{
+      vvp_code_t cur = first_chunk;
+      while (cur && idx >= code_chunk_size) {
+	    cur = cur[code_chunk_size-1].cptr;
+	    idx -= code_chunk_size;
+      }
+      if (cur == 0)
+	    return 0;
+      if (cur == current_chunk && idx >= current_within_chunk
+	  && idx != code_chunk_size-1)
+	    return 0;
+      return cur + idx;
+}
+
+/*
+ * The fusion pass looks for these sequences, which tgt-vvp generates
+ * for the conditions and the steps of loops:
+ *
+ *    %load/vec4 <var>; %cmpi/<e|s|u> <imm>; %jmp/0xz <pc>, <flag>;
+ *    %load/vec4 <var>; %pushi/vec4 <imm>; %cmp/<e|s|u>; %jmp/0xz <pc>, <flag>;
+ *    %load/vec4 <var>; %addi <imm>; %store/vec4 <var>, 0, <wid>;
+ *
+ * The %load/vec4 is replaced with a fused instruction that does the
+ * work of the whole sequence without pushing the intermediate values
+ * on the vec4 stack, then skips the rest of the sequence. The rest of
+ * the instructions are left in place, so a jump into the middle of a
+ * sequence still works. The fused compare instructions find the
+ * %jmp/0xz at cp + cp->bit_idx[0], which is otherwise not used by the
+ * %load/vec4 instruction.
+ *
+ * The load gets the full width of the variable, so the sequence is
+ * only fused if the immediate value has that same width.
+ */
+static bool fuse_signal_width(vvp_net_t*net, unsigned&wid)
+{
+      vvp_signal_value*sig = dynamic_cast<vvp_signal_value*> (net->fil);
+      if (sig == 0)
+	    return false;
+
+      wid = sig->value_size();
+      return true;
+}
+
+static vvp_code_fun fuse_cmp_jmp(vvp_code_fun cmp)
+{
+      if (cmp == &of_CMPE || cmp == &of_CMPIE)
+	    return &of_FUSED_CMPIE_JMP0XZ;
+      if (cmp == &of_CMPS || cmp == &of_CMPIS)
+	    return &of_FUSED_CMPIS_JMP0XZ;
+      if (cmp == &of_CMPU || cmp == &of_CMPIU)
+	    return &of_FUSED_CMPIU_JMP0XZ;
+      return 0;
+}
+
+static void fuse_code(vvp_code_t cp, void*)
+{
+      if (cp->opcode != &of_LOAD_VEC4)
+	    return;
+
+      unsigned wid;
+      if (! fuse_signal_width(cp->net, wid))
+	    return;
+
+      vvp_code_t imm = cp + 1;
+      vvp_code_fun use_fun = 0;
+      unsigned use_jmp = 0;
+
+      if (imm->opcode == &of_ADDI) {
+	    vvp_code_t sto = cp + 2;
+	    if (sto->opcode == &of_STORE_VEC4
+		&& sto->net == cp->net
+		&& sto->bit_idx[0] == 0
+		&& sto->bit_idx[1] == wid
+		&& imm->number == wid) {
+		  use_fun = &of_FUSED_ADDI_VEC4;
+	    }
+
+      } else if (imm->opcode == &of_CMPIE
+		 || imm->opcode == &of_CMPIS
+		 || imm->opcode == &of_CMPIU) {
+	    if (imm->number == wid && cp[2].opcode == &of_JMP0XZ) {
+		  use_fun = fuse_cmp_jmp(imm->opcode);
+		  use_jmp = 2;
+	    }
+
+      } else if (imm->opcode == &of_PUSHI_VEC4) {
+	    vvp_code_fun cmp = cp[2].opcode;
+	    if (imm->number == wid
+		&& (cmp == &of_CMPE || cmp == &of_CMPS || cmp == &of_CMPU)
+		&& cp[3].opcode == &of_JMP0XZ) {
+		  use_fun = fuse_cmp_jmp(cmp);
+		  use_jmp = 3;
+	    }
+      }
+
+      if (use_fun == 0)
+	    return;
+
+      cp->opcode = use_fun;
+      cp->bit_idx[0] = use_jmp;
+      count_opcodes_fused += 1;
+}
+
+void codespace_fuse(void)
+{
+      count_opcodes_fused = 0;
+      codespace_for_each(&fuse_code, 0);
+}
+
 #ifdef CHECK_WITH_VALGRIND
 void codespace_delete(void)
 {
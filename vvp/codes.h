@@ -275,11 +275,27 @@ extern bool of_REAP_UFUNC(vthread_t thr, vvp_code_t code);
 
 extern bool of_CHUNK_LINK(vthread_t thr, vvp_code_t code);
 
+/*
+ * These are fused instructions. They are not in the opcode table,
+ * and are only created by the codespace_fuse() pass, which puts them
+ * in place of the first instruction of a sequence that it knows.
+ */
+extern bool of_FUSED_ADDI_VEC4(vthread_t thr, vvp_code_t code);
+extern bool of_FUSED_CMPIE_JMP0XZ(vthread_t thr, vvp_code_t code);
+extern bool of_FUSED_CMPIS_JMP0XZ(vthread_t thr, vvp_code_t code);
+extern bool of_FUSED_CMPIU_JMP0XZ(vthread_t thr, vvp_code_t code);
+
 /*
  * This is the format of a machine code instruction.
  */
 struct vvp_code_s {
       vvp_code_fun opcode;
+#ifdef VVP_THREADED_DISPATCH
+	// Label in the threaded thread engine that executes this
+	// instruction. This is filled in from the opcode by the
+	// vthread_threaded_link() pass after compile.
+      const void*dispatch;
+#endif
 
       union {
 	    unsigned long number;
@@ -317,4 +333,29 @@ extern vvp_code_t codespace_allocate(void);
 extern vvp_code_t codespace_next(void);
 extern vvp_code_t codespace_null(void);
 
+/*
+ * Call the fun for every instruction that has been allocated in the
+ * code space, including the chunk link instructions. This is for
+ * passes that rewrite the compiled code after the compile is done.
+ */
+extern void codespace_for_each(void (*fun)(vvp_code_t code, void*cd),
+			       void*cd);
+
+/*
+ * Convert an instruction address to its position in the code space,
+ * and back. The position does not depend on where the code space
+ * happens to be in memory, so checkpoints use it to refer to code.
+ * codespace_address returns nil if the position is past the end of
+ * the code space.
+ */
+extern size_t codespace_index(vvp_code_t code);
+extern vvp_code_t codespace_address(size_t idx);
+
+/*
+ * This is a peephole pass over the compiled code that replaces some
+ * common instruction sequences with fused instructions. It must be
+ * run after the code is linked, and before any thread runs.
+ */
+extern void codespace_fuse(void);
+
 #endif /* IVL_codes_H */
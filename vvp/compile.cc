@@ -32,8 +32,15 @@
 # include  "parse_misc.h"
 # include  "statistics.h"
 # include  "schedule.h"
+# include  "native.h"
+# include  "levelize.h"
+# include  "fanout.h"
+# include  "profile.h"
 # include  <iostream>
 # include  <list>
+# include  <map>
+# include  <string>
+# include  <vector>
 # include  <cstdlib>
 # include  <cstring>
 # include  <cassert>
@@ -79,248 +86,256 @@ enum operand_e {
 struct opcode_table_s {
       const char*mnemonic;
       vvp_code_fun opcode;
+	/* The name of the opcode function, for the native code. */
+      const char*opcode_name;
 
       unsigned argc;
       enum operand_e argt[OPERAND_MAX];
 };
 
+  /* Each entry names its opcode function twice, as the function and
+     as a string for the native code to call it by. */
+# define OPF(fun) fun, #fun
+
 static const struct opcode_table_s opcode_table[] = {
-      { "%abs/wr", of_ABS_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%add",    of_ADD,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%add/wr", of_ADD_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%addi",   of_ADDI,   3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
-      { "%alloc",  of_ALLOC,  1,  {OA_VPI_PTR,  OA_NONE,     OA_NONE} },
-      { "%and",    of_AND,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%and/r",  of_ANDR,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%assign/ar",of_ASSIGN_AR,2,{OA_ARR_PTR,OA_BIT1,     OA_NONE} },
-      { "%assign/ar/d",of_ASSIGN_ARD,2,{OA_ARR_PTR,OA_BIT1,  OA_NONE} },
-      { "%assign/ar/e",of_ASSIGN_ARE,1,{OA_ARR_PTR,OA_NONE,  OA_NONE} },
-      { "%assign/vec4",      of_ASSIGN_VEC4,       2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
-      { "%assign/vec4/a/d",  of_ASSIGN_VEC4_A_D,   3, {OA_ARR_PTR,  OA_BIT1, OA_BIT2} },
-      { "%assign/vec4/a/e",  of_ASSIGN_VEC4_A_E,   2, {OA_ARR_PTR,  OA_BIT1, OA_NONE} },
-      { "%assign/vec4/d",    of_ASSIGN_VEC4D,      2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
-      { "%assign/vec4/e",    of_ASSIGN_VEC4E,      1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
-      { "%assign/vec4/off/d",of_ASSIGN_VEC4_OFF_D, 3, {OA_FUNC_PTR, OA_BIT1, OA_BIT2} },
-      { "%assign/vec4/off/e",of_ASSIGN_VEC4_OFF_E, 2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
-      { "%assign/wr",  of_ASSIGN_WR, 2,{OA_VPI_PTR, OA_BIT1, OA_NONE} },
-      { "%assign/wr/d",of_ASSIGN_WRD,2,{OA_VPI_PTR, OA_BIT1, OA_NONE} },
-      { "%assign/wr/e",of_ASSIGN_WRE,1,{OA_VPI_PTR, OA_NONE, OA_NONE} },
-      { "%blend",    of_BLEND,   0,  {OA_NONE,  OA_NONE,     OA_NONE} },
-      { "%blend/wr", of_BLEND_WR,0,  {OA_NONE,  OA_NONE,     OA_NONE} },
-      { "%breakpoint", of_BREAKPOINT, 0,  {OA_NONE, OA_NONE, OA_NONE} },
-      { "%callf/obj",       of_CALLF_OBJ,       2,{OA_CODE_PTR2,OA_VPI_PTR, OA_NONE} },
-      { "%callf/real",      of_CALLF_REAL,      2,{OA_CODE_PTR2,OA_VPI_PTR, OA_NONE} },
-      { "%callf/str",       of_CALLF_STR,       2,{OA_CODE_PTR2,OA_VPI_PTR, OA_NONE} },
-      { "%callf/vec4",      of_CALLF_VEC4,      2,{OA_CODE_PTR2,OA_VPI_PTR, OA_NONE} },
-      { "%callf/void",      of_CALLF_VOID,      2,{OA_CODE_PTR2,OA_VPI_PTR, OA_NONE} },
-      { "%cassign/link",    of_CASSIGN_LINK,    2,{OA_FUNC_PTR,OA_FUNC_PTR2,OA_NONE} },
-      { "%cassign/vec4",    of_CASSIGN_VEC4,    1,{OA_FUNC_PTR,OA_NONE,     OA_NONE} },
-      { "%cassign/vec4/off",of_CASSIGN_VEC4_OFF,2,{OA_FUNC_PTR,OA_BIT1,     OA_NONE} },
-      { "%cassign/wr",  of_CASSIGN_WR,  1,{OA_FUNC_PTR,OA_NONE,     OA_NONE} },
-      { "%cast/vec2/dar", of_CAST_VEC2_DAR, 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
-      { "%cast/vec4/dar", of_CAST_VEC4_DAR, 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
-      { "%cast/vec4/str", of_CAST_VEC4_STR, 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
-      { "%cast2",   of_CAST2,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%cmp/e",   of_CMPE,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%cmp/ne",  of_CMPNE,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%cmp/s",   of_CMPS,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%cmp/str", of_CMPSTR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%cmp/u",   of_CMPU,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%cmp/we",  of_CMPWE,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%cmp/wne", of_CMPWNE, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%cmp/wr",  of_CMPWR,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%cmp/x",   of_CMPX,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%cmp/z",   of_CMPZ,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%cmpi/e",  of_CMPIE,  3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
-      { "%cmpi/ne", of_CMPINE, 3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
-      { "%cmpi/s",  of_CMPIS,  3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
-      { "%cmpi/u",  of_CMPIU,  3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
-      { "%concat/str",  of_CONCAT_STR,  0,{OA_NONE,  OA_NONE,  OA_NONE} },
-      { "%concat/vec4", of_CONCAT_VEC4, 0,{OA_NONE,  OA_NONE,  OA_NONE} },
-      { "%concati/str", of_CONCATI_STR, 1,{OA_STRING,OA_NONE,  OA_NONE} },
-      { "%concati/vec4",of_CONCATI_VEC4,3,{OA_BIT1,  OA_BIT2,  OA_NUMBER} },
-      { "%cvt/rv",   of_CVT_RV,  0, {OA_NONE,   OA_NONE,     OA_NONE} },
-      { "%cvt/rv/s", of_CVT_RV_S,0, {OA_NONE,   OA_NONE,     OA_NONE} },
-      { "%cvt/sr", of_CVT_SR, 1,  {OA_BIT1,     OA_NONE,     OA_NONE} },
-      { "%cvt/ur", of_CVT_UR, 1,  {OA_BIT1,     OA_NONE,     OA_NONE} },
-      { "%cvt/vr", of_CVT_VR, 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
-      { "%deassign",of_DEASSIGN,3,{OA_FUNC_PTR, OA_BIT1,     OA_BIT2} },
-      { "%deassign/wr",of_DEASSIGN_WR,1,{OA_FUNC_PTR, OA_NONE,     OA_NONE} },
-      { "%debug/thr",  of_DEBUG_THR,  1,{OA_STRING,   OA_NONE,     OA_NONE} },
-      { "%delay",  of_DELAY,  2,  {OA_BIT1,     OA_BIT2,     OA_NONE} },
-      { "%delayx", of_DELAYX, 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
-      { "%delete/elem",of_DELETE_ELEM,1,{OA_FUNC_PTR,OA_NONE,OA_NONE} },
-      { "%delete/obj",of_DELETE_OBJ,1,{OA_FUNC_PTR,OA_NONE,  OA_NONE} },
-      { "%delete/tail",of_DELETE_TAIL,2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
-      { "%disable",  of_DISABLE, 1, {OA_VPI_PTR,OA_NONE,     OA_NONE} },
-      { "%disable/flow", of_DISABLE_FLOW, 1, {OA_VPI_PTR,OA_NONE, OA_NONE} },
-      { "%disable/fork",of_DISABLE_FORK,0,{OA_NONE,OA_NONE,  OA_NONE} },
-      { "%div",      of_DIV,     0, {OA_NONE,   OA_NONE,     OA_NONE} },
-      { "%div/s",    of_DIV_S,   0, {OA_NONE,   OA_NONE,     OA_NONE} },
-      { "%div/wr",   of_DIV_WR,  0, {OA_NONE,   OA_NONE,     OA_NONE} },
-      { "%dup/obj",  of_DUP_OBJ, 0, {OA_NONE,   OA_NONE,     OA_NONE} },
-      { "%dup/real", of_DUP_REAL,0, {OA_NONE,   OA_NONE,     OA_NONE} },
-      { "%dup/vec4", of_DUP_VEC4,0, {OA_NONE,   OA_NONE,     OA_NONE} },
-      { "%end",    of_END,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%evctl",  of_EVCTL,  2,  {OA_FUNC_PTR, OA_BIT1,     OA_NONE} },
-      { "%evctl/c",of_EVCTLC, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%evctl/i",of_EVCTLI, 2,  {OA_FUNC_PTR, OA_BIT1,     OA_NONE} },
-      { "%evctl/s",of_EVCTLS, 2,  {OA_FUNC_PTR, OA_BIT1,     OA_NONE} },
-      { "%event",    of_EVENT,    1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
-      { "%event/nb", of_EVENT_NB, 2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
-      { "%flag_get/vec4", of_FLAG_GET_VEC4, 1, {OA_NUMBER, OA_NONE, OA_NONE} },
-      { "%flag_inv",      of_FLAG_INV,      1, {OA_BIT1,   OA_NONE, OA_NONE} },
-      { "%flag_mov",      of_FLAG_MOV,      2, {OA_BIT1,   OA_BIT2, OA_NONE} },
-      { "%flag_or",       of_FLAG_OR,       2, {OA_BIT1,   OA_BIT2, OA_NONE} },
-      { "%flag_set/imm",  of_FLAG_SET_IMM,  2, {OA_NUMBER, OA_BIT1, OA_NONE} },
-      { "%flag_set/vec4", of_FLAG_SET_VEC4, 1, {OA_NUMBER, OA_NONE, OA_NONE} },
-      { "%force/link",    of_FORCE_LINK,2,{OA_FUNC_PTR, OA_FUNC_PTR2, OA_NONE} },
-      { "%force/vec4",    of_FORCE_VEC4,    1,{OA_FUNC_PTR, OA_NONE,      OA_NONE} },
-      { "%force/vec4/off",of_FORCE_VEC4_OFF,2,{OA_FUNC_PTR, OA_BIT1,      OA_NONE} },
-      { "%force/vec4/off/d",of_FORCE_VEC4_OFF_D,3,{OA_FUNC_PTR, OA_BIT1,  OA_BIT2} },
-      { "%force/wr",      of_FORCE_WR,      1,{OA_FUNC_PTR, OA_NONE,      OA_NONE} },
-      { "%fork",   of_FORK,   2,  {OA_CODE_PTR2,OA_VPI_PTR,  OA_NONE} },
-      { "%free",   of_FREE,   1,  {OA_VPI_PTR,  OA_NONE,     OA_NONE} },
-      { "%inv",    of_INV,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%ix/add", of_IX_ADD, 3,  {OA_NUMBER,   OA_BIT1,     OA_BIT2} },
-      { "%ix/getv",of_IX_GETV,2,  {OA_BIT1,     OA_FUNC_PTR, OA_NONE} },
-      { "%ix/getv/s",of_IX_GETV_S,2, {OA_BIT1,   OA_FUNC_PTR, OA_NONE} },
-      { "%ix/load",of_IX_LOAD,3,  {OA_NUMBER,   OA_BIT1,     OA_BIT2} },
-      { "%ix/mov", of_IX_MOV, 2,  {OA_BIT1,     OA_BIT2,     OA_NONE} },
-      { "%ix/mul", of_IX_MUL, 3,  {OA_NUMBER,   OA_BIT1,     OA_BIT2} },
-      { "%ix/sub", of_IX_SUB, 3,  {OA_NUMBER,   OA_BIT1,     OA_BIT2} },
-      { "%ix/vec4",  of_IX_VEC4,  1,  {OA_NUMBER,   OA_NONE, OA_NONE} },
-      { "%ix/vec4/s",of_IX_VEC4_S,1,  {OA_NUMBER,   OA_NONE, OA_NONE} },
-      { "%jmp",    of_JMP,    1,  {OA_CODE_PTR, OA_NONE,     OA_NONE} },
-      { "%jmp/0",  of_JMP0,   2,  {OA_CODE_PTR, OA_BIT1,     OA_NONE} },
-      { "%jmp/0xz",of_JMP0XZ, 2,  {OA_CODE_PTR, OA_BIT1,     OA_NONE} },
-      { "%jmp/1",  of_JMP1,   2,  {OA_CODE_PTR, OA_BIT1,     OA_NONE} },
-      { "%jmp/1xz",of_JMP1XZ, 2,  {OA_CODE_PTR, OA_BIT1,     OA_NONE} },
-      { "%join",   of_JOIN,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%join/detach",of_JOIN_DETACH,1,{OA_NUMBER,OA_NONE,  OA_NONE} },
-      { "%load/ar",of_LOAD_AR,2,  {OA_ARR_PTR,  OA_BIT1,     OA_NONE} },
-      { "%load/dar/r",  of_LOAD_DAR_R,    1, {OA_FUNC_PTR, OA_NONE, OA_NONE}},
-      { "%load/dar/str",of_LOAD_DAR_STR,  1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
-      { "%load/dar/vec4",of_LOAD_DAR_VEC4,1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
-      { "%load/obj",   of_LOAD_OBJ,  1,{OA_FUNC_PTR,OA_NONE, OA_NONE} },
-      { "%load/obja",  of_LOAD_OBJA, 2,{OA_ARR_PTR, OA_BIT1, OA_NONE} },
-      { "%load/real",  of_LOAD_REAL, 1,{OA_VPI_PTR, OA_NONE, OA_NONE} },
-      { "%load/str",   of_LOAD_STR,  1,{OA_FUNC_PTR,OA_NONE, OA_NONE} },
-      { "%load/stra",  of_LOAD_STRA, 2,{OA_ARR_PTR, OA_BIT1, OA_NONE} },
-      { "%load/vec4",  of_LOAD_VEC4, 1,{OA_FUNC_PTR,OA_NONE,  OA_NONE} },
-      { "%load/vec4a", of_LOAD_VEC4A,2,{OA_ARR_PTR, OA_BIT1, OA_NONE} },
-      { "%max/wr", of_MAX_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%min/wr", of_MIN_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%mod",    of_MOD,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%mod/s",  of_MOD_S,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%mod/wr", of_MOD_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%mul",    of_MUL,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%mul/wr", of_MUL_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%muli",   of_MULI,   3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
-      { "%nand",   of_NAND,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%nand/r", of_NANDR,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%new/cobj",  of_NEW_COBJ,  1, {OA_VPI_PTR,OA_NONE,  OA_NONE} },
-      { "%new/darray",of_NEW_DARRAY,2, {OA_BIT1,   OA_STRING,OA_NONE} },
-      { "%noop",   of_NOOP,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%nor",    of_NOR,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%nor/r",  of_NORR,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%null",   of_NULL,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%or",     of_OR,     0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%or/r",   of_ORR,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%pad/s",  of_PAD_S,  1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
-      { "%pad/u",  of_PAD_U,  1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
-      { "%part/s", of_PART_S, 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
-      { "%part/u", of_PART_U, 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
-      { "%parti/s",of_PARTI_S,3,  {OA_NUMBER,   OA_BIT1,     OA_BIT2} },
-      { "%parti/u",of_PARTI_U,3,  {OA_NUMBER,   OA_BIT1,     OA_BIT2} },
-      { "%pop/obj", of_POP_OBJ, 2, {OA_BIT1,    OA_BIT2,     OA_NONE} },
-      { "%pop/real",of_POP_REAL,1, {OA_NUMBER,  OA_NONE,     OA_NONE} },
-      { "%pop/str", of_POP_STR, 1, {OA_NUMBER,  OA_NONE,     OA_NONE} },
-      { "%pop/vec4",of_POP_VEC4,1, {OA_NUMBER,  OA_NONE,     OA_NONE} },
-      { "%pow",     of_POW,     0,  {OA_NONE,   OA_NONE,     OA_NONE} },
-      { "%pow/s",   of_POW_S,   0,  {OA_NONE,   OA_NONE,     OA_NONE} },
-      { "%pow/wr",  of_POW_WR,  0,  {OA_NONE,   OA_NONE,     OA_NONE} },
-      { "%prop/obj",of_PROP_OBJ,2,  {OA_NUMBER,   OA_BIT1,     OA_NONE} },
-      { "%prop/r",  of_PROP_R,  1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
-      { "%prop/str",of_PROP_STR,1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
-      { "%prop/v",  of_PROP_V,  1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
-      { "%pushi/real",of_PUSHI_REAL,2,{OA_BIT1,   OA_BIT2,   OA_NONE} },
-      { "%pushi/str", of_PUSHI_STR, 1,{OA_STRING, OA_NONE,   OA_NONE} },
-      { "%pushi/vec4",of_PUSHI_VEC4,3,{OA_BIT1,   OA_BIT2,   OA_NUMBER} },
-      { "%pushv/str", of_PUSHV_STR, 0,{OA_NONE,   OA_NONE,   OA_NONE} },
-      { "%putc/str/vec4",of_PUTC_STR_VEC4,2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
-      { "%qinsert/real",of_QINSERT_REAL,2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
-      { "%qinsert/str", of_QINSERT_STR, 2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
-      { "%qinsert/v",   of_QINSERT_V,   3,{OA_FUNC_PTR,OA_BIT1,OA_BIT2} },
-      { "%qpop/b/real",of_QPOP_B_REAL,1,{OA_FUNC_PTR,OA_NONE,OA_NONE} },
-      { "%qpop/b/str", of_QPOP_B_STR, 1,{OA_FUNC_PTR,OA_NONE,OA_NONE} },
-      { "%qpop/b/v",   of_QPOP_B_V,   2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
-      { "%qpop/f/real",of_QPOP_F_REAL,1,{OA_FUNC_PTR,OA_NONE,OA_NONE} },
-      { "%qpop/f/str", of_QPOP_F_STR, 1,{OA_FUNC_PTR,OA_NONE,OA_NONE} },
-      { "%qpop/f/v",   of_QPOP_F_V,   2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
-      { "%release/net",of_RELEASE_NET,3,{OA_FUNC_PTR,OA_BIT1,OA_BIT2} },
-      { "%release/reg",of_RELEASE_REG,3,{OA_FUNC_PTR,OA_BIT1,OA_BIT2} },
-      { "%release/wr", of_RELEASE_WR, 2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
-      { "%replicate", of_REPLICATE,   1,{OA_NUMBER,  OA_NONE,OA_NONE} },
-      { "%ret/real",  of_RET_REAL,    1,{OA_NUMBER,  OA_NONE,OA_NONE} },
-      { "%ret/str",   of_RET_STR,     1,{OA_NUMBER,  OA_NONE,OA_NONE} },
-      { "%ret/vec4",  of_RET_VEC4,    3,{OA_NUMBER,  OA_BIT1,OA_BIT2} },
-      { "%retload/real",of_RETLOAD_REAL,1,{OA_NUMBER,  OA_NONE,OA_NONE} },
-      { "%retload/str", of_RETLOAD_STR, 1,{OA_NUMBER,  OA_NONE,OA_NONE} },
-      { "%retload/vec4",of_RETLOAD_VEC4,1,{OA_NUMBER,  OA_NONE,OA_NONE} },
-      { "%scopy",  of_SCOPY,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%set/dar/obj/real",of_SET_DAR_OBJ_REAL,1,{OA_NUMBER,OA_NONE,OA_NONE} },
-      { "%set/dar/obj/str", of_SET_DAR_OBJ_STR, 1,{OA_NUMBER,OA_NONE,OA_NONE} },
-      { "%set/dar/obj/vec4",of_SET_DAR_OBJ_VEC4,1,{OA_NUMBER,OA_NONE,OA_NONE} },
-      { "%shiftl",   of_SHIFTL,   1, {OA_NUMBER, OA_NONE,   OA_NONE} },
-      { "%shiftr",   of_SHIFTR,   1, {OA_NUMBER, OA_NONE,   OA_NONE} },
-      { "%shiftr/s", of_SHIFTR_S, 1, {OA_NUMBER, OA_NONE,   OA_NONE} },
-      { "%split/vec4",    of_SPLIT_VEC4,    1,{OA_NUMBER,   OA_NONE, OA_NONE} },
-      { "%store/dar/r",   of_STORE_DAR_R,   1,{OA_FUNC_PTR, OA_NONE, OA_NONE} },
-      { "%store/dar/str", of_STORE_DAR_STR, 1,{OA_FUNC_PTR, OA_NONE, OA_NONE} },
-      { "%store/dar/vec4",of_STORE_DAR_VEC4,1,{OA_FUNC_PTR, OA_NONE, OA_NONE} },
-      { "%store/obj",   of_STORE_OBJ,   1, {OA_FUNC_PTR,OA_NONE, OA_NONE} },
-      { "%store/obja",  of_STORE_OBJA,  2, {OA_ARR_PTR, OA_BIT1, OA_NONE} },
-      { "%store/prop/obj",of_STORE_PROP_OBJ,2, {OA_NUMBER,  OA_BIT1, OA_NONE} },
-      { "%store/prop/r",  of_STORE_PROP_R,  1, {OA_NUMBER,  OA_NONE, OA_NONE} },
-      { "%store/prop/str",of_STORE_PROP_STR,1, {OA_NUMBER,  OA_NONE, OA_NONE} },
-      { "%store/prop/v",  of_STORE_PROP_V,  2, {OA_NUMBER,  OA_BIT1, OA_NONE} },
-      { "%store/qb/r",   of_STORE_QB_R,    2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
-      { "%store/qb/str", of_STORE_QB_STR,  2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
-      { "%store/qb/v",   of_STORE_QB_V,    3, {OA_FUNC_PTR, OA_BIT1, OA_BIT2} },
-      { "%store/qdar/r",  of_STORE_QDAR_R,  2,{OA_FUNC_PTR, OA_BIT1, OA_NONE} },
-      { "%store/qdar/str",of_STORE_QDAR_STR,2,{OA_FUNC_PTR, OA_BIT1, OA_NONE} },
-      { "%store/qdar/v",  of_STORE_QDAR_V,  3,{OA_FUNC_PTR, OA_BIT1, OA_BIT2} },
-      { "%store/qf/r",   of_STORE_QF_R,    2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
-      { "%store/qf/str", of_STORE_QF_STR,  2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
-      { "%store/qf/v",   of_STORE_QF_V,    3, {OA_FUNC_PTR, OA_BIT1, OA_BIT2} },
-      { "%store/qobj/r",  of_STORE_QOBJ_R,  2, {OA_FUNC_PTR,OA_BIT1, OA_NONE} },
-      { "%store/qobj/str",of_STORE_QOBJ_STR,2, {OA_FUNC_PTR,OA_BIT1, OA_NONE} },
-      { "%store/qobj/v",  of_STORE_QOBJ_V,  3, {OA_FUNC_PTR,OA_BIT1, OA_BIT2} },
-      { "%store/real",    of_STORE_REAL,    1, {OA_FUNC_PTR,OA_NONE, OA_NONE} },
-      { "%store/reala",   of_STORE_REALA,   2, {OA_ARR_PTR, OA_BIT1, OA_NONE} },
-      { "%store/str",     of_STORE_STR,     1, {OA_FUNC_PTR,OA_NONE, OA_NONE} },
-      { "%store/stra",    of_STORE_STRA,    2, {OA_ARR_PTR, OA_BIT1, OA_NONE} },
-      { "%store/vec4",    of_STORE_VEC4,    3, {OA_FUNC_PTR,OA_BIT1, OA_BIT2} },
-      { "%store/vec4a",   of_STORE_VEC4A,   3, {OA_ARR_PTR, OA_BIT1, OA_BIT2} },
-      { "%sub",    of_SUB,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%sub/wr", of_SUB_WR, 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%subi",   of_SUBI,   3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
-      { "%substr",     of_SUBSTR,     2,{OA_BIT1,    OA_BIT2, OA_NONE} },
-      { "%substr/vec4",of_SUBSTR_VEC4,2,{OA_BIT1,    OA_BIT2, OA_NONE} },
-      { "%test_nul",     of_TEST_NUL,     1,{OA_FUNC_PTR,OA_NONE,    OA_NONE} },
-      { "%test_nul/a",   of_TEST_NUL_A,   2,{OA_ARR_PTR, OA_BIT1,    OA_NONE} },
-      { "%test_nul/obj", of_TEST_NUL_OBJ, 0,{OA_NONE,    OA_NONE,    OA_NONE} },
-      { "%test_nul/prop",of_TEST_NUL_PROP,2,{OA_NUMBER,  OA_BIT1,    OA_NONE} },
-      { "%wait",   of_WAIT,   1,  {OA_FUNC_PTR, OA_NONE,     OA_NONE} },
-      { "%wait/fork",of_WAIT_FORK,0,{OA_NONE,   OA_NONE,     OA_NONE} },
-      { "%xnor",   of_XNOR,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%xnor/r", of_XNORR,  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%xor",    of_XOR,    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { "%xor/r",  of_XORR,   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
-      { 0, of_NOOP, 0, {OA_NONE, OA_NONE, OA_NONE} }
+      { "%abs/wr", OPF(of_ABS_WR), 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%add",    OPF(of_ADD),    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%add/wr", OPF(of_ADD_WR), 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%addi",   OPF(of_ADDI),   3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
+      { "%alloc",  OPF(of_ALLOC),  1,  {OA_VPI_PTR,  OA_NONE,     OA_NONE} },
+      { "%and",    OPF(of_AND),    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%and/r",  OPF(of_ANDR),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%assign/ar",OPF(of_ASSIGN_AR),2,{OA_ARR_PTR,OA_BIT1,     OA_NONE} },
+      { "%assign/ar/d",OPF(of_ASSIGN_ARD),2,{OA_ARR_PTR,OA_BIT1,  OA_NONE} },
+      { "%assign/ar/e",OPF(of_ASSIGN_ARE),1,{OA_ARR_PTR,OA_NONE,  OA_NONE} },
+      { "%assign/vec4",      OPF(of_ASSIGN_VEC4),       2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%assign/vec4/a/d",  OPF(of_ASSIGN_VEC4_A_D),   3, {OA_ARR_PTR,  OA_BIT1, OA_BIT2} },
+      { "%assign/vec4/a/e",  OPF(of_ASSIGN_VEC4_A_E),   2, {OA_ARR_PTR,  OA_BIT1, OA_NONE} },
+      { "%assign/vec4/d",    OPF(of_ASSIGN_VEC4D),      2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%assign/vec4/e",    OPF(of_ASSIGN_VEC4E),      1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
+      { "%assign/vec4/off/d",OPF(of_ASSIGN_VEC4_OFF_D), 3, {OA_FUNC_PTR, OA_BIT1, OA_BIT2} },
+      { "%assign/vec4/off/e",OPF(of_ASSIGN_VEC4_OFF_E), 2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%assign/wr",  OPF(of_ASSIGN_WR), 2,{OA_VPI_PTR, OA_BIT1, OA_NONE} },
+      { "%assign/wr/d",OPF(of_ASSIGN_WRD),2,{OA_VPI_PTR, OA_BIT1, OA_NONE} },
+      { "%assign/wr/e",OPF(of_ASSIGN_WRE),1,{OA_VPI_PTR, OA_NONE, OA_NONE} },
+      { "%blend",    OPF(of_BLEND),   0,  {OA_NONE,  OA_NONE,     OA_NONE} },
+      { "%blend/wr", OPF(of_BLEND_WR),0,  {OA_NONE,  OA_NONE,     OA_NONE} },
+      { "%breakpoint", OPF(of_BREAKPOINT), 0,  {OA_NONE, OA_NONE, OA_NONE} },
+      { "%callf/obj",       OPF(of_CALLF_OBJ),       2,{OA_CODE_PTR2,OA_VPI_PTR, OA_NONE} },
+      { "%callf/real",      OPF(of_CALLF_REAL),      2,{OA_CODE_PTR2,OA_VPI_PTR, OA_NONE} },
+      { "%callf/str",       OPF(of_CALLF_STR),       2,{OA_CODE_PTR2,OA_VPI_PTR, OA_NONE} },
+      { "%callf/vec4",      OPF(of_CALLF_VEC4),      2,{OA_CODE_PTR2,OA_VPI_PTR, OA_NONE} },
+      { "%callf/void",      OPF(of_CALLF_VOID),      2,{OA_CODE_PTR2,OA_VPI_PTR, OA_NONE} },
+      { "%cassign/link",    OPF(of_CASSIGN_LINK),    2,{OA_FUNC_PTR,OA_FUNC_PTR2,OA_NONE} },
+      { "%cassign/vec4",    OPF(of_CASSIGN_VEC4),    1,{OA_FUNC_PTR,OA_NONE,     OA_NONE} },
+      { "%cassign/vec4/off",OPF(of_CASSIGN_VEC4_OFF),2,{OA_FUNC_PTR,OA_BIT1,     OA_NONE} },
+      { "%cassign/wr",  OPF(of_CASSIGN_WR),  1,{OA_FUNC_PTR,OA_NONE,     OA_NONE} },
+      { "%cast/vec2/dar", OPF(of_CAST_VEC2_DAR), 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
+      { "%cast/vec4/dar", OPF(of_CAST_VEC4_DAR), 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
+      { "%cast/vec4/str", OPF(of_CAST_VEC4_STR), 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
+      { "%cast2",   OPF(of_CAST2),  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmp/e",   OPF(of_CMPE),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmp/ne",  OPF(of_CMPNE),  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmp/s",   OPF(of_CMPS),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmp/str", OPF(of_CMPSTR), 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmp/u",   OPF(of_CMPU),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmp/we",  OPF(of_CMPWE),  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmp/wne", OPF(of_CMPWNE), 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmp/wr",  OPF(of_CMPWR),  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmp/x",   OPF(of_CMPX),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmp/z",   OPF(of_CMPZ),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%cmpi/e",  OPF(of_CMPIE),  3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
+      { "%cmpi/ne", OPF(of_CMPINE), 3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
+      { "%cmpi/s",  OPF(of_CMPIS),  3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
+      { "%cmpi/u",  OPF(of_CMPIU),  3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
+      { "%concat/str",  OPF(of_CONCAT_STR),  0,{OA_NONE,  OA_NONE,  OA_NONE} },
+      { "%concat/vec4", OPF(of_CONCAT_VEC4), 0,{OA_NONE,  OA_NONE,  OA_NONE} },
+      { "%concati/str", OPF(of_CONCATI_STR), 1,{OA_STRING,OA_NONE,  OA_NONE} },
+      { "%concati/vec4",OPF(of_CONCATI_VEC4),3,{OA_BIT1,  OA_BIT2,  OA_NUMBER} },
+      { "%cvt/rv",   OPF(of_CVT_RV),  0, {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%cvt/rv/s", OPF(of_CVT_RV_S),0, {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%cvt/sr", OPF(of_CVT_SR), 1,  {OA_BIT1,     OA_NONE,     OA_NONE} },
+      { "%cvt/ur", OPF(of_CVT_UR), 1,  {OA_BIT1,     OA_NONE,     OA_NONE} },
+      { "%cvt/vr", OPF(of_CVT_VR), 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
+      { "%deassign",OPF(of_DEASSIGN),3,{OA_FUNC_PTR, OA_BIT1,     OA_BIT2} },
+      { "%deassign/wr",OPF(of_DEASSIGN_WR),1,{OA_FUNC_PTR, OA_NONE,     OA_NONE} },
+      { "%debug/thr",  OPF(of_DEBUG_THR),  1,{OA_STRING,   OA_NONE,     OA_NONE} },
+      { "%delay",  OPF(of_DELAY),  2,  {OA_BIT1,     OA_BIT2,     OA_NONE} },
+      { "%delayx", OPF(of_DELAYX), 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
+      { "%delete/elem",OPF(of_DELETE_ELEM),1,{OA_FUNC_PTR,OA_NONE,OA_NONE} },
+      { "%delete/obj",OPF(of_DELETE_OBJ),1,{OA_FUNC_PTR,OA_NONE,  OA_NONE} },
+      { "%delete/tail",OPF(of_DELETE_TAIL),2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
+      { "%disable",  OPF(of_DISABLE), 1, {OA_VPI_PTR,OA_NONE,     OA_NONE} },
+      { "%disable/flow", OPF(of_DISABLE_FLOW), 1, {OA_VPI_PTR,OA_NONE, OA_NONE} },
+      { "%disable/fork",OPF(of_DISABLE_FORK),0,{OA_NONE,OA_NONE,  OA_NONE} },
+      { "%div",      OPF(of_DIV),     0, {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%div/s",    OPF(of_DIV_S),   0, {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%div/wr",   OPF(of_DIV_WR),  0, {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%dup/obj",  OPF(of_DUP_OBJ), 0, {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%dup/real", OPF(of_DUP_REAL),0, {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%dup/vec4", OPF(of_DUP_VEC4),0, {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%end",    OPF(of_END),    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%evctl",  OPF(of_EVCTL),  2,  {OA_FUNC_PTR, OA_BIT1,     OA_NONE} },
+      { "%evctl/c",OPF(of_EVCTLC), 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%evctl/i",OPF(of_EVCTLI), 2,  {OA_FUNC_PTR, OA_BIT1,     OA_NONE} },
+      { "%evctl/s",OPF(of_EVCTLS), 2,  {OA_FUNC_PTR, OA_BIT1,     OA_NONE} },
+      { "%event",    OPF(of_EVENT),    1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
+      { "%event/nb", OPF(of_EVENT_NB), 2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%flag_get/vec4", OPF(of_FLAG_GET_VEC4), 1, {OA_NUMBER, OA_NONE, OA_NONE} },
+      { "%flag_inv",      OPF(of_FLAG_INV),      1, {OA_BIT1,   OA_NONE, OA_NONE} },
+      { "%flag_mov",      OPF(of_FLAG_MOV),      2, {OA_BIT1,   OA_BIT2, OA_NONE} },
+      { "%flag_or",       OPF(of_FLAG_OR),       2, {OA_BIT1,   OA_BIT2, OA_NONE} },
+      { "%flag_set/imm",  OPF(of_FLAG_SET_IMM),  2, {OA_NUMBER, OA_BIT1, OA_NONE} },
+      { "%flag_set/vec4", OPF(of_FLAG_SET_VEC4), 1, {OA_NUMBER, OA_NONE, OA_NONE} },
+      { "%force/link",    OPF(of_FORCE_LINK),2,{OA_FUNC_PTR, OA_FUNC_PTR2, OA_NONE} },
+      { "%force/vec4",    OPF(of_FORCE_VEC4),    1,{OA_FUNC_PTR, OA_NONE,      OA_NONE} },
+      { "%force/vec4/off",OPF(of_FORCE_VEC4_OFF),2,{OA_FUNC_PTR, OA_BIT1,      OA_NONE} },
+      { "%force/vec4/off/d",OPF(of_FORCE_VEC4_OFF_D),3,{OA_FUNC_PTR, OA_BIT1,  OA_BIT2} },
+      { "%force/wr",      OPF(of_FORCE_WR),      1,{OA_FUNC_PTR, OA_NONE,      OA_NONE} },
+      { "%fork",   OPF(of_FORK),   2,  {OA_CODE_PTR2,OA_VPI_PTR,  OA_NONE} },
+      { "%free",   OPF(of_FREE),   1,  {OA_VPI_PTR,  OA_NONE,     OA_NONE} },
+      { "%inv",    OPF(of_INV),    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%ix/add", OPF(of_IX_ADD), 3,  {OA_NUMBER,   OA_BIT1,     OA_BIT2} },
+      { "%ix/getv",OPF(of_IX_GETV),2,  {OA_BIT1,     OA_FUNC_PTR, OA_NONE} },
+      { "%ix/getv/s",OPF(of_IX_GETV_S),2, {OA_BIT1,   OA_FUNC_PTR, OA_NONE} },
+      { "%ix/load",OPF(of_IX_LOAD),3,  {OA_NUMBER,   OA_BIT1,     OA_BIT2} },
+      { "%ix/mov", OPF(of_IX_MOV), 2,  {OA_BIT1,     OA_BIT2,     OA_NONE} },
+      { "%ix/mul", OPF(of_IX_MUL), 3,  {OA_NUMBER,   OA_BIT1,     OA_BIT2} },
+      { "%ix/sub", OPF(of_IX_SUB), 3,  {OA_NUMBER,   OA_BIT1,     OA_BIT2} },
+      { "%ix/vec4",  OPF(of_IX_VEC4),  1,  {OA_NUMBER,   OA_NONE, OA_NONE} },
+      { "%ix/vec4/s",OPF(of_IX_VEC4_S),1,  {OA_NUMBER,   OA_NONE, OA_NONE} },
+      { "%jmp",    OPF(of_JMP),    1,  {OA_CODE_PTR, OA_NONE,     OA_NONE} },
+      { "%jmp/0",  OPF(of_JMP0),   2,  {OA_CODE_PTR, OA_BIT1,     OA_NONE} },
+      { "%jmp/0xz",OPF(of_JMP0XZ), 2,  {OA_CODE_PTR, OA_BIT1,     OA_NONE} },
+      { "%jmp/1",  OPF(of_JMP1),   2,  {OA_CODE_PTR, OA_BIT1,     OA_NONE} },
+      { "%jmp/1xz",OPF(of_JMP1XZ), 2,  {OA_CODE_PTR, OA_BIT1,     OA_NONE} },
+      { "%join",   OPF(of_JOIN),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%join/detach",OPF(of_JOIN_DETACH),1,{OA_NUMBER,OA_NONE,  OA_NONE} },
+      { "%load/ar",OPF(of_LOAD_AR),2,  {OA_ARR_PTR,  OA_BIT1,     OA_NONE} },
+      { "%load/dar/r",  OPF(of_LOAD_DAR_R),    1, {OA_FUNC_PTR, OA_NONE, OA_NONE}},
+      { "%load/dar/str",OPF(of_LOAD_DAR_STR),  1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
+      { "%load/dar/vec4",OPF(of_LOAD_DAR_VEC4),1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
+      { "%load/obj",   OPF(of_LOAD_OBJ),  1,{OA_FUNC_PTR,OA_NONE, OA_NONE} },
+      { "%load/obja",  OPF(of_LOAD_OBJA), 2,{OA_ARR_PTR, OA_BIT1, OA_NONE} },
+      { "%load/real",  OPF(of_LOAD_REAL), 1,{OA_VPI_PTR, OA_NONE, OA_NONE} },
+      { "%load/str",   OPF(of_LOAD_STR),  1,{OA_FUNC_PTR,OA_NONE, OA_NONE} },
+      { "%load/stra",  OPF(of_LOAD_STRA), 2,{OA_ARR_PTR, OA_BIT1, OA_NONE} },
+      { "%load/vec4",  OPF(of_LOAD_VEC4), 1,{OA_FUNC_PTR,OA_NONE,  OA_NONE} },
+      { "%load/vec4a", OPF(of_LOAD_VEC4A),2,{OA_ARR_PTR, OA_BIT1, OA_NONE} },
+      { "%max/wr", OPF(of_MAX_WR), 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%min/wr", OPF(of_MIN_WR), 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%mod",    OPF(of_MOD),    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%mod/s",  OPF(of_MOD_S),  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%mod/wr", OPF(of_MOD_WR), 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%mul",    OPF(of_MUL),    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%mul/wr", OPF(of_MUL_WR), 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%muli",   OPF(of_MULI),   3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
+      { "%nand",   OPF(of_NAND),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%nand/r", OPF(of_NANDR),  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%new/cobj",  OPF(of_NEW_COBJ),  1, {OA_VPI_PTR,OA_NONE,  OA_NONE} },
+      { "%new/darray",OPF(of_NEW_DARRAY),2, {OA_BIT1,   OA_STRING,OA_NONE} },
+      { "%noop",   OPF(of_NOOP),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%nor",    OPF(of_NOR),    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%nor/r",  OPF(of_NORR),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%null",   OPF(of_NULL),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%or",     OPF(of_OR),     0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%or/r",   OPF(of_ORR),    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%pad/s",  OPF(of_PAD_S),  1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
+      { "%pad/u",  OPF(of_PAD_U),  1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
+      { "%part/s", OPF(of_PART_S), 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
+      { "%part/u", OPF(of_PART_U), 1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
+      { "%parti/s",OPF(of_PARTI_S),3,  {OA_NUMBER,   OA_BIT1,     OA_BIT2} },
+      { "%parti/u",OPF(of_PARTI_U),3,  {OA_NUMBER,   OA_BIT1,     OA_BIT2} },
+      { "%pop/obj", OPF(of_POP_OBJ), 2, {OA_BIT1,    OA_BIT2,     OA_NONE} },
+      { "%pop/real",OPF(of_POP_REAL),1, {OA_NUMBER,  OA_NONE,     OA_NONE} },
+      { "%pop/str", OPF(of_POP_STR), 1, {OA_NUMBER,  OA_NONE,     OA_NONE} },
+      { "%pop/vec4",OPF(of_POP_VEC4),1, {OA_NUMBER,  OA_NONE,     OA_NONE} },
+      { "%pow",     OPF(of_POW),     0,  {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%pow/s",   OPF(of_POW_S),   0,  {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%pow/wr",  OPF(of_POW_WR),  0,  {OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%prop/obj",OPF(of_PROP_OBJ),2,  {OA_NUMBER,   OA_BIT1,     OA_NONE} },
+      { "%prop/r",  OPF(of_PROP_R),  1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
+      { "%prop/str",OPF(of_PROP_STR),1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
+      { "%prop/v",  OPF(of_PROP_V),  1,  {OA_NUMBER,   OA_NONE,     OA_NONE} },
+      { "%pushi/real",OPF(of_PUSHI_REAL),2,{OA_BIT1,   OA_BIT2,   OA_NONE} },
+      { "%pushi/str", OPF(of_PUSHI_STR), 1,{OA_STRING, OA_NONE,   OA_NONE} },
+      { "%pushi/vec4",OPF(of_PUSHI_VEC4),3,{OA_BIT1,   OA_BIT2,   OA_NUMBER} },
+      { "%pushv/str", OPF(of_PUSHV_STR), 0,{OA_NONE,   OA_NONE,   OA_NONE} },
+      { "%putc/str/vec4",OPF(of_PUTC_STR_VEC4),2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
+      { "%qinsert/real",OPF(of_QINSERT_REAL),2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
+      { "%qinsert/str", OPF(of_QINSERT_STR), 2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
+      { "%qinsert/v",   OPF(of_QINSERT_V),   3,{OA_FUNC_PTR,OA_BIT1,OA_BIT2} },
+      { "%qpop/b/real",OPF(of_QPOP_B_REAL),1,{OA_FUNC_PTR,OA_NONE,OA_NONE} },
+      { "%qpop/b/str", OPF(of_QPOP_B_STR), 1,{OA_FUNC_PTR,OA_NONE,OA_NONE} },
+      { "%qpop/b/v",   OPF(of_QPOP_B_V),   2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
+      { "%qpop/f/real",OPF(of_QPOP_F_REAL),1,{OA_FUNC_PTR,OA_NONE,OA_NONE} },
+      { "%qpop/f/str", OPF(of_QPOP_F_STR), 1,{OA_FUNC_PTR,OA_NONE,OA_NONE} },
+      { "%qpop/f/v",   OPF(of_QPOP_F_V),   2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
+      { "%release/net",OPF(of_RELEASE_NET),3,{OA_FUNC_PTR,OA_BIT1,OA_BIT2} },
+      { "%release/reg",OPF(of_RELEASE_REG),3,{OA_FUNC_PTR,OA_BIT1,OA_BIT2} },
+      { "%release/wr", OPF(of_RELEASE_WR), 2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
+      { "%replicate", OPF(of_REPLICATE),   1,{OA_NUMBER,  OA_NONE,OA_NONE} },
+      { "%ret/real",  OPF(of_RET_REAL),    1,{OA_NUMBER,  OA_NONE,OA_NONE} },
+      { "%ret/str",   OPF(of_RET_STR),     1,{OA_NUMBER,  OA_NONE,OA_NONE} },
+      { "%ret/vec4",  OPF(of_RET_VEC4),    3,{OA_NUMBER,  OA_BIT1,OA_BIT2} },
+      { "%retload/real",OPF(of_RETLOAD_REAL),1,{OA_NUMBER,  OA_NONE,OA_NONE} },
+      { "%retload/str", OPF(of_RETLOAD_STR), 1,{OA_NUMBER,  OA_NONE,OA_NONE} },
+      { "%retload/vec4",OPF(of_RETLOAD_VEC4),1,{OA_NUMBER,  OA_NONE,OA_NONE} },
+      { "%scopy",  OPF(of_SCOPY),  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%set/dar/obj/real",OPF(of_SET_DAR_OBJ_REAL),1,{OA_NUMBER,OA_NONE,OA_NONE} },
+      { "%set/dar/obj/str", OPF(of_SET_DAR_OBJ_STR), 1,{OA_NUMBER,OA_NONE,OA_NONE} },
+      { "%set/dar/obj/vec4",OPF(of_SET_DAR_OBJ_VEC4),1,{OA_NUMBER,OA_NONE,OA_NONE} },
+      { "%shiftl",   OPF(of_SHIFTL),   1, {OA_NUMBER, OA_NONE,   OA_NONE} },
+      { "%shiftr",   OPF(of_SHIFTR),   1, {OA_NUMBER, OA_NONE,   OA_NONE} },
+      { "%shiftr/s", OPF(of_SHIFTR_S), 1, {OA_NUMBER, OA_NONE,   OA_NONE} },
+      { "%split/vec4",    OPF(of_SPLIT_VEC4),    1,{OA_NUMBER,   OA_NONE, OA_NONE} },
+      { "%store/dar/r",   OPF(of_STORE_DAR_R),   1,{OA_FUNC_PTR, OA_NONE, OA_NONE} },
+      { "%store/dar/str", OPF(of_STORE_DAR_STR), 1,{OA_FUNC_PTR, OA_NONE, OA_NONE} },
+      { "%store/dar/vec4",OPF(of_STORE_DAR_VEC4),1,{OA_FUNC_PTR, OA_NONE, OA_NONE} },
+      { "%store/obj",   OPF(of_STORE_OBJ),   1, {OA_FUNC_PTR,OA_NONE, OA_NONE} },
+      { "%store/obja",  OPF(of_STORE_OBJA),  2, {OA_ARR_PTR, OA_BIT1, OA_NONE} },
+      { "%store/prop/obj",OPF(of_STORE_PROP_OBJ),2, {OA_NUMBER,  OA_BIT1, OA_NONE} },
+      { "%store/prop/r",  OPF(of_STORE_PROP_R),  1, {OA_NUMBER,  OA_NONE, OA_NONE} },
+      { "%store/prop/str",OPF(of_STORE_PROP_STR),1, {OA_NUMBER,  OA_NONE, OA_NONE} },
+      { "%store/prop/v",  OPF(of_STORE_PROP_V),  2, {OA_NUMBER,  OA_BIT1, OA_NONE} },
+      { "%store/qb/r",   OPF(of_STORE_QB_R),    2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%store/qb/str", OPF(of_STORE_QB_STR),  2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%store/qb/v",   OPF(of_STORE_QB_V),    3, {OA_FUNC_PTR, OA_BIT1, OA_BIT2} },
+      { "%store/qdar/r",  OPF(of_STORE_QDAR_R),  2,{OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%store/qdar/str",OPF(of_STORE_QDAR_STR),2,{OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%store/qdar/v",  OPF(of_STORE_QDAR_V),  3,{OA_FUNC_PTR, OA_BIT1, OA_BIT2} },
+      { "%store/qf/r",   OPF(of_STORE_QF_R),    2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%store/qf/str", OPF(of_STORE_QF_STR),  2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%store/qf/v",   OPF(of_STORE_QF_V),    3, {OA_FUNC_PTR, OA_BIT1, OA_BIT2} },
+      { "%store/qobj/r",  OPF(of_STORE_QOBJ_R),  2, {OA_FUNC_PTR,OA_BIT1, OA_NONE} },
+      { "%store/qobj/str",OPF(of_STORE_QOBJ_STR),2, {OA_FUNC_PTR,OA_BIT1, OA_NONE} },
+      { "%store/qobj/v",  OPF(of_STORE_QOBJ_V),  3, {OA_FUNC_PTR,OA_BIT1, OA_BIT2} },
+      { "%store/real",    OPF(of_STORE_REAL),    1, {OA_FUNC_PTR,OA_NONE, OA_NONE} },
+      { "%store/reala",   OPF(of_STORE_REALA),   2, {OA_ARR_PTR, OA_BIT1, OA_NONE} },
+      { "%store/str",     OPF(of_STORE_STR),     1, {OA_FUNC_PTR,OA_NONE, OA_NONE} },
+      { "%store/stra",    OPF(of_STORE_STRA),    2, {OA_ARR_PTR, OA_BIT1, OA_NONE} },
+      { "%store/vec4",    OPF(of_STORE_VEC4),    3, {OA_FUNC_PTR,OA_BIT1, OA_BIT2} },
+      { "%store/vec4a",   OPF(of_STORE_VEC4A),   3, {OA_ARR_PTR, OA_BIT1, OA_BIT2} },
+      { "%sub",    OPF(of_SUB),    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%sub/wr", OPF(of_SUB_WR), 0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%subi",   OPF(of_SUBI),   3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
+      { "%substr",     OPF(of_SUBSTR),     2,{OA_BIT1,    OA_BIT2, OA_NONE} },
+      { "%substr/vec4",OPF(of_SUBSTR_VEC4),2,{OA_BIT1,    OA_BIT2, OA_NONE} },
+      { "%test_nul",     OPF(of_TEST_NUL),     1,{OA_FUNC_PTR,OA_NONE,    OA_NONE} },
+      { "%test_nul/a",   OPF(of_TEST_NUL_A),   2,{OA_ARR_PTR, OA_BIT1,    OA_NONE} },
+      { "%test_nul/obj", OPF(of_TEST_NUL_OBJ), 0,{OA_NONE,    OA_NONE,    OA_NONE} },
+      { "%test_nul/prop",OPF(of_TEST_NUL_PROP),2,{OA_NUMBER,  OA_BIT1,    OA_NONE} },
+      { "%wait",   OPF(of_WAIT),   1,  {OA_FUNC_PTR, OA_NONE,     OA_NONE} },
+      { "%wait/fork",OPF(of_WAIT_FORK),0,{OA_NONE,   OA_NONE,     OA_NONE} },
+      { "%xnor",   OPF(of_XNOR),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%xnor/r", OPF(of_XNORR),  0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%xor",    OPF(of_XOR),    0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { "%xor/r",  OPF(of_XORR),   0,  {OA_NONE,     OA_NONE,     OA_NONE} },
+      { 0, OPF(of_NOOP), 0, {OA_NONE, OA_NONE, OA_NONE} }
 };
 
+# undef OPF
+
 static const unsigned opcode_count =
                     sizeof(opcode_table)/sizeof(*opcode_table) - 1;
 
@@ -331,6 +346,42 @@ static int opcode_compare(const void*k, const void*r)
       return strcmp(kp, rp->mnemonic);
 }
 
+/*
+ * This is the reverse lookup of the opcode table, from the opcode
+ * function to the mnemonic, function name and operand types. It is
+ * only used by the native code generator, so the map is made when
+ * first needed.
+ */
+const char*compile_opcode_info(vvp_code_fun fun, const char*&fun_name,
+			       bool&cptr, bool&cptr2)
+{
+      static std::map<vvp_code_fun,const struct opcode_table_s*> fun_map;
+      if (fun_map.empty()) {
+	    for (unsigned idx = 0 ; idx < opcode_count ; idx += 1)
+		  fun_map.insert(std::make_pair(opcode_table[idx].opcode,
+						opcode_table+idx));
+      }
+
+      fun_name = 0;
+      cptr = false;
+      cptr2 = false;
+
+      std::map<vvp_code_fun,const struct opcode_table_s*>::const_iterator cur
+	    = fun_map.find(fun);
+      if (cur == fun_map.end())
+	    return 0;
+
+      const struct opcode_table_s*op = cur->second;
+      for (unsigned idx = 0 ; idx < op->argc ; idx += 1) {
+	    if (op->argt[idx] == OA_CODE_PTR)
+		  cptr = true;
+	    if (op->argt[idx] == OA_CODE_PTR2)
+		  cptr2 = true;
+      }
+      fun_name = op->opcode_name;
+      return op->mnemonic;
+}
+
 /*
  * Keep a symbol table of addresses within code space. Labels on
  * executable opcodes are mapped to their address here.
@@ -373,6 +424,7 @@ void define_functor_symbol(const char*label, vvp_net_t*net)
       symbol_value_t val;
       val.net = net;
       sym_set_value(sym_functors, label, val);
+      resolv_wakeup(label);
 }
 
 static vvp_net_t*lookup_functor_symbol(const char*label)
@@ -480,11 +532,46 @@ vvp_net_t* vvp_net_lookup(const char*label)
  */
 static resolv_list_s*resolv_list = 0;
 
+/*
+ * While compile_cleanup works through the resolv_list, the resolvers
+ * that cannot yet complete are parked in the resolv_waiting table,
+ * chained by the label they are waiting for, and resolv_ready holds
+ * the resolvers that are ready to be (re)tried. The resolv_waiting
+ * table only exists during compile_cleanup.
+ */
+static symbol_map_s<resolv_list_s>*resolv_waiting = 0;
+static std::vector<std::string> resolv_waiting_labels;
+static resolv_list_s*resolv_ready = 0;
+static unsigned resolv_waiting_count = 0;
+
 resolv_list_s::~resolv_list_s()
 {
       free(label_);
 }
 
+/*
+ * The label has just been defined, so move any resolvers that are
+ * waiting for it to the ready list.
+ */
+void resolv_wakeup(const char*label)
+{
+      if (resolv_waiting == 0)
+	    return;
+
+      resolv_list_s*cur = resolv_waiting->sym_get_value(label);
+      if (cur == 0)
+	    return;
+
+      resolv_waiting->sym_set_value(label, 0);
+      while (cur) {
+	    resolv_list_s*tmp = cur->next;
+	    cur->next = resolv_ready;
+	    resolv_ready = cur;
+	    resolv_waiting_count -= 1;
+	    cur = tmp;
+      }
+}
+
 void resolv_submit(resolv_list_s*cur)
 {
       if (cur->resolve()) {
@@ -777,7 +864,51 @@ void compile_cleanup(void)
 	    fflush(stderr);
       }
 
-      do {
+	/* Try each resolver in turn. The ones that cannot complete are
+	   parked by their label, and are retried as soon as some other
+	   resolver defines that label. */
+      resolv_waiting = new symbol_map_s<resolv_list_s>;
+      resolv_ready = resolv_list;
+      resolv_list = 0;
+      while (resolv_ready) {
+	    resolv_list_s *cur = resolv_ready;
+	    resolv_ready = cur->next;
+	    if (cur->resolve()) {
+		  delete cur;
+		  continue;
+	    }
+
+	    resolv_list_s *wait = resolv_waiting->sym_get_value(cur->label());
+	    if (wait == 0)
+		  resolv_waiting_labels.push_back(cur->label());
+	    cur->next = wait;
+	    resolv_waiting->sym_set_value(cur->label(), cur);
+	    resolv_waiting_count += 1;
+      }
+
+	/* Anything still parked is waiting for a label that is never
+	   defined, or that is defined in some way that does not wake
+	   its resolvers. Put them back on the resolv_list, and go
+	   through them as before until no more progress is made, then
+	   report the ones that are left. */
+      if (resolv_waiting_count > 0) {
+	    for (size_t idx = 0 ; idx < resolv_waiting_labels.size() ; idx += 1) {
+		  const char*label = resolv_waiting_labels[idx].c_str();
+		  resolv_list_s *cur = resolv_waiting->sym_get_value(label);
+		  while (cur) {
+			resolv_list_s *tmp = cur->next;
+			cur->next = resolv_list;
+			resolv_list = cur;
+			cur = tmp;
+		  }
+	    }
+      }
+      delete resolv_waiting;
+      resolv_waiting = 0;
+      resolv_waiting_labels.clear();
+      resolv_waiting_count = 0;
+
+      while (resolv_list) {
 	    resolv_list_s *res = resolv_list;
 	    resolv_list = 0x0;
 	    last = nerrs == lnerrs;
@@ -798,7 +929,9 @@ void compile_cleanup(void)
 		  fprintf(stderr,
 			  "compile_cleanup: %d unresolved items\n",
 			  nerrs);
-      } while (nerrs && !last);
+	    if (last)
+		  break;
+      }
 
       compile_errors += nerrs;
 
@@ -826,6 +959,27 @@ void compile_cleanup(void)
       compile_island_cleanup();
       compile_array_cleanup();
 
+	/* The netlist is complete, so sort the logic into levels if
+	   levelized evaluation is enabled. */
+      levelize_netlist();
+
+	/* Then move the long fan-out lists into flat arrays, if that
+	   is enabled. */
+      fanout_netlist();
+
+	/* Now that the code is linked, replace the common instruction
+	   sequences with fused instructions. */
+      codespace_fuse();
+
+	/* Write or load the native thread code. */
+      native_compile();
+
+#ifdef VVP_THREADED_DISPATCH
+	/* All the code is in place now, so bind the instructions to
+	   the labels of the threaded thread engine. */
+      vthread_threaded_link();
+#endif
+
       if (verbose_flag) {
 	    fprintf(stderr, " ... Compiletf functions\n");
 	    fflush(stderr);
@@ -850,6 +1004,7 @@ void compile_vpi_symbol(const char*label, vpiHandle obj)
       symbol_value_t val;
       val.ptr = obj;
       sym_set_value(sym_vpi, label, val);
+      resolv_wakeup(label);
 }
 
 /*
@@ -1988,6 +2143,11 @@ void compile_thread(char*start_sym, char*flag)
       if (flag && (strcmp(flag,"$push") == 0))
 	    push_flag = true;
 
+      if (profile_flag)
+	    profile_label(pc, start_sym);
+
+      native_thread_start(pc);
+
       vthread_t thr = vthread_new(pc, vpip_peek_current_scope());
 
       if (flag && (strcmp(flag,"$init") == 0))
@@ -48,6 +48,13 @@ extern void compile_cleanup(void);
 
 extern bool verbose_flag;
 
+/*
+ * With the two_state_flag (vvp -2) the static vector variables and
+ * arrays are all made 2-state, as if they were declared bit, so that
+ * they start at 0 and drop any X or Z bits written to them.
+ */
+extern bool two_state_flag;
+
 /*
  * If this file opened, then write debug information to this
  * file. This is used for debugging the VVP runtime itself.
@@ -308,6 +315,12 @@ extern void compile_param_real(char*label, char*name, char*value,
  * The mes parameter of the resolve method tells the resolver that
  * this call is its last chance. If it cannot complete the operation,
  * it must print an error message and return false.
+ *
+ * A resolver that cannot complete is waiting for its label to be
+ * defined, so the compile_cleanup function parks it with the other
+ * resolvers waiting for the same label, and the resolv_wakeup function
+ * retries them when a resolver defines that label. This resolves the
+ * whole list in a single pass, whatever order the references are in.
  */
 class resolv_list_s {
 
@@ -323,12 +336,20 @@ class resolv_list_s {
 
     private:
       friend void resolv_submit(class resolv_list_s*cur);
+      friend void resolv_wakeup(const char*label);
       friend void compile_cleanup(void);
 
       char*label_;
       class resolv_list_s*next;
 };
 
+/*
+ * Tell the resolvers waiting for the label that it is now defined.
+ * The define_functor_symbol and compile_vpi_symbol functions call
+ * this for every label that they define.
+ */
+extern void resolv_wakeup(const char*label);
+
 /*
  * This function schedules a lookup of an indexed label. The ref
  * points to the vvp_net_t that receives the result. The result may
@@ -27,7 +27,7 @@ using namespace std;
 
 vvp_fun_concat::vvp_fun_concat(unsigned w0, unsigned w1,
 			       unsigned w2, unsigned w3)
-: val_(w0+w1+w2+w3)
+: val_(w0+w1+w2+w3), sent_(false)
 {
       wid_[0] = w0;
       wid_[1] = w1;
@@ -58,10 +58,14 @@ void vvp_fun_concat::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       for (unsigned idx = 0 ;  idx < pdx ;  idx += 1)
 	    off += wid_[idx];
 
-      for (unsigned idx = 0 ;  idx < wid_[pdx] ;  idx += 1) {
-	    val_.set_bit(off+idx, bit.value(idx));
+	// The other inputs are as they were, so if this one did not
+	// change, neither did the output.
+      if (! val_.set_vec(off, bit) && sent_) {
+	    count_unchanged_sends += 1;
+	    return;
       }
 
+      sent_ = true;
       port.ptr()->send_vec4(val_, 0);
 }
 
@@ -85,11 +89,20 @@ void vvp_fun_concat::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       unsigned limit = off + wid_[pdx];
 
       off += base;
+      bool changed = false;
       for (unsigned idx = 0 ;  idx < wid ;  idx += 1) {
             if (off+idx >= limit) break;
+	    if (val_.value(off+idx) == bit.value(idx)) continue;
 	    val_.set_bit(off+idx, bit.value(idx));
+	    changed = true;
+      }
+
+      if (! changed && sent_) {
+	    count_unchanged_sends += 1;
+	    return;
       }
 
+      sent_ = true;
       port.ptr()->send_vec4(val_, 0);
 }
 
@@ -19,6 +19,7 @@
 
 #include "delay.h"
 #include "schedule.h"
+#include "checkpoint.h"
 #include "vpi_priv.h"
 #include "config.h"
 #ifdef CHECK_WITH_VALGRIND
@@ -507,6 +508,140 @@ void vvp_fun_delay::run_run_real_(struct vvp_fun_delay::event_*cur)
       net_->send_real(cur_real_, 0);
 }
 
+/*
+ * The checkpoint holds the current output and the transitions that
+ * are still on their way. The scheduler saves the events that will
+ * run them (see checkpoint_event), so here only the list is saved.
+ */
+bool vvp_fun_delay::save_state(vvp_checkpoint_out&out) const
+{
+      if (initial_ && list_ == 0)
+	    return false;
+
+      out.put_uint(type_);
+      out.put_uint(initial_? 1 : 0);
+      switch (type_) {
+	  case VEC4_DELAY:
+	    out.put_vec4(cur_vec4_);
+	    break;
+	  case VEC8_DELAY:
+	    out.put_vec8(cur_vec8_);
+	    break;
+	  case REAL_DELAY:
+	    out.put_real(cur_real_);
+	    break;
+	  default:
+	    break;
+      }
+
+      size_t count = 0;
+      if (list_) {
+	    struct event_*cur = list_;
+	    do {
+		  count += 1;
+		  cur = cur->next;
+	    } while (cur != list_);
+      }
+      out.put_uint(count);
+
+      if (list_) {
+	    struct event_*cur = list_->next;
+	    for (;;) {
+		  out.put_uint(cur->sim_time);
+		  if (cur->run_run_ptr == &vvp_fun_delay::run_run_vec4_) {
+			out.put_uint(VEC4_DELAY);
+			out.put_vec4(cur->ptr_vec4);
+		  } else if (cur->run_run_ptr == &vvp_fun_delay::run_run_vec8_) {
+			out.put_uint(VEC8_DELAY);
+			out.put_vec8(cur->ptr_vec8);
+		  } else {
+			out.put_uint(REAL_DELAY);
+			out.put_real(cur->ptr_real);
+		  }
+		  if (cur == list_)
+			break;
+		  cur = cur->next;
+	    }
+      }
+
+      return true;
+}
+
+void vvp_fun_delay::restore_state(vvp_net_t*, vvp_checkpoint_in&in)
+{
+      uint64_t type = in.get_uint();
+      if (type > REAL_DELAY) {
+	    in.error("bad delay type");
+	    return;
+      }
+      type_ = (delay_type_t)type;
+      initial_ = in.get_uint() != 0;
+      switch (type_) {
+	  case VEC4_DELAY:
+	    cur_vec4_ = in.get_vec4();
+	    break;
+	  case VEC8_DELAY:
+	    cur_vec8_ = in.get_vec8();
+	    break;
+	  case REAL_DELAY:
+	    cur_real_ = in.get_real();
+	    break;
+	  default:
+	    break;
+      }
+
+      while (struct event_*cur = dequeue_())
+	    delete cur;
+
+      uint64_t count = in.get_uint();
+      for (uint64_t idx = 0 ; idx < count && !in.bad() ; idx += 1) {
+	    struct event_*cur = new struct event_(in.get_uint());
+	    switch (in.get_uint()) {
+		case VEC4_DELAY:
+		  cur->run_run_ptr = &vvp_fun_delay::run_run_vec4_;
+		  cur->ptr_vec4 = in.get_vec4();
+		  break;
+		case VEC8_DELAY:
+		  cur->run_run_ptr = &vvp_fun_delay::run_run_vec8_;
+		  cur->ptr_vec8 = in.get_vec8();
+		  break;
+		case REAL_DELAY:
+		  cur->run_run_ptr = &vvp_fun_delay::run_run_real_;
+		  cur->ptr_real = in.get_real();
+		  break;
+		default:
+		  in.error("bad delay event");
+		  delete cur;
+		  return;
+	    }
+	    enqueue_(cur);
+      }
+
+	// The initial value was already sent when the design was
+	// initialized.
+      if (initial_)
+	    return;
+
+      switch (type_) {
+	  case VEC4_DELAY:
+	    in.send_later(net_, cur_vec4_);
+	    break;
+	  case VEC8_DELAY:
+	    in.send_later(net_, cur_vec8_);
+	    break;
+	  case REAL_DELAY:
+	    in.send_later(net_, cur_real_);
+	    break;
+	  default:
+	    break;
+      }
+}
+
+vvp_gen_event_s* vvp_fun_delay::checkpoint_event()
+{
+      return this;
+}
+
 vvp_fun_modpath::vvp_fun_modpath(vvp_net_t*net, unsigned width)
 : net_(net), src_list_(0), ifnone_list_(0)
 {
@@ -676,6 +811,28 @@ void vvp_fun_modpath::run_run()
       net_->send_vec4(cur_vec4_, 0);
 }
 
+/*
+ * The output of a modpath is the value that it last received, except
+ * while a transition is on its way. The checkpoint does not tell the
+ * two apart, so a restored modpath sends the new value right away.
+ */
+bool vvp_fun_modpath::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec4(cur_vec4_);
+      return true;
+}
+
+void vvp_fun_modpath::restore_state(vvp_net_t*, vvp_checkpoint_in&in)
+{
+      cur_vec4_ = in.get_vec4();
+      in.send_later(net_, cur_vec4_);
+}
+
+vvp_gen_event_s* vvp_fun_modpath::checkpoint_event()
+{
+      return this;
+}
+
 vvp_fun_modpath_src::vvp_fun_modpath_src(vvp_time64_t del[12])
 {
       for (unsigned idx = 0 ;  idx < 12 ;  idx += 1)
@@ -724,6 +881,27 @@ bool vvp_fun_modpath_src::test_vec4(const vvp_vector4_t&)
       return true;
 }
 
+/*
+ * The delays are saved as well, since they may have been annotated
+ * by SDF at run time.
+ */
+bool vvp_fun_modpath_src::save_state(vvp_checkpoint_out&out) const
+{
+      for (unsigned idx = 0 ;  idx < 12 ;  idx += 1)
+	    out.put_uint(delay_[idx]);
+      out.put_uint(wake_time_);
+      out.put_uint(condition_flag_? 1 : 0);
+      return true;
+}
+
+void vvp_fun_modpath_src::restore_state(vvp_net_t*, vvp_checkpoint_in&in)
+{
+      for (unsigned idx = 0 ;  idx < 12 ;  idx += 1)
+	    delay_[idx] = in.get_uint();
+      wake_time_ = in.get_uint();
+      condition_flag_ = in.get_uint() != 0;
+}
+
 vvp_fun_modpath_edge::vvp_fun_modpath_edge(vvp_time64_t del[12],
 					   bool pos, bool neg)
 : vvp_fun_modpath_src(del)
@@ -744,6 +922,19 @@ bool vvp_fun_modpath_edge::test_vec4(const vvp_vector4_t&bit)
       return false;
 }
 
+bool vvp_fun_modpath_edge::save_state(vvp_checkpoint_out&out) const
+{
+      vvp_fun_modpath_src::save_state(out);
+      out.put_uint(old_value_);
+      return true;
+}
+
+void vvp_fun_modpath_edge::restore_state(vvp_net_t*net, vvp_checkpoint_in&in)
+{
+      vvp_fun_modpath_src::restore_state(net, in);
+      old_value_ = (vvp_bit4_t) (in.get_uint() & 3);
+}
+
 
 /*
  * All the below routines that begin with
@@ -1186,6 +1377,27 @@ void vvp_fun_intermodpath::run_run()
       net_->send_vec4(cur_vec4_, 0);
 }
 
+bool vvp_fun_intermodpath::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_vec4(cur_vec4_);
+      for (unsigned idx = 0 ;  idx < 12 ;  idx += 1)
+	    out.put_uint(delay_[idx]);
+      return true;
+}
+
+void vvp_fun_intermodpath::restore_state(vvp_net_t*, vvp_checkpoint_in&in)
+{
+      cur_vec4_ = in.get_vec4();
+      for (unsigned idx = 0 ;  idx < 12 ;  idx += 1)
+	    delay_[idx] = in.get_uint();
+      in.send_later(net_, cur_vec4_);
+}
+
+vvp_gen_event_s* vvp_fun_intermodpath::checkpoint_event()
+{
+      return this;
+}
+
 /*
  * All the below routines that begin with
  * intermodpath_* belong the internal function
@@ -103,6 +103,10 @@ class vvp_fun_delay  : public vvp_net_fun_t, private vvp_gen_event_s {
       void recv_vec8_pv(vvp_net_ptr_t ptr, const vvp_vector8_t&bit,
 			unsigned base, unsigned vwid);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_net_t*net, vvp_checkpoint_in&in);
+      vvp_gen_event_s*checkpoint_event();
+
     private:
       virtual void run_run();
 
@@ -174,6 +178,10 @@ class vvp_fun_modpath  : public vvp_net_fun_t, private vvp_gen_event_s {
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_net_t*net, vvp_checkpoint_in&in);
+      vvp_gen_event_s*checkpoint_event();
+
     private:
       virtual void run_run();
 
@@ -207,6 +215,9 @@ class vvp_fun_modpath_src  : public vvp_net_fun_t {
       void get_delay12(vvp_time64_t out[12]) const;
       void put_delay12(const vvp_time64_t in[12]);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_net_t*net, vvp_checkpoint_in&in);
+
     private:
 	// FIXME: Needs to be a 12-value array
       vvp_time64_t delay_[12];
@@ -228,6 +239,9 @@ class vvp_fun_modpath_edge  : public vvp_fun_modpath_src {
 
       bool test_vec4(const vvp_vector4_t&bit);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_net_t*net, vvp_checkpoint_in&in);
+
     private:
       vvp_bit4_t old_value_;
       bool posedge_;
@@ -251,6 +265,10 @@ class vvp_fun_intermodpath  : public vvp_net_fun_t, private vvp_gen_event_s {
       void get_delay12(vvp_time64_t out[12]) const;
       void put_delay12(const vvp_time64_t in[12]);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_net_t*net, vvp_checkpoint_in&in);
+      vvp_gen_event_s*checkpoint_event();
+
     private:
       virtual void run_run();
 
@@ -20,6 +20,7 @@
 # include  "compile.h"
 # include  "schedule.h"
 # include  "dff.h"
+# include  "checkpoint.h"
 # include  <climits>
 # include  <cstdio>
 # include  <cassert>
@@ -38,7 +39,7 @@
    the flip-flop operates normally. */
 
 vvp_dff::vvp_dff(unsigned width, bool negedge)
-: clk_(BIT4_X), ena_(BIT4_X), asc_(BIT4_Z), d_(width, BIT4_X)
+: clk_(BIT4_X), ena_(BIT4_X), asc_(BIT4_Z), d_(width, BIT4_X), q_(width, BIT4_X)
 {
       clk_active_ = negedge ? BIT4_0 : BIT4_1;
 }
@@ -83,7 +84,7 @@ void vvp_dff::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 	    tmp = clk_;
 	    clk_ = bit.value(0);
 	    if (clk_ == clk_active_ && tmp != clk_active_)
-		  schedule_propagate_vector(port.ptr(), 0, d_);
+		  propagate_(port.ptr(), d_);
 	    break;
 
 	  case 2: // CE
@@ -97,8 +98,10 @@ void vvp_dff::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 	    asc_ = bit.value(0);
 	    if (asc_ == BIT4_1 && tmp != BIT4_1)
 		  recv_async(port);
-	    else if (tmp == BIT4_Z)
-		  port.ptr()->send_vec4(vvp_vector4_t(d_.size(), BIT4_X), 0);
+	    else if (tmp == BIT4_Z) {
+		  q_ = vvp_vector4_t(d_.size(), BIT4_X);
+		  port.ptr()->send_vec4(q_, 0);
+	    }
 	    break;
       }
 }
@@ -109,6 +112,32 @@ void vvp_dff::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       recv_vec4_pv_(ptr, bit, base, vwid, ctx);
 }
 
+void vvp_dff::propagate_(vvp_net_t*net, const vvp_vector4_t&val)
+{
+      q_ = val;
+      schedule_propagate_vector(net, 0, val);
+}
+
+bool vvp_dff::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_uint(clk_);
+      out.put_uint(ena_);
+      out.put_uint(asc_);
+      out.put_vec4(d_);
+      out.put_vec4(q_);
+      return true;
+}
+
+void vvp_dff::restore_state(vvp_net_t*net, vvp_checkpoint_in&in)
+{
+      clk_ = (vvp_bit4_t) (in.get_uint() & 3);
+      ena_ = (vvp_bit4_t) (in.get_uint() & 3);
+      asc_ = (vvp_bit4_t) (in.get_uint() & 3);
+      d_ = in.get_vec4();
+      q_ = in.get_vec4();
+      in.send_later(net, q_);
+}
+
 /*
  * The recv_async functions respond to the asynchronous
  * set/clear input by propagating the desired output.
@@ -124,17 +153,17 @@ void vvp_dff::recv_async(vvp_net_ptr_t)
 
 void vvp_dff_aclr::recv_async(vvp_net_ptr_t port)
 {
-      schedule_propagate_vector(port.ptr(), 0, vvp_vector4_t(d_.size(), BIT4_0));
+      propagate_(port.ptr(), vvp_vector4_t(d_.size(), BIT4_0));
 }
 
 void vvp_dff_aset::recv_async(vvp_net_ptr_t port)
 {
-      schedule_propagate_vector(port.ptr(), 0, vvp_vector4_t(d_.size(), BIT4_1));
+      propagate_(port.ptr(), vvp_vector4_t(d_.size(), BIT4_1));
 }
 
 void vvp_dff_asc::recv_async(vvp_net_ptr_t port)
 {
-      schedule_propagate_vector(port.ptr(), 0, asc_value_);
+      propagate_(port.ptr(), asc_value_);
 }
 
 void compile_dff(char*label, unsigned width, bool negedge,
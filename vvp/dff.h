@@ -47,6 +47,9 @@ class vvp_dff : public vvp_net_fun_t {
       void recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 			unsigned base, unsigned vwid, vvp_context_t ctx);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_net_t*net, vvp_checkpoint_in&in);
+
     private:
       virtual void recv_async(vvp_net_ptr_t port);
 
@@ -57,6 +60,11 @@ class vvp_dff : public vvp_net_fun_t {
 
     protected:
       vvp_vector4_t d_;
+	// The value most recently sent to the output. This is only
+	// needed to restore the output from a checkpoint.
+      vvp_vector4_t q_;
+	// Schedule the value to be sent to the output.
+      void propagate_(vvp_net_t*net, const vvp_vector4_t&val);
 };
 
 /*
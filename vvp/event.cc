@@ -52,6 +52,11 @@ void waitable_hooks_s::run_waiting_threads_(vthread_t&threads)
       vthread_schedule_list(tmp);
 }
 
+vthread_t* waitable_hooks_s::waiting_threads()
+{
+      return 0;
+}
+
 evctl::evctl(unsigned long ecount)
 {
       ecount_ = ecount;
@@ -268,6 +273,11 @@ vthread_t vvp_fun_edge_sa::add_waiting_thread(vthread_t thread)
       return tmp;
 }
 
+vthread_t* vvp_fun_edge_sa::waiting_threads()
+{
+      return &threads_;
+}
+
 void vvp_fun_edge_sa::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                                 vvp_context_t)
 {
@@ -589,6 +599,11 @@ vthread_t vvp_fun_anyedge_sa::add_waiting_thread(vthread_t thread)
       return tmp;
 }
 
+vthread_t* vvp_fun_anyedge_sa::waiting_threads()
+{
+      return &threads_;
+}
+
 void vvp_fun_anyedge_sa::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                                    vvp_context_t)
 {
@@ -803,6 +818,11 @@ vthread_t vvp_fun_event_or_sa::add_waiting_thread(vthread_t thread)
       return tmp;
 }
 
+vthread_t* vvp_fun_event_or_sa::waiting_threads()
+{
+      return &threads_;
+}
+
 void vvp_fun_event_or_sa::recv_vec4(vvp_net_ptr_t, const vvp_vector4_t&bit,
                                     vvp_context_t)
 {
@@ -898,6 +918,11 @@ vthread_t vvp_named_event_sa::add_waiting_thread(vthread_t thread)
       return tmp;
 }
 
+vthread_t* vvp_named_event_sa::waiting_threads()
+{
+      return &threads_;
+}
+
 void vvp_named_event_sa::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                                    vvp_context_t)
 {
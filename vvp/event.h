@@ -125,6 +125,9 @@ struct waitable_hooks_s {
       virtual ~waitable_hooks_s() {}
 
       virtual vthread_t add_waiting_thread(vthread_t thread) = 0;
+	// Return the list of threads waiting on a statically allocated
+	// event, or nil for automatic events. Checkpoints use this.
+      virtual vthread_t*waiting_threads();
 
       evctl*event_ctls;
       evctl**last;
@@ -181,6 +184,7 @@ class vvp_fun_edge_sa : public vvp_fun_edge {
       virtual ~vvp_fun_edge_sa();
 
       vthread_t add_waiting_thread(vthread_t thread);
+      vthread_t*waiting_threads();
 
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t context);
@@ -252,6 +256,7 @@ class vvp_fun_anyedge_sa : public vvp_fun_anyedge {
       virtual ~vvp_fun_anyedge_sa();
 
       vthread_t add_waiting_thread(vthread_t thread);
+      vthread_t*waiting_threads();
 
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t context);
@@ -327,6 +332,7 @@ class vvp_fun_event_or_sa : public vvp_fun_event_or {
       ~vvp_fun_event_or_sa();
 
       vthread_t add_waiting_thread(vthread_t thread);
+      vthread_t*waiting_threads();
 
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t context);
@@ -385,6 +391,7 @@ class vvp_named_event_sa : public vvp_named_event {
       ~vvp_named_event_sa();
 
       vthread_t add_waiting_thread(vthread_t thread);
+      vthread_t*waiting_threads();
 
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t);
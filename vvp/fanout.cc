@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+# include  "config.h"
+# include  "fanout.h"
+# include  "delay.h"
+# include  "statistics.h"
+# include  <vector>
+# include  <cassert>
+
+using namespace std;
+
+bool fanout_flag = false;
+
+unsigned long count_fanout_nets = 0;
+unsigned long count_fanout_receivers = 0;
+
+/*
+ * Nets with fewer receivers than this keep their lists, since the
+ * fanout net adds a call of its own to each send.
+ */
+static const unsigned FANOUT_MIN = 4;
+
+  // The drivers that have fanout nets.
+static vector<vvp_net_t*> fanout_drivers;
+
+vvp_fun_fanout::vvp_fun_fanout(const entry_s*list, unsigned count)
+: list_(list), count_(count)
+{
+}
+
+vvp_fun_fanout::~vvp_fun_fanout()
+{
+}
+
+void vvp_fun_fanout::recv_vec4(vvp_net_ptr_t, const vvp_vector4_t&bit,
+			       vvp_context_t context)
+{
+      for (const entry_s*cur = list_ ; cur != list_+count_ ; cur += 1) {
+	    if (profile_flag)
+		  profile_recv(cur->fun);
+	    cur->fun->recv_vec4(cur->ptr, bit, context);
+      }
+}
+
+void vvp_fun_fanout::recv_vec8(vvp_net_ptr_t, const vvp_vector8_t&bit)
+{
+      for (const entry_s*cur = list_ ; cur != list_+count_ ; cur += 1) {
+	    if (profile_flag)
+		  profile_recv(cur->fun);
+	    cur->fun->recv_vec8(cur->ptr, bit);
+      }
+}
+
+void vvp_fun_fanout::recv_real(vvp_net_ptr_t, double bit,
+			       vvp_context_t context)
+{
+      for (const entry_s*cur = list_ ; cur != list_+count_ ; cur += 1) {
+	    if (profile_flag)
+		  profile_recv(cur->fun);
+	    cur->fun->recv_real(cur->ptr, bit, context);
+      }
+}
+
+void vvp_fun_fanout::recv_string(vvp_net_ptr_t, const std::string&bit,
+				 vvp_context_t context)
+{
+      for (const entry_s*cur = list_ ; cur != list_+count_ ; cur += 1) {
+	    if (profile_flag)
+		  profile_recv(cur->fun);
+	    cur->fun->recv_string(cur->ptr, bit, context);
+      }
+}
+
+void vvp_fun_fanout::recv_object(vvp_net_ptr_t, vvp_object_t bit,
+				 vvp_context_t context)
+{
+      for (const entry_s*cur = list_ ; cur != list_+count_ ; cur += 1) {
+	    if (profile_flag)
+		  profile_recv(cur->fun);
+	    cur->fun->recv_object(cur->ptr, bit, context);
+      }
+}
+
+void vvp_fun_fanout::recv_vec4_pv(vvp_net_ptr_t, const vvp_vector4_t&bit,
+				  unsigned base, unsigned vwid,
+				  vvp_context_t context)
+{
+      for (const entry_s*cur = list_ ; cur != list_+count_ ; cur += 1) {
+	    if (profile_flag)
+		  profile_recv(cur->fun);
+	    cur->fun->recv_vec4_pv(cur->ptr, bit, base, vwid, context);
+      }
+}
+
+void vvp_fun_fanout::recv_vec8_pv(vvp_net_ptr_t, const vvp_vector8_t&bit,
+				  unsigned base, unsigned vwid)
+{
+      for (const entry_s*cur = list_ ; cur != list_+count_ ; cur += 1) {
+	    if (profile_flag)
+		  profile_recv(cur->fun);
+	    cur->fun->recv_vec8_pv(cur->ptr, bit, base, vwid);
+      }
+}
+
+/*
+ * Count the receivers in the list of a net, or return 0 if the list
+ * must stay as it is. The vvp_fun_modpath_src functors are kept at
+ * the front of the list by vvp_net_t::link, which a fanout net would
+ * get in the way of.
+ */
+static unsigned fanout_count_(const vvp_net_t*net)
+{
+      unsigned count = 0;
+      for (vvp_net_ptr_t cur = net->out_ ; ! cur.nil()
+		 ; cur = cur.ptr()->port[cur.port()]) {
+	    vvp_net_fun_t*fun = cur.ptr()->fun;
+	    if (fun == 0)
+		  continue;
+	    if (dynamic_cast<vvp_fun_modpath_src*>(fun))
+		  return 0;
+	    count += 1;
+      }
+      return count;
+}
+
+static void fanout_collect_(vvp_net_t*net, void*cd)
+{
+      if (fanout_count_(net) >= FANOUT_MIN)
+	    static_cast<vector<vvp_net_t*>*>(cd)->push_back(net);
+}
+
+/*
+ * The arrays of all the fanout nets are in one block, in the order of
+ * the nets, so the arrays of nets that are made together are near
+ * each other in memory.
+ */
+void fanout_netlist(void)
+{
+      if (! fanout_flag)
+	    return;
+
+      vector<vvp_net_t*> nets;
+      vvp_net_for_each(&fanout_collect_, &nets);
+
+      size_t total = 0;
+      for (size_t idx = 0 ; idx < nets.size() ; idx += 1)
+	    total += fanout_count_(nets[idx]);
+      if (total == 0)
+	    return;
+
+      vvp_fun_fanout::entry_s*block = new vvp_fun_fanout::entry_s[total];
+      vvp_fun_fanout::entry_s*list = block;
+
+      for (size_t idx = 0 ; idx < nets.size() ; idx += 1) {
+	    vvp_net_t*net = nets[idx];
+	    unsigned count = 0;
+	    for (vvp_net_ptr_t cur = net->out_ ; ! cur.nil()
+		       ; cur = cur.ptr()->port[cur.port()]) {
+		  if (cur.ptr()->fun == 0)
+			continue;
+		  list[count].fun = cur.ptr()->fun;
+		  list[count].ptr = cur;
+		  count += 1;
+	    }
+
+	    vvp_net_t*fan = new vvp_net_t;
+	    fan->fun = new vvp_fun_fanout(list, count);
+	    fan->out_ = net->out_;
+	    net->out_ = vvp_net_ptr_t(fan, 0);
+	    fanout_drivers.push_back(net);
+
+	    list += count;
+	    count_fanout_nets += 1;
+	    count_fanout_receivers += count;
+      }
+      assert(list == block+total);
+}
+
+bool fanout_expand(vvp_net_ptr_t&link)
+{
+      vvp_net_t*fan = link.ptr();
+      if (! dynamic_cast<vvp_fun_fanout*>(fan->fun))
+	    return false;
+
+      assert(fan->port[0].nil());
+      link = fan->out_;
+      fan->out_ = vvp_net_ptr_t(0,0);
+      return true;
+}
+
+/*
+ * A fanout net is always at the end of the list of its driver, since
+ * new links go in front of it, so follow the list to the end.
+ */
+void fanout_expand_all(void)
+{
+      for (size_t idx = 0 ; idx < fanout_drivers.size() ; idx += 1) {
+	    vvp_net_ptr_t*cur = &fanout_drivers[idx]->out_;
+	    while (! cur->nil() && ! fanout_expand(*cur))
+		  cur = &cur->ptr()->port[cur->port()];
+      }
+      fanout_drivers.clear();
+}
@@ -0,0 +1,91 @@
+#ifndef IVL_fanout_H
+#define IVL_fanout_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "vvp_net.h"
+
+/*
+ * Flat fanouts (the -f flag). The fanout of a net is a list threaded
+ * through the input ports of the nets that receive it (see vvp_net_t),
+ * so a send visits each receiving net in turn, wherever it is in
+ * memory. After the netlist is linked, the list of each net with many
+ * receivers is moved behind a fanout net, whose vvp_fun_fanout holds
+ * the receiving functors and their ports in an array, and delivers
+ * values from that without touching the receiving nets.
+ *
+ * The list itself is kept as the output of the fanout net, so code
+ * that walks the netlist still sees all of it, and a send that starts
+ * part way down the list still works. Nets that are linked at run
+ * time go in front of the fanout net. A receiver that is unlinked at
+ * run time is behind the fanout net, so then the list is put back
+ * where it was and the fanout net is left unused.
+ */
+extern bool fanout_flag;
+
+/*
+ * The compile_cleanup function calls this after the netlist is
+ * linked. It does nothing unless fanout_flag is set.
+ */
+extern void fanout_netlist(void);
+
+/*
+ * If the link refers to a fanout net, replace it with the list that
+ * the fanout net holds and return true. This is for unlink.
+ */
+extern bool fanout_expand(vvp_net_ptr_t&link);
+
+/*
+ * Put back the lists of all the fanout nets. This is for code that
+ * changes the netlist in ways that it does not know about.
+ */
+extern void fanout_expand_all(void);
+
+class vvp_fun_fanout : public vvp_net_fun_t {
+
+    public:
+      struct entry_s {
+	    vvp_net_fun_t*fun;
+	    vvp_net_ptr_t ptr;
+      };
+
+      vvp_fun_fanout(const entry_s*list, unsigned count);
+      ~vvp_fun_fanout();
+
+      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                     vvp_context_t context);
+      void recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit);
+      void recv_real(vvp_net_ptr_t port, double bit,
+                     vvp_context_t context);
+      void recv_string(vvp_net_ptr_t port, const std::string&bit,
+		       vvp_context_t context);
+      void recv_object(vvp_net_ptr_t port, vvp_object_t bit,
+		       vvp_context_t context);
+
+      void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			unsigned base, unsigned vwid, vvp_context_t context);
+      void recv_vec8_pv(vvp_net_ptr_t port, const vvp_vector8_t&bit,
+			unsigned base, unsigned vwid);
+
+    private:
+      const entry_s*list_;
+      unsigned count_;
+};
+
+#endif /* IVL_fanout_H */
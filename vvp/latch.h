@@ -40,9 +40,14 @@ class vvp_latch : public vvp_net_fun_t {
       void recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 			unsigned base, unsigned vwid, vvp_context_t ctx);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_net_t*net, vvp_checkpoint_in&in);
+
     private:
       vvp_bit4_t en_;
       vvp_vector4_t d_;
+	// The value most recently sent to the output, for checkpoints.
+      vvp_vector4_t q_;
 };
 
 #endif /* IVL_latch_H */
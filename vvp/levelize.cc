@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "levelize.h"
+# include  "logic.h"
+# include  "delay.h"
+# include  "dff.h"
+# include  "latch.h"
+# include  "statistics.h"
+# include  <vector>
+# include  <algorithm>
+# include  <climits>
+
+using namespace std;
+
+/*
+ * The levelizer builds a graph with a node for each levelizable logic
+ * functor, and an edge from each functor to the levelizable functors
+ * that its output reaches. The output may pass through any number of
+ * other nodes (signals, part selects, concatenations, arithmetic and
+ * so on) that propagate values as they receive them, but paths stop
+ * at nodes that hold or delay values, as those do not take part in
+ * the combinational evaluation of the time step.
+ *
+ * The strongly connected components of the graph are found with
+ * Tarjan's algorithm, which also gives the components in reverse
+ * topological order. Components with more than one functor (or a
+ * functor that feeds itself) are combinational loops, and those
+ * functors are left to schedule their own events. The rest get a
+ * level one more than the highest level that drives them.
+ *
+ * Getting an edge wrong does not break the simulation, since the
+ * sweep in schedule.cc copes with functors queued out of order, but
+ * it may cost extra evaluations.
+ */
+
+bool levelize_flag = false;
+
+unsigned long count_levelized_functors = 0;
+unsigned long count_levelized_loops = 0;
+unsigned long count_logic_levels = 0;
+
+static const unsigned NO_NODE = UINT_MAX;
+
+/*
+ * Return true if values passed to this functor do not go straight
+ * on to its output.
+ */
+static bool stops_propagation(vvp_net_fun_t*fun)
+{
+      if (fun == 0)
+	    return true;
+      if (dynamic_cast<vvp_dff*>(fun))
+	    return true;
+      if (dynamic_cast<vvp_latch*>(fun))
+	    return true;
+      if (dynamic_cast<vvp_fun_delay*>(fun))
+	    return true;
+      if (dynamic_cast<vvp_fun_modpath*>(fun))
+	    return true;
+      if (dynamic_cast<vvp_fun_intermodpath*>(fun))
+	    return true;
+      return false;
+}
+
+struct levelize_graph_s {
+      vvp_net_table_t table;
+      vector<unsigned> node_of;
+      vector<size_t> nodes;
+	// The edges out of node n are edges[edge_start[n]] up to
+	// edges[edge_start[n+1]].
+      vector<size_t> edge_start;
+      vector<unsigned> edges;
+
+      void find_edges(void);
+};
+
+void levelize_graph_s::find_edges(void)
+{
+      vector<unsigned> visited (table.size(), NO_NODE);
+      vector<vvp_net_t*> work;
+
+      edge_start.resize(nodes.size() + 1);
+      for (unsigned node = 0 ; node < nodes.size() ; node += 1) {
+	    edge_start[node] = edges.size();
+
+	    work.push_back(table[nodes[node]]);
+	    while (! work.empty()) {
+		  vvp_net_t*net = work.back();
+		  work.pop_back();
+
+		  vvp_net_ptr_t cur = net->out_;
+		  while (vvp_net_t*dst = cur.ptr()) {
+			cur = dst->port[cur.port()];
+
+			size_t ddx = table.index(dst);
+			if (ddx >= table.size() || visited[ddx] == node)
+			      continue;
+			visited[ddx] = node;
+
+			if (node_of[ddx] != NO_NODE)
+			      edges.push_back(node_of[ddx]);
+			else if (! stops_propagation(dst->fun))
+			      work.push_back(dst);
+		  }
+	    }
+      }
+      edge_start[nodes.size()] = edges.size();
+}
+
+/*
+ * Find the strongly connected components of the graph. The nodes are
+ * written to order a component at a time, in reverse topological
+ * order, and the nodes that are in loops are marked in cyclic. This
+ * is the usual algorithm with the recursion turned into a loop, since
+ * logic cones can be very deep.
+ */
+static void find_components(const levelize_graph_s&graph,
+			    vector<unsigned>&order, vector<bool>&cyclic)
+{
+      size_t count = graph.nodes.size();
+      vector<unsigned> index (count, NO_NODE);
+      vector<unsigned> low (count, 0);
+      vector<bool> on_stack (count, false);
+      vector<unsigned> stack;
+      vector< pair<unsigned,size_t> > calls;
+      unsigned next_index = 0;
+
+      for (unsigned root = 0 ; root < count ; root += 1) {
+	    if (index[root] != NO_NODE)
+		  continue;
+
+	    calls.push_back(make_pair(root, graph.edge_start[root]));
+	    index[root] = low[root] = next_index++;
+	    stack.push_back(root);
+	    on_stack[root] = true;
+
+	    while (! calls.empty()) {
+		  unsigned node = calls.back().first;
+		  size_t&edx = calls.back().second;
+
+		  if (edx < graph.edge_start[node+1]) {
+			unsigned dst = graph.edges[edx];
+			edx += 1;
+			if (dst == node) {
+			      cyclic[node] = true;
+			} else if (index[dst] == NO_NODE) {
+			      index[dst] = low[dst] = next_index++;
+			      stack.push_back(dst);
+			      on_stack[dst] = true;
+			      calls.push_back(make_pair(dst, graph.edge_start[dst]));
+			} else if (on_stack[dst]) {
+			      low[node] = min(low[node], index[dst]);
+			}
+			continue;
+		  }
+
+		  calls.pop_back();
+		  if (! calls.empty()) {
+			unsigned parent = calls.back().first;
+			low[parent] = min(low[parent], low[node]);
+		  }
+
+		  if (low[node] != index[node])
+			continue;
+
+		  size_t base = order.size();
+		  unsigned cur;
+		  do {
+			cur = stack.back();
+			stack.pop_back();
+			on_stack[cur] = false;
+			order.push_back(cur);
+		  } while (cur != node);
+
+		  if (order.size() - base > 1) {
+			for (size_t idx = base ; idx < order.size() ; idx += 1)
+			      cyclic[order[idx]] = true;
+		  }
+	    }
+      }
+}
+
+void levelize_netlist(void)
+{
+      if (! levelize_flag)
+	    return;
+
+      levelize_graph_s graph;
+      graph.node_of.resize(graph.table.size(), NO_NODE);
+      for (size_t idx = 0 ; idx < graph.table.size() ; idx += 1) {
+	    vvp_net_fun_t*fun = graph.table[idx]->fun;
+	    if (dynamic_cast<vvp_fun_levelized_*>(fun) == 0)
+		  continue;
+	    graph.node_of[idx] = graph.nodes.size();
+	    graph.nodes.push_back(idx);
+      }
+
+      graph.find_edges();
+
+      vector<unsigned> order;
+      vector<bool> cyclic (graph.nodes.size(), false);
+      order.reserve(graph.nodes.size());
+      find_components(graph, order, cyclic);
+
+	/* Walk the nodes in topological order, pushing the level of
+	   each node up to its fanout. */
+      vector<unsigned> level (graph.nodes.size(), 1);
+      for (size_t idx = order.size() ; idx > 0 ; idx -= 1) {
+	    unsigned node = order[idx-1];
+	    vvp_fun_levelized_*fun = dynamic_cast<vvp_fun_levelized_*>
+		  (graph.table[graph.nodes[node]]->fun);
+
+	    if (cyclic[node]) {
+		  count_levelized_loops += 1;
+		  fun->set_level(0);
+		  continue;
+	    }
+
+	    fun->set_level(level[node]);
+	    count_levelized_functors += 1;
+	    if (level[node] > count_logic_levels)
+		  count_logic_levels = level[node];
+
+	    for (size_t edx = graph.edge_start[node]
+		       ; edx < graph.edge_start[node+1] ; edx += 1) {
+		  unsigned dst = graph.edges[edx];
+		  if (! cyclic[dst] && level[dst] <= level[node])
+			level[dst] = level[node] + 1;
+	    }
+      }
+}
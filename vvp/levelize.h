@@ -0,0 +1,42 @@
+#ifndef IVL_levelize_H
+#define IVL_levelize_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Levelized evaluation of the zero-delay combinational logic (the -L
+ * flag). At link time the logic functors (see vvp_fun_levelized_ in
+ * logic.h) are sorted into levels so that every functor has a higher
+ * level than the functors that drive it. At run time changed functors
+ * are then evaluated in level order by a single scheduled sweep,
+ * instead of each scheduling its own event, so a functor that has
+ * several inputs change in a time step is evaluated once.
+ *
+ * Functors that are part of a combinational loop cannot be put in
+ * order, so they keep their own events.
+ */
+extern bool levelize_flag;
+
+/*
+ * The compile_cleanup function calls this after the netlist is
+ * linked. It does nothing unless levelize_flag is set.
+ */
+extern void levelize_netlist(void);
+
+#endif /* IVL_levelize_H */
@@ -29,9 +29,27 @@
 # include  <cassert>
 # include  <cstdlib>
 
-vvp_fun_boolean_::vvp_fun_boolean_(unsigned wid)
+bool vvp_fun_levelized_::eval_vec4_(vvp_vector4_t&, bool) const
+{
+      return false;
+}
+
+void vvp_fun_levelized_::send_(const vvp_vector4_t&out)
 {
+      vvp_net_t*ptr = net_;
       net_ = 0;
+      ptr->send_vec4(out, 0);
+}
+
+void vvp_fun_levelized_::run_run()
+{
+      vvp_vector4_t out;
+      eval_vec4_(out, false);
+      send_(out);
+}
+
+vvp_fun_boolean_::vvp_fun_boolean_(unsigned wid)
+{
       for (unsigned idx = 0 ;  idx < 4 ;  idx += 1)
 	    input_[idx] = vvp_vector4_t(wid, BIT4_Z);
 }
@@ -48,10 +66,7 @@ void vvp_fun_boolean_::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    return;
 
       input_[port] = bit;
-      if (net_ == 0) {
-	    net_ = ptr.ptr();
-	    schedule_functor(this);
-      }
+      input_changed_(ptr.ptr());
 }
 
 void vvp_fun_boolean_::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
@@ -66,10 +81,16 @@ void vvp_fun_boolean_::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       if (flag == false)
 	    return;
 
-      if (net_ == 0) {
-	    net_ = ptr.ptr();
-	    schedule_functor(this);
+      input_changed_(ptr.ptr());
+}
+
+bool vvp_fun_boolean_::inputs_narrow_() const
+{
+      for (unsigned idx = 0 ;  idx < 4 ;  idx += 1) {
+	    if (input_[idx].size() > 8*sizeof(unsigned long))
+		  return false;
       }
+      return true;
 }
 
 vvp_fun_and::vvp_fun_and(unsigned wid, bool invert)
@@ -82,12 +103,12 @@ vvp_fun_and::~vvp_fun_and()
 {
 }
 
-void vvp_fun_and::run_run()
+bool vvp_fun_and::eval_vec4_(vvp_vector4_t&result, bool narrow) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
+      if (narrow && ! inputs_narrow_())
+	    return false;
 
-      vvp_vector4_t result (input_[0]);
+      result = input_[0];
 
       for (unsigned idx = 0 ;  idx < result.size() ;  idx += 1) {
 	    vvp_bit4_t bitbit = result.value(idx);
@@ -105,7 +126,7 @@ void vvp_fun_and::run_run()
 	    result.set_bit(idx, bitbit);
       }
 
-      ptr->send_vec4(result, 0);
+      return true;
 }
 
 vvp_fun_equiv::vvp_fun_equiv()
@@ -118,18 +139,15 @@ vvp_fun_equiv::~vvp_fun_equiv()
 {
 }
 
-void vvp_fun_equiv::run_run()
+bool vvp_fun_equiv::eval_vec4_(vvp_vector4_t&result, bool) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
-
       assert(input_[0].size() == 1);
       assert(input_[1].size() == 1);
 
       vvp_bit4_t bit = ~(input_[0].value(0) ^ input_[1].value(0));
-      vvp_vector4_t result (1, bit);
+      result = vvp_vector4_t(1, bit);
 
-      ptr->send_vec4(result, 0);
+      return true;
 }
 
 vvp_fun_impl::vvp_fun_impl()
@@ -142,24 +160,20 @@ vvp_fun_impl::~vvp_fun_impl()
 {
 }
 
-void vvp_fun_impl::run_run()
+bool vvp_fun_impl::eval_vec4_(vvp_vector4_t&result, bool) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
-
       assert(input_[0].size() == 1);
       assert(input_[1].size() == 1);
 
       vvp_bit4_t bit = ~input_[0].value(0) | input_[1].value(0);
-      vvp_vector4_t result (1, bit);
+      result = vvp_vector4_t(1, bit);
 
-      ptr->send_vec4(result, 0);
+      return true;
 }
 
 vvp_fun_buf::vvp_fun_buf(unsigned wid)
 : input_(wid, BIT4_Z)
 {
-      net_ = 0;
       count_functors_logic += 1;
 }
 
@@ -182,10 +196,7 @@ void vvp_fun_buf::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 
       input_ = bit;
 
-      if (net_ == 0) {
-	    net_ = ptr.ptr();
-	    schedule_functor(this);
-      }
+      input_changed_(ptr.ptr());
 }
 
 void vvp_fun_buf::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
@@ -201,20 +212,17 @@ void vvp_fun_buf::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       if (flag == false)
 	    return;
 
-      if (net_ == 0) {
-	    net_ = ptr.ptr();
-	    schedule_functor(this);
-      }
+      input_changed_(ptr.ptr());
 }
 
-void vvp_fun_buf::run_run()
+bool vvp_fun_buf::eval_vec4_(vvp_vector4_t&result, bool narrow) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
+      if (narrow && input_.size() > 8*sizeof(unsigned long))
+	    return false;
 
-      vvp_vector4_t tmp (input_);
-      tmp.change_z2x();
-      ptr->send_vec4(tmp, 0);
+      result = input_;
+      result.change_z2x();
+      return true;
 }
 
 vvp_fun_bufz::vvp_fun_bufz()
@@ -268,7 +276,6 @@ void vvp_fun_buft::recv_vec8(vvp_net_ptr_t ptr, const vvp_vector8_t&bit)
 vvp_fun_muxr::vvp_fun_muxr()
 : a_(0.0), b_(0.0)
 {
-      net_ = 0;
       count_functors_logic += 1;
       select_ = SEL_BOTH;
 }
@@ -301,10 +308,7 @@ void vvp_fun_muxr::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    select_ = SEL_BOTH;
       }
 
-      if (net_ == 0) {
-	    net_ = ptr.ptr();
-	    schedule_functor(this);
-      }
+      input_changed_(ptr.ptr());
 }
 
 void vvp_fun_muxr::recv_real(vvp_net_ptr_t ptr, double bit,
@@ -328,10 +332,7 @@ void vvp_fun_muxr::recv_real(vvp_net_ptr_t ptr, double bit,
 	    assert(0);
       }
 
-      if (net_ == 0) {
-	    net_ = ptr.ptr();
-	    schedule_functor(this);
-      }
+      input_changed_(ptr.ptr());
 }
 
 void vvp_fun_muxr::run_run()
@@ -359,7 +360,6 @@ void vvp_fun_muxr::run_run()
 vvp_fun_muxz::vvp_fun_muxz(unsigned wid)
 : a_(wid, BIT4_Z), b_(wid, BIT4_Z)
 {
-      net_ = 0;
       count_functors_logic += 1;
       select_ = SEL_BOTH;
       has_run_ = false;
@@ -403,10 +403,7 @@ void vvp_fun_muxz::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    return;
       }
 
-      if (net_ == 0) {
-	    net_ = ptr.ptr();
-	    schedule_functor(this);
-      }
+      input_changed_(ptr.ptr());
 }
 
 void vvp_fun_muxz::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
@@ -432,24 +429,21 @@ void vvp_fun_muxz::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	  default:
 	    return;
       }
-      if (net_ == 0) {
-	    net_ = ptr.ptr();
-	    schedule_functor(this);
-      }
+      input_changed_(ptr.ptr());
 }
 
-void vvp_fun_muxz::run_run()
+bool vvp_fun_muxz::eval_vec4_(vvp_vector4_t&result, bool narrow) const
 {
-      has_run_ = true;
-      vvp_net_t*ptr = net_;
-      net_ = 0;
+      const unsigned word = 8*sizeof(unsigned long);
+      if (narrow && (a_.size() > word || b_.size() > word))
+	    return false;
 
       switch (select_) {
 	  case SEL_PORT0:
-	    ptr->send_vec4(a_, 0);
+	    result = a_;
 	    break;
 	  case SEL_PORT1:
-	    ptr->send_vec4(b_, 0);
+	    result = b_;
 	    break;
 	  default:
 	      {
@@ -472,16 +466,23 @@ void vvp_fun_muxz::run_run()
 		    for (unsigned idx = min_size ;  idx < max_size ;  idx += 1)
 			  res.set_bit(idx, BIT4_X);
 
-		    ptr->send_vec4(res, 0);
+		    result = res;
 	      }
 	    break;
       }
+
+      return true;
+}
+
+void vvp_fun_muxz::send_(const vvp_vector4_t&result)
+{
+      has_run_ = true;
+      vvp_fun_levelized_::send_(result);
 }
 
 vvp_fun_not::vvp_fun_not(unsigned wid)
 : input_(wid, BIT4_Z)
 {
-      net_ = 0;
       count_functors_logic += 1;
 }
 
@@ -503,10 +504,7 @@ void vvp_fun_not::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 	    return;
 
       input_ = bit;
-      if (net_ == 0) {
-	    net_ = ptr.ptr();
-	    schedule_functor(this);
-      }
+      input_changed_(ptr.ptr());
 }
 
 void vvp_fun_not::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
@@ -522,19 +520,16 @@ void vvp_fun_not::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       if (flag == false)
 	    return;
 
-      if (net_ == 0) {
-	    net_ = ptr.ptr();
-	    schedule_functor(this);
-      }
+      input_changed_(ptr.ptr());
 }
 
-void vvp_fun_not::run_run()
+bool vvp_fun_not::eval_vec4_(vvp_vector4_t&result, bool narrow) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
+      if (narrow && input_.size() > 8*sizeof(unsigned long))
+	    return false;
 
-      vvp_vector4_t result (input_, true /* invert */);
-      ptr->send_vec4(result, 0);
+      result = vvp_vector4_t(input_, true /* invert */);
+      return true;
 }
 
 vvp_fun_or::vvp_fun_or(unsigned wid, bool invert)
@@ -547,12 +542,12 @@ vvp_fun_or::~vvp_fun_or()
 {
 }
 
-void vvp_fun_or::run_run()
+bool vvp_fun_or::eval_vec4_(vvp_vector4_t&result, bool narrow) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
+      if (narrow && ! inputs_narrow_())
+	    return false;
 
-      vvp_vector4_t result (input_[0]);
+      result = input_[0];
 
       for (unsigned idx = 0 ;  idx < result.size() ;  idx += 1) {
 	    vvp_bit4_t bitbit = result.value(idx);
@@ -570,7 +565,7 @@ void vvp_fun_or::run_run()
 	    result.set_bit(idx, bitbit);
       }
 
-      ptr->send_vec4(result, 0);
+      return true;
 }
 
 vvp_fun_xor::vvp_fun_xor(unsigned wid, bool invert)
@@ -583,12 +578,12 @@ vvp_fun_xor::~vvp_fun_xor()
 {
 }
 
-void vvp_fun_xor::run_run()
+bool vvp_fun_xor::eval_vec4_(vvp_vector4_t&result, bool narrow) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
+      if (narrow && ! inputs_narrow_())
+	    return false;
 
-      vvp_vector4_t result (input_[0]);
+      result = input_[0];
 
       for (unsigned idx = 0 ;  idx < result.size() ;  idx += 1) {
 	    vvp_bit4_t bitbit = result.value(idx);
@@ -606,7 +601,7 @@ void vvp_fun_xor::run_run()
 	    result.set_bit(idx, bitbit);
       }
 
-      ptr->send_vec4(result, 0);
+      return true;
 }
 
 /*
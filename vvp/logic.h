@@ -23,10 +23,74 @@
 # include  "schedule.h"
 # include  <cstddef>
 
+/*
+ * vvp_fun_levelized_ is the base of the logic functors that compute
+ * their output in a scheduled event. Normally each functor schedules
+ * its own event, but if the netlist is levelized (see levelize.h) the
+ * functor is given a level number and is instead queued to be run in
+ * level order by a single sweep of the combinational logic.
+ */
+class vvp_fun_levelized_ : public vvp_net_fun_t, protected vvp_gen_event_s {
+
+    public:
+      vvp_fun_levelized_() : net_(0), level_(0), stale_(false) { }
+
+      void set_level(unsigned level) { level_ = level; }
+      unsigned get_level() const { return level_; }
+
+	// The parallel level sweep (vvp -j) evaluates the functors of
+	// a level on several threads at once with eval(), and then
+	// sends the results in order with send_result(). Only vectors
+	// that fit in a word are evaluated this way, as wider vectors
+	// use a heap that is not thread safe, so eval() returns false
+	// for the rest. If an input changes after the evaluation the
+	// functor is stale, and is run as usual instead.
+      bool eval(vvp_vector4_t&out)
+      {
+	    stale_ = false;
+	    return eval_vec4_(out, true);
+      }
+      bool is_stale() const { return stale_; }
+      void send_result(const vvp_vector4_t&out) { send_(out); }
+      void run() { run_run(); }
+
+    protected:
+	// The recv methods call this when an input changes, to
+	// arrange for run_run() to be called to evaluate the functor.
+      void input_changed_(vvp_net_t*net)
+      {
+	    if (net_ != 0) {
+		  stale_ = true;
+		  return;
+	    }
+
+	    net_ = net;
+	    if (level_)
+		  schedule_levelized(this, level_);
+	    else
+		  schedule_functor(this);
+      }
+
+	// Compute the output from the inputs, without changing the
+	// functor. If narrow is true, give up and return false if any
+	// of the vectors involved is wider than a word.
+      virtual bool eval_vec4_(vvp_vector4_t&out, bool narrow) const;
+	// Send the output.
+      virtual void send_(const vvp_vector4_t&out);
+
+      void run_run();
+
+      vvp_net_t*net_;
+
+    private:
+      unsigned level_;
+      bool stale_;
+};
+
 /*
  * vvp_fun_boolean_ is just a common hook for holding operands.
  */
-class vvp_fun_boolean_ : public vvp_net_fun_t, protected vvp_gen_event_s {
+class vvp_fun_boolean_ : public vvp_fun_levelized_ {
 
     public:
       explicit vvp_fun_boolean_(unsigned wid);
@@ -38,8 +102,10 @@ class vvp_fun_boolean_ : public vvp_net_fun_t, protected vvp_gen_event_s {
 			unsigned base, unsigned vwid, vvp_context_t);
 
     protected:
+	// True if all the inputs fit in a word.
+      bool inputs_narrow_() const;
+
       vvp_vector4_t input_[4];
-      vvp_net_t*net_;
 };
 
 class vvp_fun_and  : public vvp_fun_boolean_ {
@@ -49,7 +115,7 @@ class vvp_fun_and  : public vvp_fun_boolean_ {
       ~vvp_fun_and();
 
     private:
-      void run_run();
+      bool eval_vec4_(vvp_vector4_t&out, bool narrow) const;
       bool invert_;
 };
 
@@ -60,7 +126,7 @@ class vvp_fun_equiv : public vvp_fun_boolean_ {
       ~vvp_fun_equiv();
 
     private:
-      void run_run();
+      bool eval_vec4_(vvp_vector4_t&out, bool narrow) const;
 };
 
 class vvp_fun_impl : public vvp_fun_boolean_ {
@@ -70,7 +136,7 @@ class vvp_fun_impl : public vvp_fun_boolean_ {
       ~vvp_fun_impl();
 
     private:
-      void run_run();
+      bool eval_vec4_(vvp_vector4_t&out, bool narrow) const;
 };
 
 /*
@@ -79,7 +145,7 @@ class vvp_fun_impl : public vvp_fun_boolean_ {
  * The retransmitted vector has all Z values changed to X, just like
  * the buf(Q,D) gate in Verilog.
  */
-class vvp_fun_buf: public vvp_net_fun_t, private vvp_gen_event_s {
+class vvp_fun_buf: public vvp_fun_levelized_ {
 
     public:
       explicit vvp_fun_buf(unsigned wid);
@@ -91,11 +157,10 @@ class vvp_fun_buf: public vvp_net_fun_t, private vvp_gen_event_s {
 			unsigned base, unsigned vwid, vvp_context_t);
 
     private:
-      void run_run();
+      bool eval_vec4_(vvp_vector4_t&out, bool narrow) const;
 
     private:
       vvp_vector4_t input_;
-      vvp_net_t*net_;
 };
 
 /*
@@ -143,7 +208,7 @@ enum sel_type {SEL_PORT0, SEL_PORT1, SEL_BOTH};
  * input (port-0 or port-1) to enter the device. The narrow vector is
  * padded with X values.
  */
-class vvp_fun_muxz : public vvp_net_fun_t, private vvp_gen_event_s {
+class vvp_fun_muxz : public vvp_fun_levelized_ {
 
     public:
       explicit vvp_fun_muxz(unsigned width);
@@ -155,17 +220,17 @@ class vvp_fun_muxz : public vvp_net_fun_t, private vvp_gen_event_s {
 			unsigned base, unsigned vwid, vvp_context_t);
 
     private:
-      void run_run();
+      bool eval_vec4_(vvp_vector4_t&out, bool narrow) const;
+      void send_(const vvp_vector4_t&out);
 
     private:
       vvp_vector4_t a_;
       vvp_vector4_t b_;
-      vvp_net_t*net_;
       sel_type select_;
       bool has_run_;
 };
 
-class vvp_fun_muxr : public vvp_net_fun_t, private vvp_gen_event_s {
+class vvp_fun_muxr : public vvp_fun_levelized_ {
 
     public:
       explicit vvp_fun_muxr();
@@ -182,11 +247,10 @@ class vvp_fun_muxr : public vvp_net_fun_t, private vvp_gen_event_s {
     private:
       double a_;
       double b_;
-      vvp_net_t*net_;
       sel_type select_;
 };
 
-class vvp_fun_not: public vvp_net_fun_t, private vvp_gen_event_s {
+class vvp_fun_not: public vvp_fun_levelized_ {
 
     public:
       explicit vvp_fun_not(unsigned wid);
@@ -198,11 +262,10 @@ class vvp_fun_not: public vvp_net_fun_t, private vvp_gen_event_s {
 			unsigned base, unsigned vwid, vvp_context_t);
 
     private:
-      void run_run();
+      bool eval_vec4_(vvp_vector4_t&out, bool narrow) const;
 
     private:
       vvp_vector4_t input_;
-      vvp_net_t*net_;
 };
 
 class vvp_fun_or  : public vvp_fun_boolean_ {
@@ -212,7 +275,7 @@ class vvp_fun_or  : public vvp_fun_boolean_ {
       ~vvp_fun_or();
 
     private:
-      void run_run();
+      bool eval_vec4_(vvp_vector4_t&out, bool narrow) const;
       bool invert_;
 };
 
@@ -223,7 +286,7 @@ class vvp_fun_xor  : public vvp_fun_boolean_ {
       ~vvp_fun_xor();
 
     private:
-      void run_run();
+      bool eval_vec4_(vvp_vector4_t&out, bool narrow) const;
       bool invert_;
 };
 
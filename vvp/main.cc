@@ -25,8 +25,17 @@ const char COPYRIGHT[] =
 # include  "schedule.h"
 # include  "vpi_priv.h"
 # include  "statistics.h"
+# include  "checkpoint.h"
+# include  "snapshot.h"
+# include  "native.h"
+# include  "profile.h"
+# include  "levelize.h"
+# include  "partition.h"
+# include  "fanout.h"
+# include  "vvp_binary.h"
 # include  "vvp_cleanup.h"
 # include  "vvp_object.h"
+# include  "vvp_vector4_kernels.h"
 # include  <cstdio>
 # include  <cstdlib>
 # include  <cstring>
@@ -60,6 +69,7 @@ extern "C" const char*optarg;
 #endif
 
 bool verbose_flag = false;
+bool two_state_flag = false;
 bool version_flag = false;
 static int vvp_return_value = 0;
 
@@ -217,6 +227,7 @@ static void final_cleanup()
       }
 	/* Clear the static result buffer. */
       (void)need_result_buf(0, RBUF_DEL);
+      native_delete();
       codespace_delete();
       root_table_delete();
       def_table_delete();
@@ -230,6 +241,7 @@ static void final_cleanup()
       signal_pool_delete();
       vvp_net_pool_delete();
       ufunc_pool_delete();
+      vthread_pool_delete();
 #endif
 	/*
 	 * Unload the VPI modules. This is essential for MinGW, to ensure
@@ -251,7 +263,7 @@ static void final_cleanup()
 unsigned module_cnt = 0;
 const char*module_tab[64];
 
-extern void vpip_mcd_init(FILE *log);
+extern void vpip_mcd_init(FILE *log, const char*log_name);
 extern void vvp_vpi_init(void);
 
 int main(int argc, char*argv[])
@@ -282,29 +294,77 @@ int main(int argc, char*argv[])
         /* For non-interactive runs we do not want to run the interactive
          * debugger, so make $stop just execute a $finish. */
       stop_is_finish = false;
-      while ((opt = getopt(argc, argv, "+hil:M:m:nNsvV")) != EOF) switch (opt) {
+      while ((opt = getopt(argc, argv, "+2a:A:B:E:fF:hij:l:LM:m:nNP:R:svV")) != EOF) switch (opt) {
          case 'h':
            fprintf(stderr,
                    "Usage: vvp [options] input-file [+plusargs...]\n"
                    "Options:\n"
+                   " -2             Make all vector variables 2-state.\n"
+                   " -a file        Load native thread code module.\n"
+                   " -A file        Write native thread code as C++ (and build it for -a).\n"
+                   " -B file        Write the design in binary format.\n"
+                   " -E file        Write scheduler statistics per time step to file.\n"
+                   " -f             Send to large fan-outs from flat arrays.\n"
+                   " -F file        Fan out into the runs in file at $ivl_snapshot.\n"
                    " -h             Print this help message.\n"
                    " -i             Interactive mode (unbuffered stdio).\n"
+                   " -j N           Parallel levelized gate evaluation on N threads (-L).\n"
                    " -l file        Logfile, '-' for <stderr>\n"
+                   " -L             Evaluate combinational logic in levelized order.\n"
                    " -M path        VPI module directory\n"
 		   " -M -           Clear VPI module path\n"
                    " -m module      Load vpi module.\n"
 		   " -n             Non-interactive ($stop = $finish).\n"
                    " -N             Same as -n, but exit code is 1 instead of 0\n"
+                   " -P file        Write a profile of the simulation to file.\n"
+                   " -R file        Resume the simulation from a checkpoint.\n"
 		   " -s             $stop right away.\n"
                    " -v             Verbose progress messages.\n"
                    " -V             Print the version information.\n" );
            exit(0);
+	  case '2':
+	    two_state_flag = true;
+	    break;
+	  case 'a':
+	    native_module_path = optarg;
+	    break;
+	  case 'A':
+	    native_source_path = optarg;
+	    break;
+	  case 'B':
+	    binary_output_path = optarg;
+	    break;
+	  case 'E':
+	    sched_stats_path = optarg;
+	    break;
+	  case 'f':
+	    fanout_flag = true;
+	    break;
+	  case 'F':
+	    snapshot_fanout_path = optarg;
+	    break;
 	  case 'i':
 	    setvbuf(stdout, 0, _IONBF, 0);
 	    break;
+	  case 'j': {
+		char*end;
+		unsigned long cnt = strtoul(optarg, &end, 10);
+		if (*end != 0 || cnt < 1 || cnt > 256) {
+		      fprintf(stderr, "vvp: -j needs a thread count "
+			      "from 1 to 256, not %s.\n", optarg);
+		      flag_errors += 1;
+		      break;
+		}
+		parallel_threads = cnt;
+		levelize_flag = true;
+		break;
+	  }
 	  case 'l':
 	    logfile_name = optarg;
 	    break;
+	  case 'L':
+	    levelize_flag = true;
+	    break;
 	  case 'M':
 	    if (strcmp(optarg,"-") == 0) {
 		  vpip_clear_module_paths();
@@ -322,6 +382,13 @@ int main(int argc, char*argv[])
             stop_is_finish = true;
             stop_is_finish_exit_code = 1;
             break;
+	  case 'P':
+	    profile_path = optarg;
+	    profile_flag = true;
+	    break;
+	  case 'R':
+	    checkpoint_restore_path = optarg;
+	    break;
 	  case 's':
 	    schedule_stop(0);
 	    break;
@@ -393,7 +460,7 @@ int main(int argc, char*argv[])
 	    }
       }
 
-      vpip_mcd_init(logfile);
+      vpip_mcd_init(logfile, logfile == stderr? 0 : logfile_name);
 
       if (verbose_flag) {
 	    my_getrusage(cycles+0);
@@ -445,15 +512,33 @@ int main(int argc, char*argv[])
 			   count_filters, vvp_net_fil_t::heap_total());
 	    vpi_mcd_printf(1, " ... %8lu opcodes (%zu bytes)\n",
 	                   count_opcodes, size_opcodes);
+	    vpi_mcd_printf(1, "           %8lu fused\n", count_opcodes_fused);
 	    vpi_mcd_printf(1, " ... %8lu nets\n",     count_vpi_nets);
 	    vpi_mcd_printf(1, " ... %8lu vvp_nets (%zu bytes)\n",
 			   count_vvp_nets, size_vvp_nets);
+	    vpi_mcd_printf(1, "           %8s vector kernels\n",
+			   vvp_vector4_kernels_name);
+	    compute_net_partitions();
+	    vpi_mcd_printf(1, "           %8lu partitions (largest %lu, "
+			   "%lu single)\n", count_net_partitions,
+			   count_net_partition_max,
+			   count_net_partition_singles);
+	    if (levelize_flag)
+		  vpi_mcd_printf(1, "           %8lu levelized (%lu levels, "
+				 "%lu in loops)\n", count_levelized_functors,
+				 count_logic_levels, count_levelized_loops);
+	    if (fanout_flag)
+		  vpi_mcd_printf(1, "           %8lu flat fan-outs (%lu receivers)\n",
+				 count_fanout_nets, count_fanout_receivers);
 	    vpi_mcd_printf(1, " ... %8lu arrays (%lu words)\n",
 			   count_net_arrays, count_net_array_words);
 	    vpi_mcd_printf(1, " ... %8lu memories\n",
 			   count_var_arrays+count_real_arrays);
 	    vpi_mcd_printf(1, "           %8lu logic (%lu words)\n",
 			   count_var_arrays, count_var_array_words);
+	    if (count_var_sparse_arrays)
+		  vpi_mcd_printf(1, "           %8lu sparse\n",
+				 count_var_sparse_arrays);
 	    vpi_mcd_printf(1, "           %8lu real (%lu words)\n",
 			   count_real_arrays, count_real_array_words);
 	    vpi_mcd_printf(1, " ... %8lu scopes\n",   count_vpi_scopes);
@@ -466,8 +551,14 @@ int main(int argc, char*argv[])
       }
 
 
+      if (profile_flag)
+	    profile_start();
+
       schedule_simulate();
 
+      if (profile_flag)
+	    profile_write();
+
       if (verbose_flag) {
 	    my_getrusage(cycles+2);
 	    print_rusage(cycles+2, cycles+1);
@@ -477,10 +568,16 @@ int main(int argc, char*argv[])
 			   count_time_events, count_time_pool());
 	    vpi_mcd_printf(1, "    %8lu thread schedule events\n",
 		    count_thread_events);
+	    vpi_mcd_printf(1, "             ...wakes merged=%lu\n",
+			   count_thread_wakes_merged);
+	    vpi_mcd_printf(1, "    %8lu threads (pool=%lu)\n",
+			   count_vthreads, count_vthread_pool());
 	    vpi_mcd_printf(1, "    %8lu assign events\n",
 		    count_assign_events);
 	    vpi_mcd_printf(1, "             ...assign(vec4) pool=%lu\n",
 			   count_assign4_pool());
+	    vpi_mcd_printf(1, "             ...assign(vec4) merged=%lu\n",
+			   count_assign_merged);
 	    vpi_mcd_printf(1, "             ...assign(vec8) pool=%lu\n",
 			   count_assign8_pool());
 	    vpi_mcd_printf(1, "             ...assign(real) pool=%lu\n",
@@ -491,6 +588,13 @@ int main(int argc, char*argv[])
 			   count_assign_arword_pool());
 	    vpi_mcd_printf(1, "    %8lu other events (pool=%lu)\n",
 			   count_gen_events, count_gen_pool());
+	    if (levelize_flag)
+		  vpi_mcd_printf(1, "    %8lu levelized sweeps (%lu functor runs, "
+				 "%lu parallel levels)\n", count_level_sweeps,
+				 count_level_runs, count_level_parallel);
+	    vpi_mcd_printf(1, "    %8lu unchanged outputs not propagated\n",
+			   count_unchanged_sends);
+	    schedule_stats_report();
       }
 
       final_cleanup();
@@ -0,0 +1,1157 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "native.h"
+# include  "compile.h"
+# include  "vthread.h"
+# include  "vvp_net_sig.h"
+# include  "ivl_dlfcn.h"
+#ifdef CHECK_WITH_VALGRIND
+# include  "vvp_cleanup.h"
+#endif
+# include  <cstdarg>
+# include  <cstdio>
+# include  <cstdlib>
+# include  <cstring>
+# include  <map>
+# include  <set>
+# include  <string>
+# include  <vector>
+
+using namespace std;
+
+const char*native_source_path = 0;
+const char*native_module_path = 0;
+
+/*
+ * The native code is made of blocks. A block starts at an entry
+ * instruction, which is the start of a thread, the target of a jump,
+ * a %fork or a function call, the instruction after an unconditional
+ * %jmp or %end, or the instruction after one that may suspend the
+ * thread, where the thread resumes. The block runs the instructions
+ * from there to the next entry or unconditional %jmp or %end. A jump
+ * back to the start of the block, which is what a simple loop looks
+ * like, is a plain goto. Anything else that changes the program
+ * counter returns to the thread engine, which carries on from there.
+ *
+ * Most instructions are run by calling their opcode function
+ * directly. The vec4 instructions that load, store, do arithmetic on
+ * or compare values of up to a word are lowered instead: the block
+ * keeps those values in local variables in place of the vec4 stack,
+ * and the flags that its compares set in local variables in place of
+ * the thread flags, and only puts them into the thread before an
+ * instruction that it does not lower, or when it returns. The lowered
+ * code only handles 0 and 1 bits. If a %load/vec4 finds an x or z bit,
+ * the block runs that instruction and returns to the thread engine,
+ * which runs the rest of the block interpreted.
+ *
+ * When the native code is loaded, the opcode of each entry
+ * instruction is replaced with its block. None of the other
+ * instructions are changed, so a thread that gets to the middle of a
+ * block some other way just runs interpreted up to the next entry.
+ *
+ * The native code refers to instructions by their index in the code
+ * space, in the order that codespace_for_each() visits them. That only
+ * depends on the order of the code in the input file, so the module
+ * checks that the mnemonic, and the operands that the native code was
+ * written for, of every instruction match before it is used.
+ */
+static const unsigned native_version = 2;
+
+  /* The compiler and flags that make a loadable module. The Makefile
+     passes the ones that vvp itself is built with. */
+#ifndef NATIVE_CXX
+# define NATIVE_CXX "c++"
+#endif
+#ifndef NATIVE_SHARED
+# define NATIVE_SHARED "-fPIC -shared"
+#endif
+
+  /* Values wider than this are not lowered. */
+static const unsigned native_word = 8 * sizeof(unsigned long);
+
+  /* A long run of straight line code is split into blocks of about
+     this many instructions, so that the C++ compiler does not have to
+     digest one enormous function. */
+static const size_t native_block_limit = 512;
+
+struct native_insn_s {
+      vvp_code_t code;
+      vvp_code_fun fun;
+      const char*name;
+	// Name of the C++ function of the opcode.
+      string cname;
+	// Index of the code pointer target, or 0 if none.
+      size_t target;
+      size_t target2;
+      bool entry;
+};
+
+static vector<native_insn_s> native_insn;
+static vector<vvp_code_t> native_starts;
+
+  /* These are passed to the native module, so must stay put. The
+     native_sig holds the signal of each instruction that the native
+     code loads or stores. */
+static vector<vvp_code_t> native_code;
+static vector<vvp_signal_value*> native_sig;
+static vector<vvp_code_fun> native_fun;
+
+static ivl_dll_t native_dll = 0;
+
+void native_thread_start(vvp_code_t pc)
+{
+      if (native_source_path == 0 && native_module_path == 0)
+	    return;
+
+      native_starts.push_back(pc);
+}
+
+static void native_collect(vvp_code_t code, void*)
+{
+      native_insn_s cur;
+      cur.code = code;
+      cur.fun = code->opcode;
+      cur.name = 0;
+      cur.target = 0;
+      cur.target2 = 0;
+      cur.entry = false;
+      native_insn.push_back(cur);
+}
+
+/*
+ * The opcodes that the compiler creates directly are not in the
+ * opcode table, so they get a made up mnemonic here.
+ */
+static const struct native_extra_s {
+      vvp_code_fun fun;
+      const char*name;
+      const char*fun_name;
+      bool cptr;
+} native_extra[] = {
+      { &of_CHUNK_LINK,         "<chunk_link>",           "of_CHUNK_LINK",         false },
+      { &of_VPI_CALL,           "%vpi_call",              "of_VPI_CALL",           false },
+      { &of_ZOMBIE,             "<zombie>",               "of_ZOMBIE",             false },
+      { &of_EXEC_UFUNC_REAL,    "<exec_ufunc/real>",      "of_EXEC_UFUNC_REAL",    true },
+      { &of_EXEC_UFUNC_VEC4,    "<exec_ufunc/vec4>",      "of_EXEC_UFUNC_VEC4",    true },
+      { &of_REAP_UFUNC,         "<reap_ufunc>",           "of_REAP_UFUNC",         false },
+      { &of_FUSED_ADDI_VEC4,    "<fused_addi/vec4>",      "of_FUSED_ADDI_VEC4",    false },
+      { &of_FUSED_CMPIE_JMP0XZ, "<fused_cmpi/e_jmp/0xz>", "of_FUSED_CMPIE_JMP0XZ", false },
+      { &of_FUSED_CMPIS_JMP0XZ, "<fused_cmpi/s_jmp/0xz>", "of_FUSED_CMPIS_JMP0XZ", false },
+      { &of_FUSED_CMPIU_JMP0XZ, "<fused_cmpi/u_jmp/0xz>", "of_FUSED_CMPIU_JMP0XZ", false },
+      { 0, 0, 0, false }
+};
+
+/*
+ * Get the mnemonic of the opcode and the name of its C++ function,
+ * which the native code calls. The function name is nil if the
+ * opcode is not known.
+ */
+static const char*native_opcode_name(vvp_code_fun fun, const char*&fun_name,
+				     bool&cptr, bool&cptr2)
+{
+      if (const char*name = compile_opcode_info(fun, fun_name, cptr, cptr2))
+	    return name;
+
+      for (const native_extra_s*cur = native_extra ; cur->fun ; cur += 1) {
+	    if (cur->fun == fun) {
+		  fun_name = cur->fun_name;
+		  cptr = cur->cptr;
+		  return cur->name;
+	    }
+      }
+
+      fun_name = 0;
+      return "<unknown>";
+}
+
+static bool native_is_jump(vvp_code_fun fun)
+{
+      return fun == &of_JMP  || fun == &of_JMP0 || fun == &of_JMP0XZ
+	  || fun == &of_JMP1 || fun == &of_JMP1XZ;
+}
+
+static bool native_is_terminator(vvp_code_fun fun)
+{
+      return fun == &of_JMP || fun == &of_END || fun == &of_ZOMBIE;
+}
+
+static bool native_is_fused_jump(vvp_code_fun fun)
+{
+      return fun == &of_FUSED_CMPIE_JMP0XZ
+	  || fun == &of_FUSED_CMPIS_JMP0XZ
+	  || fun == &of_FUSED_CMPIU_JMP0XZ;
+}
+
+/*
+ * These are the instructions that may suspend the thread. The thread
+ * resumes at the instruction after, so that is an entry.
+ */
+static bool native_is_suspend(vvp_code_fun fun)
+{
+      return fun == &of_DELAY     || fun == &of_DELAYX
+	  || fun == &of_WAIT      || fun == &of_WAIT_FORK
+	  || fun == &of_JOIN      || fun == &of_VPI_CALL
+	  || fun == &of_CALLF_OBJ || fun == &of_CALLF_REAL
+	  || fun == &of_CALLF_STR || fun == &of_CALLF_VEC4
+	  || fun == &of_CALLF_VOID
+	  || fun == &of_EXEC_UFUNC_REAL || fun == &of_EXEC_UFUNC_VEC4;
+}
+
+/*
+ * Get the index of the instruction that runs after this one if it
+ * does not jump. That is the next instruction, except for the fused
+ * instructions, which skip over the rest of their sequence. Also get
+ * the index of the jump target, or 0 if it is not a jump.
+ */
+static size_t native_next(size_t idx, size_t&target)
+{
+      const native_insn_s&cur = native_insn[idx];
+
+      if (native_is_jump(cur.fun)) {
+	    target = cur.target;
+	    return idx + 1;
+      }
+
+      if (native_is_fused_jump(cur.fun)) {
+	    size_t jmp = idx + cur.code->bit_idx[0];
+	    target = native_insn[jmp].target;
+	    return jmp + 1;
+      }
+
+      target = 0;
+      if (cur.fun == &of_FUSED_ADDI_VEC4)
+	    return idx + 3;
+
+      return idx + 1;
+}
+
+/*
+ * Get the width of the signal of a %load/vec4 or fused instruction,
+ * or 0 if it is not a signal.
+ */
+static unsigned native_signal_width(vvp_code_t code)
+{
+      vvp_signal_value*sig = dynamic_cast<vvp_signal_value*> (code->net->fil);
+      return sig? sig->value_size() : 0;
+}
+
+/*
+ * Get the mnemonic of the instruction, with the operands that the
+ * lowered code depends on. The module records these for every
+ * instruction, and is only used if they all match.
+ */
+static string native_signature(size_t idx)
+{
+      const native_insn_s&cur = native_insn[idx];
+      vvp_code_t code = cur.code;
+      vvp_code_fun fun = cur.fun;
+      char buf[64];
+      buf[0] = 0;
+
+      if (fun == &of_LOAD_VEC4 || fun == &of_FUSED_ADDI_VEC4
+	  || native_is_fused_jump(fun)) {
+	    snprintf(buf, sizeof buf, " %u", native_signal_width(code));
+
+      } else if (fun == &of_PUSHI_VEC4 || fun == &of_ADDI
+		 || fun == &of_SUBI || fun == &of_MULI
+		 || fun == &of_CMPIE || fun == &of_CMPINE
+		 || fun == &of_CMPIS || fun == &of_CMPIU) {
+	    snprintf(buf, sizeof buf, " %u %u %lu", code->bit_idx[0],
+		     code->bit_idx[1], code->number);
+
+      } else if (fun == &of_STORE_VEC4) {
+	    snprintf(buf, sizeof buf, " %u %u", code->bit_idx[0],
+		     code->bit_idx[1]);
+
+      } else if (native_is_jump(fun) && fun != &of_JMP) {
+	    snprintf(buf, sizeof buf, " %u", code->bit_idx[0]);
+
+      } else if (fun == &of_POP_VEC4) {
+	    snprintf(buf, sizeof buf, " %lu", code->number);
+      }
+
+      return string(cur.name) + buf;
+}
+
+/*
+ * Collect the instructions, and mark the entry instructions.
+ */
+static void native_scan(void)
+{
+      codespace_for_each(&native_collect, 0);
+
+      map<vvp_code_t,size_t> index;
+      for (size_t idx = 0 ; idx < native_insn.size() ; idx += 1)
+	    index[native_insn[idx].code] = idx;
+
+      map<vvp_code_t,size_t>::const_iterator tgt;
+      for (size_t idx = 0 ; idx < native_starts.size() ; idx += 1) {
+	    if ((tgt = index.find(native_starts[idx])) != index.end())
+		  native_insn[tgt->second].entry = true;
+      }
+
+      for (size_t idx = 0 ; idx < native_insn.size() ; idx += 1) {
+	    native_insn_s&cur = native_insn[idx];
+	    bool cptr, cptr2;
+	    const char*fun_name;
+	    cur.name = native_opcode_name(cur.fun, fun_name, cptr, cptr2);
+	    cur.cname = fun_name? fun_name : "";
+
+	    if (cptr && (tgt = index.find(cur.code->cptr)) != index.end()) {
+		  cur.target = tgt->second;
+		  native_insn[tgt->second].entry = true;
+	    }
+	    if (cptr2 && (tgt = index.find(cur.code->cptr2)) != index.end()) {
+		  cur.target2 = tgt->second;
+		  native_insn[tgt->second].entry = true;
+	    }
+
+	    if ((native_is_terminator(cur.fun) || native_is_suspend(cur.fun))
+		&& idx+1 < native_insn.size())
+		  native_insn[idx+1].entry = true;
+      }
+
+	/* Instruction 0 is the zombie, and the last instruction is
+	   the link at the end of the last chunk. Neither is run. */
+      native_insn[0].entry = false;
+      native_insn.back().entry = false;
+
+	/* Split long blocks, but never inside the sequence that a
+	   fused instruction skips over. */
+      size_t count = 0, skip = 0;
+      for (size_t idx = 1 ; idx+1 < native_insn.size() ; idx += 1) {
+	    native_insn_s&cur = native_insn[idx];
+	    if (idx >= skip && count >= native_block_limit)
+		  cur.entry = true;
+	    if (cur.entry)
+		  count = 0;
+	    count += 1;
+
+	    size_t target;
+	    size_t next = native_next(idx, target);
+	    if (next > skip)
+		  skip = next;
+      }
+}
+
+/*
+ * Get the instructions of the block that starts at the entry
+ * instruction, in the order that they run.
+ */
+static void native_block(size_t entry, vector<size_t>&list)
+{
+      size_t idx = entry;
+      for (;;) {
+	    list.push_back(idx);
+	    if (native_is_terminator(native_insn[idx].fun))
+		  break;
+
+	    size_t target;
+	    size_t next = native_next(idx, target);
+	    if (next+1 >= native_insn.size() || native_insn[next].entry)
+		  break;
+	    idx = next;
+      }
+}
+
+/*
+ * This is the state of a block as its code is written. The stack
+ * holds the vec4 values that are in local variables instead of on top
+ * of the thread stack. The flags mask has bit n set if flag n is in
+ * the local variable f<n> instead of in the thread.
+ */
+struct native_value_s {
+      unsigned var;
+      unsigned wid;
+};
+
+struct native_state_s {
+      string out;
+      vector<native_value_s> stack;
+      unsigned flags;
+      unsigned flags_used;
+      unsigned vars;
+      bool loop_used;
+	// Names of the opcode functions that the code calls.
+      set<string>*calls;
+};
+
+static void native_emit(string&out, const char*fmt, ...)
+{
+      char buf[512];
+      va_list ap;
+      va_start(ap, fmt);
+      vsnprintf(buf, sizeof buf, fmt, ap);
+      va_end(ap);
+      out += buf;
+}
+
+/*
+ * Write the code that puts the local values and flags into the
+ * thread, at the indent ind. This does not change the state, since
+ * it is also used on the paths that leave the block.
+ */
+static void native_flush(native_state_s&st, const char*ind)
+{
+      for (size_t idx = 0 ; idx < st.stack.size() ; idx += 1)
+	    native_emit(st.out, "%svthread_native_push(thr, v%u, %u);\n",
+			ind, st.stack[idx].var, st.stack[idx].wid);
+
+      if (st.flags == 0)
+	    return;
+
+      string bits;
+      for (unsigned idx = 4 ; idx <= 6 ; idx += 1) {
+	    if ((st.flags & (1U << idx)) == 0)
+		  continue;
+	    char buf[32];
+	    snprintf(buf, sizeof buf, "%s(unsigned)f%u << %u",
+		     bits.empty()? "" : " | ", idx, idx);
+	    bits += buf;
+      }
+      native_emit(st.out, "%svthread_native_flags(thr, 0x%x, %s);\n",
+		  ind, st.flags, bits.c_str());
+}
+
+static void native_call(native_state_s&st, const char*ind, size_t idx)
+{
+      const native_insn_s&cur = native_insn[idx];
+      st.calls->insert(cur.cname);
+      native_emit(st.out, "%s*pc = C[%zu];\n", ind, idx+1);
+      native_emit(st.out, "%sif (! %s(thr, C[%zu])) return false;\n",
+		  ind, cur.cname.c_str(), idx);
+}
+
+static string native_mask(const string&expr, unsigned wid)
+{
+      if (wid >= 64)
+	    return expr;
+
+      char buf[64];
+      snprintf(buf, sizeof buf, " & 0x%llxULL", (1ULL << wid) - 1);
+      return "(" + expr + ")" + buf;
+}
+
+static string native_signed(const string&expr, unsigned wid)
+{
+      if (wid >= 64)
+	    return "(int64_t)" + expr;
+
+      char buf[64];
+      snprintf(buf, sizeof buf, "((int64_t)(%s << %u) >> %u)",
+	       expr.c_str(), 64 - wid, 64 - wid);
+      return buf;
+}
+
+static string native_var(unsigned var)
+{
+      char buf[32];
+      snprintf(buf, sizeof buf, "v%u", var);
+      return buf;
+}
+
+/*
+ * Get the immediate operand of the instruction as an expression, if
+ * it has no x or z bits and fits in a word.
+ */
+static bool native_immediate(vvp_code_t code, string&expr)
+{
+      unsigned wid = code->number;
+      if (code->bit_idx[1] != 0 || wid == 0 || wid > native_word)
+	    return false;
+
+      unsigned long long val = code->bit_idx[0];
+      if (wid < 64)
+	    val &= (1ULL << wid) - 1;
+
+      char buf[64];
+      snprintf(buf, sizeof buf, "0x%llxULL", val);
+      expr = buf;
+      return true;
+}
+
+/*
+ * Write a new local value, and push it onto the local stack.
+ */
+static void native_push(native_state_s&st, const string&expr, unsigned wid)
+{
+      native_value_s val;
+      val.var = st.vars++;
+      val.wid = wid;
+      native_emit(st.out, "      uint64_t v%u = %s;\n", val.var, expr.c_str());
+      st.stack.push_back(val);
+}
+
+/*
+ * Write a %load/vec4, or the load of a fused instruction, into a new
+ * local value. If the value cannot be lowered, the whole instruction
+ * runs as usual and the block returns.
+ */
+static void native_lower_load(native_state_s&st, size_t idx, unsigned wid)
+{
+      native_value_s val;
+      val.var = st.vars++;
+      val.wid = wid;
+
+      const native_insn_s&cur = native_insn[idx];
+      st.calls->insert(cur.cname);
+      native_emit(st.out, "      uint64_t v%u;\n", val.var);
+      native_emit(st.out, "      if (! vthread_native_load(S[%zu], v%u)) {\n",
+		  idx, val.var);
+      native_flush(st, "\t    ");
+      native_emit(st.out, "\t    *pc = C[%zu];\n", idx+1);
+      native_emit(st.out, "\t    return %s(thr, C[%zu]);\n",
+		  cur.cname.c_str(), idx);
+      native_emit(st.out, "      }\n");
+      st.stack.push_back(val);
+}
+
+enum native_cmp_t { NATIVE_CMPE, NATIVE_CMPNE, NATIVE_CMPS, NATIVE_CMPU };
+
+/*
+ * Write a compare of two values of the same width, which sets the
+ * same flags that the compare instruction does.
+ */
+static void native_compare(native_state_s&st, native_cmp_t cmp,
+			   const string&l, const string&r, unsigned wid)
+{
+      const char*op = cmp == NATIVE_CMPNE? "!=" : "==";
+      native_emit(st.out, "      f4 = %s %s %s;\n", l.c_str(), op, r.c_str());
+      native_emit(st.out, "      f6 = f4;\n");
+      unsigned mask = (1U << 4) | (1U << 6);
+
+      if (cmp == NATIVE_CMPU) {
+	    native_emit(st.out, "      f5 = %s < %s;\n", l.c_str(), r.c_str());
+	    mask |= 1U << 5;
+      } else if (cmp == NATIVE_CMPS) {
+	    native_emit(st.out, "      f5 = %s < %s;\n",
+			native_signed(l, wid).c_str(),
+			native_signed(r, wid).c_str());
+	    mask |= 1U << 5;
+      }
+
+      st.flags |= mask;
+      st.flags_used |= mask;
+}
+
+static bool native_compare_kind(vvp_code_fun fun, native_cmp_t&cmp, bool&imm)
+{
+      imm = false;
+      if (fun == &of_CMPE) cmp = NATIVE_CMPE;
+      else if (fun == &of_CMPNE) cmp = NATIVE_CMPNE;
+      else if (fun == &of_CMPS) cmp = NATIVE_CMPS;
+      else if (fun == &of_CMPU) cmp = NATIVE_CMPU;
+      else {
+	    imm = true;
+	    if (fun == &of_CMPIE) cmp = NATIVE_CMPE;
+	    else if (fun == &of_CMPINE) cmp = NATIVE_CMPNE;
+	    else if (fun == &of_CMPIS) cmp = NATIVE_CMPS;
+	    else if (fun == &of_CMPIU) cmp = NATIVE_CMPU;
+	    else return false;
+      }
+      return true;
+}
+
+/*
+ * Write the lowered code of the instruction, if it can be lowered in
+ * the current state. Return false, and write nothing, if not.
+ */
+static bool native_lower(native_state_s&st, size_t idx)
+{
+      vvp_code_t code = native_insn[idx].code;
+      vvp_code_fun fun = native_insn[idx].fun;
+      size_t depth = st.stack.size();
+      string imm;
+
+      if (fun == &of_PUSHI_VEC4) {
+	    if (! native_immediate(code, imm))
+		  return false;
+	    native_push(st, imm, code->number);
+	    return true;
+      }
+
+      if (fun == &of_LOAD_VEC4) {
+	    unsigned wid = native_signal_width(code);
+	    if (wid == 0 || wid > native_word)
+		  return false;
+	    native_lower_load(st, idx, wid);
+	    return true;
+      }
+
+      if (fun == &of_STORE_VEC4) {
+	    unsigned wid = code->bit_idx[1];
+	    if (depth == 0 || code->bit_idx[0] != 0 || wid == 0
+		|| st.stack.back().wid < wid)
+		  return false;
+	    native_value_s val = st.stack.back();
+	    st.stack.pop_back();
+	    string expr = native_var(val.var);
+	    if (val.wid > wid)
+		  expr = native_mask(expr, wid);
+	    native_emit(st.out, "      vthread_native_store(thr, C[%zu], S[%zu], %s, %u);\n",
+			idx, idx, expr.c_str(), wid);
+	    return true;
+      }
+
+      if (fun == &of_POP_VEC4) {
+	    if (code->number > depth)
+		  return false;
+	    st.stack.resize(depth - code->number);
+	    return true;
+      }
+
+      if (fun == &of_DUP_VEC4) {
+	    if (depth == 0)
+		  return false;
+	    st.stack.push_back(st.stack.back());
+	    return true;
+      }
+
+      if (fun == &of_INV) {
+	    if (depth == 0)
+		  return false;
+	    native_value_s val = st.stack.back();
+	    st.stack.pop_back();
+	    native_push(st, native_mask("~" + native_var(val.var), val.wid),
+			val.wid);
+	    return true;
+      }
+
+	/* The binary operators, with both operands on the stack. */
+      const char*op = 0;
+      bool mask = true;
+      if (fun == &of_ADD) op = "+";
+      else if (fun == &of_SUB) op = "-";
+      else if (fun == &of_MUL) op = "*";
+      else if (fun == &of_AND) { op = "&"; mask = false; }
+      else if (fun == &of_OR)  { op = "|"; mask = false; }
+      else if (fun == &of_XOR) { op = "^"; mask = false; }
+
+      if (op) {
+	    if (depth < 2 || st.stack[depth-1].wid != st.stack[depth-2].wid)
+		  return false;
+	    native_value_s r = st.stack[depth-1];
+	    native_value_s l = st.stack[depth-2];
+	    st.stack.resize(depth-2);
+	    string expr = native_var(l.var) + " " + op + " " + native_var(r.var);
+	    native_push(st, mask? native_mask(expr, l.wid) : expr, l.wid);
+	    return true;
+      }
+
+	/* The binary operators with an immediate operand. */
+      if (fun == &of_ADDI) op = "+";
+      else if (fun == &of_SUBI) op = "-";
+      else if (fun == &of_MULI) op = "*";
+
+      if (op) {
+	    if (depth == 0 || ! native_immediate(code, imm)
+		|| st.stack.back().wid != code->number)
+		  return false;
+	    native_value_s l = st.stack.back();
+	    st.stack.pop_back();
+	    string expr = native_var(l.var) + " " + op + " " + imm;
+	    native_push(st, native_mask(expr, l.wid), l.wid);
+	    return true;
+      }
+
+	/* %load/vec4 <var>; %addi <imm>; %store/vec4 <var>, 0, <wid> */
+      if (fun == &of_FUSED_ADDI_VEC4) {
+	    unsigned wid = native_signal_width(code);
+	    if (wid == 0 || wid > native_word
+		|| ! native_immediate(native_insn[idx+1].code, imm))
+		  return false;
+	    native_lower_load(st, idx, wid);
+	    native_value_s l = st.stack.back();
+	    st.stack.pop_back();
+	    native_emit(st.out, "      vthread_native_store(thr, C[%zu], S[%zu], %s, %u);\n",
+			idx+2, idx+2, native_mask(native_var(l.var) + " + " + imm,
+					   wid).c_str(), wid);
+	    return true;
+      }
+
+	/* The compares. */
+      native_cmp_t cmp;
+      bool cmp_imm;
+      if (! native_compare_kind(fun, cmp, cmp_imm))
+	    return false;
+
+      if (cmp_imm) {
+	    if (depth == 0 || ! native_immediate(code, imm)
+		|| st.stack.back().wid != code->number)
+		  return false;
+	    native_value_s l = st.stack.back();
+	    st.stack.pop_back();
+	    native_compare(st, cmp, native_var(l.var), imm, l.wid);
+	    return true;
+      }
+
+      if (depth < 2 || st.stack[depth-1].wid != st.stack[depth-2].wid)
+	    return false;
+      native_value_s r = st.stack[depth-1];
+      native_value_s l = st.stack[depth-2];
+      st.stack.resize(depth-2);
+      native_compare(st, cmp, native_var(l.var), native_var(r.var), l.wid);
+      return true;
+}
+
+/*
+ * Write a jump to the target instruction, if the condition is true
+ * or there is no condition. The jump instructions also check for a
+ * $stop, so that it can break the simulation out of a loop.
+ */
+static void native_jump(native_state_s&st, const char*cond,
+			size_t target, size_t next, size_t entry)
+{
+      native_emit(st.out, "      if (vthread_native_stopped(thr)) {\n");
+      native_flush(st, "\t    ");
+      if (cond)
+	    native_emit(st.out, "\t    *pc = %s? C[%zu] : C[%zu];\n",
+			cond, target, next);
+      else
+	    native_emit(st.out, "\t    *pc = C[%zu];\n", target);
+      native_emit(st.out, "\t    return false;\n");
+      native_emit(st.out, "      }\n");
+
+      const char*ind = "      ";
+      if (cond) {
+	    native_emit(st.out, "      if (%s) {\n", cond);
+	    ind = "\t    ";
+      }
+
+      native_flush(st, ind);
+      if (target == entry) {
+	    native_emit(st.out, "%sgoto L;\n", ind);
+	    st.loop_used = true;
+      } else {
+	    native_emit(st.out, "%s*pc = C[%zu];\n", ind, target);
+	    native_emit(st.out, "%sreturn true;\n", ind);
+      }
+
+      if (cond)
+	    native_emit(st.out, "      }\n");
+}
+
+/*
+ * Get the condition of a %jmp/0, %jmp/0xz, %jmp/1 or %jmp/1xz on a
+ * flag that is in a local variable, or nil if the flag is not.
+ */
+static const char*native_condition(const native_state_s&st, size_t idx,
+				   char*buf, size_t len)
+{
+      vvp_code_t code = native_insn[idx].code;
+      vvp_code_fun fun = native_insn[idx].fun;
+      unsigned flag = code->bit_idx[0];
+      if (flag > 6 || (st.flags & (1U << flag)) == 0)
+	    return 0;
+
+	/* The flag is never x or z in a local variable. */
+      if (fun == &of_JMP0 || fun == &of_JMP0XZ)
+	    snprintf(buf, len, "! f%u", flag);
+      else if (fun == &of_JMP1 || fun == &of_JMP1XZ)
+	    snprintf(buf, len, "f%u", flag);
+      else
+	    return 0;
+
+      return buf;
+}
+
+/*
+ * Write the fused compare and %jmp/0xz, if it can be lowered.
+ */
+static bool native_fused_jump(native_state_s&st, size_t idx, size_t entry)
+{
+      const native_insn_s&cur = native_insn[idx];
+      size_t jmp = idx + cur.code->bit_idx[0];
+      unsigned flag = native_insn[jmp].code->bit_idx[0];
+      unsigned wid = native_signal_width(cur.code);
+      string imm;
+
+      native_cmp_t cmp = NATIVE_CMPE;
+      if (cur.fun == &of_FUSED_CMPIS_JMP0XZ)
+	    cmp = NATIVE_CMPS;
+      else if (cur.fun == &of_FUSED_CMPIU_JMP0XZ)
+	    cmp = NATIVE_CMPU;
+
+	/* The %cmp/e does not set flag 5. */
+      bool flag_set = flag == 4 || flag == 6
+	    || (flag == 5 && (cmp != NATIVE_CMPE || (st.flags & (1U << 5))));
+
+      if (wid == 0 || wid > native_word || ! flag_set
+	  || native_insn[jmp].target == 0
+	  || ! native_immediate(native_insn[idx+1].code, imm))
+	    return false;
+
+      native_lower_load(st, idx, wid);
+      native_value_s l = st.stack.back();
+      st.stack.pop_back();
+      native_compare(st, cmp, native_var(l.var), imm, wid);
+
+      char buf[16];
+      snprintf(buf, sizeof buf, "! f%u", flag);
+      native_jump(st, buf, native_insn[jmp].target, jmp+1, entry);
+      return true;
+}
+
+static void native_write_block(string&out, size_t entry, set<string>&calls)
+{
+      vector<size_t> list;
+      native_block(entry, list);
+
+      native_state_s st;
+      st.flags = 0;
+      st.flags_used = 0;
+      st.vars = 0;
+      st.loop_used = false;
+      st.calls = &calls;
+
+	/* True if the code so far may fall through to the next
+	   instruction, and the program counter is not yet set for
+	   it. */
+      bool open = false;
+
+      for (size_t ldx = 0 ; ldx < list.size() ; ldx += 1) {
+	    size_t cur = list[ldx];
+	    const native_insn_s&insn = native_insn[cur];
+	    size_t target;
+	    size_t next = native_next(cur, target);
+	    char buf[16];
+
+	    native_emit(st.out, "\t// %s\n", insn.name);
+
+	    if (native_lower(st, cur)) {
+		  open = true;
+		  continue;
+	    }
+
+	    if (insn.fun == &of_JMP && target != 0) {
+		  native_jump(st, 0, target, next, entry);
+		  open = false;
+		  break;
+	    }
+
+	    const char*cond;
+	    if (target != 0 && (cond = native_condition(st, cur, buf, sizeof buf))) {
+		  native_jump(st, cond, target, next, entry);
+		  open = true;
+		  continue;
+	    }
+
+	    if (native_is_fused_jump(insn.fun) && native_fused_jump(st, cur, entry)) {
+		  open = true;
+		  continue;
+	    }
+
+	      /* Run the instruction with its opcode function. */
+	    native_flush(st, "      ");
+	    st.stack.clear();
+	    st.flags = 0;
+	    native_call(st, "      ", cur);
+	    open = false;
+
+	    if (target == entry) {
+		  native_emit(st.out, "      if (*pc == C[%zu]) goto L;\n", entry);
+		  st.loop_used = true;
+	    }
+	    if (ldx+1 < list.size())
+		  native_emit(st.out, "      if (*pc != C[%zu]) return true;\n", next);
+	    else
+		  native_emit(st.out, "      return true;\n");
+      }
+
+      if (open) {
+	    size_t target;
+	    size_t next = native_next(list.back(), target);
+	    native_flush(st, "      ");
+	    native_emit(st.out, "      *pc = C[%zu];\n", next);
+	    native_emit(st.out, "      return true;\n");
+      }
+
+      native_emit(out, "static bool B%zu(vthread_s*thr, vvp_code_s*)\n", entry);
+      native_emit(out, "{\n");
+      native_emit(out, "      vvp_code_s**pc = vthread_pc_ref(thr);\n");
+      for (unsigned idx = 4 ; idx <= 6 ; idx += 1) {
+	    if (st.flags_used & (1U << idx))
+		  native_emit(out, "      bool f%u = false;\n", idx);
+      }
+      if (st.loop_used)
+	    native_emit(out, "  L:\n");
+      out += st.out;
+      native_emit(out, "}\n\n");
+}
+
+static void native_write(const char*path)
+{
+      for (size_t idx = 0 ; idx < native_insn.size() ; idx += 1) {
+	    native_insn_s&cur = native_insn[idx];
+	    if (cur.cname.empty()) {
+		  fprintf(stderr, "%s: Unable to write native code: "
+			  "unknown opcode %s.\n", path, cur.name);
+		  compile_errors += 1;
+		  return;
+	    }
+      }
+
+      FILE*fd = fopen(path, "w");
+      if (fd == 0) {
+	    perror(path);
+	    compile_errors += 1;
+	    return;
+      }
+
+	/* Write the blocks first, to find the opcode functions that
+	   they call. */
+      vector<size_t> entries;
+      set<string> calls;
+      string body;
+      for (size_t idx = 0 ; idx < native_insn.size() ; idx += 1) {
+	    if (! native_insn[idx].entry)
+		  continue;
+	    entries.push_back(idx);
+	    native_write_block(body, idx, calls);
+      }
+
+      fprintf(fd, "/*\n");
+      fprintf(fd, " * Native thread code written by vvp -A. Compile this into a shared\n");
+      fprintf(fd, " * object, for example with:\n");
+      fprintf(fd, " *\n");
+      fprintf(fd, " *    %s -O2 %s -o design.so %s\n", NATIVE_CXX,
+	      NATIVE_SHARED, path);
+      fprintf(fd, " *\n");
+      fprintf(fd, " * and load it with vvp -a when running the same design. Giving vvp\n");
+      fprintf(fd, " * both -A and -a does all of that in one run.\n");
+      fprintf(fd, " */\n\n");
+      fprintf(fd, "# include  <stdint.h>\n\n");
+      fprintf(fd, "struct vthread_s;\n");
+      fprintf(fd, "struct vvp_code_s;\n");
+      fprintf(fd, "class vvp_signal_value;\n");
+      fprintf(fd, "typedef bool (*vvp_code_fun)(vthread_s*, vvp_code_s*);\n\n");
+      fprintf(fd, "extern vvp_code_s**vthread_pc_ref(vthread_s*thr);\n");
+      fprintf(fd, "extern bool vthread_native_load(vvp_signal_value*sig, uint64_t&val);\n");
+      fprintf(fd, "extern void vthread_native_store(vthread_s*thr, vvp_code_s*cp,\n");
+      fprintf(fd, "                                 vvp_signal_value*sig,\n");
+      fprintf(fd, "                                 uint64_t val, unsigned wid);\n");
+      fprintf(fd, "extern void vthread_native_push(vthread_s*thr, uint64_t val, unsigned wid);\n");
+      fprintf(fd, "extern void vthread_native_flags(vthread_s*thr, unsigned mask, unsigned bits);\n");
+      fprintf(fd, "extern bool vthread_native_stopped(vthread_s*thr);\n\n");
+      for (set<string>::const_iterator cur = calls.begin()
+		 ; cur != calls.end() ; ++ cur)
+	    fprintf(fd, "extern bool %s(vthread_s*, vvp_code_s*);\n", cur->c_str());
+      fprintf(fd, "\nstatic vvp_code_s*const*C;\n");
+      fprintf(fd, "static vvp_signal_value*const*S;\n\n");
+
+      fputs(body.c_str(), fd);
+
+      fprintf(fd, "extern \"C\" {\n\n");
+      fprintf(fd, "extern const unsigned vvp_native_version = %u;\n",
+	      native_version);
+      fprintf(fd, "extern const unsigned vvp_native_count = %zu;\n",
+	      native_insn.size());
+      fprintf(fd, "extern const char*const vvp_native_opcodes[] = {\n");
+      for (size_t idx = 0 ; idx < native_insn.size() ; idx += 1)
+	    fprintf(fd, "      \"%s\",\n", native_signature(idx).c_str());
+      fprintf(fd, "      0\n};\n\n");
+
+      fprintf(fd, "extern const unsigned vvp_native_entry_count = %zu;\n",
+	      entries.size());
+      fprintf(fd, "extern const unsigned vvp_native_entries[] = {\n");
+      for (size_t idx = 0 ; idx < entries.size() ; idx += 1)
+	    fprintf(fd, "      %zu,\n", entries[idx]);
+      fprintf(fd, "      0\n};\n\n");
+      fprintf(fd, "extern const vvp_code_fun vvp_native_blocks[] = {\n");
+      for (size_t idx = 0 ; idx < entries.size() ; idx += 1)
+	    fprintf(fd, "      &B%zu,\n", entries[idx]);
+      fprintf(fd, "      0\n};\n\n");
+
+      fprintf(fd, "void vvp_native_bind(vvp_code_s*const*code, vvp_signal_value*const*sig)\n");
+      fprintf(fd, "{\n");
+      fprintf(fd, "      C = code;\n");
+      fprintf(fd, "      S = sig;\n");
+      fprintf(fd, "}\n\n");
+      fprintf(fd, "}\n");
+
+      fclose(fd);
+
+      if (verbose_flag) {
+	    fprintf(stderr, " ... Wrote native code for %zu blocks to %s\n",
+		    entries.size(), path);
+	    fflush(stderr);
+      }
+}
+
+/*
+ * Put a path in single quotes for the shell.
+ */
+static string native_quote(const char*path)
+{
+      string res = "'";
+      for (const char*cp = path ; *cp ; cp += 1) {
+	    if (*cp == '\'')
+		  res += "'\\''";
+	    else
+		  res += *cp;
+      }
+      res += "'";
+      return res;
+}
+
+/*
+ * Compile the native source into a shared object with the system C++
+ * compiler. This is the compiler that vvp was built with, unless the
+ * CXX environment variable names another.
+ */
+static void native_build(const char*source, const char*module)
+{
+      const char*cxx = getenv("CXX");
+      if (cxx == 0 || *cxx == 0)
+	    cxx = NATIVE_CXX;
+
+      string cmd = cxx;
+      cmd += " -O2 " NATIVE_SHARED " -o ";
+      cmd += native_quote(module);
+      cmd += " ";
+      cmd += native_quote(source);
+
+      if (verbose_flag) {
+	    fprintf(stderr, " ... Compiling native code: %s\n", cmd.c_str());
+	    fflush(stderr);
+      }
+
+      fflush(stdout);
+      int rc = system(cmd.c_str());
+      if (rc != 0) {
+	    fprintf(stderr, "%s: Unable to compile native code, "
+		    "the command failed: %s\n", module, cmd.c_str());
+	    compile_errors += 1;
+      }
+}
+
+typedef void (*native_bind_f)(vvp_code_t const*code,
+			      vvp_signal_value*const*sig);
+
+static void native_load(const char*path)
+{
+      native_dll = ivl_dlopen(path, false);
+      if (native_dll == 0) {
+	    fprintf(stderr, "%s: Unable to load native code: %s\n",
+		    path, dlerror());
+	    compile_errors += 1;
+	    return;
+      }
+
+      const unsigned*version = (const unsigned*)
+	    ivl_dlsym(native_dll, LU "vvp_native_version" TU);
+      const unsigned*count = (const unsigned*)
+	    ivl_dlsym(native_dll, LU "vvp_native_count" TU);
+      const char*const*opcodes = (const char*const*)
+	    ivl_dlsym(native_dll, LU "vvp_native_opcodes" TU);
+      const unsigned*entry_count = (const unsigned*)
+	    ivl_dlsym(native_dll, LU "vvp_native_entry_count" TU);
+      const unsigned*entries = (const unsigned*)
+	    ivl_dlsym(native_dll, LU "vvp_native_entries" TU);
+      const vvp_code_fun*blocks = (const vvp_code_fun*)
+	    ivl_dlsym(native_dll, LU "vvp_native_blocks" TU);
+      native_bind_f bind = (native_bind_f)
+	    ivl_dlsym(native_dll, LU "vvp_native_bind" TU);
+
+      if (!version || !count || !opcodes || !entry_count
+	  || !entries || !blocks || !bind || *version != native_version) {
+	    fprintf(stderr, "%s: Not a vvp native code module.\n", path);
+	    compile_errors += 1;
+	    return;
+      }
+
+      bool match = *count == native_insn.size();
+      for (size_t idx = 0 ; match && idx < native_insn.size() ; idx += 1) {
+	    if (native_signature(idx) != opcodes[idx])
+		  match = false;
+      }
+      for (unsigned idx = 0 ; match && idx < *entry_count ; idx += 1) {
+	    if (entries[idx] == 0 || entries[idx]+1 >= native_insn.size())
+		  match = false;
+      }
+      if (! match) {
+	    fprintf(stderr, "%s: Native code does not match this design.\n",
+		    path);
+	    compile_errors += 1;
+	    return;
+      }
+
+      native_code.resize(native_insn.size());
+      native_fun.resize(native_insn.size());
+      native_sig.resize(native_insn.size());
+      for (size_t idx = 0 ; idx < native_insn.size() ; idx += 1) {
+	    vvp_code_fun fun = native_insn[idx].fun;
+	    native_code[idx] = native_insn[idx].code;
+	    native_fun[idx] = fun;
+	    native_sig[idx] = 0;
+	    if (fun == &of_LOAD_VEC4 || fun == &of_STORE_VEC4
+		|| fun == &of_FUSED_ADDI_VEC4 || native_is_fused_jump(fun))
+		  native_sig[idx] = dynamic_cast<vvp_signal_value*>
+			(native_insn[idx].code->net->fil);
+      }
+
+      bind(&native_code[0], &native_sig[0]);
+
+      for (unsigned idx = 0 ; idx < *entry_count ; idx += 1)
+	    native_code[entries[idx]]->opcode = blocks[idx];
+
+      if (verbose_flag) {
+	    fprintf(stderr, " ... Loaded native code for %u blocks from %s\n",
+		    *entry_count, path);
+	    fflush(stderr);
+      }
+}
+
+void native_compile(void)
+{
+      if (native_source_path == 0 && native_module_path == 0)
+	    return;
+
+      native_scan();
+
+      if (native_source_path)
+	    native_write(native_source_path);
+      if (native_source_path && native_module_path && compile_errors == 0)
+	    native_build(native_source_path, native_module_path);
+      if (native_module_path && compile_errors == 0)
+	    native_load(native_module_path);
+
+      native_insn.clear();
+      native_starts.clear();
+}
+
+#ifdef CHECK_WITH_VALGRIND
+void native_delete(void)
+{
+	/* Put back the opcodes that the blocks replaced, so that the
+	   code space cleanup finds them. */
+      for (size_t idx = 0 ; idx < native_code.size() ; idx += 1)
+	    native_code[idx]->opcode = native_fun[idx];
+
+      native_insn.clear();
+      native_code.clear();
+      native_sig.clear();
+      native_fun.clear();
+      if (native_dll)
+	    ivl_dlclose(native_dll);
+      native_dll = 0;
+}
+#endif
@@ -0,0 +1,59 @@
+#ifndef IVL_native_H
+#define IVL_native_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "codes.h"
+
+/*
+ * Native thread code is C++ source that vvp writes from the compiled
+ * thread code of a design (the -A flag). It is compiled into a shared
+ * object with the system compiler, and a run of the same design loads
+ * that (the -a flag) to run the threads as native code. With both
+ * flags, vvp runs the compiler itself before it loads the module.
+ *
+ * These are the paths from the command line, or nil.
+ */
+extern const char*native_source_path;
+extern const char*native_module_path;
+
+/*
+ * The compile_cleanup function calls this after the code is linked
+ * and fused. It writes the native source, builds and/or loads the
+ * native module, as requested.
+ */
+extern void native_compile(void);
+
+/*
+ * The compile_thread function calls this with the start of each
+ * thread, so that the native code has an entry there.
+ */
+extern void native_thread_start(vvp_code_t pc);
+
+/*
+ * Get the mnemonic of an opcode function, the name of the function
+ * in the C++ source, and whether its operands include a code pointer
+ * in the cptr or cptr2 member. This returns nil if the function is not
+ * in the opcode table. It lives in compile.cc, with the opcode table.
+ */
+extern const char*compile_opcode_info(vvp_code_fun fun,
+				      const char*&fun_name,
+				      bool&cptr, bool&cptr2);
+
+#endif /* IVL_native_H */
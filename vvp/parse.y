@@ -22,6 +22,7 @@
 # include  "parse_misc.h"
 # include  "compile.h"
 # include  "delay.h"
+# include  "vvp_binary.h"
 # include  <list>
 # include  <cstdio>
 # include  <cstdlib>
@@ -36,6 +37,12 @@ using namespace std;
  */
 extern FILE*yyin;
 
+/*
+ * The parser reads its tokens through binary_lex, which either passes
+ * on the tokens of the text lexor or reads them from a binary design.
+ */
+# define yylex binary_lex
+
 vector <const char*> file_names;
 
 /*
@@ -1246,17 +1253,49 @@ delay
 
 %%
 
+/*
+ * The binary design format (vvp -B) stores the token numbers of this
+ * parser, so it is stamped with this hash of the whole token table:
+ * every token number that yylex can return, with the name of the
+ * token. Changing, adding or removing any token changes the hash. The
+ * names come from the table that bison makes for the -t debug flag,
+ * which the Makefile always passes.
+ */
+unsigned parse_token_signature(void)
+{
+      unsigned sig = 2166136261U;
+      for (int tok = 0 ; tok <= YYMAXUTOK ; tok += 1) {
+	    const char*name = yytname[YYTRANSLATE(tok)];
+	    sig = (sig ^ (unsigned)tok) * 16777619U;
+	    for (const char*cp = name ; *cp ; cp += 1)
+		  sig = (sig ^ (unsigned char)*cp) * 16777619U;
+      }
+      return sig;
+}
+
 int compile_design(const char*path)
 {
       yypath = path;
       yyline = 1;
+
+      int rc = binary_input_open(path);
+      if (rc < 0)
+	    return -1;
+      if (rc > 0) {
+	    rc = yyparse();
+	    binary_input_close();
+	    return rc;
+      }
+
       yyin = fopen(path, "r");
       if (yyin == 0) {
 	    fprintf(stderr, "%s: Unable to open input file.\n", path);
 	    return -1;
       }
 
-      int rc = yyparse();
+      binary_output_open();
+      rc = yyparse();
+      binary_output_close(rc == 0 && compile_errors == 0);
       fclose(yyin);
       return rc;
 }
@@ -27,6 +27,12 @@
  */
 extern int compile_design(const char*path);
 
+/*
+ * Get a hash of the token numbers and names of the parser, which the
+ * binary design format uses to recognize files of another parser.
+ */
+extern unsigned parse_token_signature(void);
+
 /*
  * This routine is called to check that the input file has a compatible
  * version.
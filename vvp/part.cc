@@ -80,6 +80,30 @@ void vvp_fun_part_sa::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 void vvp_fun_part_sa::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 				   unsigned base, unsigned vwid, vvp_context_t)
 {
+	// Only the bits of the sent part changed, so once the part
+	// select has a value, only those that it selects need to be
+	// looked at, and if there are none it has nothing to do.
+      if (val_.size() == wid_) {
+	    unsigned lo = base > base_? base : base_;
+	    unsigned hi = base + bit.size();
+	    if (hi > base_ + wid_)
+		  hi = base_ + wid_;
+	    if (lo >= hi) {
+		  count_unchanged_sends += 1;
+		  return;
+	    }
+
+	    vvp_vector4_t tmp (bit, lo - base, hi - lo);
+	    if (! val_.set_vec(lo - base_, tmp))
+		  return;
+
+	    if (net_ == 0) {
+		  net_ = port.ptr();
+		  schedule_functor(this);
+	    }
+	    return;
+      }
+
       vvp_vector4_t tmp (vwid, BIT4_Z);
       tmp.set_vec(base_, val_);
       tmp.set_vec(base, bit);
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "partition.h"
+# include  "vvp_net.h"
+# include  "statistics.h"
+# include  <vector>
+# include  <cstdio>
+# include  <pthread.h>
+
+using namespace std;
+
+/*
+ * This pass splits the linked netlist into partitions of vvp_net_t
+ * objects that are connected to each other through their output
+ * fanout chains. Nets in different partitions never deliver values
+ * to each other directly, and can only interact through threads,
+ * islands, wide functors or VPI. The result gives an idea of how
+ * loosely coupled the structural part of a design is, and so how
+ * well it might be split up for evaluation. The partitions are only
+ * reported by -v. Nothing evaluates them separately: the -j flag
+ * splits the changed gates of each level of the levelized logic
+ * between threads instead (see parallel_run below).
+ *
+ * The partitions are found with a union-find over the nets, indexed
+ * by the position of each net in the vvp_net_table_t.
+ */
+
+unsigned long count_net_partitions = 0;
+unsigned long count_net_partition_max = 0;
+unsigned long count_net_partition_singles = 0;
+
+static size_t find_root(vector<size_t>&parent, size_t idx)
+{
+      while (parent[idx] != idx) {
+	    parent[idx] = parent[parent[idx]];
+	    idx = parent[idx];
+      }
+      return idx;
+}
+
+void compute_net_partitions(void)
+{
+      vvp_net_table_t table;
+
+      vector<size_t> parent (table.size());
+      for (size_t idx = 0 ; idx < parent.size() ; idx += 1)
+	    parent[idx] = idx;
+
+      for (size_t idx = 0 ; idx < table.size() ; idx += 1) {
+	    vvp_net_ptr_t cur = table[idx]->out_;
+	    while (vvp_net_t*dst = cur.ptr()) {
+		  size_t ddx = table.index(dst);
+		  if (ddx < table.size()) {
+			size_t ra = find_root(parent, idx);
+			size_t rb = find_root(parent, ddx);
+			if (ra != rb) parent[rb] = ra;
+		  }
+		  cur = dst->port[cur.port()];
+	    }
+      }
+
+      vector<unsigned long> size (table.size(), 0);
+      for (size_t idx = 0 ; idx < table.size() ; idx += 1)
+	    size[find_root(parent, idx)] += 1;
+
+      count_net_partitions = 0;
+      count_net_partition_max = 0;
+      count_net_partition_singles = 0;
+      for (size_t idx = 0 ; idx < size.size() ; idx += 1) {
+	    if (size[idx] == 0)
+		  continue;
+	    count_net_partitions += 1;
+	    if (size[idx] == 1)
+		  count_net_partition_singles += 1;
+	    if (size[idx] > count_net_partition_max)
+		  count_net_partition_max = size[idx];
+      }
+}
+
+/*
+ * The worker pool for parallel_run. Each worker waits for the job
+ * generation to change, runs its chunk of the job, and counts itself
+ * off in pool_pending. The main thread runs the first chunk itself,
+ * then waits for pool_pending to reach zero. Worker N always runs
+ * chunk N, so the chunks (and the job arguments) only need to be
+ * published under the lock once per job.
+ */
+unsigned parallel_threads = 1;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER;
+static bool pool_started = false;
+static unsigned pool_workers = 0;
+static unsigned long pool_generation = 0;
+static unsigned long pool_start_generation = 0;
+static unsigned pool_pending = 0;
+
+static size_t pool_count = 0;
+static parallel_fun_t pool_fun = 0;
+static void*pool_arg = 0;
+
+static void pool_run_chunk(unsigned part)
+{
+      unsigned parts = pool_workers + 1;
+      size_t lo = pool_count * part / parts;
+      size_t hi = pool_count * (part+1) / parts;
+      if (lo < hi)
+	    pool_fun(lo, hi, pool_arg);
+}
+
+static void* pool_thread(void*arg)
+{
+      unsigned part = (unsigned) (size_t) arg;
+
+	/* The job generation when the pool was started. The first
+	   job may already be posted by the time this thread runs. */
+      unsigned long seen = pool_start_generation;
+
+      pthread_mutex_lock(&pool_lock);
+      for (;;) {
+	    while (pool_generation == seen)
+		  pthread_cond_wait(&pool_work, &pool_lock);
+	    seen = pool_generation;
+	    pthread_mutex_unlock(&pool_lock);
+
+	    pool_run_chunk(part);
+
+	    pthread_mutex_lock(&pool_lock);
+	    pool_pending -= 1;
+	    if (pool_pending == 0)
+		  pthread_cond_signal(&pool_done);
+      }
+      return 0;
+}
+
+/*
+ * The threads of the pool do not survive a fork (the snapshot
+ * fan-out of the -F flag), so the child forgets them and starts a
+ * new pool if it needs one. The lock is held across the fork so that
+ * the child does not get a copy that a worker had locked.
+ */
+static void pool_atfork_prepare(void)
+{
+      pthread_mutex_lock(&pool_lock);
+}
+
+static void pool_atfork_parent(void)
+{
+      pthread_mutex_unlock(&pool_lock);
+}
+
+static void pool_atfork_child(void)
+{
+      pool_started = false;
+      pool_workers = 0;
+      pool_pending = 0;
+      pthread_cond_init(&pool_work, 0);
+      pthread_cond_init(&pool_done, 0);
+      pthread_mutex_unlock(&pool_lock);
+}
+
+static void pool_start(void)
+{
+      static bool atfork_registered = false;
+      if (! atfork_registered) {
+	    pthread_atfork(pool_atfork_prepare, pool_atfork_parent,
+			   pool_atfork_child);
+	    atfork_registered = true;
+      }
+
+      pool_started = true;
+      pool_workers = 0;
+      pool_start_generation = pool_generation;
+      for (unsigned idx = 1 ; idx < parallel_threads ; idx += 1) {
+	    pthread_t tid;
+	    void*part = (void*) (size_t) idx;
+	    int rc = pthread_create(&tid, 0, pool_thread, part);
+	    if (rc != 0) {
+		  fprintf(stderr, "vvp warning: Unable to start logic "
+			  "thread %u of %u, continuing with %u.\n",
+			  idx+1, parallel_threads, idx);
+		  break;
+	    }
+	    pthread_detach(tid);
+	    pool_workers += 1;
+      }
+}
+
+void parallel_run(size_t count, parallel_fun_t fun, void*arg)
+{
+      if (! pool_started)
+	    pool_start();
+
+      if (pool_workers == 0) {
+	    if (count > 0)
+		  fun(0, count, arg);
+	    return;
+      }
+
+      pthread_mutex_lock(&pool_lock);
+      pool_count = count;
+      pool_fun = fun;
+      pool_arg = arg;
+      pool_pending = pool_workers;
+      pool_generation += 1;
+      pthread_cond_broadcast(&pool_work);
+      pthread_mutex_unlock(&pool_lock);
+
+      pool_run_chunk(0);
+
+      pthread_mutex_lock(&pool_lock);
+      while (pool_pending > 0)
+	    pthread_cond_wait(&pool_done, &pool_lock);
+      pthread_mutex_unlock(&pool_lock);
+}
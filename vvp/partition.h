@@ -0,0 +1,42 @@
+#ifndef IVL_partition_H
+#define IVL_partition_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  <cstddef>
+
+/*
+ * The number of threads (including the main thread) that evaluate
+ * the levelized logic, set by the -j flag. The default of 1 keeps
+ * all of the simulation on the main thread.
+ */
+extern unsigned parallel_threads;
+
+/*
+ * Split the range [0,count) into parallel_threads contiguous chunks
+ * and call fun(lo, hi, arg) for each, one chunk on the main thread
+ * and the rest on a pool of worker threads. This returns when all of
+ * the chunks are done. The worker threads are started by the first
+ * call, and are started again after a fork. The function must not
+ * touch the scheduler or anything else that is not thread safe.
+ */
+typedef void (*parallel_fun_t)(size_t lo, size_t hi, void*arg);
+extern void parallel_run(size_t count, parallel_fun_t fun, void*arg);
+
+#endif /* IVL_partition_H */
@@ -0,0 +1,606 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "profile.h"
+# include  "compile.h"
+# include  "native.h"
+# include  "vpi_priv.h"
+# include  <algorithm>
+# include  <chrono>
+# include  <cstdio>
+# include  <cstdlib>
+# include  <map>
+# include  <string>
+# include  <typeindex>
+# include  <unordered_map>
+# include  <vector>
+#ifdef __GNUC__
+# include  <cxxabi.h>
+#endif
+
+using namespace std;
+
+const char*profile_path = 0;
+bool profile_flag = false;
+
+typedef chrono::steady_clock profile_clock;
+
+/*
+ * An item is a process or a functor class. The times are in
+ * nanoseconds, and are the time that the item spent itself.
+ */
+struct profile_item_s {
+      bool process;
+      string name;
+	// Processes only: the scope, and the first %file_line, if any.
+	// The file names are read at the end of the design file, so
+	// the file and line are only looked up for the report.
+      __vpiScope*scope;
+      vpiHandle file_line;
+
+      uint64_t time;
+      uint64_t runs;
+      uint64_t opcodes;
+      uint64_t values;
+	// The node that the item was last entered at, and the parent
+	// of that node, so that the node map is only searched when an
+	// item is called from somewhere new.
+      unsigned last_parent;
+      unsigned last_node;
+};
+
+/*
+ * The call stacks are kept as a tree of nodes, each an item called
+ * from the item of its parent node. Node 0 is the root, which stands
+ * for the scheduler itself.
+ */
+struct profile_node_s {
+      unsigned parent;
+      profile_item_s*item;
+      uint64_t time;
+};
+
+struct profile_frame_s {
+      unsigned node;
+      profile_clock::time_point start;
+	// The time of the runs and events called from this one.
+      uint64_t called;
+};
+
+static map<vvp_code_t,profile_item_s*> profile_procs;
+static map<vvp_code_t,string> profile_labels;
+static unordered_map<type_index,profile_item_s*> profile_classes;
+
+/*
+ * The opcodes are counted in a flat open addressed table, keyed by
+ * the opcode function, so that counting an opcode is a hash and
+ * nearly always a single compare. The table is kept at most half
+ * full. The names of the opcodes are only looked up for the report.
+ */
+struct profile_opcode_s {
+      vvp_code_fun fun;
+      uint64_t count;
+};
+static profile_opcode_s*profile_opcode_table = 0;
+static size_t profile_opcode_mask = 0;
+static size_t profile_opcode_used = 0;
+
+static const type_info*profile_last_type = 0;
+static profile_item_s*profile_last_class = 0;
+
+static vector<profile_node_s> profile_nodes;
+static map<pair<unsigned,profile_item_s*>,unsigned> profile_node_map;
+static vector<profile_frame_s> profile_stack;
+static profile_item_s*profile_current = 0;
+static profile_clock::time_point profile_start_time;
+
+static string profile_type_name_(const type_info&type)
+{
+      string name = type.name();
+#ifdef __GNUC__
+      int status = 0;
+      char*buf = abi::__cxa_demangle(type.name(), 0, 0, &status);
+      if (buf && status == 0)
+	    name = buf;
+      free(buf);
+#endif
+      return name;
+}
+
+static profile_item_s* profile_new_item_(bool process, const string&name)
+{
+      profile_item_s*item = new profile_item_s;
+      item->process = process;
+      item->name = name;
+      item->scope = 0;
+      item->file_line = 0;
+      item->time = 0;
+      item->runs = 0;
+      item->opcodes = 0;
+      item->values = 0;
+      item->last_parent = 0;
+      item->last_node = 0;
+      return item;
+}
+
+void profile_label(vvp_code_t pc, const char*label)
+{
+      profile_labels[pc] = label;
+}
+
+/*
+ * Look for the first %file_line of the process, following the code
+ * from the start address until it ends or leaves the process.
+ */
+static void profile_find_file_line_(profile_item_s*proc, vvp_code_t pc)
+{
+      for (unsigned idx = 0 ; idx < 64 && pc ; idx += 1) {
+	    if (pc->opcode == &of_FILE_LINE) {
+		  proc->file_line = pc->handle;
+		  return;
+	    }
+	    if (pc->opcode == &of_CHUNK_LINK) {
+		  pc = pc->cptr;
+		  continue;
+	    }
+	    if (pc->opcode == &of_END || pc->opcode == &of_JMP)
+		  return;
+	    pc += 1;
+      }
+}
+
+profile_item_s* profile_process(vvp_code_t pc, __vpiScope*scope)
+{
+      profile_item_s*&proc = profile_procs[pc];
+      if (proc)
+	    return proc;
+
+      map<vvp_code_t,string>::const_iterator label = profile_labels.find(pc);
+      proc = profile_new_item_(true, label == profile_labels.end()
+			       ? string("thread") : label->second);
+      proc->scope = scope;
+      profile_find_file_line_(proc, pc);
+      return proc;
+}
+
+static void profile_enter_(profile_item_s*item)
+{
+      unsigned parent = profile_stack.empty()? 0 : profile_stack.back().node;
+      unsigned node = item->last_node;
+      if (node == 0 || item->last_parent != parent) {
+	    unsigned&map_node = profile_node_map[make_pair(parent, item)];
+	    if (map_node == 0) {
+		  profile_node_s tmp;
+		  tmp.parent = parent;
+		  tmp.item = item;
+		  tmp.time = 0;
+		  map_node = profile_nodes.size();
+		  profile_nodes.push_back(tmp);
+	    }
+	    node = map_node;
+	    item->last_parent = parent;
+	    item->last_node = node;
+      }
+
+      profile_frame_s frame;
+      frame.node = node;
+      frame.called = 0;
+      profile_stack.push_back(frame);
+      item->runs += 1;
+      profile_current = item;
+	// Take the time last, so that the work above is not counted.
+      profile_stack.back().start = profile_clock::now();
+}
+
+static void profile_leave_(void)
+{
+      profile_clock::time_point now = profile_clock::now();
+      profile_frame_s&frame = profile_stack.back();
+      uint64_t total = chrono::duration_cast<chrono::nanoseconds>
+	    (now - frame.start).count();
+      uint64_t self = total > frame.called? total - frame.called : 0;
+
+      profile_node_s&node = profile_nodes[frame.node];
+      node.time += self;
+      node.item->time += self;
+      profile_stack.pop_back();
+
+      if (profile_stack.empty()) {
+	    profile_current = 0;
+      } else {
+	    profile_stack.back().called += total;
+	    profile_current = profile_nodes[profile_stack.back().node].item;
+      }
+}
+
+void profile_thread_enter(profile_item_s*proc)
+{
+      profile_enter_(proc);
+}
+
+void profile_thread_leave(void)
+{
+      profile_leave_();
+}
+
+static inline size_t profile_opcode_hash_(vvp_code_fun fun)
+{
+      uint64_t key = reinterpret_cast<uintptr_t>(fun);
+      return (size_t)((key * UINT64_C(0x9e3779b97f4a7c15)) >> 32);
+}
+
+static void profile_opcode_grow_(void)
+{
+      profile_opcode_s*old_table = profile_opcode_table;
+      size_t old_size = old_table? profile_opcode_mask + 1 : 0;
+      size_t new_size = old_size? 2*old_size : 512;
+
+      profile_opcode_table = new profile_opcode_s[new_size];
+      profile_opcode_mask = new_size - 1;
+      for (size_t idx = 0 ; idx < new_size ; idx += 1) {
+	    profile_opcode_table[idx].fun = 0;
+	    profile_opcode_table[idx].count = 0;
+      }
+
+      for (size_t idx = 0 ; idx < old_size ; idx += 1) {
+	    if (old_table[idx].fun == 0)
+		  continue;
+	    size_t ndx = profile_opcode_hash_(old_table[idx].fun)
+		  & profile_opcode_mask;
+	    while (profile_opcode_table[ndx].fun)
+		  ndx = (ndx + 1) & profile_opcode_mask;
+	    profile_opcode_table[ndx] = old_table[idx];
+      }
+      delete[]old_table;
+}
+
+void profile_opcode(vvp_code_fun fun)
+{
+      profile_current->opcodes += 1;
+
+      size_t idx = profile_opcode_hash_(fun) & profile_opcode_mask;
+      while (profile_opcode_table[idx].fun != fun) {
+	    if (profile_opcode_table[idx].fun == 0) {
+		  if (2*(profile_opcode_used+1) > profile_opcode_mask+1) {
+			profile_opcode_grow_();
+			idx = profile_opcode_hash_(fun) & profile_opcode_mask;
+			while (profile_opcode_table[idx].fun)
+			      idx = (idx + 1) & profile_opcode_mask;
+		  }
+		  profile_opcode_table[idx].fun = fun;
+		  profile_opcode_used += 1;
+		  break;
+	    }
+	    idx = (idx + 1) & profile_opcode_mask;
+      }
+      profile_opcode_table[idx].count += 1;
+}
+
+static profile_item_s* profile_class_(const type_info&type)
+{
+      if (&type == profile_last_type)
+	    return profile_last_class;
+
+      profile_item_s*&item = profile_classes[type_index(type)];
+      if (item == 0)
+	    item = profile_new_item_(false, profile_type_name_(type));
+      profile_last_type = &type;
+      profile_last_class = item;
+      return item;
+}
+
+void profile_event_enter(const type_info&type)
+{
+      profile_enter_(profile_class_(type));
+}
+
+void profile_event_leave(void)
+{
+      profile_leave_();
+}
+
+void profile_recv(vvp_net_fun_t*fun)
+{
+      profile_class_(typeid(*fun))->values += 1;
+}
+
+void profile_start(void)
+{
+      profile_node_s root;
+      root.parent = 0;
+      root.item = 0;
+      root.time = 0;
+      profile_nodes.push_back(root);
+      profile_opcode_grow_();
+      profile_start_time = profile_clock::now();
+}
+
+/*
+ * The report
+ */
+
+static const size_t PROFILE_ROWS = 100;
+
+static string profile_item_name_(const profile_item_s*item)
+{
+      if (! item->process)
+	    return item->name;
+
+      string name = item->name;
+      if (item->file_line) {
+	    char buf[32];
+	    snprintf(buf, sizeof buf, ":%d", vpi_get(vpiLineNo, item->file_line));
+	    name += string("@") + vpi_get_str(vpiFile, item->file_line) + buf;
+      }
+      return name;
+}
+
+static string profile_scope_name_(__vpiScope*scope)
+{
+      if (scope == 0)
+	    return "";
+      return scope->vpi_get_str(vpiFullName);
+}
+
+struct profile_row_s {
+      string name;
+      uint64_t time;
+      uint64_t runs;
+      uint64_t count;
+};
+
+static bool profile_row_less_(const profile_row_s&a, const profile_row_s&b)
+{
+      if (a.time != b.time)
+	    return a.time > b.time;
+      if (a.count != b.count)
+	    return a.count > b.count;
+      return a.name < b.name;
+}
+
+static void profile_rows_(FILE*fd, vector<profile_row_s>&rows,
+			  uint64_t total, const char*runs, const char*count)
+{
+      sort(rows.begin(), rows.end(), &profile_row_less_);
+
+      fprintf(fd, "  %12s %6s %12s %12s  %s\n", "time (ms)", "%", runs, count,
+	      "name");
+      for (size_t idx = 0 ; idx < rows.size() && idx < PROFILE_ROWS ; idx += 1) {
+	    const profile_row_s&row = rows[idx];
+	    fprintf(fd, "  %12.3f %6.2f %12llu %12llu  %s\n",
+		    row.time / 1e6, total? 100.0 * row.time / total : 0.0,
+		    (unsigned long long)row.runs,
+		    (unsigned long long)row.count, row.name.c_str());
+      }
+      if (rows.size() > PROFILE_ROWS)
+	    fprintf(fd, "  ... %zu more\n", rows.size() - PROFILE_ROWS);
+      fprintf(fd, "\n");
+}
+
+/*
+ * The opcodes are not timed, so they are listed by count instead.
+ */
+static void profile_opcode_rows_(FILE*fd, vector<profile_row_s>&rows,
+				 uint64_t total)
+{
+      sort(rows.begin(), rows.end(), &profile_row_less_);
+
+      fprintf(fd, "  %12s %6s  %s\n", "count", "%", "opcode");
+      for (size_t idx = 0 ; idx < rows.size() && idx < PROFILE_ROWS ; idx += 1) {
+	    const profile_row_s&row = rows[idx];
+	    fprintf(fd, "  %12llu %6.2f  %s\n", (unsigned long long)row.count,
+		    total? 100.0 * row.count / total : 0.0, row.name.c_str());
+      }
+      if (rows.size() > PROFILE_ROWS)
+	    fprintf(fd, "  ... %zu more\n", rows.size() - PROFILE_ROWS);
+      fprintf(fd, "\n");
+}
+
+/*
+ * These opcodes are made by the compiler and the optimizer instead of
+ * being parsed from the opcode table, so they are named here.
+ */
+static const struct {
+      vvp_code_fun fun;
+      const char*name;
+} profile_other_opcodes[] = {
+      { &of_VPI_CALL,            "%vpi_call" },
+      { &of_FILE_LINE,           "%file_line" },
+      { &of_CHUNK_LINK,          "(chunk link)" },
+      { &of_EXEC_UFUNC_REAL,     "(exec ufunc/real)" },
+      { &of_EXEC_UFUNC_VEC4,     "(exec ufunc/vec4)" },
+      { &of_REAP_UFUNC,          "(reap ufunc)" },
+      { &of_FUSED_ADDI_VEC4,     "(fused %addi/%store)" },
+      { &of_FUSED_CMPIE_JMP0XZ,  "(fused %cmpi/e/%jmp/0xz)" },
+      { &of_FUSED_CMPIS_JMP0XZ,  "(fused %cmpi/s/%jmp/0xz)" },
+      { &of_FUSED_CMPIU_JMP0XZ,  "(fused %cmpi/u/%jmp/0xz)" },
+      { 0, 0 }
+};
+
+static const char* profile_opcode_name_(vvp_code_fun fun)
+{
+      const char*fun_name;
+      bool cptr, cptr2;
+      if (const char*name = compile_opcode_info(fun, fun_name, cptr, cptr2))
+	    return name;
+
+      for (unsigned idx = 0 ; profile_other_opcodes[idx].fun ; idx += 1) {
+	    if (profile_other_opcodes[idx].fun == fun)
+		  return profile_other_opcodes[idx].name;
+      }
+
+	// Anything else is a block of native code (vvp -a).
+      return "(native code)";
+}
+
+static void profile_write_report_(FILE*fd, uint64_t total)
+{
+      uint64_t thread_time = 0, event_time = 0;
+      uint64_t opcodes = 0, values = 0;
+
+      vector<profile_row_s> procs;
+      map<__vpiScope*,profile_row_s> scopes;
+      for (map<vvp_code_t,profile_item_s*>::const_iterator cur = profile_procs.begin()
+		 ; cur != profile_procs.end() ; ++ cur) {
+	    const profile_item_s*item = cur->second;
+	    if (item->runs == 0)
+		  continue;
+	    thread_time += item->time;
+	    opcodes += item->opcodes;
+
+	    profile_row_s row;
+	    row.name = profile_scope_name_(item->scope) + ": "
+		  + profile_item_name_(item);
+	    row.time = item->time;
+	    row.runs = item->runs;
+	    row.count = item->opcodes;
+	    procs.push_back(row);
+
+	    profile_row_s&srow = scopes[item->scope];
+	    srow.time += item->time;
+	    srow.runs += item->runs;
+	    srow.count += item->opcodes;
+      }
+
+      vector<profile_row_s> scope_rows;
+      for (map<__vpiScope*,profile_row_s>::iterator cur = scopes.begin()
+		 ; cur != scopes.end() ; ++ cur) {
+	    cur->second.name = profile_scope_name_(cur->first);
+	    scope_rows.push_back(cur->second);
+      }
+
+      vector<profile_row_s> classes;
+      for (unordered_map<type_index,profile_item_s*>::const_iterator cur = profile_classes.begin()
+		 ; cur != profile_classes.end() ; ++ cur) {
+	    const profile_item_s*item = cur->second;
+	    event_time += item->time;
+	    values += item->values;
+
+	    profile_row_s row;
+	    row.name = item->name;
+	    row.time = item->time;
+	    row.runs = item->runs;
+	    row.count = item->values;
+	    classes.push_back(row);
+      }
+
+      vector<profile_row_s> codes;
+      for (size_t idx = 0 ; idx <= profile_opcode_mask ; idx += 1) {
+	    const profile_opcode_s&cur = profile_opcode_table[idx];
+	    if (cur.fun == 0)
+		  continue;
+	    profile_row_s row;
+	    row.name = profile_opcode_name_(cur.fun);
+	    row.time = 0;
+	    row.runs = 0;
+	    row.count = cur.count;
+	    codes.push_back(row);
+      }
+
+      uint64_t sched_time = profile_nodes[0].time;
+
+      fprintf(fd, "Profile of the simulation\n\n");
+      fprintf(fd, "  %12.3f ms  total\n", total / 1e6);
+      fprintf(fd, "  %12.3f ms  in threads (%llu opcodes)\n", thread_time / 1e6,
+	      (unsigned long long)opcodes);
+      fprintf(fd, "  %12.3f ms  in functor events (%llu values delivered)\n",
+	      event_time / 1e6, (unsigned long long)values);
+      fprintf(fd, "  %12.3f ms  in the scheduler\n\n", sched_time / 1e6);
+
+      fprintf(fd, "Scopes:\n");
+      profile_rows_(fd, scope_rows, total, "runs", "opcodes");
+      fprintf(fd, "Processes:\n");
+      profile_rows_(fd, procs, total, "runs", "opcodes");
+      fprintf(fd, "Functor classes:\n");
+      profile_rows_(fd, classes, total, "events", "values");
+      fprintf(fd, "Opcodes:\n");
+      profile_opcode_rows_(fd, codes, opcodes);
+}
+
+/*
+ * The frames of a folded stack are separated by ';', so the scope
+ * names are split at the '.' into a frame for each level.
+ */
+static string profile_frame_(const profile_node_s&node)
+{
+      const profile_item_s*item = node.item;
+      if (! item->process) {
+	    if (node.parent == 0)
+		  return "(functors);" + item->name;
+	    return item->name;
+      }
+
+      string scope = profile_scope_name_(item->scope);
+      if (node.parent == 0) {
+	    replace(scope.begin(), scope.end(), '.', ';');
+	    return scope + ";" + profile_item_name_(item);
+      }
+      return scope + ":" + profile_item_name_(item);
+}
+
+static void profile_write_folded_(FILE*fd)
+{
+      vector<string> names (profile_nodes.size());
+      names[0] = "(scheduler)";
+      if (profile_nodes[0].time)
+	    fprintf(fd, "%s %llu\n", names[0].c_str(),
+		    (unsigned long long)profile_nodes[0].time);
+
+	// A node always comes after its parent, so the names of the
+	// parents are there when they are needed.
+      for (size_t idx = 1 ; idx < profile_nodes.size() ; idx += 1) {
+	    const profile_node_s&node = profile_nodes[idx];
+	    string frame = profile_frame_(node);
+	    names[idx] = node.parent? names[node.parent] + ";" + frame : frame;
+	    if (node.time)
+		  fprintf(fd, "%s %llu\n", names[idx].c_str(),
+			  (unsigned long long)node.time);
+      }
+}
+
+void profile_write(void)
+{
+      uint64_t total = chrono::duration_cast<chrono::nanoseconds>
+	    (profile_clock::now() - profile_start_time).count();
+
+	// Whatever the threads and events did not take is the time of
+	// the scheduler itself.
+      uint64_t used = 0;
+      for (size_t idx = 1 ; idx < profile_nodes.size() ; idx += 1)
+	    used += profile_nodes[idx].time;
+      profile_nodes[0].time = total > used? total - used : 0;
+
+      FILE*fd = fopen(profile_path, "w");
+      if (fd == 0) {
+	    perror(profile_path);
+	    return;
+      }
+      profile_write_report_(fd, total);
+      fclose(fd);
+
+      string folded = string(profile_path) + ".folded";
+      fd = fopen(folded.c_str(), "w");
+      if (fd == 0) {
+	    perror(folded.c_str());
+	    return;
+      }
+      profile_write_folded_(fd);
+      fclose(fd);
+}
@@ -0,0 +1,77 @@
+#ifndef IVL_profile_H
+#define IVL_profile_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "codes.h"
+# include  <typeinfo>
+
+/*
+ * The profiler (the -P flag) counts and times what the simulation
+ * spends its time on. The things that it measures are the processes
+ * and the functor classes of the design:
+ *
+ *   - A process is the code that a thread starts at. The threads of
+ *     the .thread statements (the always and initial blocks) and the
+ *     threads of tasks, functions and forks are each a process. Each
+ *     run of a thread is timed, and the opcodes that it executes are
+ *     counted. The processes are named by the label of their .thread
+ *     statement, if any, and by the first %file_line in their code,
+ *     which the compiler writes with -pfileline=1.
+ *
+ *   - A functor class is the C++ class of the functors that events in
+ *     the scheduler work on, such as propagations out of delays and
+ *     assignments into variables. Each event is timed, and each value
+ *     delivered to a functor is counted by the class of the functor.
+ *
+ * The time of a run or event is what it spends itself, without the
+ * time of other runs or events that it calls. Processes are added up
+ * into the scopes that they belong to for the report.
+ *
+ * At the end of the simulation, profile_write() writes a text report
+ * to the -P file and the call stacks, in the folded form that the
+ * flame graph tools read, to the same file with a ".folded" suffix.
+ */
+
+class __vpiScope;
+struct profile_item_s;
+
+  // The profile_flag, which the -P flag sets, and profile_recv(),
+  // which counts a value delivered to a functor, are in vvp_net.h.
+extern const char*profile_path;
+
+  // Give the .thread label of the code at pc to the process.
+extern void profile_label(vvp_code_t pc, const char*label);
+  // Get the process of a thread that starts at pc, in the scope.
+extern profile_item_s* profile_process(vvp_code_t pc, __vpiScope*scope);
+
+  // Bracket a run of a thread, and count its opcodes. A run may hold
+  // runs of other threads (function calls).
+extern void profile_thread_enter(profile_item_s*proc);
+extern void profile_thread_leave(void);
+extern void profile_opcode(vvp_code_fun fun);
+
+  // Bracket an event that the scheduler runs for a functor class.
+extern void profile_event_enter(const std::type_info&type);
+extern void profile_event_leave(void);
+
+extern void profile_start(void);
+extern void profile_write(void);
+
+#endif /* IVL_profile_H */
@@ -24,12 +24,22 @@
 # include  "vvp_net_sig.h"
 # include  "slab.h"
 # include  "compile.h"
+# include  "checkpoint.h"
+# include  "logic.h"
+# include  "partition.h"
+# include  "profile.h"
+# include  "statistics.h"
 # include  <new>
 # include  <typeinfo>
 # include  <csignal>
 # include  <cstdlib>
+# include  <cstdio>
+# include  <cstring>
 # include  <cassert>
 # include  <iostream>
+# include  <algorithm>
+# include  <map>
+# include  <vector>
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 # include  "ivl_alloc.h"
@@ -40,6 +50,7 @@ using namespace std;
 unsigned long count_assign_events = 0;
 unsigned long count_gen_events = 0;
 unsigned long count_thread_events = 0;
+unsigned long count_thread_wakes_merged = 0;
   // Count the time events (A time cell created)
 unsigned long count_time_events = 0;
 
@@ -73,20 +84,25 @@ void event_s::single_step_display(void)
       std::cerr << "event_s: Step into event " << typeid(*this).name() << std::endl;
 }
 
+struct assign_batch_s;
+
 struct event_time_s {
       event_time_s() {
 	    count_time_events += 1;
-	    delay = 0;
+	    time = 0;
 	    start = 0;
 	    active = 0;
 	    inactive = 0;
 	    nbassign = 0;
+	    nba_batch = 0;
 	    rwsync = 0;
 	    rosync = 0;
 	    del_thr = 0;
 	    next = NULL;
+	    hash_next = NULL;
       }
-      vvp_time64_t delay;
+	// The absolute simulation time of this time step.
+      vvp_time64_t time;
 
       struct event_s*start;
       struct event_s*active;
@@ -96,7 +112,15 @@ struct event_time_s {
       struct event_s*rosync;
       struct event_s*del_thr;
 
+	// The batch of non-blocking assignments that new assignments to
+	// this time step are added to, if it is still the last event of
+	// the nbassign queue.
+      struct assign_batch_s*nba_batch;
+
+	// Link to the next time step in the same timing wheel slot.
       struct event_time_s*next;
+	// Link to the next time step in the same hash bucket.
+      struct event_time_s*hash_next;
 
       static void* operator new (size_t);
       static void operator delete(void*obj, size_t s);
@@ -123,8 +147,17 @@ struct vthread_event_s : public event_s {
       static void operator delete(void*);
 };
 
+/*
+ * The latest event of schedule_vthread_wake, and the last thread in
+ * its list, while the event is waiting to run.
+ */
+static struct vthread_event_s*sched_wake_event = 0;
+static vthread_t sched_wake_tail = 0;
+
 void vthread_event_s::run_run(void)
 {
+      if (this == sched_wake_event)
+	    sched_wake_event = 0;
       count_thread_events += 1;
       vthread_run(thr);
 }
@@ -222,6 +255,130 @@ void assign_vector4_event_s::operator delete(void*dptr)
 
 unsigned long count_assign4_pool(void) { return assign4_heap.pool; }
 
+/*
+ * The non-blocking assignments of vectors to a time step are staged in
+ * assign_batch_s events, each of which holds a run of assignments that
+ * follow each other in the nbassign queue of the time step. A new
+ * assignment is added to the batch at the end of the queue if there is
+ * one, so a clock edge that updates many variables makes one event
+ * instead of one per variable, and the batch commits the assignments
+ * in a single sweep, in the order that they were made.
+ *
+ * An assignment to the part of a variable just next to the part that
+ * the last assignment of the batch wrote is merged into it, so that
+ * the variable is updated, and its fanout triggered, once for the
+ * whole run. This is what a loop that assigns a vector a bit at a
+ * time makes. The parts do not overlap, so each bit still changes at
+ * most once. Assignments that overlap, for example repeated writes of
+ * the same variable, are not merged and commit in their order.
+ */
+struct assign_batch_s : public event_s {
+
+      struct entry_s {
+	    vvp_net_ptr_t ptr;
+	    vvp_vector4_t val;
+	    unsigned base;
+	    unsigned vwid;
+      };
+
+      assign_batch_s();
+      ~assign_batch_s();
+
+      void add(vvp_net_ptr_t ptr, unsigned base, unsigned vwid,
+	       const vvp_vector4_t&val);
+
+      void run_run(void);
+      void single_step_display(void);
+
+      std::vector<entry_s> list;
+
+    private:
+      bool merge_(vvp_net_ptr_t ptr, unsigned base, unsigned vwid,
+		  const vvp_vector4_t&val);
+
+	// The storage of the last batch to finish, which the next batch
+	// reuses so that the list does not grow again every time step.
+      static std::vector<entry_s> spare_;
+};
+
+unsigned long count_assign_merged = 0;
+
+std::vector<assign_batch_s::entry_s> assign_batch_s::spare_;
+
+assign_batch_s::assign_batch_s()
+{
+      list.swap(spare_);
+}
+
+assign_batch_s::~assign_batch_s()
+{
+      list.clear();
+      if (list.capacity() > spare_.capacity())
+	    list.swap(spare_);
+}
+
+bool assign_batch_s::merge_(vvp_net_ptr_t ptr, unsigned base, unsigned vwid,
+			    const vvp_vector4_t&val)
+{
+      if (list.empty())
+	    return false;
+
+      entry_s&last = list.back();
+      if (last.ptr != ptr || last.vwid == 0 || last.vwid != vwid)
+	    return false;
+
+      unsigned lwid = last.val.size();
+      if (last.base + lwid == base) {
+	    last.val.resize(lwid + val.size());
+	    last.val.set_vec(lwid, val);
+
+      } else if (base + val.size() == last.base) {
+	    vvp_vector4_t tmp (val.size() + lwid);
+	    tmp.set_vec(0, val);
+	    tmp.set_vec(val.size(), last.val);
+	    last.val = tmp;
+	    last.base = base;
+
+      } else {
+	    return false;
+      }
+
+      count_assign_merged += 1;
+      return true;
+}
+
+void assign_batch_s::add(vvp_net_ptr_t ptr, unsigned base, unsigned vwid,
+			 const vvp_vector4_t&val)
+{
+      if (merge_(ptr, base, vwid, val))
+	    return;
+
+      list.resize(list.size() + 1);
+      entry_s&cur = list.back();
+      cur.ptr = ptr;
+      cur.val = val;
+      cur.base = base;
+      cur.vwid = vwid;
+}
+
+void assign_batch_s::run_run(void)
+{
+      for (size_t idx = 0 ; idx < list.size() ; idx += 1) {
+	    const entry_s&cur = list[idx];
+	    count_assign_events += 1;
+	    if (cur.vwid > 0)
+		  vvp_send_vec4_pv(cur.ptr, cur.val, cur.base, cur.vwid, 0);
+	    else
+		  vvp_send_vec4(cur.ptr, cur.val, 0);
+      }
+}
+
+void assign_batch_s::single_step_display(void)
+{
+      cerr << "assign_batch: Propagate " << list.size()
+	   << " non-blocking assignments" << endl;
+}
+
 struct assign_vector8_event_s  : public event_s {
       vvp_net_ptr_t ptr;
       vvp_vector8_t val;
@@ -554,12 +711,258 @@ inline void event_time_s::operator delete(void*ptr, size_t)
 
 unsigned long count_time_pool(void) { return event_time_heap.pool; }
 
+static vvp_time64_t schedule_time;
+
+/*
+ * The pending time steps are kept in a hierarchical timing wheel. The
+ * wheel has WHEEL_LEVELS levels of WHEEL_SIZE slots each, and each
+ * level covers WHEEL_BITS more bits of the absolute simulation time
+ * than the level below it. A time step is placed in the level that
+ * holds the most significant bit where its time differs from the
+ * current wheel time (sched_wheel_now), and in the slot selected by
+ * the bits of its time at that level. This means that:
+ *
+ *   - Level 0 slots each hold at most one time step, and the slot for
+ *     the current time holds the time step that is being executed.
+ *
+ *   - Every time step in a level is later than every time step in
+ *     all the levels below it, so the next time step is found in the
+ *     lowest occupied slot of the lowest occupied level.
+ *
+ * When the simulation time advances into the range covered by a slot
+ * at a higher level, the time steps of that slot are cascaded into
+ * the lower levels. Each time step is cascaded at most once per
+ * level, so inserting and removing time steps is O(1) amortized no
+ * matter how many distinct times are pending. Each level keeps a
+ * bitmap of its occupied slots so that finding the next time step
+ * does not need to scan empty slots.
+ *
+ * The sched_wheel_now value is always the same as schedule_time,
+ * except while cascading.
+ */
+static const unsigned WHEEL_BITS = 8;
+static const unsigned WHEEL_SIZE = 1U << WHEEL_BITS;
+static const unsigned WHEEL_LEVELS = (64 + WHEEL_BITS - 1) / WHEEL_BITS;
+static const unsigned WHEEL_MAP_WORDS = WHEEL_SIZE / 64;
+
+struct wheel_level_s {
+      struct event_time_s*slot[WHEEL_SIZE];
+      uint64_t map[WHEEL_MAP_WORDS];
+};
+
+static struct wheel_level_s sched_wheel[WHEEL_LEVELS];
+static vvp_time64_t sched_wheel_now = 0;
+  // The number of time steps in the wheel.
+static unsigned long sched_wheel_count = 0;
+
+/*
+ * The wheel slots of the higher levels contain time steps for many
+ * different times, so a hash table indexed by the absolute time is
+ * used to find the time step (if any) for a given time.
+ */
+static struct event_time_s**sched_hash = 0;
+static unsigned sched_hash_size = 0;
+
+static inline unsigned sched_hash_index(vvp_time64_t time)
+{
+      uint64_t tmp = time * UINT64_C(0x9e3779b97f4a7c15);
+      return (unsigned) (tmp >> 32) & (sched_hash_size - 1);
+}
+
+static void sched_hash_resize(unsigned new_size)
+{
+      struct event_time_s**old_hash = sched_hash;
+      unsigned old_size = sched_hash_size;
+
+      sched_hash = new struct event_time_s*[new_size];
+      sched_hash_size = new_size;
+      for (unsigned idx = 0 ; idx < new_size ; idx += 1)
+	    sched_hash[idx] = 0;
+
+      for (unsigned idx = 0 ; idx < old_size ; idx += 1) {
+	    while (struct event_time_s*cur = old_hash[idx]) {
+		  old_hash[idx] = cur->hash_next;
+		  unsigned hdx = sched_hash_index(cur->time);
+		  cur->hash_next = sched_hash[hdx];
+		  sched_hash[hdx] = cur;
+	    }
+      }
+
+      delete[]old_hash;
+}
+
+static inline unsigned wheel_level_of(vvp_time64_t time)
+{
+      uint64_t diff = time ^ sched_wheel_now;
+      unsigned level = 0;
+      while (diff >> WHEEL_BITS) {
+	    diff >>= WHEEL_BITS;
+	    level += 1;
+      }
+      return level;
+}
+
+static inline unsigned wheel_slot_of(vvp_time64_t time, unsigned level)
+{
+      return (unsigned) (time >> (level*WHEEL_BITS)) & (WHEEL_SIZE-1);
+}
+
+/*
+ * Return the lowest occupied slot of the level, or WHEEL_SIZE if the
+ * level is empty.
+ */
+static inline unsigned wheel_first_slot(const struct wheel_level_s&lev)
+{
+      for (unsigned wdx = 0 ; wdx < WHEEL_MAP_WORDS ; wdx += 1) {
+	    uint64_t word = lev.map[wdx];
+	    if (word == 0)
+		  continue;
+#if defined(__GNUC__)
+	    return wdx*64 + __builtin_ctzll(word);
+#else
+	    unsigned bit = 0;
+	    while ((word & 1) == 0) {
+		  word >>= 1;
+		  bit += 1;
+	    }
+	    return wdx*64 + bit;
+#endif
+      }
+      return WHEEL_SIZE;
+}
+
+/*
+ * Link the time step into the wheel slot that matches its time
+ * relative to the current wheel time.
+ */
+static void wheel_link(struct event_time_s*ctim)
+{
+      assert(ctim->time >= sched_wheel_now);
+      unsigned level = wheel_level_of(ctim->time);
+      unsigned slot = wheel_slot_of(ctim->time, level);
+      struct wheel_level_s&lev = sched_wheel[level];
+
+      ctim->next = lev.slot[slot];
+      lev.slot[slot] = ctim;
+      lev.map[slot/64] |= UINT64_C(1) << (slot%64);
+}
+
 /*
- * This is the head of the list of pending events. This includes all
- * the events that have not been executed yet, and reaches into the
- * future.
+ * Get the time step for the given absolute time, creating it if it
+ * does not already exist.
  */
-static struct event_time_s* sched_list = 0;
+static struct event_time_s* sched_time_cell(vvp_time64_t time)
+{
+      if (time == sched_wheel_now) {
+	    struct event_time_s*ctim = sched_wheel[0].slot[wheel_slot_of(time,0)];
+	    if (ctim) {
+		  assert(ctim->time == time);
+		  return ctim;
+	    }
+
+      } else if (sched_hash_size > 0) {
+	    unsigned hdx = sched_hash_index(time);
+	    for (struct event_time_s*cur = sched_hash[hdx]
+		       ; cur ; cur = cur->hash_next) {
+		  if (cur->time == time)
+			return cur;
+	    }
+      }
+
+      if (sched_wheel_count >= sched_hash_size)
+	    sched_hash_resize(sched_hash_size? 2*sched_hash_size : 256);
+
+      struct event_time_s*ctim = new struct event_time_s;
+      ctim->time = time;
+
+      unsigned hdx = sched_hash_index(time);
+      ctim->hash_next = sched_hash[hdx];
+      sched_hash[hdx] = ctim;
+
+      wheel_link(ctim);
+      sched_wheel_count += 1;
+      return ctim;
+}
+
+/*
+ * Return the time step for the current simulation time, or nil if
+ * there are no events pending for the current time.
+ */
+static inline struct event_time_s* sched_current(void)
+{
+      assert(sched_wheel_now == schedule_time);
+      return sched_wheel[0].slot[wheel_slot_of(schedule_time,0)];
+}
+
+/*
+ * Remove the time step for the current simulation time from the
+ * wheel and delete it. The time step must be empty.
+ */
+static void sched_retire_current(struct event_time_s*ctim)
+{
+      assert(ctim->time == sched_wheel_now);
+      unsigned slot = wheel_slot_of(ctim->time, 0);
+      struct wheel_level_s&lev = sched_wheel[0];
+      assert(lev.slot[slot] == ctim && ctim->next == 0);
+      lev.slot[slot] = 0;
+      lev.map[slot/64] &= ~(UINT64_C(1) << (slot%64));
+
+      struct event_time_s**pp = &sched_hash[sched_hash_index(ctim->time)];
+      while (*pp != ctim)
+	    pp = &(*pp)->hash_next;
+      *pp = ctim->hash_next;
+
+      sched_wheel_count -= 1;
+      delete ctim;
+}
+
+/*
+ * Advance the wheel to the earliest pending time step, cascading the
+ * time steps of higher levels as needed, and return that time
+ * step. The caller is responsible for advancing schedule_time to the
+ * time of the returned time step. This is only called when there is
+ * no time step for the current time.
+ */
+static struct event_time_s* sched_advance(void)
+{
+      for (;;) {
+	    unsigned level = 0;
+	    unsigned slot = WHEEL_SIZE;
+	    while (level < WHEEL_LEVELS) {
+		  slot = wheel_first_slot(sched_wheel[level]);
+		  if (slot < WHEEL_SIZE) break;
+		  level += 1;
+	    }
+
+	    if (level == WHEEL_LEVELS)
+		  return 0;
+
+	    struct wheel_level_s&lev = sched_wheel[level];
+	    struct event_time_s*list = lev.slot[slot];
+	    if (level == 0) {
+		  sched_wheel_now = list->time;
+		  return list;
+	    }
+
+	      /* Move the wheel time to the start of the range covered
+		 by this slot, then redistribute the time steps of the
+		 slot among the lower levels. */
+	    unsigned shift = level*WHEEL_BITS;
+	    vvp_time64_t span_mask = (((vvp_time64_t)WHEEL_SIZE) << shift) - 1;
+	    if (shift + WHEEL_BITS >= 64)
+		  span_mask = ~(vvp_time64_t)0;
+	    sched_wheel_now = (sched_wheel_now & ~span_mask)
+		  | ((vvp_time64_t)slot << shift);
+
+	    lev.slot[slot] = 0;
+	    lev.map[slot/64] &= ~(UINT64_C(1) << (slot%64));
+	    while (list) {
+		  struct event_time_s*cur = list;
+		  list = cur->next;
+		  wheel_link(cur);
+	    }
+      }
+}
 
 /*
  * This is a list of initialization events. The setup puts
@@ -673,6 +1076,41 @@ static void schedule_final_event(struct event_s*cur)
       schedule_final_list = cur;
 }
 
+/*
+ * With the profiler on, the events are timed in the name of the class
+ * of the functor or callback that they work for, or else of their own
+ * class. Thread events are left alone, since the threads time their
+ * runs themselves.
+ */
+static const type_info& profile_event_type_(struct event_s*cur)
+{
+      if (generic_event_s*gen = dynamic_cast<generic_event_s*>(cur)) {
+	    if (gen->obj)
+		  return typeid(*gen->obj);
+      } else if (propagate_vector4_event_s*p4 = dynamic_cast<propagate_vector4_event_s*>(cur)) {
+	    if (p4->net->fun)
+		  return typeid(*p4->net->fun);
+      } else if (propagate_real_event_s*pr = dynamic_cast<propagate_real_event_s*>(cur)) {
+	    if (pr->net->fun)
+		  return typeid(*pr->net->fun);
+      } else if (assign_vector4_event_s*a4 = dynamic_cast<assign_vector4_event_s*>(cur)) {
+	    if (a4->ptr.ptr()->fun)
+		  return typeid(*a4->ptr.ptr()->fun);
+      }
+      return typeid(*cur);
+}
+
+static inline void run_event_(struct event_s*cur)
+{
+      if (profile_flag && dynamic_cast<vthread_event_s*>(cur) == 0) {
+	    profile_event_enter(profile_event_type_(cur));
+	    cur->run_run();
+	    profile_event_leave();
+      } else {
+	    cur->run_run();
+      }
+}
+
 /*
  * This function does all the hard work of putting an event into the
  * event queue. The event delay is taken from the event structure
@@ -682,61 +1120,12 @@ static void schedule_final_event(struct event_s*cur)
 typedef enum event_queue_e { SEQ_START, SEQ_ACTIVE, SEQ_INACTIVE, SEQ_NBASSIGN,
 			     SEQ_RWSYNC, SEQ_ROSYNC, DEL_THREAD } event_queue_t;
 
-static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
-			    event_queue_t select_queue)
+static void schedule_event_at_(struct event_s*cur, vvp_time64_t time,
+			       event_queue_t select_queue)
 {
       cur->next = cur;
-      struct event_time_s*ctim = sched_list;
-
-      if (sched_list == 0) {
-	      /* Is the event_time list completely empty? Create the
-		 first event_time object. */
-	    ctim = new struct event_time_s;
-	    ctim->delay = delay;
-	    ctim->next  = 0;
-	    sched_list = ctim;
-
-      } else if (sched_list->delay > delay) {
-
-	      /* Am I looking for an event before the first event_time?
-		 If so, create a new event_time to go in front. */
-	    struct event_time_s*tmp = new struct event_time_s;
-	    tmp->delay = delay;
-	    tmp->next = ctim;
-	    ctim->delay -= delay;
-	    ctim = tmp;
-	    sched_list = ctim;
-
-      } else {
-	    struct event_time_s*prev = 0;
-
-	    while (ctim->next && (ctim->delay < delay)) {
-		  delay -= ctim->delay;
-		  prev = ctim;
-		  ctim = ctim->next;
-	    }
-
-	    if (ctim->delay > delay) {
-		  struct event_time_s*tmp = new struct event_time_s;
-		  tmp->delay = delay;
-		  tmp->next  = prev->next;
-		  prev->next = tmp;
-
-		  tmp->next->delay -= delay;
-		  ctim = tmp;
-
-	    } else if (ctim->delay == delay) {
 
-	    } else {
-		  assert(ctim->next == 0);
-		  struct event_time_s*tmp = new struct event_time_s;
-		  tmp->delay = delay - ctim->delay;
-		  tmp->next = 0;
-		  ctim->next = tmp;
-
-		  ctim = tmp;
-	    }
-      }
+      struct event_time_s*ctim = sched_time_cell(time);
 
 	/* By this point, ctim is the event_time structure that is to
 	   receive the event at hand. Put the event in to the
@@ -754,7 +1143,7 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 	    break;
 
 	  case SEQ_INACTIVE:
-	    assert(delay == 0);
+	    assert(time == schedule_time);
 	    q = &ctim->inactive;
 	    break;
 
@@ -785,15 +1174,30 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
       }
 }
 
+static inline vvp_time64_t schedule_delay_time_(vvp_time64_t delay)
+{
+	/* Saturate times that are too far in the future to represent
+	   instead of letting them wrap around into the past. */
+      vvp_time64_t time = schedule_time + delay;
+      if (time < schedule_time)
+	    time = ~(vvp_time64_t)0;
+      return time;
+}
+
+static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
+			    event_queue_t select_queue)
+{
+      schedule_event_at_(cur, schedule_delay_time_(delay), select_queue);
+}
+
 static void schedule_event_push_(struct event_s*cur)
 {
-      if ((sched_list == 0) || (sched_list->delay > 0)) {
+      struct event_time_s*ctim = sched_current();
+      if (ctim == 0) {
 	    schedule_event_(cur, 0, SEQ_ACTIVE);
 	    return;
       }
 
-      struct event_time_s*ctim = sched_list;
-
       if (ctim->active == 0) {
 	    cur->next = cur;
 	    ctim->active = cur;
@@ -823,6 +1227,32 @@ void schedule_vthread(vthread_t thr, vvp_time64_t delay, bool push_flag)
       }
 }
 
+/*
+ * If the latest wake event is still the last event in the active
+ * queue, then a new event would run right after it, so add the threads
+ * to the end of its list instead. They run in the same order either
+ * way, but an edge that wakes many processes that wait on their own
+ * event functors then makes one event instead of one per process.
+ */
+void schedule_vthread_wake(vthread_t thr)
+{
+      vthread_t tail = vthread_mark_scheduled(thr);
+
+      struct event_time_s*ctim = sched_current();
+      if (sched_wake_event && ctim && ctim->active == sched_wake_event) {
+	    vthread_append_list(sched_wake_tail, thr);
+	    sched_wake_tail = tail;
+	    count_thread_wakes_merged += 1;
+	    return;
+      }
+
+      struct vthread_event_s*cur = new vthread_event_s;
+      cur->thr = thr;
+      schedule_event_(cur, 0, SEQ_ACTIVE);
+      sched_wake_event = cur;
+      sched_wake_tail = tail;
+}
+
 void schedule_t0_trigger(vvp_net_ptr_t ptr)
 {
       vvp_vector4_t bit (1, BIT4_X);
@@ -866,11 +1296,15 @@ void schedule_assign_vector(vvp_net_ptr_t ptr,
 			    const vvp_vector4_t&bit,
 			    vvp_time64_t delay)
 {
-      struct assign_vector4_event_s*cur = new struct assign_vector4_event_s(bit);
-      cur->ptr = ptr;
-      cur->base = base;
-      cur->vwid = vwid;
-      schedule_event_(cur, delay, SEQ_NBASSIGN);
+      vvp_time64_t time = schedule_delay_time_(delay);
+      struct event_time_s*ctim = sched_time_cell(time);
+      assign_batch_s*cur = ctim->nba_batch;
+      if (cur == 0 || ctim->nbassign != cur) {
+	    cur = new assign_batch_s;
+	    schedule_event_at_(cur, time, SEQ_NBASSIGN);
+	    ctim->nba_batch = cur;
+      }
+      cur->add(ptr, base, vwid, bit);
 }
 
 void schedule_force_vector(vvp_net_t*net,
@@ -1037,6 +1471,134 @@ void schedule_functor(vvp_gen_event_t obj)
       }
 }
 
+/*
+ * The levelized functors are queued in per-level lists, and a single
+ * functor event (the level sweep) runs them lowest level first. The
+ * levels are assigned so that running a functor only queues functors
+ * at higher levels, so each functor normally runs once per sweep. If
+ * something does queue a lower level (for example through a path
+ * the levelizer did not see) the sweep simply goes back down to it.
+ */
+unsigned long count_level_sweeps = 0;
+unsigned long count_level_runs = 0;
+unsigned long count_level_parallel = 0;
+
+static vector< vector<vvp_fun_levelized_*> > level_queue;
+static vector<vvp_fun_levelized_*> level_work;
+static size_t level_lowest = 0;
+static bool level_sweep_scheduled = false;
+
+/*
+ * With more than one logic thread (the -j flag) a level with at
+ * least this many functors per thread is evaluated in parallel.
+ * Smaller levels are not worth waking the worker threads for.
+ */
+static const size_t level_parallel_min = 64;
+
+static vector<vvp_vector4_t> level_results;
+static vector<char> level_ok;
+
+static void level_eval(size_t lo, size_t hi, void*)
+{
+      for (size_t idx = lo ; idx < hi ; idx += 1)
+	    level_ok[idx] = level_work[idx]->eval(level_results[idx]);
+}
+
+/*
+ * Evaluate the functors of level_work on all the logic threads, and
+ * then send the results in order on this thread. Sending a result
+ * can change the inputs of a later functor of the same level (only
+ * through a path the levelizer did not see), which makes its result
+ * stale, so that functor is run again instead. Functors that do not
+ * have a result (wide vectors, real values) are run here too. The
+ * outputs are therefore the same as those of the serial sweep.
+ */
+static void level_run_parallel(void)
+{
+      size_t count = level_work.size();
+      if (level_results.size() < count)
+	    level_results.resize(count);
+      level_ok.resize(count);
+
+      count_level_parallel += 1;
+      parallel_run(count, &level_eval, 0);
+
+      for (size_t idx = 0 ; idx < count ; idx += 1) {
+	    count_level_runs += 1;
+	    vvp_fun_levelized_*fun = level_work[idx];
+	    if (level_ok[idx] && ! fun->is_stale())
+		  fun->send_result(level_results[idx]);
+	    else
+		  fun->run();
+      }
+}
+
+struct level_sweep_s : public vvp_gen_event_s {
+      ~level_sweep_s() { }
+      void run_run(void);
+      void single_step_display(void);
+};
+
+void level_sweep_s::run_run(void)
+{
+      count_level_sweeps += 1;
+
+      while (level_lowest < level_queue.size()) {
+	    if (level_queue[level_lowest].empty()) {
+		  level_lowest += 1;
+		  continue;
+	    }
+
+	      /* Take the whole level before running any of it, so that
+		 anything queued while it runs goes into a fresh list. */
+	    level_work.swap(level_queue[level_lowest]);
+	    if (parallel_threads > 1 && ! profile_flag
+		&& level_work.size() >= level_parallel_min*parallel_threads) {
+		  level_run_parallel();
+		  level_work.clear();
+		  continue;
+	    }
+
+	    for (size_t idx = 0 ; idx < level_work.size() ; idx += 1) {
+		  count_level_runs += 1;
+		  if (profile_flag) {
+			profile_event_enter(typeid(*level_work[idx]));
+			level_work[idx]->run();
+			profile_event_leave();
+		  } else {
+			level_work[idx]->run();
+		  }
+	    }
+	    level_work.clear();
+      }
+
+      level_sweep_scheduled = false;
+}
+
+void level_sweep_s::single_step_display(void)
+{
+      cerr << "levelized logic sweep" << endl;
+}
+
+static level_sweep_s level_sweep;
+
+void schedule_levelized(vvp_fun_levelized_*obj, unsigned level)
+{
+      assert(level > 0);
+      size_t idx = level - 1;
+      if (idx >= level_queue.size())
+	    level_queue.resize(idx + 1);
+
+      level_queue[idx].push_back(obj);
+      if (idx < level_lowest)
+	    level_lowest = idx;
+
+      if (! level_sweep_scheduled) {
+	    level_sweep_scheduled = true;
+	    schedule_functor(&level_sweep);
+      }
+}
+
 void schedule_at_start_of_simtime(vvp_gen_event_t obj, vvp_time64_t delay)
 {
       struct generic_event_s*cur = new generic_event_s;
@@ -1060,7 +1622,6 @@ void schedule_at_end_of_simtime(vvp_gen_event_t obj, vvp_time64_t delay)
       schedule_event_(cur, delay, SEQ_RWSYNC);
 }
 
-static vvp_time64_t schedule_time;
 vvp_time64_t schedule_simtime(void)
 { return schedule_time; }
 
@@ -1073,6 +1634,285 @@ static bool sim_at_rosync = false;
 bool schedule_at_rosync(void)
 { return sim_at_rosync; }
 
+/*
+ * Scheduler statistics. The main loop counts the events that it runs
+ * from each region of the time step. The queue of a later region is
+ * moved into the active queue when that runs dry (a delta cycle), so
+ * the loop remembers the last event of the moved queue: the events up
+ * to and including it are of the region that the queue came from, and
+ * the events after it were added to the active queue as they ran. The
+ * counts of a time step are added to the totals, and written to the
+ * -E file, when the time step is retired.
+ */
+enum sched_region_t {
+      SR_ACTIVE = 0, SR_INACTIVE, SR_NBASSIGN, SR_RWSYNC, SR_ROSYNC,
+      SR_COUNT
+};
+
+static const char*sched_region_name[SR_COUNT] = {
+      "active", "inactive", "nbassign", "rwsync", "rosync"
+};
+
+  // The counts of the current time step.
+static unsigned long sched_step_events[SR_COUNT];
+static unsigned long sched_step_deltas = 0;
+  // The totals of the retired time steps.
+static uint64_t sched_total_events[SR_COUNT];
+static uint64_t sched_total_deltas = 0;
+static uint64_t sched_total_steps = 0;
+static unsigned long sched_max_deltas = 0;
+  // The thread wakes and assignments up to the last retired step.
+static unsigned long sched_last_threads = 0;
+static unsigned long sched_last_assigns = 0;
+
+  // Histograms of the events run in a time step and of the time steps
+  // still pending after it. Bucket 0 counts zeros, and bucket n the
+  // values from 2**(n-1) to 2**n-1.
+static const unsigned SCHED_HIST_SIZE = 65;
+static uint64_t sched_hist_events[SCHED_HIST_SIZE];
+static uint64_t sched_hist_pending[SCHED_HIST_SIZE];
+
+  // The event pools. They never shrink, so their sizes are the high
+  // water marks of the events of each kind.
+struct sched_pool_s {
+      const char*name;
+      unsigned long (*count)(void);
+};
+
+static const struct sched_pool_s sched_pools[] = {
+      { "time",        count_time_pool },
+      { "thread",      count_vthread_pool },
+      { "assign4",     count_assign4_pool },
+      { "assign8",     count_assign8_pool },
+      { "assign_real", count_assign_real_pool },
+      { "assign_word", count_assign_aword_pool },
+      { "assign_word_r", count_assign_arword_pool },
+      { "force4",      count_force4_pool },
+      { "gen",         count_gen_pool }
+};
+static const unsigned SCHED_POOLS = sizeof sched_pools / sizeof sched_pools[0];
+
+const char*sched_stats_path = 0;
+static FILE*sched_stats_fd = 0;
+static bool sched_stats_json = false;
+
+static unsigned sched_hist_bucket_(unsigned long val)
+{
+      unsigned res = 0;
+      while (val) {
+	    res += 1;
+	    val >>= 1;
+      }
+      return res;
+}
+
+/*
+ * Open the -E file, and write the header if it is a CSV file. A file
+ * with a .json suffix gets a JSON object per line instead. A snapshot
+ * run opens its own file, in the format of the file of the parent.
+ */
+void schedule_stats_open(void)
+{
+      if (sched_stats_fd) {
+	    fclose(sched_stats_fd);
+      } else {
+	    size_t len = strlen(sched_stats_path);
+	    sched_stats_json = len >= 5
+		  && strcmp(sched_stats_path+len-5, ".json") == 0;
+      }
+
+      sched_stats_fd = fopen(sched_stats_path, "w");
+      if (sched_stats_fd == 0) {
+	    perror(sched_stats_path);
+	    return;
+      }
+
+      if (sched_stats_json)
+	    return;
+
+      fprintf(sched_stats_fd, "time");
+      for (unsigned idx = 0 ; idx < SR_COUNT ; idx += 1)
+	    fprintf(sched_stats_fd, ",%s", sched_region_name[idx]);
+      fprintf(sched_stats_fd, ",deltas,threads,assigns,pending");
+      for (unsigned idx = 0 ; idx < SCHED_POOLS ; idx += 1)
+	    fprintf(sched_stats_fd, ",pool_%s", sched_pools[idx].name);
+      fprintf(sched_stats_fd, "\n");
+}
+
+static void sched_stats_write_(vvp_time64_t time, unsigned long threads,
+			       unsigned long assigns, unsigned long pending)
+{
+      FILE*fd = sched_stats_fd;
+      if (sched_stats_json) {
+	    fprintf(fd, "{\"time\":%" TIME_FMT_U, time);
+	    for (unsigned idx = 0 ; idx < SR_COUNT ; idx += 1)
+		  fprintf(fd, ",\"%s\":%lu", sched_region_name[idx],
+			  sched_step_events[idx]);
+	    fprintf(fd, ",\"deltas\":%lu,\"threads\":%lu,\"assigns\":%lu,"
+		    "\"pending\":%lu", sched_step_deltas, threads, assigns,
+		    pending);
+	    for (unsigned idx = 0 ; idx < SCHED_POOLS ; idx += 1)
+		  fprintf(fd, ",\"pool_%s\":%lu", sched_pools[idx].name,
+			  sched_pools[idx].count());
+	    fprintf(fd, "}\n");
+	    return;
+      }
+
+      fprintf(fd, "%" TIME_FMT_U, time);
+      for (unsigned idx = 0 ; idx < SR_COUNT ; idx += 1)
+	    fprintf(fd, ",%lu", sched_step_events[idx]);
+      fprintf(fd, ",%lu,%lu,%lu,%lu", sched_step_deltas, threads, assigns,
+	      pending);
+      for (unsigned idx = 0 ; idx < SCHED_POOLS ; idx += 1)
+	    fprintf(fd, ",%lu", sched_pools[idx].count());
+      fprintf(fd, "\n");
+}
+
+/*
+ * Account for the current time step, which is about to be retired.
+ */
+static void sched_stats_step_(const struct event_time_s*ctim)
+{
+      unsigned long events = 0;
+      for (unsigned idx = 0 ; idx < SR_COUNT ; idx += 1) {
+	    events += sched_step_events[idx];
+	    sched_total_events[idx] += sched_step_events[idx];
+      }
+
+      unsigned long wakes = count_thread_events + count_thread_wakes_merged;
+      unsigned long threads = wakes - sched_last_threads;
+      unsigned long assigns = count_assign_events - sched_last_assigns;
+      unsigned long pending = sched_wheel_count - 1;
+      sched_last_threads = wakes;
+      sched_last_assigns = count_assign_events;
+
+      sched_total_steps += 1;
+      sched_total_deltas += sched_step_deltas;
+      if (sched_step_deltas > sched_max_deltas)
+	    sched_max_deltas = sched_step_deltas;
+      sched_hist_events[sched_hist_bucket_(events)] += 1;
+      sched_hist_pending[sched_hist_bucket_(pending)] += 1;
+
+      if (sched_stats_fd)
+	    sched_stats_write_(ctim->time, threads, assigns, pending);
+
+      for (unsigned idx = 0 ; idx < SR_COUNT ; idx += 1)
+	    sched_step_events[idx] = 0;
+      sched_step_deltas = 0;
+}
+
+/*
+ * Account for the time step that the scheduler is in, if it stopped
+ * in the middle of one (for example $finish from the interactive
+ * prompt), and close the -E file.
+ */
+static void sched_stats_close_(void)
+{
+      struct event_time_s*ctim = sched_wheel_count? sched_current() : 0;
+      bool started = sched_step_deltas > 0;
+      for (unsigned idx = 0 ; idx < SR_COUNT ; idx += 1)
+	    if (sched_step_events[idx]) started = true;
+      if (ctim && started)
+	    sched_stats_step_(ctim);
+
+      if (sched_stats_fd)
+	    fclose(sched_stats_fd);
+      sched_stats_fd = 0;
+}
+
+static PLI_INT32 sched_stat_clip_(uint64_t val)
+{
+      return val > INT32_MAX? INT32_MAX : (PLI_INT32) val;
+}
+
+/*
+ * The _vpiSched* global properties. The totals include the counts of
+ * the current time step so far.
+ */
+bool schedule_stats_get(int property, PLI_INT32&val)
+{
+      unsigned region;
+      switch (property) {
+	  case _vpiSchedTimeSteps:
+	    val = sched_stat_clip_(sched_total_steps);
+	    return true;
+	  case _vpiSchedActive:
+	    region = SR_ACTIVE;
+	    break;
+	  case _vpiSchedInactive:
+	    region = SR_INACTIVE;
+	    break;
+	  case _vpiSchedNbassign:
+	    region = SR_NBASSIGN;
+	    break;
+	  case _vpiSchedRwsync:
+	    region = SR_RWSYNC;
+	    break;
+	  case _vpiSchedRosync:
+	    region = SR_ROSYNC;
+	    break;
+	  case _vpiSchedDeltas:
+	    val = sched_stat_clip_(sched_total_deltas + sched_step_deltas);
+	    return true;
+	  case _vpiSchedStepDeltas:
+	    val = sched_stat_clip_(sched_step_deltas);
+	    return true;
+	  case _vpiSchedMaxDeltas:
+	    val = sched_stat_clip_(max(sched_max_deltas, sched_step_deltas));
+	    return true;
+	  case _vpiSchedThreadWakes:
+	    val = sched_stat_clip_(count_thread_events
+				   + count_thread_wakes_merged);
+	    return true;
+	  case _vpiSchedPending:
+	    val = sched_stat_clip_(sched_wheel_count);
+	    return true;
+	  default:
+	    if (property >= _vpiSchedPoolTime
+		&& property < _vpiSchedPoolTime + (int)SCHED_POOLS) {
+		  val = sched_stat_clip_(sched_pools[property-_vpiSchedPoolTime].count());
+		  return true;
+	    }
+	    return false;
+      }
+
+      val = sched_stat_clip_(sched_total_events[region]
+			     + sched_step_events[region]);
+      return true;
+}
+
+static void sched_stats_hist_(const char*title, const uint64_t*hist)
+{
+      unsigned last = 0;
+      for (unsigned idx = 0 ; idx < SCHED_HIST_SIZE ; idx += 1)
+	    if (hist[idx]) last = idx;
+
+      vpi_mcd_printf(1, "    %s:\n", title);
+      for (unsigned idx = 0 ; idx <= last ; idx += 1) {
+	    unsigned long lo = idx? 1UL << (idx-1) : 0;
+	    unsigned long hi = idx? (lo << 1) - 1 : 0;
+	    vpi_mcd_printf(1, "      %10lu..%-10lu %10" TIME_FMT_U "\n",
+			   lo, hi, hist[idx]);
+      }
+}
+
+/*
+ * Print the scheduler statistics for the -v flag.
+ */
+void schedule_stats_report(void)
+{
+      vpi_mcd_printf(1, "Scheduler:\n");
+      for (unsigned idx = 0 ; idx < SR_COUNT ; idx += 1)
+	    vpi_mcd_printf(1, "    %8" TIME_FMT_U " %s events\n",
+			   sched_total_events[idx], sched_region_name[idx]);
+      vpi_mcd_printf(1, "    %8" TIME_FMT_U " delta cycles (at most %lu "
+		     "in a time step)\n", sched_total_deltas, sched_max_deltas);
+      if (sched_total_steps == 0)
+	    return;
+      sched_stats_hist_("events per time step", sched_hist_events);
+      sched_stats_hist_("time steps pending", sched_hist_pending);
+}
+
 /*
  * The scheduler uses this function to drain the rosync events of the
  * current time. The ctim object is still in the event queue, because
@@ -1094,7 +1934,8 @@ static void run_rosync(struct event_time_s*ctim)
 		  ctim->rosync->next = cur->next;
 	    }
 
-	    cur->run_run();
+	    sched_step_events[SR_ROSYNC] += 1;
+	    run_event_(cur);
 	    delete cur;
       }
       sim_at_rosync = false;
@@ -1156,17 +1997,32 @@ void schedule_simulate(void)
 
       sim_started = true;
 
+	// Resume from a checkpoint if asked to. This replaces the
+	// threads that were about to start at time 0.
+      if (checkpoint_restore_path && !checkpoint_restore()) {
+	    schedule_runnable = false;
+	    vpip_set_return_value(1);
+      }
+
       signals_capture();
 
       if (verbose_flag) {
 	    vpi_mcd_printf(1, " ...run scheduler\n");
       }
 
+      if (sched_stats_path)
+	    schedule_stats_open();
+
+	// The region of the events in the active queue, up to and
+	// including region_tail. (See the scheduler statistics.)
+      sched_region_t region = SR_ACTIVE;
+      struct event_s*region_tail = 0;
+
       // If there were no compiletf, etc. errors then we are going to
       // process events and when done run the final blocks.
       run_finals = schedule_runnable;
 
-      if (schedule_runnable) while (sched_list) {
+      if (schedule_runnable) while (sched_wheel_count > 0) {
 
 	    if (schedule_stopped_flag) {
 		  schedule_stopped_flag = false;
@@ -1177,21 +2033,24 @@ void schedule_simulate(void)
 	    }
 
 	      /* ctim is the current time step. */
-	    struct event_time_s* ctim = sched_list;
+	    struct event_time_s* ctim = sched_current();
 
 	      /* If the time is advancing, then first run the
 		 postponed sync events. Run them all. */
-	    if (ctim->delay > 0) {
+	    if (ctim == 0) {
 
 		  if (!schedule_runnable) break;
-		  schedule_time += ctim->delay;
+		  ctim = sched_advance();
+		  assert(ctim);
+		  schedule_time = ctim->time;
+		  region = SR_ACTIVE;
+		  region_tail = 0;
 		    /* When the design is being traced (we are emitting
 		     * file/line information) also print any time changes. */
 		  if (show_file_line) {
 			cerr << "Advancing to simulation time: "
 			     << schedule_time << endl;
 		  }
-		  ctim->delay = 0;
 
 		  vpiNextSimTime();
 		    // Process the cbAtStartOfSimTime callbacks.
@@ -1202,7 +2061,7 @@ void schedule_simulate(void)
 			} else {
 			      ctim->start->next = cur->next;
 			}
-			cur->run_run();
+			run_event_(cur);
 			delete (cur);
 		  }
 	    }
@@ -1214,26 +2073,33 @@ void schedule_simulate(void)
 	    if (ctim->active == 0) {
 		  ctim->active = ctim->inactive;
 		  ctim->inactive = 0;
+		  region = SR_INACTIVE;
 
 		  if (ctim->active == 0) {
 			ctim->active = ctim->nbassign;
 			ctim->nbassign = 0;
+			ctim->nba_batch = 0;
+			region = SR_NBASSIGN;
 
 			if (ctim->active == 0) {
 			      ctim->active = ctim->rwsync;
 			      ctim->rwsync = 0;
+			      region = SR_RWSYNC;
 
 				/* If out of rw events, then run the rosync
 				   events and delete this time step. This also
 				   deletes threads as needed. */
 			      if (ctim->active == 0) {
 				    run_rosync(ctim);
-				    sched_list = ctim->next;
-				    delete ctim;
+				    sched_stats_step_(ctim);
+				    sched_retire_current(ctim);
+				    region = SR_ACTIVE;
 				    continue;
 			      }
 			}
 		  }
+		  region_tail = ctim->active;
+		  sched_step_deltas += 1;
 	    }
 
 	      /* Pull the first item off the list. If this is the last
@@ -1246,17 +2112,25 @@ void schedule_simulate(void)
 		  ctim->active->next = cur->next;
 	    }
 
+	    sched_step_events[region] += 1;
+	    if (cur == region_tail) {
+		  region = SR_ACTIVE;
+		  region_tail = 0;
+	    }
+
 	    if (schedule_single_step_flag) {
 		  cur->single_step_display();
 		  schedule_stopped_flag = true;
 		  schedule_single_step_flag = false;
 	    }
 
-	    cur->run_run();
+	    run_event_(cur);
 
 	    delete (cur);
       }
 
+      sched_stats_close_();
+
 	// Execute final events.
       schedule_runnable = run_finals;
       while (schedule_runnable && schedule_final_list) {
@@ -1283,6 +2157,388 @@ void schedule_simulate(void)
 #endif
 }
 
+/*
+ * The checkpoint of the scheduler holds the events of the time steps
+ * after the current one. (The checkpoint is taken in the read-only
+ * sync region, so the current time step has nothing else left that
+ * is part of the design.) Each time step is written as its time and
+ * then its events, each preceded by the number of its queue, in the
+ * order that they would run.
+ *
+ * The events of functors that schedule themselves are written as the
+ * net of the functor. Other generic events are VPI callbacks, which
+ * are not saved, so they make the save fail.
+ */
+enum checkpoint_event_t {
+      CP_VTHREAD = 1, CP_ASSIGN4, CP_ASSIGN8, CP_ASSIGNR,
+      CP_PROPAGATE4, CP_PROPAGATER, CP_ARRAY_WORD, CP_ARRAY_R_WORD,
+      CP_FUNCTOR
+};
+
+static const unsigned CHECKPOINT_QUEUES = 7;
+
+static struct event_s*& checkpoint_queue_(struct event_time_s*ctim, unsigned idx)
+{
+      switch (idx) {
+	  case 0: return ctim->start;
+	  case 1: return ctim->active;
+	  case 2: return ctim->inactive;
+	  case 3: return ctim->nbassign;
+	  case 4: return ctim->rwsync;
+	  case 5: return ctim->rosync;
+	  default: return ctim->del_thr;
+      }
+}
+
+static void checkpoint_functor_event_(vvp_net_t*net, void*cd)
+{
+      map<vvp_gen_event_t,vvp_net_t*>*table = static_cast<map<vvp_gen_event_t,vvp_net_t*>*>(cd);
+      if (net->fun == 0)
+	    return;
+      if (vvp_gen_event_t obj = net->fun->checkpoint_event())
+	    (*table)[obj] = net;
+}
+
+static void checkpoint_put_event_(vvp_checkpoint_out&out, unsigned qdx,
+				  struct event_s*cur,
+				  const map<vvp_gen_event_t,vvp_net_t*>&functors)
+{
+	// A generic event without an object has been cancelled.
+      generic_event_s*gen = dynamic_cast<generic_event_s*>(cur);
+      if (gen && gen->obj == 0)
+	    return;
+
+	// A batch is saved as the assignments that it holds.
+      if (assign_batch_s*batch = dynamic_cast<assign_batch_s*>(cur)) {
+	    for (size_t idx = 0 ; idx < batch->list.size() ; idx += 1) {
+		  const assign_batch_s::entry_s&ent = batch->list[idx];
+		  out.put_uint(qdx+1);
+		  out.put_uint(CP_ASSIGN4);
+		  out.put_net(ent.ptr.ptr());
+		  out.put_uint(ent.ptr.port());
+		  out.put_vec4(ent.val);
+		  out.put_uint(ent.base);
+		  out.put_uint(ent.vwid);
+	    }
+	    return;
+      }
+
+      out.put_uint(qdx+1);
+
+      if (vthread_event_s*vev = dynamic_cast<vthread_event_s*>(cur)) {
+	    out.put_uint(CP_VTHREAD);
+	    vthread_checkpoint_put_list(out, vev->thr);
+
+      } else if (assign_vector4_event_s*a4 = dynamic_cast<assign_vector4_event_s*>(cur)) {
+	    out.put_uint(CP_ASSIGN4);
+	    out.put_net(a4->ptr.ptr());
+	    out.put_uint(a4->ptr.port());
+	    out.put_vec4(a4->val);
+	    out.put_uint(a4->base);
+	    out.put_uint(a4->vwid);
+
+      } else if (assign_vector8_event_s*a8 = dynamic_cast<assign_vector8_event_s*>(cur)) {
+	    out.put_uint(CP_ASSIGN8);
+	    out.put_net(a8->ptr.ptr());
+	    out.put_uint(a8->ptr.port());
+	    out.put_vec8(a8->val);
+
+      } else if (assign_real_event_s*ar = dynamic_cast<assign_real_event_s*>(cur)) {
+	    out.put_uint(CP_ASSIGNR);
+	    out.put_net(ar->ptr.ptr());
+	    out.put_uint(ar->ptr.port());
+	    out.put_real(ar->val);
+
+      } else if (propagate_vector4_event_s*p4 = dynamic_cast<propagate_vector4_event_s*>(cur)) {
+	    out.put_uint(CP_PROPAGATE4);
+	    out.put_net(p4->net);
+	    out.put_vec4(p4->val);
+
+      } else if (propagate_real_event_s*pr = dynamic_cast<propagate_real_event_s*>(cur)) {
+	    out.put_uint(CP_PROPAGATER);
+	    out.put_net(pr->net);
+	    out.put_real(pr->val);
+
+      } else if (assign_array_word_s*aw = dynamic_cast<assign_array_word_s*>(cur)) {
+	    out.put_uint(CP_ARRAY_WORD);
+	    out.put_array(aw->mem);
+	    out.put_uint(aw->adr);
+	    out.put_vec4(aw->val);
+	    out.put_uint(aw->off);
+
+      } else if (assign_array_r_word_s*arw = dynamic_cast<assign_array_r_word_s*>(cur)) {
+	    out.put_uint(CP_ARRAY_R_WORD);
+	    out.put_array(arw->mem);
+	    out.put_uint(arw->adr);
+	    out.put_real(arw->val);
+
+      } else if (gen) {
+	    map<vvp_gen_event_t,vvp_net_t*>::const_iterator cur_fun = functors.find(gen->obj);
+	    if (cur_fun == functors.end()) {
+		  out.refuse("a callback is scheduled for a later time");
+		  return;
+	    }
+	    out.put_uint(CP_FUNCTOR);
+	    out.put_net(cur_fun->second);
+
+      } else {
+	    out.refuse(string("cannot save a scheduled ") + typeid(*cur).name());
+      }
+}
+
+static bool checkpoint_cell_time_less_(const struct event_time_s*a,
+				       const struct event_time_s*b)
+{
+      return a->time < b->time;
+}
+
+void schedule_checkpoint_save(vvp_checkpoint_out&out)
+{
+      map<vvp_gen_event_t,vvp_net_t*> functors;
+      vvp_net_for_each(&checkpoint_functor_event_, &functors);
+
+      vector<struct event_time_s*> cells;
+      for (unsigned idx = 0 ; idx < sched_hash_size ; idx += 1) {
+	    for (struct event_time_s*cur = sched_hash[idx]
+		       ; cur ; cur = cur->hash_next) {
+		  if (cur->time != schedule_time)
+			cells.push_back(cur);
+	    }
+      }
+      sort(cells.begin(), cells.end(), &checkpoint_cell_time_less_);
+
+      for (size_t idx = 0 ; idx < cells.size() ; idx += 1) {
+	    struct event_time_s*ctim = cells[idx];
+	    out.put_uint(1);
+	    out.put_uint(ctim->time);
+	    for (unsigned qdx = 0 ; qdx < CHECKPOINT_QUEUES ; qdx += 1) {
+		  struct event_s*tail = checkpoint_queue_(ctim, qdx);
+		  if (tail == 0)
+			continue;
+		  struct event_s*cur = tail;
+		  do {
+			cur = cur->next;
+			checkpoint_put_event_(out, qdx, cur, functors);
+		  } while (cur != tail && !out.refused());
+	    }
+	    out.put_uint(0);
+      }
+      out.put_uint(0);
+}
+
+static void checkpoint_delete_queue_(struct event_s*&tail)
+{
+      while (tail) {
+	    struct event_s*cur = tail->next;
+	    if (cur == tail)
+		  tail = 0;
+	    else
+		  tail->next = cur->next;
+	    delete cur;
+      }
+}
+
+/*
+ * Sending the restored values through the netlist can make functors
+ * such as delays schedule events for later times. The real pending
+ * events are in the checkpoint, so drop all the later time steps
+ * before reading them.
+ */
+static void checkpoint_drop_later_(void)
+{
+      vector<struct event_time_s*> cells;
+      for (unsigned idx = 0 ; idx < sched_hash_size ; idx += 1) {
+	    for (struct event_time_s*cur = sched_hash[idx]
+		       ; cur ; cur = cur->hash_next)
+		  cells.push_back(cur);
+	    sched_hash[idx] = 0;
+      }
+      for (unsigned level = 0 ; level < WHEEL_LEVELS ; level += 1) {
+	    for (unsigned slot = 0 ; slot < WHEEL_SIZE ; slot += 1)
+		  sched_wheel[level].slot[slot] = 0;
+	    for (unsigned wdx = 0 ; wdx < WHEEL_MAP_WORDS ; wdx += 1)
+		  sched_wheel[level].map[wdx] = 0;
+      }
+      sched_wheel_count = 0;
+
+      for (size_t idx = 0 ; idx < cells.size() ; idx += 1) {
+	    struct event_time_s*ctim = cells[idx];
+	    if (ctim->time == schedule_time) {
+		  unsigned hdx = sched_hash_index(ctim->time);
+		  ctim->hash_next = sched_hash[hdx];
+		  sched_hash[hdx] = ctim;
+		  wheel_link(ctim);
+		  sched_wheel_count += 1;
+		  continue;
+	    }
+	    for (unsigned qdx = 0 ; qdx < CHECKPOINT_QUEUES ; qdx += 1)
+		  checkpoint_delete_queue_(checkpoint_queue_(ctim, qdx));
+	    delete ctim;
+      }
+}
+
+static struct event_s* checkpoint_get_event_(vvp_checkpoint_in&in)
+{
+      switch (in.get_uint()) {
+	  case CP_VTHREAD: {
+		vthread_t thr = vthread_checkpoint_get_list(in);
+		if (thr == 0)
+		      break;
+		struct vthread_event_s*cur = new vthread_event_s;
+		cur->thr = thr;
+		return cur;
+	  }
+	  case CP_ASSIGN4: {
+		vvp_net_t*net = in.get_net();
+		unsigned port = in.get_uint() & 3;
+		struct assign_vector4_event_s*cur
+		      = new struct assign_vector4_event_s(in.get_vec4());
+		cur->ptr = vvp_net_ptr_t(net, port);
+		cur->base = in.get_uint();
+		cur->vwid = in.get_uint();
+		return cur;
+	  }
+	  case CP_ASSIGN8: {
+		vvp_net_t*net = in.get_net();
+		unsigned port = in.get_uint() & 3;
+		struct assign_vector8_event_s*cur = new struct assign_vector8_event_s;
+		cur->ptr = vvp_net_ptr_t(net, port);
+		cur->val = in.get_vec8();
+		return cur;
+	  }
+	  case CP_ASSIGNR: {
+		vvp_net_t*net = in.get_net();
+		unsigned port = in.get_uint() & 3;
+		struct assign_real_event_s*cur = new struct assign_real_event_s;
+		cur->ptr = vvp_net_ptr_t(net, port);
+		cur->val = in.get_real();
+		return cur;
+	  }
+	  case CP_PROPAGATE4: {
+		vvp_net_t*net = in.get_net();
+		struct propagate_vector4_event_s*cur
+		      = new struct propagate_vector4_event_s(in.get_vec4());
+		cur->net = net;
+		return cur;
+	  }
+	  case CP_PROPAGATER: {
+		struct propagate_real_event_s*cur = new struct propagate_real_event_s;
+		cur->net = in.get_net();
+		cur->val = in.get_real();
+		return cur;
+	  }
+	  case CP_ARRAY_WORD: {
+		struct assign_array_word_s*cur = new struct assign_array_word_s;
+		cur->mem = in.get_array();
+		cur->adr = in.get_uint();
+		cur->val = in.get_vec4();
+		cur->off = in.get_uint();
+		return cur;
+	  }
+	  case CP_ARRAY_R_WORD: {
+		struct assign_array_r_word_s*cur = new struct assign_array_r_word_s;
+		cur->mem = in.get_array();
+		cur->adr = in.get_uint();
+		cur->val = in.get_real();
+		return cur;
+	  }
+	  case CP_FUNCTOR: {
+		vvp_net_t*net = in.get_net();
+		vvp_gen_event_t obj = net && net->fun? net->fun->checkpoint_event() : 0;
+		if (obj == 0)
+		      break;
+		struct generic_event_s*cur = new generic_event_s;
+		cur->obj = obj;
+		cur->delete_obj_when_done = false;
+		return cur;
+	  }
+	  default:
+	    break;
+      }
+
+      in.error("bad event");
+      return 0;
+}
+
+void schedule_checkpoint_restore(vvp_checkpoint_in&in)
+{
+      sched_wake_event = 0;
+      checkpoint_drop_later_();
+
+      while (in.get_uint() == 1 && !in.bad()) {
+	    vvp_time64_t time = in.get_uint();
+	    if (time <= schedule_time) {
+		  in.error("event time is not in the future");
+		  return;
+	    }
+
+	    for (;;) {
+		  uint64_t qdx = in.get_uint();
+		  if (qdx == 0 || in.bad())
+			break;
+		  if (qdx > CHECKPOINT_QUEUES || qdx-1 == SEQ_INACTIVE) {
+			in.error("bad event queue");
+			return;
+		  }
+		  struct event_s*cur = checkpoint_get_event_(in);
+		  if (cur == 0 || in.bad()) {
+			delete cur;
+			return;
+		  }
+		  schedule_event_at_(cur, time, (event_queue_t)(qdx-1));
+	    }
+      }
+}
+
+bool schedule_checkpoint_start(vvp_time64_t time)
+{
+      sched_wake_event = 0;
+      struct event_time_s*ctim = sched_current();
+      unsigned long others = sched_wheel_count - (ctim? 1 : 0);
+      if (others > 0)
+	    return false;
+
+      struct event_s*queue[CHECKPOINT_QUEUES];
+      for (unsigned qdx = 0 ; qdx < CHECKPOINT_QUEUES ; qdx += 1) {
+	    queue[qdx] = 0;
+	    if (ctim) {
+		  queue[qdx] = checkpoint_queue_(ctim, qdx);
+		  checkpoint_queue_(ctim, qdx) = 0;
+	    }
+      }
+      if (ctim)
+	    sched_retire_current(ctim);
+
+	// The inactive queue holds the time 0 triggers, which are not
+	// needed since the threads are already waiting.
+      checkpoint_delete_queue_(queue[2]);
+
+      schedule_time = time;
+      sched_wheel_now = time;
+
+	// Move the rest of the events to the checkpoint time, except
+	// the threads about to start, which are replaced by the saved
+	// threads.
+      for (unsigned qdx = 0 ; qdx < CHECKPOINT_QUEUES ; qdx += 1) {
+	    while (struct event_s*tail = queue[qdx]) {
+		  struct event_s*cur = tail->next;
+		  if (cur == tail)
+			queue[qdx] = 0;
+		  else
+			tail->next = cur->next;
+
+		  if (vthread_event_s*ev = dynamic_cast<vthread_event_s*>(cur)) {
+			vthread_checkpoint_drop_list(ev->thr);
+			delete cur;
+			continue;
+		  }
+		  schedule_event_at_(cur, time, (event_queue_t)qdx);
+	    }
+      }
+
+      return true;
+}
+
 #ifdef CHECK_WITH_VALGRIND
 void schedule_delete(void)
 {
@@ -1294,5 +2550,8 @@ void schedule_delete(void)
       array_r_w_heap.delete_pool();
       generic_event_heap.delete_pool();
       event_time_heap.delete_pool();
+      delete[]sched_hash;
+      sched_hash = 0;
+      sched_hash_size = 0;
 }
 #endif
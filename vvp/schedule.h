@@ -35,6 +35,14 @@
 extern void schedule_vthread(vthread_t thr, vvp_time64_t delay,
 			     bool push_flag =false);
 
+/*
+ * This schedules the list of threads that an event woke up, to run
+ * with delay 0. It is the same as schedule_vthread, except that the
+ * lists of events that wake up one after the other, such as the
+ * processes of many always @(posedge clk) blocks, share an event.
+ */
+extern void schedule_vthread_wake(vthread_t thr);
+
 extern void schedule_inactive(vthread_t thr);
 
 extern void schedule_init_vthread(vthread_t thr);
@@ -153,6 +161,18 @@ extern void schedule_generic(vvp_gen_event_t obj, vvp_time64_t delay,
 */
 extern void schedule_functor(vvp_gen_event_t obj);
 
+/*
+ * Queue a functor to be run in the next levelized sweep of the
+ * combinational logic. The level is at least 1, and a functor must
+ * have a higher level than any levelized functor that drives it. The
+ * sweep is itself a functor event, and runs all the queued functors
+ * in level order, including any that are queued by the sweep itself.
+ * With the -j flag, the functors of a large level are evaluated on
+ * several threads before their results are sent in order.
+ */
+class vvp_fun_levelized_;
+extern void schedule_levelized(vvp_fun_levelized_*obj, unsigned level);
+
 extern void schedule_at_start_of_simtime(vvp_gen_event_t obj, vvp_time64_t delay);
 extern void schedule_at_end_of_simtime(vvp_gen_event_t obj, vvp_time64_t delay);
 
@@ -214,6 +234,19 @@ extern unsigned long count_assign_events;
 extern unsigned long count_gen_events;
 extern unsigned long count_prop_events;
 extern unsigned long count_thread_events;
+extern unsigned long count_thread_wakes_merged;
 extern unsigned long count_event_pool;
 
+/*
+ * Scheduler statistics. The -E flag names the file that gets a row
+ * of counts for each time step (the regions of the events run, the
+ * delta cycles, the thread wakes and assignments, the time steps
+ * pending and the event pool sizes), and VPI code reads the totals
+ * with vpi_get() of the _vpiSched* properties and a null handle.
+ */
+extern const char*sched_stats_path;
+extern void schedule_stats_open(void);
+extern bool schedule_stats_get(int property, PLI_INT32&val);
+extern void schedule_stats_report(void);
+
 #endif /* IVL_schedule_H */
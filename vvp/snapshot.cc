@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "snapshot.h"
+# include  "schedule.h"
+# include  "profile.h"
+# include  "vpi_priv.h"
+# include  <cstdio>
+# include  <cstdlib>
+# include  <cstring>
+# include  <string>
+# include  <vector>
+#if !defined(__MINGW32__) && !defined(_MSC_VER)
+# include  <sys/types.h>
+# include  <sys/wait.h>
+# include  <unistd.h>
+#endif
+
+using namespace std;
+
+const char*snapshot_fanout_path = 0;
+
+/*
+ * Read the fan-out file. Each line that is not empty lists the extended
+ * arguments of one run, separated by white space. A '#' starts a
+ * comment that runs to the end of the line.
+ */
+static bool snapshot_read_(vector<vector<string> >&runs)
+{
+      FILE*fd = fopen(snapshot_fanout_path, "r");
+      if (fd == 0)
+	    return false;
+
+      string line;
+      int ch;
+      do {
+	    ch = fgetc(fd);
+	    if (ch != '\n' && ch != EOF) {
+		  line += (char)ch;
+		  continue;
+	    }
+
+	    size_t hash = line.find('#');
+	    if (hash != string::npos)
+		  line.erase(hash);
+
+	    vector<string> args;
+	    size_t pos = line.find_first_not_of(" \t\r");
+	    while (pos != string::npos) {
+		  size_t end = line.find_first_of(" \t\r", pos);
+		  args.push_back(line.substr(pos, end == string::npos? end : end-pos));
+		  pos = line.find_first_not_of(" \t\r", end);
+	    }
+	    if (! args.empty())
+		  runs.push_back(args);
+	    line.clear();
+      } while (ch != EOF);
+
+      bool rc = ferror(fd) == 0;
+      fclose(fd);
+      return rc;
+}
+
+#if !defined(__MINGW32__) && !defined(_MSC_VER)
+
+/*
+ * In the child, send the output to the log of the run and add the
+ * arguments of the run to the extended arguments, then return to
+ * carry on with the simulation.
+ */
+static void snapshot_child_(unsigned num, const vector<string>&args)
+{
+      string log = snapshot_fanout_path;
+      char buf[64];
+      snprintf(buf, sizeof buf, ".%u.log", num);
+      log += buf;
+
+	// A child does not fan out again, and writes its own profile
+	// and scheduler statistics.
+      snapshot_fanout_path = 0;
+      snprintf(buf, sizeof buf, ".%u", num);
+      if (profile_path)
+	    profile_path = strdup((string(profile_path) + buf).c_str());
+      if (sched_stats_path) {
+	    sched_stats_path = strdup((string(sched_stats_path) + buf).c_str());
+	    schedule_stats_open();
+      }
+
+      if (freopen(log.c_str(), "w", stdout) == 0) {
+	    perror(log.c_str());
+	    _exit(1);
+      }
+      if (! vpip_mcd_snapshot_child(buf))
+	    _exit(1);
+
+      s_vpi_vlog_info info;
+      vpi_get_vlog_info(&info);
+
+      int argc = info.argc + 1 + args.size();
+      char**argv = new char*[argc + 1];
+      for (int idx = 0 ; idx < info.argc ; idx += 1)
+	    argv[idx] = info.argv[idx];
+
+      snprintf(buf, sizeof buf, "+ivl_snapshot_child=%u", num);
+      argv[info.argc] = strdup(buf);
+      for (size_t idx = 0 ; idx < args.size() ; idx += 1)
+	    argv[info.argc + 1 + idx] = strdup(args[idx].c_str());
+      argv[argc] = 0;
+
+      vpip_set_vlog_args(argc, argv);
+}
+
+/*
+ * The parent runs as many children at a time as there are processors,
+ * then reports and exits without going on with the simulation.
+ */
+static void snapshot_fanout_(const vector<vector<string> >&runs)
+{
+      long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+      if (jobs < 1)
+	    jobs = 1;
+
+	// The children inherit the stdio buffers, so empty them first.
+      fflush(0);
+
+      vector<pid_t> pids (runs.size());
+      size_t next = 0;
+      long running = 0;
+      unsigned failed = 0;
+
+      while (next < runs.size() || running > 0) {
+	    if (next < runs.size() && running < jobs) {
+		  pid_t pid = fork();
+		  if (pid == 0) {
+			snapshot_child_(next+1, runs[next]);
+			return;
+		  }
+		  if (pid < 0) {
+			perror("fork");
+			failed += runs.size() - next;
+			next = runs.size();
+			continue;
+		  }
+		  pids[next++] = pid;
+		  running += 1;
+		  continue;
+	    }
+
+	    int status;
+	    pid_t pid = wait(&status);
+	    if (pid < 0)
+		  break;
+
+	    for (size_t idx = 0 ; idx < next ; idx += 1) {
+		  if (pids[idx] != pid)
+			continue;
+		  running -= 1;
+		  if (! WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			vpi_mcd_printf(1, "Snapshot run %zu failed.\n", idx+1);
+			failed += 1;
+		  }
+		  break;
+	    }
+      }
+
+      vpi_mcd_printf(1, "Snapshot: %zu runs, %u failed.\n", runs.size(), failed);
+      fflush(0);
+      _exit(failed? 1 : 0);
+}
+
+#else
+
+static void snapshot_fanout_(const vector<vector<string> >&)
+{
+      fprintf(stderr, "Error: $ivl_snapshot is not supported on this platform.\n");
+}
+
+#endif
+
+/*
+ * The fan-out happens in the read-only sync region of the time step
+ * of the $ivl_snapshot call, like $save, so that every child starts at
+ * the end of a complete time step.
+ */
+struct snapshot_event_s : public vvp_gen_event_s {
+      explicit snapshot_event_s(const char*why);
+      void run_run();
+
+      string why_;
+};
+
+snapshot_event_s::snapshot_event_s(const char*why)
+{
+      if (why)
+	    why_ = why;
+}
+
+void snapshot_event_s::run_run()
+{
+      if (snapshot_fanout_path == 0)
+	    return;
+
+	// The children cannot share the open files of the simulation,
+	// nor the writer of a waveform dump. Refuse the fan-out, and
+	// carry on with this run alone.
+      if (why_.empty()) {
+	    if (const char*name = vpip_mcd_snapshot_open_file())
+		  why_ = string("file ") + name + " is open";
+      }
+      if (! why_.empty()) {
+	    fprintf(stderr, "Error: cannot fan out at $ivl_snapshot: %s.\n",
+		    why_.c_str());
+	    return;
+      }
+
+      vector<vector<string> > runs;
+      if (! snapshot_read_(runs)) {
+	    fprintf(stderr, "Error: cannot read snapshot fan-out file %s.\n",
+		    snapshot_fanout_path);
+	    return;
+      }
+      if (runs.empty()) {
+	    fprintf(stderr, "Warning: snapshot fan-out file %s has no runs.\n",
+		    snapshot_fanout_path);
+	    return;
+      }
+
+      snapshot_fanout_(runs);
+}
+
+void snapshot_schedule(const char*why)
+{
+      schedule_generic(new snapshot_event_s(why), 0, true, true, true);
+}
@@ -0,0 +1,57 @@
+#ifndef IVL_snapshot_H
+#define IVL_snapshot_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * A snapshot fans a simulation out into many runs that share the same
+ * start. The fan-out file (the -F flag) has a line of extended
+ * arguments for each run. When the simulation calls $ivl_snapshot,
+ * vvp forks a child process for each line at the end of that time
+ * step. The child adds the arguments of its line, and a
+ * +ivl_snapshot_child=<n> argument that numbers it from 1, to the
+ * extended arguments and carries on with its output going to the file
+ * <fan-out file>.<n>.log. The parent waits for the children and exits,
+ * with status 1 if any of them failed. The children share the pages
+ * of the loaded design with the parent until they write them.
+ *
+ * The children would also share the files that are open at the
+ * snapshot, so the fan-out is refused if the simulation opened a file
+ * or started a waveform dump by then. The -l log file is opened again
+ * for each child, with .<n> added to its name.
+ */
+
+extern const char*snapshot_fanout_path;
+
+/*
+ * Arrange for the fan-out at the end of the current time step. This
+ * implements $ivl_snapshot. If the caller knows why the simulation
+ * cannot fan out, it passes the reason, and the fan-out is refused.
+ */
+extern void snapshot_schedule(const char*why);
+
+/*
+ * These are in vpi_mcd.cc. The first returns the name of a file that
+ * the simulation opened, or nil if there is none, and the second
+ * opens the -l log file again with the suffix added to its name.
+ */
+extern const char* vpip_mcd_snapshot_open_file(void);
+extern bool vpip_mcd_snapshot_child(const char*suffix);
+
+#endif /* IVL_snapshot_H */
@@ -27,6 +27,7 @@
 #endif
 
 extern unsigned long count_opcodes;
+extern unsigned long count_opcodes_fused;
 extern unsigned long count_functors;
 extern unsigned long count_functors_logic;
 extern unsigned long count_functors_bufif;
@@ -37,10 +38,23 @@ extern unsigned long count_vvp_nets;
 extern unsigned long count_vpi_nets;
 extern unsigned long count_vpi_scopes;
 
+  /* These are set by compute_net_partitions(), which is only run
+     when the statistics are going to be printed. */
+extern unsigned long count_net_partitions;
+extern unsigned long count_net_partition_max;
+extern unsigned long count_net_partition_singles;
+extern void compute_net_partitions(void);
+
+  /* These are set by levelize_netlist(), if it is enabled. */
+extern unsigned long count_levelized_functors;
+extern unsigned long count_levelized_loops;
+extern unsigned long count_logic_levels;
+
 extern unsigned long count_net_arrays;
 extern unsigned long count_net_array_words;
 extern unsigned long count_var_arrays;
 extern unsigned long count_var_array_words;
+extern unsigned long count_var_sparse_arrays;
 extern unsigned long count_real_arrays;
 extern unsigned long count_real_array_words;
 
@@ -50,14 +64,28 @@ extern unsigned long count_time_pool(void);
 
 extern unsigned long count_assign_events;
 extern unsigned long count_assign4_pool(void);
+extern unsigned long count_assign_merged;
 extern unsigned long count_assign8_pool(void);
 extern unsigned long count_assign_real_pool(void);
 extern unsigned long count_assign_aword_pool(void);
 extern unsigned long count_assign_arword_pool(void);
+extern unsigned long count_force4_pool(void);
 
 extern unsigned long count_gen_events;
 extern unsigned long count_gen_pool(void);
 
+extern unsigned long count_fanout_nets;
+extern unsigned long count_fanout_receivers;
+
+extern unsigned long count_level_sweeps;
+extern unsigned long count_level_runs;
+extern unsigned long count_level_parallel;
+
+extern unsigned long count_unchanged_sends;
+
+extern unsigned long count_vthreads;
+extern unsigned long count_vthread_pool(void);
+
 extern size_t size_opcodes;
 extern size_t size_vvp_nets;
 extern size_t size_vvp_net_funs;
@@ -63,19 +63,22 @@ class symbol_table_s {
       void sym_set_value(const char*key, symbol_value_t val);
 
 	// This method locates the value in the symbol table and returns
-	// it. If the value does not exist, create it, initialize it with
-	// zero and return the zero value.
-      symbol_value_t sym_get_value(const char*key);
+	// it. If the value does not exist, return a zero value.
+      symbol_value_t sym_get_value(const char*key) const;
+
+	// The number of keys in the table.
+      unsigned sym_count() const { return count_; }
 
     private:
       symbol_table_s(const symbol_table_s&) { assert(0); };
-      struct tree_node_*root;
+      struct table_entry_*table_;
+      unsigned mask_;
+      unsigned count_;
       struct key_strings*str_chunk;
       unsigned str_used;
 
-      symbol_value_t find_value_(struct tree_node_*cur,
-				 const char*key, symbol_value_t val,
-				 bool force_flag);
+      struct table_entry_*find_entry_(const char*key, unsigned hash) const;
+      void grow_table_();
       char*key_strdup_(const char*str);
 };
 
@@ -93,7 +96,7 @@ inline void delete_symbol_table(symbol_table_t tbl) { delete tbl; }
 inline void sym_set_value(symbol_table_t tbl, const char*key, symbol_value_t val)
 { tbl->sym_set_value(key, val); }
 
-inline symbol_value_t sym_get_value(symbol_table_t tbl, const char*key)
+inline symbol_value_t sym_get_value(const symbol_table_s*tbl, const char*key)
 { return tbl->sym_get_value(key); }
 
 /*
@@ -108,7 +111,7 @@ template <class T> class symbol_map_s : private symbol_table_s {
 	symbol_table_s::sym_set_value(key, tmp);
       }
 
-      T* sym_get_value(const char*key)
+      T* sym_get_value(const char*key) const
       { symbol_value_t val = symbol_table_s::sym_get_value(key);
 	return reinterpret_cast<T*>(val.ptr);
       }
@@ -22,6 +22,7 @@
 
 #include "udp.h"
 #include "schedule.h"
+#include "checkpoint.h"
 #include "symbols.h"
 #include "compile.h"
 #include "config.h"
@@ -969,6 +970,27 @@ void vvp_udp_fun_core::recv_vec4_from_inputs(unsigned port)
       schedule_functor(this);
 }
 
+/*
+ * A restored UDP sends its output again through run_run, the same way
+ * that it sends its initial value.
+ */
+bool vvp_udp_fun_core::save_state(vvp_checkpoint_out&out) const
+{
+      out.put_uint(cur_out_);
+      out.put_uint(current_.mask0);
+      out.put_uint(current_.mask1);
+      out.put_uint(current_.maskx);
+      return true;
+}
+
+void vvp_udp_fun_core::restore_state(vvp_net_t*, vvp_checkpoint_in&in)
+{
+      cur_out_ = (vvp_bit4_t) (in.get_uint() & 3);
+      current_.mask0 = in.get_uint();
+      current_.mask1 = in.get_uint();
+      current_.maskx = in.get_uint();
+      schedule_generic(this, 0, false);
+}
 
 /*
  * This function is called by the parser in response to a .udp
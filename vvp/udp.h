@@ -230,6 +230,9 @@ class vvp_udp_fun_core  : public vvp_wide_fun_core, private vvp_gen_event_s {
 
       void recv_vec4_from_inputs(unsigned);
 
+      bool save_state(vvp_checkpoint_out&out) const;
+      void restore_state(vvp_net_t*net, vvp_checkpoint_in&in);
+
     private:
       void run_run();
 
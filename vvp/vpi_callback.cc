@@ -630,6 +630,10 @@ vpiHandle vpi_register_cb(p_cb_data data)
 	    obj = make_value_change(data);
 	    break;
 
+	  case __ivl_cbDumpChange:
+	    obj = vpip_dump_change(data);
+	    break;
+
 	  case cbReadOnlySynch:
 	    obj = make_sync(data, true);
 	    break;
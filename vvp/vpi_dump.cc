@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * This is the native dump engine behind the __ivl_cbDumpChange
+ * callbacks. The waveform writers ($dumpvars and friends) only need
+ * the final value of each changed signal at the end of a time step,
+ * but a cbValueChange calls into the writer on every change, and the
+ * writer then formats the value through vpi_get_value.
+ *
+ * A dump_callback sits in the vpi_callbacks list of the signal filter
+ * like any value callback. When the filter reports a change, it only
+ * puts itself on the pending list of its dump_sink (once per time
+ * step). The sink is a read-only synch event that, at the end of the
+ * time step, copies the abits/bbits of the pending signals into its
+ * record buffer and calls the writer once for the whole step.
+ *
+ * There is one sink for each writer routine (cb_rtn), and the buffer
+ * of a sink is reused from one time step to the next.
+ */
+
+# include  "vpi_user.h"
+# include  "vpi_priv.h"
+# include  "vvp_net.h"
+# include  "vvp_net_sig.h"
+# include  "schedule.h"
+# include  "config.h"
+# include  <vector>
+# include  <algorithm>
+# include  <cassert>
+
+using namespace std;
+
+class dump_callback;
+
+class dump_sink : public vvp_gen_event_s {
+
+    public:
+      explicit dump_sink(PLI_INT32 (*rtn)(struct t_cb_data*));
+
+      void add(dump_callback*cb);
+      void cancel(dump_callback*cb);
+
+      void run_run();
+
+    public:
+      PLI_INT32 (*cb_rtn)(struct t_cb_data*);
+      dump_sink*next;
+
+    private:
+      struct t_cb_data cb_data_;
+      struct t_vpi_time cb_time_;
+      struct t_vpi_value cb_value_;
+      s_ivl_dump_buf buf_;
+
+      vector<dump_callback*> pending_;
+      vector<s_ivl_dump_rec> recs_;
+      vector<size_t> offs_;
+      vector<s_vpi_vecval> words_;
+      vector<unsigned long> abits_, bbits_;
+      vvp_vector4_t tmp_;
+};
+
+class dump_callback : public value_callback {
+
+    public:
+      dump_callback(p_cb_data data, dump_sink*sink, vvp_signal_value*sig,
+		    PLI_INT32 format);
+      ~dump_callback();
+
+	// Record the change in the sink instead of calling cb_rtn.
+      bool test_value_callback_ready(void);
+
+    public:
+      dump_sink*sink;
+      vvp_signal_value*sig;
+	// vpiVectorVal or vpiRealVal
+      PLI_INT32 format;
+      bool pending;
+};
+
+static dump_sink*dump_sinks = 0;
+
+dump_sink::dump_sink(PLI_INT32 (*rtn)(struct t_cb_data*))
+: cb_rtn(rtn), next(0)
+{
+      cb_time_.type = vpiSimTime;
+      cb_value_.format = vpiSuppressVal;
+      cb_value_.value.misc = (PLI_BYTE8*)&buf_;
+      buf_.count = 0;
+      buf_.recs = 0;
+
+      cb_data_.reason = __ivl_cbDumpChange;
+      cb_data_.cb_rtn = rtn;
+      cb_data_.obj = 0;
+      cb_data_.time = &cb_time_;
+      cb_data_.value = &cb_value_;
+      cb_data_.index = 0;
+      cb_data_.user_data = 0;
+}
+
+void dump_sink::add(dump_callback*cb)
+{
+      if (pending_.empty())
+	    schedule_generic(this, 0, true, true);
+      pending_.push_back(cb);
+}
+
+void dump_sink::cancel(dump_callback*cb)
+{
+      vector<dump_callback*>::iterator cur
+	    = find(pending_.begin(), pending_.end(), cb);
+      if (cur != pending_.end())
+	    *cur = 0;
+}
+
+void dump_sink::run_run()
+{
+      recs_.clear();
+      offs_.clear();
+      words_.clear();
+
+      for (size_t idx = 0 ;  idx < pending_.size() ;  idx += 1) {
+	    dump_callback*cb = pending_[idx];
+	    if (cb == 0)
+		  continue;
+	    cb->pending = false;
+	    if (cb->cb_data.cb_rtn == 0)
+		  continue;
+
+	    s_ivl_dump_rec rec;
+	    rec.user_data = cb->cb_data.user_data;
+	    rec.format = cb->format;
+	    rec.size = 0;
+
+	    if (rec.format == vpiRealVal) {
+		  rec.value.real = cb->sig->real_value();
+		  recs_.push_back(rec);
+		  offs_.push_back(0);
+		  continue;
+	    }
+
+	      // Copy the raw bits of the value into vecval words. The
+	      // records get their word pointers once the buffer is
+	      // complete, since words_ may be reallocated as it grows.
+	    cb->sig->vec4_value(tmp_);
+	    const unsigned BITS = 8*sizeof(unsigned long);
+	    unsigned wid = tmp_.size();
+	    unsigned cnt = (wid + BITS - 1) / BITS;
+	    if (abits_.size() < cnt) {
+		  abits_.resize(cnt);
+		  bbits_.resize(cnt);
+	    }
+	    tmp_.get_words(&abits_[0], &bbits_[0]);
+
+	    rec.size = wid;
+	    rec.value.vector = 0;
+	    offs_.push_back(words_.size());
+	    for (unsigned bit = 0 ;  bit < wid ;  bit += 32) {
+		  s_vpi_vecval word;
+		  word.aval = (PLI_INT32)(abits_[bit/BITS] >> bit%BITS);
+		  word.bval = (PLI_INT32)(bbits_[bit/BITS] >> bit%BITS);
+		  words_.push_back(word);
+	    }
+	    recs_.push_back(rec);
+      }
+      pending_.clear();
+
+      if (recs_.empty())
+	    return;
+
+      for (size_t idx = 0 ;  idx < recs_.size() ;  idx += 1) {
+	    if (recs_[idx].format == vpiVectorVal)
+		  recs_[idx].value.vector = &words_[offs_[idx]];
+      }
+
+      buf_.count = recs_.size();
+      buf_.recs = &recs_[0];
+      vpip_time_to_timestruct(&cb_time_, schedule_simtime());
+
+      assert(vpi_mode_flag == VPI_MODE_NONE);
+      vpi_mode_flag = VPI_MODE_ROSYNC;
+      (cb_rtn)(&cb_data_);
+      vpi_mode_flag = VPI_MODE_NONE;
+
+      buf_.count = 0;
+      buf_.recs = 0;
+}
+
+dump_callback::dump_callback(p_cb_data data, dump_sink*snk,
+			     vvp_signal_value*val, PLI_INT32 fmt)
+: value_callback(data), sink(snk), sig(val), format(fmt), pending(false)
+{
+}
+
+dump_callback::~dump_callback()
+{
+      if (pending)
+	    sink->cancel(this);
+}
+
+bool dump_callback::test_value_callback_ready(void)
+{
+      if (! pending) {
+	    pending = true;
+	    sink->add(this);
+      }
+      return false;
+}
+
+/*
+ * Make the __ivl_cbDumpChange callback for the object. This handles
+ * the plain variables and nets, whose value lives in the filter of
+ * their net. Everything else (array words, part selects, events,
+ * automatic variables) returns nil, and the caller falls back to a
+ * cbValueChange.
+ */
+value_callback* vpip_dump_change(p_cb_data data)
+{
+      assert(data->obj);
+      if (data->cb_rtn == 0 || vpi_get(vpiAutomatic, data->obj))
+	    return 0;
+
+      vvp_net_t*net = 0;
+      PLI_INT32 format = vpiVectorVal;
+      switch (data->obj->get_type_code()) {
+
+	  case vpiReg:
+	  case vpiNet:
+	  case vpiIntegerVar:
+	  case vpiBitVar:
+	  case vpiByteVar:
+	  case vpiShortIntVar:
+	  case vpiIntVar:
+	  case vpiLongIntVar: {
+		__vpiSignal*sig = dynamic_cast<__vpiSignal*>(data->obj);
+		if (sig == 0)
+		      return 0;
+		net = sig->node;
+		break;
+	  }
+
+	  case vpiRealVar: {
+		__vpiRealVar*rfp = dynamic_cast<__vpiRealVar*>(data->obj);
+		if (rfp == 0 || rfp->is_netarray)
+		      return 0;
+		net = rfp->net;
+		format = vpiRealVal;
+		break;
+	  }
+
+	  default:
+	    return 0;
+      }
+
+      if (net == 0)
+	    return 0;
+
+      vvp_net_fil_t*fil = net->fil;
+      vvp_signal_value*val = dynamic_cast<vvp_signal_value*>(fil);
+      if (fil == 0 || val == 0)
+	    return 0;
+
+      dump_sink*sink = dump_sinks;
+      while (sink && sink->cb_rtn != data->cb_rtn)
+	    sink = sink->next;
+      if (sink == 0) {
+	    sink = new dump_sink(data->cb_rtn);
+	    sink->next = dump_sinks;
+	    dump_sinks = sink;
+      }
+
+      dump_callback*obj = new dump_callback(data, sink, val, format);
+      fil->add_vpi_callback(obj);
+      return obj;
+}
@@ -18,6 +18,8 @@
  */
 
 # include  "vpi_priv.h"
+# include  "checkpoint.h"
+# include  "snapshot.h"
 # include  "config.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
@@ -27,8 +29,15 @@
 # include  <cstdio>
 # include  <cstdlib>
 # include  <cstring>
+#ifdef _MSC_VER
+# include  <io.h>
+#else
+# include  <unistd.h>
+#endif
 # include  "ivl_alloc.h"
 
+using namespace std;
+
 extern FILE* vpi_trace;
 
 /*
@@ -48,17 +57,21 @@ extern FILE* vpi_trace;
 typedef struct mcd_entry {
 	FILE *fp;
 	char *filename;
+	  // The mode the file was opened with, for checkpoints.
+	char mode[8];
 } mcd_entry_s;
 static mcd_entry_s mcd_table[31];
 static mcd_entry_s *fd_table = NULL;
 static unsigned fd_table_len = 0;
 
 static FILE* logfile;
+  // The name of the log file, or nil if it is stderr.
+static const char* logfile_name;
 
 /* Initialize mcd portion of vpi.  Must be called before
  * any vpi_mcd routines can be used.
  */
-void vpip_mcd_init(FILE *log)
+void vpip_mcd_init(FILE *log, const char*log_name)
 {
       fd_table_len = FD_INCR;
       fd_table = (mcd_entry_s *) malloc(fd_table_len*sizeof(mcd_entry_s));
@@ -78,6 +91,7 @@ void vpip_mcd_init(FILE *log)
       fd_table[2].filename = strdup("stderr");
 
       logfile = log;
+      logfile_name = log_name;
 }
 
 #ifdef CHECK_WITH_VALGRIND
@@ -175,6 +189,7 @@ got_entry:
 	if(mcd_table[i].fp == NULL)
 		return 0;
 	mcd_table[i].filename = strdup(name);
+	strcpy(mcd_table[i].mode, "w");
 
 	if (vpi_trace) {
 	      fprintf(vpi_trace, "vpi_mcd_open(%s) --> 0x%08x\n",
@@ -318,6 +333,8 @@ got_entry:
 #endif
       if (fd_table[i].fp == NULL) return 0;
       fd_table[i].filename = strdup(name);
+      strncpy(fd_table[i].mode, mode, sizeof fd_table[i].mode - 1);
+      fd_table[i].mode[sizeof fd_table[i].mode - 1] = 0;
       return ((1U<<31)|i);
 }
 
@@ -331,3 +348,169 @@ extern "C" FILE *vpi_get_file(PLI_INT32 fd)
 
       return fd_table[FD_IDX(fd)].fp;
 }
+
+/*
+ * The checkpoint of the files holds the name, mode and position of
+ * each file that the simulation opened. The standard files are left
+ * alone. The entries are kept at the same index, since the
+ * simulation holds the descriptors in its variables.
+ */
+static void checkpoint_save_entry_(vvp_checkpoint_out&out, unsigned kind,
+				   unsigned idx, const mcd_entry_s&entry)
+{
+      fflush(entry.fp);
+      long pos = ftell(entry.fp);
+      if (pos < 0) {
+	    out.refuse(string("cannot get the position in file ") + entry.filename);
+	    return;
+      }
+
+      out.put_uint(kind);
+      out.put_uint(idx);
+      out.put_string(entry.filename);
+      out.put_string(entry.mode);
+      out.put_uint(pos);
+}
+
+void vpip_mcd_checkpoint_save(vvp_checkpoint_out&out)
+{
+      for (unsigned idx = 1 ; idx < 31 ; idx += 1) {
+	    if (mcd_table[idx].fp)
+		  checkpoint_save_entry_(out, 0, idx, mcd_table[idx]);
+      }
+      for (unsigned idx = 3 ; idx < fd_table_len ; idx += 1) {
+	    if (fd_table[idx].fp)
+		  checkpoint_save_entry_(out, 1, idx, fd_table[idx]);
+      }
+      out.put_uint(2);
+}
+
+/*
+ * Open the file again at the saved position. A file that was being
+ * written is cut back to that position, since whatever the saving
+ * simulation wrote after the checkpoint is not part of this run.
+ */
+static FILE* checkpoint_reopen_(const char*name, const char*mode, long pos)
+{
+      if (mode[0] == 'r') {
+	    FILE*fp = fopen(name, mode);
+	    if (fp && fseek(fp, pos, SEEK_SET) != 0) {
+		  fclose(fp);
+		  fp = 0;
+	    }
+	    return fp;
+      }
+
+      FILE*fp = fopen(name, strchr(mode, 'b')? "r+b" : "r+");
+      if (fp == 0)
+	    return 0;
+#ifdef _MSC_VER
+      int rc = _chsize(_fileno(fp), pos);
+#else
+      int rc = ftruncate(fileno(fp), pos);
+#endif
+      if (rc != 0 || fseek(fp, pos, SEEK_SET) != 0) {
+	    fclose(fp);
+	    return 0;
+      }
+
+	// Files opened for append are opened again that way, so that
+	// they keep appending.
+      if (mode[0] == 'a') {
+	    fclose(fp);
+	    fp = fopen(name, mode);
+      }
+      return fp;
+}
+
+void vpip_mcd_checkpoint_restore(vvp_checkpoint_in&in)
+{
+      for (;;) {
+	    uint64_t kind = in.get_uint();
+	    if (in.bad() || kind == 2)
+		  break;
+	    uint64_t idx = in.get_uint();
+	    string name = in.get_string();
+	    string mode = in.get_string();
+	    long pos = in.get_uint();
+	    if (in.bad())
+		  break;
+
+	    if (kind > 2 || mode.empty() || mode.size() >= sizeof mcd_table[0].mode
+		|| (kind == 0 && (idx < 1 || idx >= 31))
+		|| (kind == 1 && (idx < 3 || idx >= 1024))) {
+		  in.error("bad file entry");
+		  break;
+	    }
+
+	    mcd_entry_s*entry;
+	    if (kind == 0) {
+		  entry = mcd_table + idx;
+	    } else {
+		  if (idx >= fd_table_len) {
+			unsigned old_len = fd_table_len;
+			while (fd_table_len <= idx)
+			      fd_table_len += FD_INCR;
+			fd_table = (mcd_entry_s *) realloc(fd_table,
+						fd_table_len*sizeof(mcd_entry_s));
+			for (unsigned tmp = old_len; tmp < fd_table_len; tmp += 1) {
+			      fd_table[tmp].fp = NULL;
+			      fd_table[tmp].filename = NULL;
+			}
+		  }
+		  entry = fd_table + idx;
+	    }
+
+	    if (entry->fp) {
+		  in.error("the descriptor of file " + name + " is already in use");
+		  break;
+	    }
+
+	    entry->fp = checkpoint_reopen_(name.c_str(), mode.c_str(), pos);
+	    if (entry->fp == 0) {
+		  in.error("cannot open file " + name + " again");
+		  break;
+	    }
+	    entry->filename = strdup(name.c_str());
+	    strcpy(entry->mode, mode.c_str());
+      }
+}
+
+/*
+ * The snapshot runs (vvp -F) are forked processes, which would all
+ * write the files that the simulation opened, so the fan-out is
+ * refused if there are any. The standard files are not counted.
+ */
+const char* vpip_mcd_snapshot_open_file(void)
+{
+      for (unsigned idx = 1 ; idx < 31 ; idx += 1) {
+	    if (mcd_table[idx].fp)
+		  return mcd_table[idx].filename;
+      }
+      for (unsigned idx = 3 ; idx < fd_table_len ; idx += 1) {
+	    if (fd_table[idx].fp)
+		  return fd_table[idx].filename;
+      }
+      return 0;
+}
+
+/*
+ * A snapshot run writes its own log file, with the suffix added to
+ * the name. The parent flushed the log before the fork, so closing it
+ * here loses nothing.
+ */
+bool vpip_mcd_snapshot_child(const char*suffix)
+{
+      if (logfile == 0 || logfile_name == 0)
+	    return true;
+
+      string name = string(logfile_name) + suffix;
+      fclose(logfile);
+      logfile = fopen(name.c_str(), "w");
+      if (logfile == 0) {
+	    perror(name.c_str());
+	    return false;
+      }
+      setvbuf(logfile, 0, _IOLBF, BUFSIZ);
+      return true;
+}
@@ -21,8 +21,11 @@
 # include  "version_base.h"
 # include  "vpi_priv.h"
 # include  "schedule.h"
+# include  "checkpoint.h"
+# include  "snapshot.h"
 # include  "logic.h"
 # include  "part.h"
+# include  "fanout.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
@@ -308,6 +311,9 @@ static int vpip_get_global(int property)
 	    return vpip_get_time_precision();
 
 	  default:
+	    PLI_INT32 val;
+	    if (schedule_stats_get(property, val))
+		  return val;
 	    fprintf(stderr, "vpi error: bad global property: %d\n", property);
 	    assert(0);
 	    return vpiUndefined;
@@ -627,6 +633,12 @@ void vpi_set_vlog_info(int argc, char** argv)
     }
 }
 
+void vpip_set_vlog_args(int argc, char**argv)
+{
+    vpi_vlog_info.argc    = argc;
+    vpi_vlog_info.argv    = argv;
+}
+
 static void vec4_get_value_string(const vvp_vector4_t&word_val, unsigned width,
 				  s_vpi_value*vp)
 {
@@ -1610,6 +1622,10 @@ vpiHandle vpi_handle_multi(PLI_INT32 type,
 	    return nullptr;
       }
 
+	// The search below follows and changes the fan-out lists, so
+	// put back the lists of any flat fan-outs (vvp -f) first.
+      fanout_expand_all();
+
 	// Indicates whether port1 refers to a single bit
       bool port1_has_index = false;
       int port1_bit_index = 0;
@@ -1884,6 +1900,14 @@ extern "C" void vpi_sim_vcontrol(int operation, va_list ap)
 	    schedule_stop(diag_msg);
 	    break;
 
+	  case __ivl_vpiSave:
+	    checkpoint_schedule_save(va_arg(ap, const char*));
+	    break;
+
+	  case __ivl_vpiSnapshot:
+	    snapshot_schedule(va_arg(ap, const char*));
+	    break;
+
 	  default:
 	    fprintf(stderr, "Unsupported operation %d.\n", operation);
 	    assert(0);
@@ -22,6 +22,7 @@
 
 # include  "sv_vpi_user.h"
 # include  "vvp_net.h"
+# include  "vthread.h"
 # include  "config.h"
 
 # include  <map>
@@ -218,6 +219,13 @@ class value_callback : public __vpiCallback {
 
 extern void callback_execute(struct __vpiCallback*cur);
 
+/*
+ * Make the callback of the native dump engine (__ivl_cbDumpChange)
+ * for a signal. This is defined in vpi_dump.cc, and returns nil for
+ * objects that the engine does not handle.
+ */
+extern value_callback* vpip_dump_change(p_cb_data data);
+
 struct __vpiSystemTime : public __vpiHandle {
       __vpiSystemTime();
       int get_type_code(void) const;
@@ -292,7 +300,7 @@ class __vpiScope : public __vpiHandle {
         /* Keep a list of freed contexts. */
       vvp_context_t free_contexts;
 	/* Keep a list of threads in the scope. */
-      std::set<vthread_t> threads;
+      vthread_list_t threads;
       signed int time_units :8;
       signed int time_precision :8;
 
@@ -721,7 +729,7 @@ class __vpiStringVar : public __vpiBaseVar {
 extern vpiHandle vpip_make_string_var(const char*name, vvp_net_t*net);
 
 struct __vpiArrayBase {
-      __vpiArrayBase() : vals_words(NULL) {}
+      __vpiArrayBase() : vals_words(NULL), vals_pages(NULL) {}
       virtual ~__vpiArrayBase() {}
 
       virtual unsigned get_size(void) const = 0;
@@ -741,9 +749,19 @@ struct __vpiArrayBase {
     // code in the following function
       vpiHandle vpi_array_base_iterate(int code);
 
-      virtual void make_vals_words();
+	// Return the handle of a word of the array, making the
+	// handles of its page if needed.
+      struct __vpiArrayWord*vals_word(unsigned idx);
+#ifdef CHECK_WITH_VALGRIND
+      void delete_vals_words();
+#endif
 
+      enum { VALS_PAGE_WORDS = 4096 };
       struct __vpiArrayWord*vals_words;
+      struct __vpiArrayWord**vals_pages;
+
+    private:
+      struct __vpiArrayWord*make_vals_words_(unsigned base, unsigned count);
 };
 
 /*
@@ -1024,6 +1042,12 @@ vpiHandle vpip_make_vthr_APV(char*label, unsigned index, unsigned bit, unsigned
  */
 extern void vpip_load_module(const char*name);
 
+/*
+ * Replace the extended arguments that vpi_get_vlog_info returns. A
+ * snapshot child uses this to add the arguments of its run.
+ */
+extern void vpip_set_vlog_args(int argc, char**argv);
+
 extern void vpip_clear_module_paths();
 extern void vpip_add_module_path(const char *path);
 extern void vpip_add_env_and_default_module_paths();
@@ -345,7 +345,7 @@ static vpiHandle module_iter(int code, vpiHandle obj)
 
 
 __vpiScope::__vpiScope(const char*nam, const char*tnam, bool auto_flag)
-: is_automatic_(auto_flag)
+: threads(vthread_list_t::SCOPE), is_automatic_(auto_flag)
 {
       name_ = vpip_name_string(nam);
       tname_ = vpip_name_string(tnam? tnam : "");
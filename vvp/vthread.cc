@@ -28,12 +28,16 @@
 # include  "vvp_cobject.h"
 # include  "vvp_darray.h"
 # include  "class_type.h"
+# include  "statistics.h"
+# include  "checkpoint.h"
+# include  "profile.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
 # include  <set>
 # include  <typeinfo>
 # include  <vector>
+# include  <utility>
 # include  <cstdlib>
 # include  <climits>
 # include  <cstring>
@@ -90,6 +94,7 @@ using namespace std;
 
 struct vthread_s {
       vthread_s();
+      ~vthread_s();
 
       void debug_dump(ostream&fd, const char*label_text);
 
@@ -118,7 +123,7 @@ struct vthread_s {
       inline vvp_vector4_t pop_vec4(void)
       {
 	    assert(! stack_vec4_.empty());
-	    vvp_vector4_t val = stack_vec4_.back();
+	    vvp_vector4_t val (std::move(stack_vec4_.back()));
 	    stack_vec4_.pop_back();
 	    return val;
       }
@@ -126,6 +131,10 @@ struct vthread_s {
       {
 	    stack_vec4_.push_back(val);
       }
+      inline void push_vec4(vvp_vector4_t&&val)
+      {
+	    stack_vec4_.push_back(std::move(val));
+      }
       inline const vvp_vector4_t& peek_vec4(unsigned depth)
       {
 	    unsigned size = stack_vec4_.size();
@@ -274,9 +283,18 @@ struct vthread_s {
       unsigned is_scheduled      :1;
       unsigned delay_delete      :1;
 	/* This points to the children of the thread. */
-      set<struct vthread_s*>children;
+      vthread_list_t children;
 	/* This points to the detached children of the thread. */
-      set<struct vthread_s*>detached_children;
+      vthread_list_t detached_children;
+	/* These link me into the list of my parent's children and the
+	   list of threads in my scope. */
+      struct {
+	    struct vthread_s*prev;
+	    struct vthread_s*next;
+	    vthread_list_t*list;
+      } link[vthread_list_t::LINK_COUNT];
+	/* Take me out of any lists that I am still in. */
+      void unlink();
 	/* This points to my parent, if I have one. */
       struct vthread_s*parent;
 	/* This points to the containing scope. */
@@ -288,6 +306,8 @@ struct vthread_s {
 	/* These are used to pass non-blocking event control information. */
       vvp_net_t*event;
       uint64_t ecount;
+	/* The process that the profiler counts this thread in. */
+      profile_item_s*profile;
 	/* Save the file/line information when available. */
     private:
       char *filenm_;
@@ -296,6 +316,11 @@ struct vthread_s {
       void set_fileline(char *filenm, unsigned lineno);
       string get_fileline();
 
+	/* Write the stacks and the file/line information to a
+	   checkpoint, and read them back. */
+      void save_private(vvp_checkpoint_out&out) const;
+      void restore_private(vvp_checkpoint_in&in);
+
       inline void cleanup()
       {
 	    if (i_was_disabled) {
@@ -314,12 +339,31 @@ struct vthread_s {
 };
 
 inline vthread_s::vthread_s()
+: children(vthread_list_t::SIBLING), detached_children(vthread_list_t::SIBLING)
 {
+      for (unsigned idx = 0 ; idx < vthread_list_t::LINK_COUNT ; idx += 1) {
+	    link[idx].prev = 0;
+	    link[idx].next = 0;
+	    link[idx].list = 0;
+      }
       stack_obj_size_ = 0;
       filenm_ = 0;
       lineno_ = 0;
 }
 
+inline vthread_s::~vthread_s()
+{
+      unlink();
+}
+
+void vthread_s::unlink()
+{
+      for (unsigned idx = 0 ; idx < vthread_list_t::LINK_COUNT ; idx += 1) {
+	    if (link[idx].list)
+		  link[idx].list->erase(this);
+      }
+}
+
 void vthread_s::set_fileline(char *filenm, unsigned lineno)
 {
       assert(filenm);
@@ -340,6 +384,103 @@ inline string vthread_s::get_fileline()
       return res;
 }
 
+void vthread_s::save_private(vvp_checkpoint_out&out) const
+{
+      if (stack_obj_size_ > 0)
+	    out.refuse("a thread has objects on its stack");
+
+      out.put_uint(stack_vec4_.size());
+      for (size_t idx = 0 ; idx < stack_vec4_.size() ; idx += 1)
+	    out.put_vec4(stack_vec4_[idx]);
+      out.put_uint(stack_real_.size());
+      for (size_t idx = 0 ; idx < stack_real_.size() ; idx += 1)
+	    out.put_real(stack_real_[idx]);
+      out.put_uint(stack_str_.size());
+      for (size_t idx = 0 ; idx < stack_str_.size() ; idx += 1)
+	    out.put_string(stack_str_[idx]);
+
+      out.put_string(filenm_? filenm_ : "");
+      out.put_uint(lineno_);
+}
+
+void vthread_s::restore_private(vvp_checkpoint_in&in)
+{
+      uint64_t count = in.get_uint();
+      for (uint64_t idx = 0 ; idx < count && !in.bad() ; idx += 1)
+	    stack_vec4_.push_back(in.get_vec4());
+      count = in.get_uint();
+      for (uint64_t idx = 0 ; idx < count && !in.bad() ; idx += 1)
+	    stack_real_.push_back(in.get_real());
+      count = in.get_uint();
+      for (uint64_t idx = 0 ; idx < count && !in.bad() ; idx += 1)
+	    stack_str_.push_back(in.get_string());
+
+      string file = in.get_string();
+      free(filenm_);
+      filenm_ = file.empty()? 0 : strdup(file.c_str());
+      lineno_ = in.get_uint();
+}
+
+vthread_list_t::vthread_list_t(link_t link)
+: link_(link), head_(0), tail_(0), count_(0)
+{
+}
+
+vthread_list_t::~vthread_list_t()
+{
+      clear();
+}
+
+vthread_t vthread_list_t::next(vthread_t thr) const
+{
+      assert(thr->link[link_].list == this);
+      return thr->link[link_].next;
+}
+
+void vthread_list_t::insert(vthread_t thr)
+{
+      assert(thr->link[link_].list == 0);
+      thr->link[link_].list = this;
+      thr->link[link_].prev = tail_;
+      thr->link[link_].next = 0;
+      if (tail_)
+	    tail_->link[link_].next = thr;
+      else
+	    head_ = thr;
+      tail_ = thr;
+      count_ += 1;
+}
+
+size_t vthread_list_t::erase(vthread_t thr)
+{
+      if (thr->link[link_].list != this)
+	    return 0;
+
+      vthread_t prev = thr->link[link_].prev;
+      vthread_t next = thr->link[link_].next;
+      if (prev)
+	    prev->link[link_].next = next;
+      else
+	    head_ = next;
+      if (next)
+	    next->link[link_].prev = prev;
+      else
+	    tail_ = prev;
+
+      thr->link[link_].prev = 0;
+      thr->link[link_].next = 0;
+      thr->link[link_].list = 0;
+      assert(count_ > 0);
+      count_ -= 1;
+      return 1;
+}
+
+void vthread_list_t::clear()
+{
+      while (head_)
+	    erase(head_);
+}
+
 void vthread_s::debug_dump(ostream&fd, const char*label)
 {
       fd << "**** " << label << endl;
@@ -686,12 +827,35 @@ void contexts_delete(struct __vpiScope*scope)
 }
 #endif
 
+/*
+ * Threads are created and destroyed at a great rate by designs that
+ * fork or call tasks and functions, so deleted threads are kept on
+ * this free list (linked through wait_next) to be used again. A
+ * recycled thread keeps the capacity of its stacks, so that once the
+ * simulation warms up, creating and reaping a thread does not touch
+ * the heap at all.
+ */
+static vthread_t vthread_free_list = 0;
+
+unsigned long count_vthreads = 0;
+static unsigned long count_vthread_objects = 0;
+
+unsigned long count_vthread_pool(void) { return count_vthread_objects; }
+
 /*
  * Create a new thread with the given start address.
  */
-vthread_t vthread_new(vvp_code_t pc, __vpiScope*scope)
+static vthread_t vthread_alloc_(vvp_code_t pc, __vpiScope*scope)
 {
-      vthread_t thr = new struct vthread_s;
+      vthread_t thr = vthread_free_list;
+      if (thr) {
+	    vthread_free_list = thr->wait_next;
+      } else {
+	    thr = new struct vthread_s;
+	    count_vthread_objects += 1;
+      }
+      count_vthreads += 1;
+
       thr->pc     = pc;
 	//thr->bits4  = vvp_vector4_t(32);
       thr->parent = 0;
@@ -711,6 +875,7 @@ vthread_t vthread_new(vvp_code_t pc, __vpiScope*scope)
       thr->waiting_for_event = 0;
       thr->event  = 0;
       thr->ecount = 0;
+      thr->profile = profile_flag? profile_process(pc, scope) : 0;
 
       thr->flags[0] = BIT4_0;
       thr->flags[1] = BIT4_1;
@@ -719,6 +884,12 @@ vthread_t vthread_new(vvp_code_t pc, __vpiScope*scope)
       for (int idx = 4 ; idx < 8 ; idx += 1)
 	    thr->flags[idx] = BIT4_X;
 
+      return thr;
+}
+
+vthread_t vthread_new(vvp_code_t pc, __vpiScope*scope)
+{
+      vthread_t thr = vthread_alloc_(pc, scope);
       scope->threads .insert(thr);
       return thr;
 }
@@ -753,11 +924,17 @@ static void child_delete(vthread_t base)
 
 void vthreads_delete(struct __vpiScope*scope)
 {
-      for (std::set<vthread_t>::iterator cur = scope->threads.begin()
-		 ; cur != scope->threads.end() ; ++ cur ) {
-	    delete *cur;
+      while (! scope->threads.empty())
+	    delete scope->threads.front();
+}
+
+void vthread_pool_delete(void)
+{
+      while (vthread_free_list) {
+	    vthread_t thr = vthread_free_list;
+	    vthread_free_list = thr->wait_next;
+	    delete thr;
       }
-      scope->threads.clear();
 }
 #endif
 
@@ -768,19 +945,15 @@ void vthreads_delete(struct __vpiScope*scope)
 static void vthread_reap(vthread_t thr)
 {
       if (! thr->children.empty()) {
-	    for (set<vthread_t>::iterator cur = thr->children.begin()
-		       ; cur != thr->children.end() ; ++cur) {
-		  vthread_t child = *cur;
-		  assert(child);
+	    for (vthread_t child = thr->children.front()
+		       ; child ; child = thr->children.next(child)) {
 		  assert(child->parent == thr);
 		  child->parent = thr->parent;
 	    }
       }
       if (! thr->detached_children.empty()) {
-	    for (set<vthread_t>::iterator cur = thr->detached_children.begin()
-		       ; cur != thr->detached_children.end() ; ++cur) {
-		  vthread_t child = *cur;
-		  assert(child);
+	    for (vthread_t child = thr->detached_children.front()
+		       ; child ; child = thr->detached_children.next(child)) {
 		  assert(child->parent == thr);
 		  assert(child->i_am_detached);
 		  child->parent = 0;
@@ -821,16 +994,254 @@ static void vthread_reap(vthread_t thr)
 void vthread_delete(vthread_t thr)
 {
       thr->cleanup();
-      delete thr;
+      thr->unlink();
+      thr->children.clear();
+      thr->detached_children.clear();
+      thr->args_real.clear();
+      thr->args_str.clear();
+      thr->args_vec4.clear();
+      thr->wait_next = vthread_free_list;
+      vthread_free_list = thr;
+}
+
+/*
+ * The checkpoint has a table of all the threads that are alive or
+ * referenced by events. The table is written after the rest of the
+ * checkpoint has named the threads that it needs, and the threads
+ * that those threads refer to are added as they are written. Each
+ * record holds everything in the thread except the wait list link,
+ * which is saved with the list that the thread is in.
+ */
+enum {
+      CP_JOINING = 0x001, CP_DETACHED = 0x002, CP_WAITING = 0x004,
+      CP_IN_FUNCTION = 0x008, CP_ENDED = 0x010, CP_DISABLED = 0x020,
+      CP_WAIT_EVENT = 0x040, CP_SCHEDULED = 0x080, CP_IN_SCOPE = 0x100
+};
+
+static void vthread_checkpoint_put_opt_(vvp_checkpoint_out&out, vthread_t thr)
+{
+      if (thr) {
+	    out.put_uint(1);
+	    out.put_thread(thr);
+      } else {
+	    out.put_uint(0);
+      }
+}
+
+static void vthread_checkpoint_put_children_(vvp_checkpoint_out&out,
+					     const vthread_list_t&list)
+{
+      out.put_uint(list.size());
+      for (vthread_t cur = list.front() ; cur ; cur = list.next(cur))
+	    out.put_thread(cur);
 }
 
-void vthread_mark_scheduled(vthread_t thr)
+void vthread_checkpoint_save(vvp_checkpoint_out&out)
 {
+      vvp_checkpoint_out body (out);
+
+      for (size_t idx = 0 ; idx < out.thread_count() ; idx += 1) {
+	    vthread_t thr = out.thread(idx);
+
+	    if (thr->wt_context || thr->rd_context)
+		  out.refuse("a thread is in an automatic task or function");
+	    if (thr->event)
+		  out.refuse("a thread has an event control");
+
+	    unsigned bits = 0;
+	    if (thr->i_am_joining)      bits |= CP_JOINING;
+	    if (thr->i_am_detached)     bits |= CP_DETACHED;
+	    if (thr->i_am_waiting)      bits |= CP_WAITING;
+	    if (thr->i_am_in_function)  bits |= CP_IN_FUNCTION;
+	    if (thr->i_have_ended)      bits |= CP_ENDED;
+	    if (thr->i_was_disabled)    bits |= CP_DISABLED;
+	    if (thr->waiting_for_event) bits |= CP_WAIT_EVENT;
+	    if (thr->is_scheduled)      bits |= CP_SCHEDULED;
+	    if (thr->link[vthread_list_t::SCOPE].list)
+		  bits |= CP_IN_SCOPE;
+
+	    body.put_scope(thr->parent_scope);
+	    body.put_code(thr->pc);
+	    body.put_uint(bits);
+	    vthread_checkpoint_put_opt_(body, thr->parent);
+	    body.put_bits(thr->flags, vthread_s::FLAGS_COUNT);
+	    for (unsigned wdx = 0 ; wdx < vthread_s::WORDS_COUNT ; wdx += 1)
+		  body.put_uint(thr->words[wdx].w_uint);
+
+	    body.put_uint(thr->args_real.size());
+	    for (size_t adx = 0 ; adx < thr->args_real.size() ; adx += 1)
+		  body.put_uint(thr->args_real[adx]);
+	    body.put_uint(thr->args_str.size());
+	    for (size_t adx = 0 ; adx < thr->args_str.size() ; adx += 1)
+		  body.put_uint(thr->args_str[adx]);
+	    body.put_uint(thr->args_vec4.size());
+	    for (size_t adx = 0 ; adx < thr->args_vec4.size() ; adx += 1)
+		  body.put_uint(thr->args_vec4[adx]);
+
+	    thr->save_private(body);
+
+	    vthread_checkpoint_put_children_(body, thr->children);
+	    vthread_checkpoint_put_children_(body, thr->detached_children);
+      }
+
+      out.put_uint(out.thread_count());
+      out.append(body);
+}
+
+static vthread_t vthread_checkpoint_get_opt_(vvp_checkpoint_in&in)
+{
+      if (in.get_uint() == 0)
+	    return 0;
+      return in.get_thread();
+}
+
+static void vthread_checkpoint_get_children_(vvp_checkpoint_in&in,
+					     vector<vthread_t>&list)
+{
+      uint64_t count = in.get_uint();
+      for (uint64_t idx = 0 ; idx < count && !in.bad() ; idx += 1)
+	    list.push_back(in.get_thread());
+}
+
+static void vthread_checkpoint_link_children_(vvp_checkpoint_in&in,
+					      vthread_t parent,
+					      const vector<vthread_t>&children,
+					      vthread_list_t&list)
+{
+      for (size_t idx = 0 ; idx < children.size() ; idx += 1) {
+	    vthread_t child = children[idx];
+	    if (child->parent != parent
+		|| child->link[vthread_list_t::SIBLING].list) {
+		  in.error("bad thread family");
+		  return;
+	    }
+	    list.insert(child);
+      }
+}
+
+void vthread_checkpoint_restore(vvp_checkpoint_in&in)
+{
+      uint64_t count = in.get_uint();
+      vector<vthread_t> table;
+      for (uint64_t idx = 0 ; idx < count && !in.bad() ; idx += 1) {
+	    vthread_t thr = vthread_alloc_(codespace_null(), 0);
+	    table.push_back(thr);
+	    in.add_thread(thr);
+      }
+
+      vector<vector<vthread_t> > children (table.size());
+      vector<vector<vthread_t> > detached (table.size());
+      for (size_t idx = 0 ; idx < table.size() && !in.bad() ; idx += 1) {
+	    vthread_t thr = table[idx];
+
+	    thr->parent_scope = in.get_scope();
+	    thr->pc = in.get_code();
+	      // The start of a restored thread is not known, so the
+	      // profiler counts it where it resumes.
+	    if (profile_flag)
+		  thr->profile = profile_process(thr->pc, thr->parent_scope);
+	    unsigned bits = in.get_uint();
+	    thr->parent = vthread_checkpoint_get_opt_(in);
+	    if (in.bad())
+		  return;
+
+	    thr->i_am_joining      = (bits & CP_JOINING)? 1 : 0;
+	    thr->i_am_detached     = (bits & CP_DETACHED)? 1 : 0;
+	    thr->i_am_waiting      = (bits & CP_WAITING)? 1 : 0;
+	    thr->i_am_in_function  = (bits & CP_IN_FUNCTION)? 1 : 0;
+	    thr->i_have_ended      = (bits & CP_ENDED)? 1 : 0;
+	    thr->i_was_disabled    = (bits & CP_DISABLED)? 1 : 0;
+	    thr->waiting_for_event = (bits & CP_WAIT_EVENT)? 1 : 0;
+	    thr->is_scheduled      = (bits & CP_SCHEDULED)? 1 : 0;
+	    if (bits & CP_IN_SCOPE)
+		  thr->parent_scope->threads.insert(thr);
+
+	    in.get_bits(thr->flags, vthread_s::FLAGS_COUNT);
+	    for (unsigned wdx = 0 ; wdx < vthread_s::WORDS_COUNT ; wdx += 1)
+		  thr->words[wdx].w_uint = in.get_uint();
+
+	    uint64_t args = in.get_uint();
+	    for (uint64_t adx = 0 ; adx < args && !in.bad() ; adx += 1)
+		  thr->args_real.push_back(in.get_uint());
+	    args = in.get_uint();
+	    for (uint64_t adx = 0 ; adx < args && !in.bad() ; adx += 1)
+		  thr->args_str.push_back(in.get_uint());
+	    args = in.get_uint();
+	    for (uint64_t adx = 0 ; adx < args && !in.bad() ; adx += 1)
+		  thr->args_vec4.push_back(in.get_uint());
+
+	    thr->restore_private(in);
+	    vthread_checkpoint_get_children_(in, children[idx]);
+	    vthread_checkpoint_get_children_(in, detached[idx]);
+	    if (in.bad())
+		  return;
+      }
+
+	// The children refer to their parents, so link the families
+	// once all the parents are known.
+      for (size_t idx = 0 ; idx < table.size() && !in.bad() ; idx += 1) {
+	    vthread_t thr = table[idx];
+	    vthread_checkpoint_link_children_(in, thr, children[idx], thr->children);
+	    vthread_checkpoint_link_children_(in, thr, detached[idx], thr->detached_children);
+      }
+}
+
+void vthread_checkpoint_put_list(vvp_checkpoint_out&out, vthread_t list)
+{
+      size_t count = 0;
+      for (vthread_t cur = list ; cur ; cur = cur->wait_next)
+	    count += 1;
+
+      out.put_uint(count);
+      for (vthread_t cur = list ; cur ; cur = cur->wait_next)
+	    out.put_thread(cur);
+}
+
+vthread_t vthread_checkpoint_get_list(vvp_checkpoint_in&in)
+{
+      uint64_t count = in.get_uint();
+      vthread_t head = 0;
+      vthread_t tail = 0;
+      for (uint64_t idx = 0 ; idx < count && !in.bad() ; idx += 1) {
+	    vthread_t thr = in.get_thread();
+	    if (thr == 0 || thr->wait_next || thr == tail) {
+		  in.error("bad thread list");
+		  return 0;
+	    }
+	    if (tail)
+		  tail->wait_next = thr;
+	    else
+		  head = thr;
+	    tail = thr;
+      }
+      return head;
+}
+
+void vthread_checkpoint_drop_list(vthread_t list)
+{
+      while (list) {
+	    vthread_t next = list->wait_next;
+	    vthread_delete(list);
+	    list = next;
+      }
+}
+
+vthread_t vthread_mark_scheduled(vthread_t thr)
+{
+      vthread_t tail = 0;
       while (thr != 0) {
 	    assert(thr->is_scheduled == 0);
 	    thr->is_scheduled = 1;
+	    tail = thr;
 	    thr = thr->wait_next;
       }
+      return tail;
+}
+
+void vthread_append_list(vthread_t tail, vthread_t list)
+{
+      assert(tail->is_scheduled && tail->wait_next == 0);
+      tail->wait_next = list;
 }
 
 void vthread_mark_final(vthread_t thr)
@@ -852,13 +1263,55 @@ void vthread_delay_delete()
 	    running_thread->delay_delete = 1;
 }
 
+/*
+ * With the profiler on, vthread_run uses this loop instead. It is the
+ * plain loop below, with each run of a thread timed and each opcode
+ * counted.
+ */
+static void vthread_run_profiled_(vthread_t thr)
+{
+      while (thr != 0) {
+	    vthread_t tmp = thr->wait_next;
+	    thr->wait_next = 0;
+
+	    assert(thr->is_scheduled);
+	    thr->is_scheduled = 0;
+
+            running_thread = thr;
+
+	    profile_thread_enter(thr->profile);
+	    for (;;) {
+		  vvp_code_t cp = thr->pc;
+		  thr->pc += 1;
+
+		  profile_opcode(cp->opcode);
+		  bool rc = (cp->opcode)(thr, cp);
+		  if (rc == false)
+			break;
+	    }
+	    profile_thread_leave();
+
+	    thr = tmp;
+      }
+      running_thread = 0;
+}
+
 /*
  * This function runs each thread by fetching an instruction,
  * incrementing the PC, and executing the instruction. The thread may
  * be the head of a list, so each thread is run so far as possible.
+ *
+ * If vvp is configured with threaded dispatch, the vthread_run
+ * function is instead at the end of this file.
  */
+#ifndef VVP_THREADED_DISPATCH
 void vthread_run(vthread_t thr)
 {
+      if (profile_flag) {
+	    vthread_run_profiled_(thr);
+	    return;
+      }
+
       while (thr != 0) {
 	    vthread_t tmp = thr->wait_next;
 	    thr->wait_next = 0;
@@ -884,6 +1337,7 @@ void vthread_run(vthread_t thr)
       }
       running_thread = 0;
 }
+#endif
 
 /*
  * The CHUNK_LINK instruction is a special next pointer for linking
@@ -908,7 +1362,12 @@ void vthread_schedule_list(vthread_t thr)
 	    cur->waiting_for_event = 0;
       }
 
-      schedule_vthread(thr, 0);
+      schedule_vthread_wake(thr);
+}
+
+vvp_code_t*vthread_pc_ref(vthread_t thr)
+{
+      return &thr->pc;
 }
 
 vvp_context_t vthread_get_wt_context()
@@ -1432,7 +1891,7 @@ bool of_BLEND(vthread_t thr, vvp_code_t)
 	    vala.set_bit(idx, BIT4_X);
       }
 
-      thr->push_vec4(vala);
+      thr->push_vec4(std::move(vala));
       return true;
 }
 
@@ -1676,18 +2135,7 @@ bool of_CASSIGN_WR(vthread_t thr, vvp_code_t cp)
 bool of_CAST2(vthread_t thr, vvp_code_t)
 {
       vvp_vector4_t&val = thr->peek_vec4();
-      unsigned wid = val.size();
-
-      for (unsigned idx = 0 ; idx < wid ; idx += 1) {
-	    switch (val.value(idx)) {
-		case BIT4_0:
-		case BIT4_1:
-		  break;
-		default:
-		  val.set_bit(idx, BIT4_0);
-		  break;
-	    }
-      }
+      val.cast2();
 
       return true;
 }
@@ -1710,7 +2158,7 @@ bool do_cast_vec_dar(vthread_t thr, vvp_code_t cp, bool as_vec4)
             schedule_stop(0);
             return false;
       }
-      thr->push_vec4(vec);
+      thr->push_vec4(std::move(vec));
       return true;
 }
 
@@ -1760,7 +2208,7 @@ bool of_CAST_VEC4_STR(vthread_t thr, vvp_code_t cp)
             }
       }
 
-      thr->push_vec4(vec);
+      thr->push_vec4(std::move(vec));
       return true;
 }
 
@@ -1893,6 +2341,19 @@ static void do_CMPS(vthread_t thr, const vvp_vector4_t&lval, const vvp_vector4_t
 {
       assert(rval.size() == lval.size());
 
+	// Two-state values that fit in a word are compared as
+	// unsigned words with the sign bits flipped.
+      unsigned long lword, rword;
+      if (lval.get_2state_word(lword) && rval.get_2state_word(rword)) {
+	    unsigned long sign = 1UL << (lval.size()-1);
+	    lword ^= sign;
+	    rword ^= sign;
+	    thr->flags[4] = lword == rword? BIT4_1 : BIT4_0; // eq
+	    thr->flags[5] = lword <  rword? BIT4_1 : BIT4_0; // lt
+	    thr->flags[6] = thr->flags[4];                   // eeq
+	    return;
+      }
+
 	// If either value has XZ bits, then the eq and lt values are
 	// known already to be X. Just calculate the eeq result as a
 	// special case and short circuit the rest of the compare.
@@ -2072,6 +2533,15 @@ static void do_CMPU(vthread_t thr, const vvp_vector4_t&lval, const vvp_vector4_t
       assert(rval.size() == lval.size());
       unsigned wid = lval.size();
 
+	// Two-state values that fit in a word need no scratch arrays.
+      unsigned long lword, rword;
+      if (lval.get_2state_word(lword) && rval.get_2state_word(rword)) {
+	    thr->flags[4] = lword == rword? BIT4_1 : BIT4_0;
+	    thr->flags[5] = lword <  rword? BIT4_1 : BIT4_0;
+	    thr->flags[6] = thr->flags[4];
+	    return;
+      }
+
       unsigned long*larray = lval.subarray(0,wid);
       if (larray == 0) return of_CMPU_the_hard_way(thr, wid, lval, rval);
 
@@ -2306,7 +2776,7 @@ bool of_CONCAT_VEC4(vthread_t thr, vvp_code_t)
 	// result. Do that by actually popping only 1 stack position
 	// and replacing the new top with the new value.
       thr->pop_vec4(1);
-      thr->peek_vec4() = res;
+      thr->peek_vec4() = std::move(res);
 
       return true;
 }
@@ -2397,7 +2867,7 @@ bool of_CVT_VR(vthread_t thr, vvp_code_t cp)
       unsigned wid = cp->number;
 
       vvp_vector4_t tmp(wid, r);
-      thr->push_vec4(tmp);
+      thr->push_vec4(std::move(tmp));
       return true;
 }
 
@@ -2597,7 +3067,7 @@ static bool do_disable(vthread_t thr, vthread_t match)
 	   %forks that this thread has done. */
       while (! thr->children.empty()) {
 
-	    vthread_t tmp = *(thr->children.begin());
+	    vthread_t tmp = thr->children.front();
 	    assert(tmp);
 	    assert(tmp->parent == thr);
 	    thr->i_am_joining = 0;
@@ -2645,9 +3115,9 @@ bool of_DISABLE(vthread_t thr, vvp_code_t cp)
       bool disabled_myself_flag = false;
 
       while (! scope->threads.empty()) {
-	    set<vthread_t>::iterator cur = scope->threads.begin();
+	    vthread_t cur = scope->threads.front();
 
-	    if (do_disable(*cur, thr))
+	    if (do_disable(cur, thr))
 		  disabled_myself_flag = true;
       }
 
@@ -2693,7 +3163,7 @@ bool of_DISABLE_FORK(vthread_t thr, vvp_code_t)
 
 	/* Disable any detached children. */
       while (! thr->detached_children.empty()) {
-	    vthread_t child = *(thr->detached_children.begin());
+	    vthread_t child = thr->detached_children.front();
 	    assert(child);
 	    assert(child->parent == thr);
 	      /* Disabling the children can never match the parent thread. */
@@ -3053,13 +3523,13 @@ bool of_END(vthread_t thr, vvp_code_t)
 
 	/* Fully detach any detached children. */
       while (! thr->detached_children.empty()) {
-	    vthread_t child = *(thr->detached_children.begin());
+	    vthread_t child = thr->detached_children.front();
 	    assert(child);
 	    assert(child->parent == thr);
 	    assert(child->i_am_detached);
 	    child->parent = 0;
 	    child->i_am_detached = 0;
-	    thr->detached_children.erase(thr->detached_children.begin());
+	    thr->detached_children.erase(child);
       }
 
 	/* It is an error to still have active children running at this
@@ -3173,7 +3643,7 @@ bool of_FLAG_GET_VEC4(vthread_t thr, vvp_code_t cp)
       assert(flag < vthread_s::FLAGS_COUNT);
 
       vvp_vector4_t val (1, thr->flags[flag]);
-      thr->push_vec4(val);
+      thr->push_vec4(std::move(val));
 
       return true;
 }
@@ -3753,9 +4223,8 @@ static bool do_join_opcode(vthread_t thr)
 
 	// Are there any children that have already ended? If so, then
 	// join with that one.
-      for (set<vthread_t>::iterator cur = thr->children.begin()
-		 ; cur != thr->children.end() ; ++cur) {
-	    vthread_t curp = *cur;
+      for (vthread_t curp = thr->children.front()
+		 ; curp ; curp = thr->children.next(curp)) {
 	    if (! curp->i_have_ended)
 		  continue;
 
@@ -3786,7 +4255,7 @@ bool of_JOIN_DETACH(vthread_t thr, vvp_code_t cp)
       assert(count == thr->children.size());
 
       while (! thr->children.empty()) {
-	    vthread_t child = *thr->children.begin();
+	    vthread_t child = thr->children.front();
 	    assert(child->parent == thr);
 
 	      // We cannot detach automatic tasks/functions within an
@@ -4011,12 +4480,12 @@ bool of_LOAD_VEC4A(vthread_t thr, vvp_code_t cp)
 	// value.
       if (thr->flags[4] == BIT4_1) {
 	    vvp_vector4_t tmp (cp->array->get_word_size(), BIT4_X);
-	    thr->push_vec4(tmp);
+	    thr->push_vec4(std::move(tmp));
 	    return true;
       }
 
       vvp_vector4_t tmp (cp->array->get_word(adr));
-      thr->push_vec4(tmp);
+      thr->push_vec4(std::move(tmp));
       return true;
 }
 
@@ -4494,14 +4963,8 @@ bool of_NAND(vthread_t thr, vvp_code_t)
       vvp_vector4_t valr = thr->pop_vec4();
       vvp_vector4_t&vall = thr->peek_vec4();
       assert(vall.size() == valr.size());
-      unsigned wid = vall.size();
-
-      for (unsigned idx = 0 ; idx < wid ; idx += 1) {
-	    vvp_bit4_t lb = vall.value(idx);
-	    vvp_bit4_t rb = valr.value(idx);
-	    vall.set_bit(idx, ~(lb&rb));
-      }
-
+      vall &= valr;
+      vall.invert();
       return true;
 }
 
@@ -4585,19 +5048,7 @@ bool of_NORR(vthread_t thr, vvp_code_t)
 {
       vvp_vector4_t val = thr->pop_vec4();
 
-      vvp_bit4_t lb = BIT4_1;
-
-      for (unsigned idx = 0 ;  idx < val.size() ;  idx += 1) {
-
-	    vvp_bit4_t rb = val.value(idx);
-	    if (rb == BIT4_1) {
-		  lb = BIT4_0;
-		  break;
-	    }
-
-	    if (rb != BIT4_0)
-		  lb = BIT4_X;
-      }
+      vvp_bit4_t lb = ~val.or_reduce();
 
       vvp_vector4_t res (1, lb);
       thr->push_vec4(res);
@@ -4622,18 +5073,7 @@ bool of_ANDR(vthread_t thr, vvp_code_t)
 {
       vvp_vector4_t val = thr->pop_vec4();
 
-      vvp_bit4_t lb = BIT4_1;
-
-      for (unsigned idx = 0 ; idx < val.size() ; idx += 1) {
-	    vvp_bit4_t rb = val.value(idx);
-	    if (rb == BIT4_0) {
-		  lb = BIT4_0;
-		  break;
-	    }
-
-	    if (rb != 1)
-		  lb = BIT4_X;
-      }
+      vvp_bit4_t lb = val.and_reduce();
 
       vvp_vector4_t res (1, lb);
       thr->push_vec4(res);
@@ -4648,18 +5088,7 @@ bool of_NANDR(vthread_t thr, vvp_code_t)
 {
       vvp_vector4_t val = thr->pop_vec4();
 
-      vvp_bit4_t lb = BIT4_0;
-      for (unsigned idx = 0 ; idx < val.size() ; idx += 1) {
-
-	    vvp_bit4_t rb = val.value(idx);
-	    if (rb == BIT4_0) {
-		  lb = BIT4_1;
-		  break;
-	    }
-
-	    if (rb != BIT4_1)
-		  lb = BIT4_X;
-      }
+      vvp_bit4_t lb = ~val.and_reduce();
 
       vvp_vector4_t res (1, lb);
       thr->push_vec4(res);
@@ -4674,17 +5103,7 @@ bool of_ORR(vthread_t thr, vvp_code_t)
 {
       vvp_vector4_t val = thr->pop_vec4();
 
-      vvp_bit4_t lb = BIT4_0;
-      for (unsigned idx = 0 ; idx < val.size() ; idx += 1) {
-	    vvp_bit4_t rb = val.value(idx);
-	    if (rb == BIT4_1) {
-		  lb = BIT4_1;
-		  break;
-	    }
-
-	    if (rb != BIT4_0)
-		  lb = BIT4_X;
-      }
+      vvp_bit4_t lb = val.or_reduce();
 
       vvp_vector4_t res (1, lb);
       thr->push_vec4(res);
@@ -4698,17 +5117,7 @@ bool of_XORR(vthread_t thr, vvp_code_t)
 {
       vvp_vector4_t val = thr->pop_vec4();
 
-      vvp_bit4_t lb = BIT4_0;
-      for (unsigned idx = 0 ; idx < val.size() ; idx += 1) {
-
-	    vvp_bit4_t rb = val.value(idx);
-	    if (rb == BIT4_1)
-		  lb = ~lb;
-	    else if (rb != BIT4_0) {
-		  lb = BIT4_X;
-		  break;
-	    }
-      }
+      vvp_bit4_t lb = val.xor_reduce();
 
       vvp_vector4_t res (1, lb);
       thr->push_vec4(res);
@@ -4722,17 +5131,7 @@ bool of_XNORR(vthread_t thr, vvp_code_t)
 {
       vvp_vector4_t val = thr->pop_vec4();
 
-      vvp_bit4_t lb = BIT4_1;
-      for (unsigned idx = 0 ; idx < val.size() ; idx += 1) {
-
-	    vvp_bit4_t rb = val.value(idx);
-	    if (rb == BIT4_1)
-		  lb = ~lb;
-	    else if (rb != BIT4_0) {
-		  lb = BIT4_X;
-		  break;
-	    }
-      }
+      vvp_bit4_t lb = ~val.xor_reduce();
 
       vvp_vector4_t res (1, lb);
       thr->push_vec4(res);
@@ -4758,14 +5157,8 @@ bool of_NOR(vthread_t thr, vvp_code_t)
       vvp_vector4_t valr = thr->pop_vec4();
       vvp_vector4_t&vall = thr->peek_vec4();
       assert(vall.size() == valr.size());
-      unsigned wid = vall.size();
-
-      for (unsigned idx = 0 ; idx < wid ; idx += 1) {
-	    vvp_bit4_t lb = vall.value(idx);
-	    vvp_bit4_t rb = valr.value(idx);
-	    vall.set_bit(idx, ~(lb|rb));
-      }
-
+      vall |= valr;
+      vall.invert();
       return true;
 }
 
@@ -5034,7 +5427,7 @@ bool of_PUSHI_VEC4(vthread_t thr, vvp_code_t cp)
       vvp_vector4_t val (wid, BIT4_0);
       get_immediate_rval (cp, val);
 
-      thr->push_vec4(val);
+      thr->push_vec4(std::move(val));
 
       return true;
 }
@@ -5364,7 +5757,7 @@ bool of_REPLICATE(vthread_t thr, vvp_code_t cp)
 	    res.set_vec(idx * val.size(), val);
       }
 
-      thr->push_vec4(res);
+      thr->push_vec4(std::move(res));
 
       return true;
 }
@@ -5687,7 +6080,7 @@ bool of_SHIFTR(vthread_t thr, vvp_code_t cp)
 	    val.set_vec(wid-shift, tmp);
       }
 
-      thr->push_vec4(val);
+      thr->push_vec4(std::move(val));
       return true;
 }
 
@@ -5717,7 +6110,7 @@ bool of_SHIFTR_S(vthread_t thr, vvp_code_t cp)
 	    val.set_vec(wid-shift, tmp);
       }
 
-      thr->push_vec4(val);
+      thr->push_vec4(std::move(val));
       return true;
 }
 
@@ -5738,7 +6131,7 @@ bool of_SPLIT_VEC4(vthread_t thr, vvp_code_t cp)
       vvp_vector4_t lsb = val.subvalue(0, lsb_wid);
       val = val.subvalue(lsb_wid, val.size()-lsb_wid);
 
-      thr->push_vec4(lsb);
+      thr->push_vec4(std::move(lsb));
       return true;
 }
 
@@ -6228,17 +6621,16 @@ bool of_STORE_STRA(vthread_t thr, vvp_code_t cp)
  * not consistent with the %store/vec4/<etc> instructions which have
  * no <wid>.
  */
-bool of_STORE_VEC4(vthread_t thr, vvp_code_t cp)
+static void do_STORE_VEC4(vthread_t thr, vvp_code_t cp,
+			  vvp_signal_value*sig, vvp_vector4_t&val)
 {
       vvp_net_ptr_t ptr(cp->net, 0);
-      vvp_signal_value*sig = dynamic_cast<vvp_signal_value*> (cp->net->fil);
       unsigned off_index = cp->bit_idx[0];
       unsigned int wid = cp->bit_idx[1];
 
       int64_t off = off_index ? thr->words[off_index].w_int : 0;
       unsigned int sig_value_size = sig->value_size();
 
-      vvp_vector4_t&val = thr->peek_vec4();
       unsigned val_size = val.size();
 
       if (val_size < wid) {
@@ -6253,21 +6645,22 @@ bool of_STORE_VEC4(vthread_t thr, vvp_code_t cp)
 
 	// If there is a problem loading the index register, flags-4
 	// will be set to 1, and we know here to skip the actual assignment.
-      if (off_index!=0 && thr->flags[4] == BIT4_1) {
-	    thr->pop_vec4(1);
-	    return true;
-      }
+      if (off_index!=0 && thr->flags[4] == BIT4_1)
+	    return;
 
-      if (!resize_rval_vec(val, off, sig_value_size)) {
-	    thr->pop_vec4(1);
-	    return true;
-      }
+      if (!resize_rval_vec(val, off, sig_value_size))
+	    return;
 
       if (off == 0 && val.size() == sig_value_size)
 	    vvp_send_vec4(ptr, val, thr->wt_context);
       else
 	    vvp_send_vec4_pv(ptr, val, off, sig_value_size, thr->wt_context);
+}
 
+bool of_STORE_VEC4(vthread_t thr, vvp_code_t cp)
+{
+      vvp_signal_value*sig = dynamic_cast<vvp_signal_value*> (cp->net->fil);
+      do_STORE_VEC4(thr, cp, sig, thr->peek_vec4());
       thr->pop_vec4(1);
       return true;
 }
@@ -6385,7 +6778,7 @@ bool of_SUBSTR_VEC4(vthread_t thr, vvp_code_t cp)
 
       if (sel < 0 || sel >= (int32_t)val.size()) {
 	    vvp_vector4_t res (wid, BIT4_0);
-	    thr->push_vec4(res);
+	    thr->push_vec4(std::move(res));
 	    return true;
       }
 
@@ -6398,7 +6791,7 @@ bool of_SUBSTR_VEC4(vthread_t thr, vvp_code_t cp)
 		  res.set_bit(idx, BIT4_1);
       }
 
-      thr->push_vec4(res);
+      thr->push_vec4(std::move(res));
       return true;
 }
 
@@ -6563,15 +6956,8 @@ bool of_XNOR(vthread_t thr, vvp_code_t)
       vvp_vector4_t valr = thr->pop_vec4();
       vvp_vector4_t&vall = thr->peek_vec4();
       assert(vall.size() == valr.size());
-      unsigned wid = vall.size();
-
-      for (unsigned idx = 0 ;  idx < wid ;  idx += 1) {
-
-	    vvp_bit4_t lb = vall.value(idx);
-	    vvp_bit4_t rb = valr.value(idx);
-	    vall.set_bit(idx, ~(lb ^ rb));
-      }
-
+      vall ^= valr;
+      vall.invert();
       return true;
 }
 
@@ -6583,15 +6969,7 @@ bool of_XOR(vthread_t thr, vvp_code_t)
       vvp_vector4_t valr = thr->pop_vec4();
       vvp_vector4_t&vall = thr->peek_vec4();
       assert(vall.size() == valr.size());
-      unsigned wid = vall.size();
-
-      for (unsigned idx = 0 ;  idx < wid ;  idx += 1) {
-
-	    vvp_bit4_t lb = vall.value(idx);
-	    vvp_bit4_t rb = valr.value(idx);
-	    vall.set_bit(idx, lb ^ rb);
-      }
-
+      vall ^= valr;
       return true;
 }
 
@@ -6716,3 +7094,266 @@ bool of_REAP_UFUNC(vthread_t thr, vvp_code_t cp)
 
       return true;
 }
+
+/*
+ * The fused instructions are created by the codespace_fuse() pass in
+ * codes.cc. Each replaces the %load/vec4 at the start of a sequence,
+ * and reads the operands of the rest of the sequence in place from
+ * the instructions that follow it.
+ */
+
+/*
+ * %load/vec4 <var>; %addi <imm>; %store/vec4 <var>, 0, <wid>
+ */
+bool of_FUSED_ADDI_VEC4(vthread_t thr, vvp_code_t cp)
+{
+      vvp_code_t imm = cp + 1;
+      vvp_signal_value*sig = dynamic_cast<vvp_signal_value*> (cp->net->fil);
+      assert(sig);
+
+      vvp_vector4_t val;
+      sig->vec4_value(val);
+
+      vvp_vector4_t r (imm->number, BIT4_0);
+      get_immediate_rval (imm, r);
+      val.add(r);
+
+      vvp_net_ptr_t ptr (cp->net, 0);
+      vvp_send_vec4(ptr, val, thr->wt_context);
+
+      thr->pc = cp + 3;
+      return true;
+}
+
+/*
+ * %load/vec4 <var>; %cmpi/<e|s|u> <imm>; %jmp/0xz <pc>, <flag>
+ * %load/vec4 <var>; %pushi/vec4 <imm>; %cmp/<e|s|u>; %jmp/0xz <pc>, <flag>
+ *
+ * The compare sets all the flags that the unfused compare would, in
+ * case they are used after the jump.
+ */
+static bool do_FUSED_CMP_JMP0XZ(vthread_t thr, vvp_code_t cp,
+				void (*cmp)(vthread_t, const vvp_vector4_t&,
+					    const vvp_vector4_t&))
+{
+      vvp_code_t imm = cp + 1;
+      vvp_code_t jmp = cp + cp->bit_idx[0];
+      vvp_signal_value*sig = dynamic_cast<vvp_signal_value*> (cp->net->fil);
+      assert(sig);
+
+      vvp_vector4_t lval;
+      sig->vec4_value(lval);
+
+      vvp_vector4_t rval (imm->number, BIT4_0);
+      get_immediate_rval (imm, rval);
+
+      cmp(thr, lval, rval);
+
+      if (thr->flags[jmp->bit_idx[0]] != BIT4_1)
+	    thr->pc = jmp->cptr;
+      else
+	    thr->pc = jmp + 1;
+
+	/* Like the %jmp instructions, give a $stop the chance to
+	   break out of a loop. */
+      if (schedule_stopped()) {
+	    schedule_vthread(thr, 0, false);
+	    return false;
+      }
+
+      return true;
+}
+
+bool of_FUSED_CMPIE_JMP0XZ(vthread_t thr, vvp_code_t cp)
+{
+      return do_FUSED_CMP_JMP0XZ(thr, cp, &do_CMPE);
+}
+
+bool of_FUSED_CMPIS_JMP0XZ(vthread_t thr, vvp_code_t cp)
+{
+      return do_FUSED_CMP_JMP0XZ(thr, cp, &do_CMPS);
+}
+
+bool of_FUSED_CMPIU_JMP0XZ(vthread_t thr, vvp_code_t cp)
+{
+      return do_FUSED_CMP_JMP0XZ(thr, cp, &do_CMPU);
+}
+
+/*
+ * These are for the native thread code. See vthread.h.
+ */
+bool vthread_native_load(vvp_signal_value*sig, uint64_t&val)
+{
+      vvp_vector4_t tmp;
+      sig->vec4_value(tmp);
+
+      unsigned long word;
+      if (! tmp.get_2state_word(word))
+	    return false;
+
+      val = word;
+      return true;
+}
+
+static vvp_vector4_t native_vector(uint64_t val, unsigned wid)
+{
+      vvp_vector4_t vec (wid, BIT4_0);
+      unsigned long tmp[1];
+      tmp[0] = val;
+      vec.setarray(0, wid, tmp);
+      return vec;
+}
+
+void vthread_native_store(vthread_t thr, vvp_code_t cp, vvp_signal_value*sig,
+			  uint64_t val, unsigned wid)
+{
+      vvp_vector4_t vec = native_vector(val, wid);
+      do_STORE_VEC4(thr, cp, sig, vec);
+}
+
+void vthread_native_push(vthread_t thr, uint64_t val, unsigned wid)
+{
+      thr->push_vec4(native_vector(val, wid));
+}
+
+void vthread_native_flags(vthread_t thr, unsigned mask, unsigned bits)
+{
+      for (unsigned idx = 0 ; mask >> idx ; idx += 1) {
+	    if (mask & (1U << idx))
+		  thr->flags[idx] = (bits & (1U << idx))? BIT4_1 : BIT4_0;
+      }
+}
+
+bool vthread_native_stopped(vthread_t thr)
+{
+      if (schedule_stopped()) {
+	    schedule_vthread(thr, 0, false);
+	    return true;
+      }
+
+      return false;
+}
+#ifdef VVP_THREADED_DISPATCH
+/*
+ * This is the direct threaded version of the thread engine. Every
+ * instruction carries in its dispatch member the address of a label
+ * in vthread_run_threaded_, and each label jumps straight to the
+ * label of the next instruction with a computed goto. That saves the
+ * indirect call and return of the function pointer dispatch, and
+ * gives each hot opcode its own indirect branch to predict.
+ *
+ * The opcodes listed here have labels of their own that call the
+ * opcode function directly. The compiler can see all those functions
+ * in this file, so it inlines the small ones into the engine. All
+ * the other opcodes share the op_CALL label, which calls through the
+ * opcode pointer as usual.
+ */
+# define VTHREAD_THREADED_OPCODES(X) \
+      X(ADD) X(ADDI) X(AND) X(ASSIGN_VEC4) X(CHUNK_LINK) \
+      X(CMPE) X(CMPIE) X(CMPIU) X(CMPS) X(CMPU) X(DELAY) \
+      X(DUP_VEC4) X(END) X(FLAG_MOV) X(FLAG_SET_IMM) X(FUSED_ADDI_VEC4) \
+      X(FUSED_CMPIE_JMP0XZ) X(FUSED_CMPIS_JMP0XZ) X(FUSED_CMPIU_JMP0XZ) X(IX_VEC4) \
+      X(JMP) X(JMP0) X(JMP0XZ) X(JMP1) X(JMP1XZ) X(LOAD_VEC4) \
+      X(OR) X(POP_VEC4) X(PUSHI_VEC4) X(STORE_VEC4) X(SUB) \
+      X(SUBI) X(WAIT) X(XOR)
+
+# define VTHREAD_THREADED_FUN_(op) &of_##op,
+static const vvp_code_fun threaded_funs[] = {
+      0,
+      VTHREAD_THREADED_OPCODES(VTHREAD_THREADED_FUN_)
+};
+# undef VTHREAD_THREADED_FUN_
+
+static const unsigned threaded_count = sizeof threaded_funs / sizeof threaded_funs[0];
+
+/*
+ * The labels of the engine, in the same order as threaded_funs. These
+ * are only visible inside the engine function, so it passes them out
+ * when called with the link_flag set.
+ */
+static const void*const*threaded_labels = 0;
+
+static void vthread_run_threaded_(vthread_t thr, bool link_flag)
+{
+# define VTHREAD_THREADED_LABEL_(op) &&op_##op,
+      static const void*const labels[] = {
+	    &&op_CALL,
+	    VTHREAD_THREADED_OPCODES(VTHREAD_THREADED_LABEL_)
+      };
+# undef VTHREAD_THREADED_LABEL_
+
+      if (link_flag) {
+	    assert(sizeof labels / sizeof labels[0] == threaded_count);
+	    threaded_labels = labels;
+	    return;
+      }
+
+      while (thr != 0) {
+	    vthread_t tmp = thr->wait_next;
+	    thr->wait_next = 0;
+
+	    assert(thr->is_scheduled);
+	    thr->is_scheduled = 0;
+
+            running_thread = thr;
+
+	    vvp_code_t cp;
+
+	      /* Fetch the next instruction, increment the PC, and jump
+		 to the label that executes it. If an opcode returns
+		 false, the thread is meant to be paused. */
+# define VTHREAD_THREADED_NEXT_ do { \
+	    cp = thr->pc; \
+	    thr->pc += 1; \
+	    goto *cp->dispatch; \
+      } while (0)
+
+	    VTHREAD_THREADED_NEXT_;
+
+	  op_CALL:
+	    if (! (cp->opcode)(thr, cp))
+		  goto paused;
+	    VTHREAD_THREADED_NEXT_;
+
+# define VTHREAD_THREADED_CASE_(op) \
+	  op_##op: \
+	    if (! of_##op(thr, cp)) \
+		  goto paused; \
+	    VTHREAD_THREADED_NEXT_;
+
+	    VTHREAD_THREADED_OPCODES(VTHREAD_THREADED_CASE_)
+
+# undef VTHREAD_THREADED_CASE_
+# undef VTHREAD_THREADED_NEXT_
+
+	  paused:
+	    thr = tmp;
+      }
+      running_thread = 0;
+}
+
+void vthread_run(vthread_t thr)
+{
+      if (profile_flag)
+	    vthread_run_profiled_(thr);
+      else
+	    vthread_run_threaded_(thr, false);
+}
+
+static void threaded_link_code(vvp_code_t code, void*)
+{
+      code->dispatch = threaded_labels[0];
+      for (unsigned idx = 1 ; idx < threaded_count ; idx += 1) {
+	    if (code->opcode == threaded_funs[idx]) {
+		  code->dispatch = threaded_labels[idx];
+		  break;
+	    }
+      }
+}
+
+void vthread_threaded_link(void)
+{
+      vthread_run_threaded_(0, true);
+      codespace_for_each(&threaded_link_code, 0);
+}
+#endif
@@ -37,6 +37,48 @@
 typedef struct vthread_s* vthread_t;
 typedef struct vvp_code_s*vvp_code_t;
 class __vpiScope;
+class vvp_signal_value;
+
+/*
+ * This is a list of threads that is linked through the threads
+ * themselves, so that adding and removing a thread never allocates.
+ * A thread can be in one sibling list (the children or detached
+ * children of its parent) and one scope list at a time, so each list
+ * is made with the link it uses. Threads are kept in the order they
+ * were inserted.
+ */
+class vthread_list_t {
+
+    public:
+      enum link_t { SIBLING = 0, SCOPE = 1, LINK_COUNT = 2 };
+
+      explicit vthread_list_t(link_t link);
+      ~vthread_list_t();
+
+      bool empty() const { return count_ == 0; }
+      size_t size() const { return count_; }
+      vthread_t front() const { return head_; }
+	// Return the thread after thr in this list, or nil.
+      vthread_t next(vthread_t thr) const;
+
+	// Add the thread to the end of the list.
+      void insert(vthread_t thr);
+	// Remove the thread from the list. Return the number of
+	// threads removed, which is 0 if thr was not in this list.
+      size_t erase(vthread_t thr);
+	// Unlink all the threads from the list.
+      void clear();
+
+    private:
+      link_t link_;
+      vthread_t head_;
+      vthread_t tail_;
+      size_t count_;
+
+    private: // Not implemented
+      vthread_list_t(const vthread_list_t&);
+      vthread_list_t& operator= (const vthread_list_t&);
+};
 
 /*
  * This creates a new simulation thread, with the given start
@@ -46,10 +88,17 @@ class __vpiScope;
 extern vthread_t vthread_new(vvp_code_t sa, __vpiScope*scope);
 
 /*
- * This function marks the thread as scheduled. It is used only by the
- * schedule_vthread function.
+ * This function marks the thread, and the threads listed after it, as
+ * scheduled, and returns the last thread of the list. It is used only
+ * by the schedule_vthread functions.
+ */
+extern vthread_t vthread_mark_scheduled(vthread_t thr);
+
+/*
+ * Add the list of threads to the end of the scheduled list that ends
+ * in tail, so that they run one after the other in one event.
  */
-extern void vthread_mark_scheduled(vthread_t thr);
+extern void vthread_append_list(vthread_t tail, vthread_t list);
 
 /*
  * This function marks the thread as being a final procedure.
@@ -70,6 +119,48 @@ extern void vthread_delay_delete();
  */
 extern void vthread_run(vthread_t thr);
 
+/*
+ * Get a reference to the program counter of the thread. This is for
+ * native thread code, which runs the instructions of a thread itself
+ * and so must keep the program counter up to date as it goes.
+ */
+extern vvp_code_t*vthread_pc_ref(vthread_t thr);
+
+/*
+ * Native thread code keeps vec4 values of up to a word in its own
+ * variables instead of on the thread stack, and the flags of the
+ * compares that it does itself in its own variables, as long as the
+ * values have no x or z bits. These do the parts of the instructions
+ * that it cannot do itself. The native code looks up the signal of
+ * each %load/vec4 and %store/vec4 once, when it is loaded, and passes
+ * it in as sig.
+ *
+ * vthread_native_load gets the value of the signal, or returns false
+ * if it does not fit in a word or has x or z bits.
+ * vthread_native_store does a %store/vec4 of the value of width
+ * wid. vthread_native_push puts a value that the native code kept
+ * onto the thread stack, and vthread_native_flags sets the flags in
+ * the mask to the matching bits of bits. vthread_native_stopped does
+ * the $stop check of the jump instructions, and returns true if the
+ * thread must stop running.
+ */
+extern bool vthread_native_load(vvp_signal_value*sig, uint64_t&val);
+extern void vthread_native_store(vthread_t thr, vvp_code_t cp,
+				 vvp_signal_value*sig,
+				 uint64_t val, unsigned wid);
+extern void vthread_native_push(vthread_t thr, uint64_t val, unsigned wid);
+extern void vthread_native_flags(vthread_t thr, unsigned mask, unsigned bits);
+extern bool vthread_native_stopped(vthread_t thr);
+
+#ifdef VVP_THREADED_DISPATCH
+/*
+ * Bind every instruction in the code space to its label in the
+ * threaded thread engine. This must be called after all the code is
+ * compiled, and before any thread is run.
+ */
+extern void vthread_threaded_link(void);
+#endif
+
 /*
  * This function schedules all the threads in the list to be scheduled
  * for execution with delay 0. The thr pointer is taken to be the head
@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "vvp_binary.h"
+# include  "parse_misc.h"
+# include  "compile.h"
+# include  "parse.h"
+# include  "version_base.h"
+# include  <map>
+# include  <string>
+# include  <vector>
+# include  <cstdio>
+# include  <cstdlib>
+# include  <cstring>
+# include  <cassert>
+# include  <fcntl.h>
+# include  <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+# include  <sys/mman.h>
+#endif
+#ifdef _MSC_VER
+# include  <io.h>
+#else
+# include  <unistd.h>
+#endif
+# include  "ivl_alloc.h"
+
+using namespace std;
+
+/*
+ * A binary design file is laid out like this, with all the header
+ * words 32bit little-endian:
+ *
+ *    "VVPB"          magic
+ *    version         binary_format_version
+ *    signature       parse_token_signature()
+ *    string count
+ *    offsets         file offset of the string offset table
+ *    strings         file offset of the string data
+ *    tokens          file offset of the token stream
+ *    token size      size in bytes of the token stream
+ *
+ * The string offset table has a 32bit offset into the string data for
+ * each string, and the string data is the nul terminated strings, so
+ * that strings can be used in place in the mapped file. String 0 is
+ * the version of the vvp that wrote the file.
+ *
+ * Each token in the stream is a token number, the count of lines since
+ * the previous token, then the value of the token if it has one. A
+ * number token has its value, a text token (label, symbol, instruction
+ * or string) has its string index and a vector token has its width and
+ * the string index of its bits. These are all written as variable
+ * length unsigned numbers, 7 bits to a byte, least significant first,
+ * with the top bit set on all but the last byte.
+ */
+
+const char*binary_output_path = 0;
+
+static const unsigned binary_format_version = 1;
+static const size_t binary_header_size = 32;
+
+/* These are for writing a binary file. */
+static FILE*out_fd = 0;
+static vector<unsigned char> out_tokens;
+static map<string,unsigned> out_string_map;
+static vector<const string*> out_strings;
+static unsigned out_line = 0;
+static size_t out_count = 0;
+
+/* These are for reading a binary file. */
+static const unsigned char*in_base = 0;
+static size_t in_size = 0;
+static bool in_mapped = false;
+static const unsigned char*in_ptr = 0;
+static const unsigned char*in_end = 0;
+static const unsigned char*in_offsets = 0;
+static const char*in_strings = 0;
+static size_t in_strings_size = 0;
+static unsigned in_string_count = 0;
+
+static void put_varint(vector<unsigned char>&buf, uint64_t val)
+{
+      while (val >= 0x80) {
+	    buf.push_back((val & 0x7f) | 0x80);
+	    val >>= 7;
+      }
+      buf.push_back(val);
+}
+
+static void put_u32(FILE*fd, unsigned long val)
+{
+      for (unsigned idx = 0 ; idx < 4 ; idx += 1) {
+	    fputc(val & 0xff, fd);
+	    val >>= 8;
+      }
+}
+
+static unsigned get_u32(const unsigned char*ptr)
+{
+      return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((unsigned)ptr[3] << 24);
+}
+
+static unsigned intern_string(const char*text)
+{
+      string key (text);
+      map<string,unsigned>::iterator cur = out_string_map.find(key);
+      if (cur != out_string_map.end())
+	    return cur->second;
+
+      unsigned idx = out_strings.size();
+      cur = out_string_map.insert(make_pair(key, idx)).first;
+      out_strings.push_back(&cur->first);
+      return idx;
+}
+
+void binary_output_open(void)
+{
+      if (binary_output_path == 0)
+	    return;
+
+      out_fd = fopen(binary_output_path, "wb");
+      if (out_fd == 0) {
+	    fprintf(stderr, "%s: Unable to open binary output file.\n",
+		    binary_output_path);
+	    compile_errors += 1;
+	    return;
+      }
+
+      out_line = yyline;
+      intern_string(VERSION);
+}
+
+static void record_token(int tok)
+{
+      put_varint(out_tokens, tok);
+      put_varint(out_tokens, yyline - out_line);
+      out_line = yyline;
+      out_count += 1;
+
+      switch (tok) {
+	  case T_NUMBER:
+	    put_varint(out_tokens, yylval.numb);
+	    break;
+	  case T_INSTR:
+	  case T_LABEL:
+	  case T_STRING:
+	  case T_SYMBOL:
+	    put_varint(out_tokens, intern_string(yylval.text));
+	    break;
+	  case T_VECTOR:
+	    put_varint(out_tokens, yylval.vect.idx);
+	    put_varint(out_tokens, intern_string(yylval.vect.text));
+	    break;
+	  default:
+	    break;
+      }
+}
+
+static void output_reset(void)
+{
+      out_fd = 0;
+      out_tokens.clear();
+      out_string_map.clear();
+      out_strings.clear();
+}
+
+void binary_output_close(bool keep)
+{
+      if (out_fd == 0)
+	    return;
+
+      if (! keep) {
+	    fclose(out_fd);
+	    remove(binary_output_path);
+	    output_reset();
+	    return;
+      }
+
+      unsigned long offsets = binary_header_size;
+      unsigned long strings = offsets + 4 * out_strings.size();
+      unsigned long tokens = strings;
+      for (size_t idx = 0 ; idx < out_strings.size() ; idx += 1)
+	    tokens += out_strings[idx]->size() + 1;
+
+      fwrite("VVPB", 1, 4, out_fd);
+      put_u32(out_fd, binary_format_version);
+      put_u32(out_fd, parse_token_signature());
+      put_u32(out_fd, out_strings.size());
+      put_u32(out_fd, offsets);
+      put_u32(out_fd, strings);
+      put_u32(out_fd, tokens);
+      put_u32(out_fd, out_tokens.size());
+
+      unsigned long pos = 0;
+      for (size_t idx = 0 ; idx < out_strings.size() ; idx += 1) {
+	    put_u32(out_fd, pos);
+	    pos += out_strings[idx]->size() + 1;
+      }
+      for (size_t idx = 0 ; idx < out_strings.size() ; idx += 1)
+	    fwrite(out_strings[idx]->c_str(), 1, out_strings[idx]->size() + 1,
+		   out_fd);
+      if (! out_tokens.empty())
+	    fwrite(&out_tokens[0], 1, out_tokens.size(), out_fd);
+
+      if (fclose(out_fd) != 0) {
+	    fprintf(stderr, "%s: Error writing binary output file.\n",
+		    binary_output_path);
+	    compile_errors += 1;
+      } else if (verbose_flag) {
+	    fprintf(stderr, " ... Wrote binary design (%zu tokens, %zu strings)"
+		    " to %s\n", out_count, out_strings.size(),
+		    binary_output_path);
+	    fflush(stderr);
+      }
+
+      output_reset();
+}
+
+static bool get_varint(uint64_t&val)
+{
+      val = 0;
+      for (unsigned shift = 0 ; in_ptr < in_end && shift < 64 ; shift += 7) {
+	    unsigned char byte = *in_ptr++;
+	    val |= (uint64_t)(byte & 0x7f) << shift;
+	    if ((byte & 0x80) == 0)
+		  return true;
+      }
+      return false;
+}
+
+static const char*get_string(void)
+{
+      uint64_t idx;
+      if (! get_varint(idx) || idx >= in_string_count)
+	    return 0;
+      unsigned long pos = get_u32(in_offsets + 4*idx);
+      if (pos >= in_strings_size)
+	    return 0;
+      return in_strings + pos;
+}
+
+static void unmap_input(void)
+{
+#ifdef HAVE_SYS_MMAN_H
+      if (in_mapped)
+	    munmap((void*)in_base, in_size);
+      else
+#endif
+	    free((void*)in_base);
+      in_base = 0;
+      in_size = 0;
+      in_mapped = false;
+}
+
+int binary_input_open(const char*path)
+{
+      int fd = open(path, O_RDONLY);
+      if (fd < 0)
+	    return 0;
+
+      struct stat sb;
+      char magic[4];
+      if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < binary_header_size
+	  || read(fd, magic, 4) != 4 || memcmp(magic, "VVPB", 4) != 0) {
+	    close(fd);
+	    return 0;
+      }
+
+      in_size = sb.st_size;
+#ifdef HAVE_SYS_MMAN_H
+      void*map = mmap(0, in_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map != MAP_FAILED) {
+	    in_base = (const unsigned char*)map;
+	    in_mapped = true;
+      }
+#endif
+      if (in_base == 0) {
+	    unsigned char*buf = (unsigned char*)malloc(in_size);
+	    if (lseek(fd, 0, SEEK_SET) == 0
+		&& (size_t)read(fd, buf, in_size) == in_size) {
+		  in_base = buf;
+	    } else {
+		  free(buf);
+	    }
+      }
+      close(fd);
+
+      if (in_base == 0) {
+	    fprintf(stderr, "%s: Unable to read binary design file.\n", path);
+	    in_size = 0;
+	    return -1;
+      }
+
+      unsigned version = get_u32(in_base + 4);
+      unsigned signature = get_u32(in_base + 8);
+      in_string_count = get_u32(in_base + 12);
+      unsigned long offsets = get_u32(in_base + 16);
+      unsigned long strings = get_u32(in_base + 20);
+      unsigned long tokens = get_u32(in_base + 24);
+      unsigned long token_size = get_u32(in_base + 28);
+
+      if (version != binary_format_version
+	  || signature != parse_token_signature()) {
+	    fprintf(stderr, "%s: Binary design file was not written by "
+		    "this version of vvp.\n", path);
+	    unmap_input();
+	    return -1;
+      }
+
+      bool ok = in_string_count > 0
+	    && offsets + 4UL*in_string_count <= strings
+	    && strings <= tokens
+	    && tokens + token_size <= in_size;
+      if (ok) {
+	    in_offsets = in_base + offsets;
+	    in_strings = (const char*)in_base + strings;
+	    in_strings_size = tokens - strings;
+	    ok = in_strings_size > 0 && in_strings[in_strings_size-1] == 0
+		  && get_u32(in_offsets) < in_strings_size;
+      }
+      if (! ok) {
+	    fprintf(stderr, "%s: Binary design file is corrupt.\n", path);
+	    unmap_input();
+	    return -1;
+      }
+
+	/* The token numbers can match across versions, so check the
+	   version of the vvp that wrote the file as well. */
+      if (strcmp(in_strings + get_u32(in_offsets), VERSION) != 0) {
+	    fprintf(stderr, "%s: Binary design file was written by vvp "
+		    "version %s.\n", path, in_strings + get_u32(in_offsets));
+	    unmap_input();
+	    return -1;
+      }
+
+      in_ptr = in_base + tokens;
+      in_end = in_ptr + token_size;
+      return 1;
+}
+
+void binary_input_close(void)
+{
+      unmap_input();
+      in_ptr = 0;
+      in_end = 0;
+}
+
+static int bad_token(void)
+{
+      yyerror("corrupt binary design file");
+      in_ptr = in_end;
+      return 0;
+}
+
+static int read_token(void)
+{
+      uint64_t tok, lines;
+      if (in_ptr >= in_end)
+	    return 0;
+      if (! get_varint(tok) || ! get_varint(lines))
+	    return bad_token();
+      yyline += lines;
+
+      const char*text;
+      switch (tok) {
+	  case T_NUMBER:
+	    if (! get_varint(yylval.numb))
+		  return bad_token();
+	    break;
+	  case T_INSTR:
+	  case T_LABEL:
+	  case T_SYMBOL:
+	    text = get_string();
+	    if (text == 0)
+		  return bad_token();
+	    yylval.text = strdup(text);
+	    break;
+	  case T_STRING:
+	      /* The lexor allocates strings with new[]. */
+	    text = get_string();
+	    if (text == 0)
+		  return bad_token();
+	    yylval.text = strcpy(new char [strlen(text)+1], text);
+	    break;
+	  case T_VECTOR: {
+		uint64_t wid;
+		if (! get_varint(wid))
+		      return bad_token();
+		text = get_string();
+		if (text == 0 || strlen(text) > wid + 1)
+		      return bad_token();
+		yylval.vect.idx = wid;
+		yylval.vect.text = (char*)malloc(wid + 2);
+		strcpy(yylval.vect.text, text);
+		break;
+	  }
+	  default:
+	    break;
+      }
+
+      return tok;
+}
+
+int binary_lex(void)
+{
+      if (in_base)
+	    return read_token();
+
+      int tok = yylex();
+      if (out_fd)
+	    record_token(tok);
+      return tok;
+}
@@ -0,0 +1,66 @@
+#ifndef IVL_vvp_binary_H
+#define IVL_vvp_binary_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The binary design format is the token stream of a text design file,
+ * as the lexor sees it, with all the strings interned in a table. vvp
+ * writes it while it reads a text design (the -B flag), and reads it
+ * in place of the text when it is given a binary file. The binary file
+ * is mapped into memory and the parser takes its tokens straight from
+ * the map, so loading it does no text scanning at all. The parser and
+ * the compiler handle the tokens as they would those of a text file,
+ * and look up the labels by name in the symbol tables.
+ *
+ * The token numbers are those of the vvp parser, so a binary file is
+ * only good for the version of vvp that wrote it. The file records
+ * the vvp version and a hash of the whole token table of the parser,
+ * and a vvp that does not match both rejects it.
+ *
+ * This is the path from the -B flag, or nil.
+ */
+extern const char*binary_output_path;
+
+/*
+ * Open the design file for the parser. If it is a binary file then
+ * map it and return 1. If it is not, return 0 and leave it to the
+ * caller to open it as text. Return -1 if the file is binary but
+ * cannot be used.
+ */
+extern int binary_input_open(const char*path);
+
+/*
+ * Start and finish writing the tokens of a text design to the
+ * binary_output_path file, if there is one. The file is only kept if
+ * the design parsed without errors.
+ */
+extern void binary_output_open(void);
+extern void binary_output_close(bool keep);
+
+extern void binary_input_close(void);
+
+/*
+ * The parser gets its tokens through this function. It reads them
+ * from the open binary file if there is one. Otherwise, it gets them
+ * from the text lexor, and records them if there is an output file.
+ */
+extern int binary_lex(void);
+
+#endif /* IVL_vvp_binary_H */
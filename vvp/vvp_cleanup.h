@@ -32,6 +32,7 @@ extern void island_delete(void);
 extern void vpi_mcd_delete(void);
 extern void load_module_delete(void);
 extern void modpath_delete(void);
+extern void native_delete(void);
 extern void root_table_delete(void);
 extern void schedule_delete(void);
 extern void signal_pool_delete(void);
@@ -41,6 +42,7 @@ extern void vpi_handle_delete(void);
 extern void vpi_stack_delete(void);
 extern void vvp_net_pool_delete(void);
 extern void ufunc_pool_delete(void);
+extern void vthread_pool_delete(void);
 
 extern void A_delete(class __vpiHandle *item);
 extern void APV_delete(class __vpiHandle *item);
@@ -23,8 +23,11 @@
 # include  "vvp_island.h"
 # include  "vpi_priv.h"
 # include  "resolv.h"
+# include  "fanout.h"
 # include  "schedule.h"
 # include  "statistics.h"
+# include  "slab.h"
+# include  "vvp_vector4_kernels.h"
 # include  <cstdio>
 # include  <cstring>
 # include  <cstdlib>
@@ -32,6 +35,8 @@
 # include  <typeinfo>
 # include  <climits>
 # include  <cmath>
+# include  <vector>
+# include  <algorithm>
 # include  <cassert>
 #ifdef CHECK_WITH_VALGRIND
 # include  <valgrind/memcheck.h>
@@ -59,10 +64,16 @@ static vvp_net_t **vvp_net_pool = NULL;
 static unsigned vvp_net_pool_count = 0;
 #endif
 static size_t vvp_net_alloc_remaining = 0;
+// Keep the chunks so that all the allocated vvp_nets can be visited.
+static vector<vvp_net_t*> vvp_net_chunks;
 // For statistics, count the vvp_nets allocated and the bytes of alloc
 // chunks allocated.
 unsigned long count_vvp_nets = 0;
 size_t size_vvp_nets = 0;
+  // Outputs that a vvp_send_cache_vec4 did not send, or that a part
+  // select or concatenation did not recompute, because they did not
+  // change.
+unsigned long count_unchanged_sends = 0;
 
 void* vvp_net_t::operator new (size_t size)
 {
@@ -70,6 +81,7 @@ void* vvp_net_t::operator new (size_t size)
       if (vvp_net_alloc_remaining == 0) {
 	    vvp_net_alloc_table = ::new vvp_net_t[VVP_NET_CHUNK];
 	    vvp_net_alloc_remaining = VVP_NET_CHUNK;
+	    vvp_net_chunks.push_back(vvp_net_alloc_table);
 	    size_vvp_nets += size*VVP_NET_CHUNK;
 #ifdef CHECK_WITH_VALGRIND
 	    VALGRIND_MAKE_MEM_NOACCESS(vvp_net_alloc_table, size*VVP_NET_CHUNK);
@@ -93,6 +105,65 @@ void* vvp_net_t::operator new (size_t size)
       return return_this;
 }
 
+void vvp_net_for_each(void (*fun)(vvp_net_t*net, void*cd), void*cd)
+{
+      for (size_t idx = 0 ; idx < vvp_net_chunks.size() ; idx += 1) {
+	    vvp_net_t*chunk = vvp_net_chunks[idx];
+	    size_t count = VVP_NET_CHUNK;
+	    if (idx+1 == vvp_net_chunks.size())
+		  count -= vvp_net_alloc_remaining;
+	    for (size_t ndx = 0 ; ndx < count ; ndx += 1)
+		  fun(chunk+ndx, cd);
+      }
+}
+
+size_t vvp_net_index(const vvp_net_t*net)
+{
+      for (size_t idx = 0 ; idx < vvp_net_chunks.size() ; idx += 1) {
+	    const vvp_net_t*chunk = vvp_net_chunks[idx];
+	    size_t count = VVP_NET_CHUNK;
+	    if (idx+1 == vvp_net_chunks.size())
+		  count -= vvp_net_alloc_remaining;
+	    if (net >= chunk && net < chunk+count)
+		  return idx*VVP_NET_CHUNK + (net-chunk);
+      }
+      return (size_t)-1;
+}
+
+vvp_net_t*vvp_net_at(size_t idx)
+{
+      size_t chunk = idx / VVP_NET_CHUNK;
+      size_t ndx = idx % VVP_NET_CHUNK;
+      if (chunk >= vvp_net_chunks.size())
+	    return 0;
+      if (chunk+1 == vvp_net_chunks.size()
+	  && ndx >= VVP_NET_CHUNK - vvp_net_alloc_remaining)
+	    return 0;
+      return vvp_net_chunks[chunk] + ndx;
+}
+
+static void vvp_net_table_collect_(vvp_net_t*net, void*cd)
+{
+      vector<vvp_net_t*>*nets = static_cast<vector<vvp_net_t*>*> (cd);
+      nets->push_back(net);
+}
+
+vvp_net_table_t::vvp_net_table_t()
+{
+      nets_.reserve(count_vvp_nets);
+      vvp_net_for_each(&vvp_net_table_collect_, &nets_);
+      sort(nets_.begin(), nets_.end());
+}
+
+size_t vvp_net_table_t::index(const vvp_net_t*net) const
+{
+      vector<vvp_net_t*>::const_iterator cur
+	    = lower_bound(nets_.begin(), nets_.end(), net);
+      if (cur == nets_.end() || *cur != net)
+	    return nets_.size();
+      return cur - nets_.begin();
+}
+
 #ifdef CHECK_WITH_VALGRIND
 static map<vvp_net_t*, bool> vvp_net_map;
 static map<sfunc_core*, bool> sfunc_map;
@@ -245,25 +316,19 @@ void vvp_net_t::unlink(vvp_net_ptr_t dst_ptr)
       vvp_net_t*net = dst_ptr.ptr();
       unsigned net_port = dst_ptr.port();
 
-      if (out_ == dst_ptr) {
-	      /* If the drive fan-out list starts with this pointer,
-		 then the unlink is easy. Pull the list forward. */
-	    out_ = net->port[net_port];
-      } else if (! out_.nil()) {
-	      /* Scan the linked list, looking for the net_ptr_t
-		 pointer *before* the one we wish to remove. */
-	    vvp_net_ptr_t cur = out_;
-	    assert(!cur.nil());
-	    vvp_net_t*cur_net = cur.ptr();
-	    unsigned cur_port = cur.port();
-	    while (cur_net && cur_net->port[cur_port] != dst_ptr) {
-		  cur = cur_net->port[cur_port];
-		  cur_net = cur.ptr();
-		  cur_port = cur.port();
-	    }
-	      /* Unlink. */
-	    if (cur_net) cur_net->port[cur_port] = net->port[net_port];
+	/* Scan the fan-out list for the link to the pointer, and pull
+	   the list forward past it. If the list ends in a flat fanout
+	   (see fanout.h), the pointer may be in the list behind that,
+	   so put that list back in its place and carry on. */
+      vvp_net_ptr_t*cur = &out_;
+      while (! cur->nil() && *cur != dst_ptr) {
+	    vvp_net_ptr_t*next = &cur->ptr()->port[cur->port()];
+	    if (next->nil() && fanout_expand(*cur))
+		  continue;
+	    cur = next;
       }
+      if (! cur->nil())
+	    *cur = net->port[net_port];
 
       net->port[net_port] = vvp_net_ptr_t(0,0);
 }
@@ -591,8 +656,11 @@ void vvp_send_vec8(vvp_net_ptr_t ptr, const vvp_vector8_t&val)
       while (vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next_val = cur->port[ptr.port()];
 
-	    if (cur->fun)
+	    if (cur->fun) {
+		  if (profile_flag)
+			profile_recv(cur->fun);
 		  cur->fun->recv_vec8(ptr, val);
+	    }
 
 	    ptr = next_val;
       }
@@ -603,8 +671,11 @@ void vvp_send_real(vvp_net_ptr_t ptr, double val, vvp_context_t context)
       while (vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next_val = cur->port[ptr.port()];
 
-	    if (cur->fun)
+	    if (cur->fun) {
+		  if (profile_flag)
+			profile_recv(cur->fun);
 		  cur->fun->recv_real(ptr, val, context);
+	    }
 
 	    ptr = next_val;
       }
@@ -694,6 +765,41 @@ void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
       }
 }
 
+/*
+ * The word arrays for vectors of up to SMALL_WORDS words are all
+ * allocated at the same size and recycled through a slab free list.
+ * Wide datapaths pop, copy and drop such vectors constantly, so this
+ * keeps the heap out of the thread stack and propagation paths. When
+ * checking with valgrind, use the heap so that leaks can be tracked.
+ */
+#ifndef CHECK_WITH_VALGRIND
+static const size_t VECTOR4_WORDS_SLAB = 2*4*sizeof(unsigned long);
+static const size_t VECTOR4_WORDS_CHUNK_COUNT = 8192 / VECTOR4_WORDS_SLAB;
+static slab_t<VECTOR4_WORDS_SLAB,VECTOR4_WORDS_CHUNK_COUNT> vector4_words_heap;
+#endif
+
+unsigned long* vvp_vector4_t::alloc_words_(unsigned cnt)
+{
+#ifndef CHECK_WITH_VALGRIND
+      static_assert(VECTOR4_WORDS_SLAB == 2*SMALL_WORDS*sizeof(unsigned long),
+		    "vector4 word slabs do not match SMALL_WORDS");
+      if (cnt <= SMALL_WORDS)
+	    return static_cast<unsigned long*> (vector4_words_heap.alloc_slab());
+#endif
+      return new unsigned long[2*cnt];
+}
+
+void vvp_vector4_t::free_words_(unsigned long*bits, unsigned cnt)
+{
+#ifndef CHECK_WITH_VALGRIND
+      if (cnt <= SMALL_WORDS) {
+	    vector4_words_heap.free_slab(bits);
+	    return;
+      }
+#endif
+      delete[]bits;
+}
+
 /*
  * This function should ONLY BE CALLED FROM vvp_vector4_t::copy_from_,
  * as it performs part of that functions tasks.
@@ -701,7 +807,7 @@ void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
 void vvp_vector4_t::copy_from_big_(const vvp_vector4_t&that)
 {
       unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
-      abits_ptr_ = new unsigned long[2*words];
+      abits_ptr_ = alloc_words_(words);
       bbits_ptr_ = abits_ptr_ + words;
 
       for (unsigned idx = 0 ;  idx < words ;  idx += 1)
@@ -720,7 +826,7 @@ void vvp_vector4_t::copy_inverted_from_(const vvp_vector4_t&that)
       size_ = that.size_;
       if (size_ > BITS_PER_WORD) {
 	    unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
-	    abits_ptr_ = new unsigned long[2*words];
+	    abits_ptr_ = alloc_words_(words);
 	    bbits_ptr_ = abits_ptr_ + words;
 
 	    unsigned remaining = size_;
@@ -750,7 +856,7 @@ void vvp_vector4_t::allocate_words_(unsigned long inita, unsigned long initb)
 {
       if (size_ > BITS_PER_WORD) {
 	    unsigned cnt = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
-	    abits_ptr_ = new unsigned long[2*cnt];
+	    abits_ptr_ = alloc_words_(cnt);
 	    bbits_ptr_ = abits_ptr_ + cnt;
 	    for (unsigned idx = 0 ;  idx < cnt ;  idx += 1)
 		  abits_ptr_[idx] = inita;
@@ -874,6 +980,21 @@ vvp_vector4_t::vvp_vector4_t(const vvp_vector4_t&that,
 	    unsigned long lmask = (1UL << off) - 1UL;
 	    unsigned trans = 0;
 	    unsigned dst = 0;
+
+	      /* Let a kernel do all but the last destination word of
+		 long unaligned parts. Those words are all made from
+		 two neighbouring source words. */
+	    unsigned full = (wid - 1) / BITS_PER_WORD;
+	    if (off != 0 && full >= VVP_VECTOR4_KERNEL_WORDS) {
+		  vvp_vector4_kernels.funnel_words(abits_ptr_, that.abits_ptr_+ptr,
+						   full, off);
+		  vvp_vector4_kernels.funnel_words(bbits_ptr_, that.bbits_ptr_+ptr,
+						   full, off);
+		  ptr += full;
+		  dst += full;
+		  trans += full * BITS_PER_WORD;
+	    }
+
 	    while (trans < wid) {
 		    // The low bits of the result.
 		  abits_ptr_[dst] = (that.abits_ptr_[ptr] & ~lmask) >> off;
@@ -1000,7 +1121,7 @@ void vvp_vector4_t::resize(unsigned newsize, vvp_bit4_t pad_bit)
 		  return;
 	    }
 
-	    unsigned long*newbits = new unsigned long[2*newcnt];
+	    unsigned long*newbits = alloc_words_(newcnt);
 
 	    if (cnt > 1) {
 		  unsigned trans = cnt;
@@ -1012,7 +1133,7 @@ void vvp_vector4_t::resize(unsigned newsize, vvp_bit4_t pad_bit)
 		  for (unsigned idx = 0 ;  idx < trans ;  idx += 1)
 			newbits[newcnt+idx] = bbits_ptr_[idx];
 
-		  delete[]abits_ptr_;
+		  free_words_(abits_ptr_, cnt);
 
 	    } else {
 		  newbits[0] = abits_val_;
@@ -1040,7 +1161,7 @@ void vvp_vector4_t::resize(unsigned newsize, vvp_bit4_t pad_bit)
 	    if (cnt > 1) {
 		  unsigned long newvala = abits_ptr_[0];
 		  unsigned long newvalb = bbits_ptr_[0];
-		  delete[]abits_ptr_;
+		  free_words_(abits_ptr_, cnt);
 		  abits_val_ = newvala;
 		  bbits_val_ = newvalb;
 	    }
@@ -1135,6 +1256,30 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid, bool xz_to_0)
       return 0;
 }
 
+void vvp_vector4_t::get_words(unsigned long*abits, unsigned long*bbits) const
+{
+      if (size_ == 0)
+	    return;
+
+      unsigned cnt = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+      if (size_ <= BITS_PER_WORD) {
+	    abits[0] = abits_val_;
+	    bbits[0] = bbits_val_;
+      } else {
+	    for (unsigned idx = 0 ;  idx < cnt ;  idx += 1) {
+		  abits[idx] = abits_ptr_[idx];
+		  bbits[idx] = bbits_ptr_[idx];
+	    }
+      }
+
+      unsigned tail = size_ % BITS_PER_WORD;
+      if (tail != 0) {
+	    unsigned long mask = (1UL << tail) - 1UL;
+	    abits[cnt-1] &= mask;
+	    bbits[cnt-1] &= mask;
+      }
+}
+
 void vvp_vector4_t::setarray(unsigned adr, unsigned wid, const unsigned long*val)
 {
       assert(adr+wid <= size_);
@@ -1298,6 +1443,16 @@ bool vvp_vector4_t::set_vec(unsigned adr, const vvp_vector4_t&that)
 	    unsigned remain = that.size_;
 	    unsigned sptr = 0;
 	    unsigned dptr = adr / BITS_PER_WORD;
+	    if (remain / BITS_PER_WORD >= VVP_VECTOR4_KERNEL_WORDS) {
+		  unsigned full = remain / BITS_PER_WORD;
+		  if (vvp_vector4_kernels.copy_words(abits_ptr_+dptr, that.abits_ptr_, full))
+			diff_flag = true;
+		  if (vvp_vector4_kernels.copy_words(bbits_ptr_+dptr, that.bbits_ptr_, full))
+			diff_flag = true;
+		  dptr += full;
+		  sptr += full;
+		  remain -= full * BITS_PER_WORD;
+	    }
 	    while (remain >= BITS_PER_WORD) {
 		  if (abits_ptr_[dptr] != that.abits_ptr_[sptr]) {
 			diff_flag = true;
@@ -1339,6 +1494,24 @@ bool vvp_vector4_t::set_vec(unsigned adr, const vvp_vector4_t&that)
 	    unsigned doff = adr % BITS_PER_WORD;
 	    unsigned long lmask = (1UL << doff) - 1;
 	    unsigned ndoff = BITS_PER_WORD - doff;
+
+	      /* For long runs, a kernel fills the destination words
+		 that are made entirely of two neighbouring source
+		 words. The loop then only does the first and last
+		 source words, which share destination words with
+		 bits that are not being replaced. That leaves the
+		 kernel full-1 words to do. */
+	    unsigned full = remain / BITS_PER_WORD;
+	    bool use_kernel = full >= VVP_VECTOR4_KERNEL_WORDS + 1;
+	    if (use_kernel) {
+		  if (vvp_vector4_kernels.funnel_words(abits_ptr_+dptr+1, that.abits_ptr_,
+						       full-1, ndoff))
+			diff_flag = true;
+		  if (vvp_vector4_kernels.funnel_words(bbits_ptr_+dptr+1, that.bbits_ptr_,
+						       full-1, ndoff))
+			diff_flag = true;
+	    }
+
 	    while (remain >= BITS_PER_WORD) {
 		  unsigned long tmp;
 
@@ -1367,6 +1540,12 @@ bool vvp_vector4_t::set_vec(unsigned adr, const vvp_vector4_t&that)
 
 		  remain -= BITS_PER_WORD;
 		  sptr += 1;
+
+		  if (use_kernel && sptr == 1) {
+			sptr = full - 1;
+			dptr += full - 2;
+			remain -= (full - 2) * BITS_PER_WORD;
+		  }
 	    }
 
 	    if (remain > 0) {
@@ -1731,11 +1910,18 @@ bool vvp_vector4_t::eeq(const vvp_vector4_t&that) const
       }
 
       unsigned words = size_ / BITS_PER_WORD;
-      for (unsigned idx = 0 ;  idx < words ;  idx += 1) {
-	    if (abits_ptr_[idx] != that.abits_ptr_[idx])
+      if (words >= VVP_VECTOR4_KERNEL_WORDS) {
+	    if (! vvp_vector4_kernels.equal_words(abits_ptr_, that.abits_ptr_, words))
 		  return false;
-	    if (bbits_ptr_[idx] != that.bbits_ptr_[idx])
+	    if (! vvp_vector4_kernels.equal_words(bbits_ptr_, that.bbits_ptr_, words))
 		  return false;
+      } else {
+	    for (unsigned idx = 0 ;  idx < words ;  idx += 1) {
+		  if (abits_ptr_[idx] != that.abits_ptr_[idx])
+			return false;
+		  if (bbits_ptr_[idx] != that.bbits_ptr_[idx])
+			return false;
+	    }
       }
 
       unsigned long mask = size_%BITS_PER_WORD;
@@ -1794,9 +1980,14 @@ bool vvp_vector4_t::has_xz() const
       }
 
       unsigned words = size_ / BITS_PER_WORD;
-      for (unsigned idx = 0 ; idx < words ; idx += 1) {
-	    if (bbits_ptr_[idx])
+      if (words >= VVP_VECTOR4_KERNEL_WORDS) {
+	    if (vvp_vector4_kernels.any_words(bbits_ptr_, words))
 		  return true;
+      } else {
+	    for (unsigned idx = 0 ; idx < words ; idx += 1) {
+		  if (bbits_ptr_[idx])
+			return true;
+	    }
       }
 
       unsigned long mask = size_%BITS_PER_WORD;
@@ -1808,6 +1999,105 @@ bool vvp_vector4_t::has_xz() const
       return false;
 }
 
+/*
+ * The reductions look at whole words at a time. The and reduction is
+ * BIT4_0 if there is any 0 bit, otherwise BIT4_X if there are any X/Z
+ * bits, otherwise BIT4_1. The or reduction is the same with the roles
+ * of 0 and 1 swapped. The xor reduction is BIT4_X if there are any
+ * X/Z bits, otherwise the parity of the abits.
+ */
+vvp_bit4_t vvp_vector4_t::and_reduce() const
+{
+      if (size_ <= BITS_PER_WORD) {
+	    if (size_ == 0)
+		  return BIT4_1;
+	    unsigned long mask = -1UL >> (BITS_PER_WORD - size_);
+	    if (~(abits_val_ | bbits_val_) & mask)
+		  return BIT4_0;
+	    return (bbits_val_ & mask)? BIT4_X : BIT4_1;
+      }
+
+      unsigned words = size_ / BITS_PER_WORD;
+      unsigned long mask = size_ % BITS_PER_WORD;
+      if (mask > 0)
+	    mask = -1UL >> (BITS_PER_WORD - mask);
+
+      if (words >= VVP_VECTOR4_KERNEL_WORDS) {
+	    if (vvp_vector4_kernels.any_zero_words(abits_ptr_, bbits_ptr_, words))
+		  return BIT4_0;
+      } else {
+	    for (unsigned idx = 0 ; idx < words ; idx += 1) {
+		  if (~(abits_ptr_[idx] | bbits_ptr_[idx]))
+			return BIT4_0;
+	    }
+      }
+      if (mask && (~(abits_ptr_[words] | bbits_ptr_[words]) & mask))
+	    return BIT4_0;
+
+      return has_xz()? BIT4_X : BIT4_1;
+}
+
+vvp_bit4_t vvp_vector4_t::or_reduce() const
+{
+      if (size_ <= BITS_PER_WORD) {
+	    if (size_ == 0)
+		  return BIT4_0;
+	    unsigned long mask = -1UL >> (BITS_PER_WORD - size_);
+	    if (abits_val_ & ~bbits_val_ & mask)
+		  return BIT4_1;
+	    return (bbits_val_ & mask)? BIT4_X : BIT4_0;
+      }
+
+      unsigned words = size_ / BITS_PER_WORD;
+      unsigned long mask = size_ % BITS_PER_WORD;
+      if (mask > 0)
+	    mask = -1UL >> (BITS_PER_WORD - mask);
+
+      if (words >= VVP_VECTOR4_KERNEL_WORDS) {
+	    if (vvp_vector4_kernels.any_one_words(abits_ptr_, bbits_ptr_, words))
+		  return BIT4_1;
+      } else {
+	    for (unsigned idx = 0 ; idx < words ; idx += 1) {
+		  if (abits_ptr_[idx] & ~bbits_ptr_[idx])
+			return BIT4_1;
+	    }
+      }
+      if (mask && (abits_ptr_[words] & ~bbits_ptr_[words] & mask))
+	    return BIT4_1;
+
+      return has_xz()? BIT4_X : BIT4_0;
+}
+
+vvp_bit4_t vvp_vector4_t::xor_reduce() const
+{
+      if (has_xz())
+	    return BIT4_X;
+
+      unsigned long acc;
+      if (size_ <= BITS_PER_WORD) {
+	    if (size_ == 0)
+		  return BIT4_0;
+	    acc = abits_val_ & (-1UL >> (BITS_PER_WORD - size_));
+
+      } else {
+	    unsigned words = size_ / BITS_PER_WORD;
+	    if (words >= VVP_VECTOR4_KERNEL_WORDS) {
+		  acc = vvp_vector4_kernels.xor_fold_words(abits_ptr_, words);
+	    } else {
+		  acc = 0;
+		  for (unsigned idx = 0 ; idx < words ; idx += 1)
+			acc ^= abits_ptr_[idx];
+	    }
+	    if (unsigned tail = size_ % BITS_PER_WORD)
+		  acc ^= abits_ptr_[words] & (-1UL >> (BITS_PER_WORD - tail));
+      }
+
+      for (unsigned shift = BITS_PER_WORD/2 ; shift > 0 ; shift /= 2)
+	    acc ^= acc >> shift;
+
+      return (acc & 1)? BIT4_1 : BIT4_0;
+}
+
 void vvp_vector4_t::change_z2x()
 {
 	// This method relies on the fact that both BIT4_X and BIT4_Z
@@ -1825,6 +2115,24 @@ void vvp_vector4_t::change_z2x()
       }
 }
 
+void vvp_vector4_t::cast2()
+{
+	// The X and Z bits are the ones with the bbit set. Clearing
+	// their abits and then all the bbits makes them BIT4_0 and
+	// leaves the BIT4_0 and BIT4_1 bits alone.
+
+      if (size_ <= BITS_PER_WORD) {
+	    abits_val_ &= ~bbits_val_;
+	    bbits_val_ = 0;
+      } else {
+	    unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
+	    for (unsigned idx = 0 ;  idx < words ;  idx += 1) {
+		  abits_ptr_[idx] &= ~bbits_ptr_[idx];
+		  bbits_ptr_[idx] = 0;
+	    }
+      }
+}
+
 void vvp_vector4_t::fill_bits(vvp_bit4_t bit)
 {
 	/* note: this relies on the bit encoding for the vvp_bit4_t. */
@@ -1890,6 +2198,11 @@ void vvp_vector4_t::invert()
       } else {
 	    unsigned remaining = size_;
 	    unsigned idx = 0;
+	    if (size_ / BITS_PER_WORD >= VVP_VECTOR4_KERNEL_WORDS) {
+		  idx = size_ / BITS_PER_WORD;
+		  vvp_vector4_kernels.invert_words(abits_ptr_, bbits_ptr_, idx);
+		  remaining -= idx * BITS_PER_WORD;
+	    }
 	    while (remaining >= BITS_PER_WORD) {
 		  abits_ptr_[idx] = ~abits_ptr_[idx];
 		  abits_ptr_[idx] |= bbits_ptr_[idx];
@@ -1917,6 +2230,10 @@ vvp_vector4_t& vvp_vector4_t::operator &= (const vvp_vector4_t&that)
 	    unsigned long tmp2 = that.abits_val_ | that.bbits_val_;
 	    abits_val_ = tmp1 & tmp2;
 	    bbits_val_ = (tmp1 & that.bbits_val_) | (tmp2 & bbits_val_);
+      } else if (size_ >= VVP_VECTOR4_KERNEL_WORDS*BITS_PER_WORD) {
+	    unsigned words = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	    vvp_vector4_kernels.and_words(abits_ptr_, bbits_ptr_,
+					  that.abits_ptr_, that.bbits_ptr_, words);
       } else {
 	    unsigned words = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
 	    for (unsigned idx = 0; idx < words ; idx += 1) {
@@ -1947,6 +2264,10 @@ vvp_vector4_t& vvp_vector4_t::operator |= (const vvp_vector4_t&that)
 	                 ((~that.abits_val_ | that.bbits_val_) & bbits_val_);
 	    abits_val_ = tmp;
 
+      } else if (size_ >= VVP_VECTOR4_KERNEL_WORDS*BITS_PER_WORD) {
+	    unsigned words = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	    vvp_vector4_kernels.or_words(abits_ptr_, bbits_ptr_,
+					 that.abits_ptr_, that.bbits_ptr_, words);
       } else {
 	    unsigned words = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
 	    for (unsigned idx = 0; idx < words ; idx += 1) {
@@ -1963,6 +2284,33 @@ vvp_vector4_t& vvp_vector4_t::operator |= (const vvp_vector4_t&that)
       return *this;
 }
 
+vvp_vector4_t& vvp_vector4_t::operator ^= (const vvp_vector4_t&that)
+{
+	// Any X or Z in either operand makes an X result, otherwise
+	// the result is the exclusive OR of the abits. If neither
+	// operand has any bbits set, this reduces to a plain two-state
+	// XOR of the abits.
+      if (size_ <= BITS_PER_WORD) {
+	    unsigned long xz = bbits_val_ | that.bbits_val_;
+	    abits_val_ = (abits_val_ ^ that.abits_val_) | xz;
+	    bbits_val_ = xz;
+
+      } else if (size_ >= VVP_VECTOR4_KERNEL_WORDS*BITS_PER_WORD) {
+	    unsigned words = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	    vvp_vector4_kernels.xor_words(abits_ptr_, bbits_ptr_,
+					  that.abits_ptr_, that.bbits_ptr_, words);
+      } else {
+	    unsigned words = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	    for (unsigned idx = 0; idx < words ; idx += 1) {
+		  unsigned long xz = bbits_ptr_[idx] | that.bbits_ptr_[idx];
+		  abits_ptr_[idx] = (abits_ptr_[idx] ^ that.abits_ptr_[idx]) | xz;
+		  bbits_ptr_[idx] = xz;
+	    }
+      }
+
+      return *this;
+}
+
 /*
 * Add an integer to the vvp_vector4_t in place, bit by bit so that
 * there is no size limitations.
@@ -2168,6 +2516,11 @@ vvp_vector4array_t::~vvp_vector4array_t()
 {
 }
 
+unsigned vvp_vector4array_t::next_stored(unsigned idx) const
+{
+      return idx;
+}
+
 void vvp_vector4array_t::set_word_(v4cell*cell, const vvp_vector4_t&that)
 {
       assert(that.size_ == width_);
@@ -2266,6 +2619,161 @@ vvp_vector4_t vvp_vector4array_sa::get_word(unsigned index) const
       return get_word_(cell);
 }
 
+template <class WORD, bool TWO_STATE>
+vvp_vector4array_packed<WORD,TWO_STATE>::vvp_vector4array_packed(unsigned width__,
+								 unsigned words__)
+: vvp_vector4array_t(width__, words__)
+{
+      assert(width_ <= 8*sizeof(WORD));
+
+      abits_ = new WORD[words_];
+      bbits_ = TWO_STATE? 0 : new WORD[words_];
+
+      WORD init = TWO_STATE? 0 : ~(WORD)0;
+      for (unsigned idx = 0 ; idx < words_ ; idx += 1)
+	    abits_[idx] = init;
+      for (unsigned idx = 0 ; idx < words_ && bbits_ ; idx += 1)
+	    bbits_[idx] = init;
+}
+
+template <class WORD, bool TWO_STATE>
+vvp_vector4array_packed<WORD,TWO_STATE>::~vvp_vector4array_packed()
+{
+      delete[]abits_;
+      delete[]bbits_;
+}
+
+template <class WORD, bool TWO_STATE>
+void vvp_vector4array_packed<WORD,TWO_STATE>::set_word(unsigned index,
+							const vvp_vector4_t&that)
+{
+      assert(index < words_);
+      assert(that.size_ == width_);
+
+      if (TWO_STATE) {
+	      // A 1 bit is an a bit without a b bit, everything else is 0.
+	    abits_[index] = that.abits_val_ & ~that.bbits_val_;
+      } else {
+	    abits_[index] = that.abits_val_;
+	    bbits_[index] = that.bbits_val_;
+      }
+}
+
+template <class WORD, bool TWO_STATE>
+vvp_vector4_t vvp_vector4array_packed<WORD,TWO_STATE>::get_word(unsigned index) const
+{
+      if (index >= words_)
+	    return vvp_vector4_t(width_, BIT4_X);
+
+      vvp_vector4_t res;
+      res.size_ = width_;
+      res.abits_val_ = abits_[index];
+      res.bbits_val_ = TWO_STATE? 0 : bbits_[index];
+      return res;
+}
+
+template class vvp_vector4array_packed<uint8_t,false>;
+template class vvp_vector4array_packed<uint16_t,false>;
+template class vvp_vector4array_packed<uint32_t,false>;
+template class vvp_vector4array_packed<uint8_t,true>;
+template class vvp_vector4array_packed<uint16_t,true>;
+template class vvp_vector4array_packed<uint32_t,true>;
+template class vvp_vector4array_packed<unsigned long,true>;
+
+vvp_vector4array_sparse::vvp_vector4array_sparse(unsigned width__, unsigned words__,
+						 bool two_state)
+: vvp_vector4array_t(width__, words__), two_state_(two_state), pages_used_(0)
+{
+      unsigned npages = page_count_();
+      pages_ = new v4cell*[npages];
+      for (unsigned idx = 0 ; idx < npages ; idx += 1)
+	    pages_[idx] = 0;
+}
+
+vvp_vector4array_sparse::~vvp_vector4array_sparse()
+{
+      unsigned npages = page_count_();
+      for (unsigned pdx = 0 ; pdx < npages ; pdx += 1) {
+	    v4cell*page = pages_[pdx];
+	    if (page == 0)
+		  continue;
+	    if (width_ > vvp_vector4_t::BITS_PER_WORD) {
+		  for (unsigned idx = 0 ; idx < PAGE_WORDS ; idx += 1)
+			delete[]page[idx].abits_ptr_;
+	    }
+	    delete[]page;
+      }
+      delete[]pages_;
+}
+
+void vvp_vector4array_sparse::set_word(unsigned index, const vvp_vector4_t&that)
+{
+      assert(index < words_);
+
+      v4cell*&page = pages_[index >> PAGE_BITS];
+      if (page == 0) {
+	    page = new v4cell[PAGE_WORDS];
+	    pages_used_ += 1;
+
+	      // Wide words get their bits when first written. Narrow
+	      // words hold the value that an untouched word reads as.
+	    unsigned long abits = 0, bbits = 0;
+	    if (width_ <= vvp_vector4_t::BITS_PER_WORD && ! two_state_) {
+		  abits = vvp_vector4_t::WORD_X_ABITS;
+		  bbits = vvp_vector4_t::WORD_X_BBITS;
+	    }
+	    for (unsigned idx = 0 ; idx < PAGE_WORDS ; idx += 1) {
+		  page[idx].abits_val_ = abits;
+		  page[idx].bbits_val_ = bbits;
+	    }
+      }
+
+      v4cell*cell = &page[index & (PAGE_WORDS-1)];
+      set_word_(cell, that);
+
+      if (! two_state_)
+	    return;
+
+	// A 1 bit is an a bit without a b bit, everything else is 0.
+      if (width_ <= vvp_vector4_t::BITS_PER_WORD) {
+	    cell->abits_val_ &= ~cell->bbits_val_;
+	    cell->bbits_val_ = 0;
+	    return;
+      }
+
+      unsigned cnt = (width_ + vvp_vector4_t::BITS_PER_WORD-1)/vvp_vector4_t::BITS_PER_WORD;
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1) {
+	    cell->abits_ptr_[idx] &= ~cell->bbits_ptr_[idx];
+	    cell->bbits_ptr_[idx] = 0;
+      }
+}
+
+vvp_vector4_t vvp_vector4array_sparse::get_word(unsigned index) const
+{
+      if (index >= words_)
+	    return vvp_vector4_t(width_, BIT4_X);
+
+      v4cell*page = pages_[index >> PAGE_BITS];
+      v4cell*cell = page? &page[index & (PAGE_WORDS-1)] : 0;
+
+      if (cell && (width_ <= vvp_vector4_t::BITS_PER_WORD || cell->abits_ptr_))
+	    return get_word_(cell);
+
+      return vvp_vector4_t(width_, two_state_? BIT4_0 : BIT4_X);
+}
+
+unsigned vvp_vector4array_sparse::next_stored(unsigned index) const
+{
+      unsigned npages = page_count_();
+      for (unsigned pdx = index >> PAGE_BITS ; pdx < npages ; pdx += 1) {
+	    if (pages_[pdx] == 0)
+		  continue;
+	    unsigned first = pdx << PAGE_BITS;
+	    return index > first? index : first;
+      }
+      return words_;
+}
+
 vvp_vector4array_aa::vvp_vector4array_aa(unsigned width__, unsigned words__)
 : vvp_vector4array_t(width__, words__)
 {
@@ -3347,6 +3855,20 @@ void vvp_net_fun_t::force_flag(bool)
 {
 }
 
+bool vvp_net_fun_t::save_state(vvp_checkpoint_out&) const
+{
+      return false;
+}
+
+void vvp_net_fun_t::restore_state(vvp_net_t*, vvp_checkpoint_in&)
+{
+}
+
+vvp_gen_event_s* vvp_net_fun_t::checkpoint_event()
+{
+      return 0;
+}
+
 /* **** vvp_fun_drive methods **** */
 
 vvp_fun_drive::vvp_fun_drive(unsigned str0, unsigned str1)
@@ -3728,6 +4250,15 @@ vvp_bit4_t compare_gtge(const vvp_vector4_t&lef, const vvp_vector4_t&rig,
       if (min_size == 0)
 	    return BIT4_X;
 
+	// Two-state values that fit in a word can be compared
+	// directly. Zero extension takes care of unequal widths.
+      unsigned long lword, rword;
+      if (lef.get_2state_word(lword) && rig.get_2state_word(rword)) {
+	    if (lword == rword)
+		  return out_if_equal;
+	    return lword > rword? BIT4_1 : BIT4_0;
+      }
+
 	// As per the IEEE1364 definition of >, >=, < and <=, if there
 	// are any X or Z values in either of the operand vectors,
 	// then the result of the compare is BIT4_X.
@@ -3772,6 +4303,18 @@ vvp_bit4_t compare_gtge_signed(const vvp_vector4_t&a,
 {
       assert(a.size() == b.size());
 
+	// Two-state values that fit in a word can be compared as
+	// unsigned words once the sign bits are flipped.
+      unsigned long aword, bword;
+      if (a.get_2state_word(aword) && b.get_2state_word(bword)) {
+	    unsigned long sign = 1UL << (a.size()-1);
+	    aword ^= sign;
+	    bword ^= sign;
+	    if (aword == bword)
+		  return out_if_equal;
+	    return aword > bword? BIT4_1 : BIT4_0;
+      }
+
       unsigned sign_idx = a.size()-1;
       vvp_bit4_t a_sign = a.value(sign_idx);
       vvp_bit4_t b_sign = b.value(sign_idx);
@@ -28,6 +28,7 @@
 # include  <cstdlib>
 # include  <cstring>
 # include  <string>
+# include  <vector>
 # include  <new>
 # include  <cassert>
 
@@ -58,6 +59,10 @@ class  vvp_fun_part;
 
 class  vvp_delay_t;
 
+class  vvp_checkpoint_out;
+class  vvp_checkpoint_in;
+struct vvp_gen_event_s;
+
 /*
  * Storage for items declared in automatically allocated scopes (i.e. automatic
  * tasks and functions). The first two slots in each context are reserved for
@@ -244,6 +249,8 @@ class vvp_vector4_t {
       friend class vvp_vector4array_t;
       friend class vvp_vector4array_sa;
       friend class vvp_vector4array_aa;
+      friend class vvp_vector4array_sparse;
+      template <class WORD, bool TWO_STATE> friend class vvp_vector4array_packed;
 
     public:
       static const vvp_vector4_t nil;
@@ -265,6 +272,11 @@ class vvp_vector4_t {
       vvp_vector4_t(const vvp_vector4_t&that, bool invert_flag);
       vvp_vector4_t& operator= (const vvp_vector4_t&that);
 
+	// Moving a vector takes over its storage and leaves the
+	// source an empty (zero width) vector.
+      vvp_vector4_t(vvp_vector4_t&&that) noexcept;
+      vvp_vector4_t& operator= (vvp_vector4_t&&that) noexcept;
+
       ~vvp_vector4_t();
 
       inline unsigned size() const { return size_; }
@@ -279,6 +291,10 @@ class vvp_vector4_t {
 	// in the array.
       unsigned long*subarray(unsigned idx, unsigned size, bool xz_to_0 =false) const;
       void setarray(unsigned idx, unsigned size, const unsigned long*val);
+	// Copy the raw abit and bbit words of the vector (the same
+	// encoding as the VPI vecval) into arrays that each have room
+	// for size() bits. The unused bits of the last word are zero.
+      void get_words(unsigned long*abits, unsigned long*bbits) const;
 
 	// Set a 4-value bit or subvector into the vector. Return true
 	// if any bits of the vector change as a result of this operation.
@@ -309,9 +325,24 @@ class vvp_vector4_t {
 	// Return true if there is an X or Z anywhere in the vector.
       bool has_xz() const;
 
+	// Return the Verilog &, | and ^ reductions of the vector.
+      vvp_bit4_t and_reduce() const;
+      vvp_bit4_t or_reduce() const;
+      vvp_bit4_t xor_reduce() const;
+
+	// If the vector fits in a single word and has no X or Z bits,
+	// then put the (zero extended) value into val and return
+	// true. This lets callers take a two-state shortcut around
+	// the bit-by-bit 4-state handling for the common case.
+      bool get_2state_word(unsigned long&val) const;
+
 	// Change all Z bits to X bits.
       void change_z2x();
 
+	// Change all X and Z bits to 0 bits, as a cast to a 2-state
+	// type does.
+      void cast2();
+
 	// Set all bits to the specified value.
       void fill_bits(vvp_bit4_t bit);
 
@@ -324,6 +355,7 @@ class vvp_vector4_t {
       void invert();
       vvp_vector4_t& operator &= (const vvp_vector4_t&that);
       vvp_vector4_t& operator |= (const vvp_vector4_t&that);
+      vvp_vector4_t& operator ^= (const vvp_vector4_t&that);
       vvp_vector4_t& operator += (int64_t);
 
     private:
@@ -357,6 +389,15 @@ class vvp_vector4_t {
 
       void allocate_words_(unsigned long inita, unsigned long initb);
 
+	// Vectors wider than a word keep their abits and bbits in a
+	// single array of 2*cnt words. Arrays for vectors up to
+	// SMALL_WORDS words wide are recycled through a free list so
+	// that copying wide values does not keep going to the heap.
+      enum { SMALL_WORDS = 4 };
+      static unsigned long*alloc_words_(unsigned cnt);
+      static void free_words_(unsigned long*bits, unsigned cnt);
+      void free_big_();
+
 	// Values in the vvp_vector4_t are stored split across two
 	// arrays. For each bit in the vector, there is an abit and a
 	// bbit. the encoding of a vvp_vector4_t is:
@@ -410,13 +451,30 @@ inline vvp_vector4_t::vvp_vector4_t(unsigned size__, vvp_bit4_t val)
       allocate_words_(init_atable[val], init_btable[val]);
 }
 
+inline bool vvp_vector4_t::get_2state_word(unsigned long&val) const
+{
+      if (size_ == 0 || size_ > BITS_PER_WORD)
+	    return false;
+
+      unsigned long mask = -1UL >> (BITS_PER_WORD - size_);
+      if (bbits_val_ & mask)
+	    return false;
+
+      val = abits_val_ & mask;
+      return true;
+}
+
+inline void vvp_vector4_t::free_big_()
+{
+	// bbits_ptr_ actually points half-way into a double-length
+	// array started at abits_ptr_
+      free_words_(abits_ptr_, (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD);
+}
+
 inline vvp_vector4_t::~vvp_vector4_t()
 {
-      if (size_ > BITS_PER_WORD) {
-	    delete[] abits_ptr_;
-	      // bbits_ptr_ actually points half-way into a
-	      // double-length array started at abits_ptr_
-      }
+      if (size_ > BITS_PER_WORD)
+	    free_big_();
 }
 
 inline vvp_vector4_t& vvp_vector4_t::operator= (const vvp_vector4_t&that)
@@ -425,13 +483,47 @@ inline vvp_vector4_t& vvp_vector4_t::operator= (const vvp_vector4_t&that)
 	    return *this;
 
       if (size_ > BITS_PER_WORD)
-	    delete[] abits_ptr_;
+	    free_big_();
 
       copy_from_(that);
 
       return *this;
 }
 
+inline vvp_vector4_t::vvp_vector4_t(vvp_vector4_t&&that) noexcept
+: size_(that.size_)
+{
+      if (size_ > BITS_PER_WORD) {
+	    abits_ptr_ = that.abits_ptr_;
+	    bbits_ptr_ = that.bbits_ptr_;
+      } else {
+	    abits_val_ = that.abits_val_;
+	    bbits_val_ = that.bbits_val_;
+      }
+      that.size_ = 0;
+}
+
+inline vvp_vector4_t& vvp_vector4_t::operator= (vvp_vector4_t&&that) noexcept
+{
+      if (this == &that)
+	    return *this;
+
+      if (size_ > BITS_PER_WORD)
+	    free_big_();
+
+      size_ = that.size_;
+      if (size_ > BITS_PER_WORD) {
+	    abits_ptr_ = that.abits_ptr_;
+	    bbits_ptr_ = that.bbits_ptr_;
+      } else {
+	    abits_val_ = that.abits_val_;
+	    bbits_val_ = that.bbits_val_;
+      }
+      that.size_ = 0;
+
+      return *this;
+}
+
 inline void vvp_vector4_t::copy_from_(const vvp_vector4_t&that)
 {
       size_ = that.size_;
@@ -589,6 +681,11 @@ class vvp_vector4array_t {
       virtual vvp_vector4_t get_word(unsigned idx) const = 0;
       virtual void set_word(unsigned idx, const vvp_vector4_t&that) = 0;
 
+	// Return the first word at or after idx that may hold a value
+	// that was written, or words() if there is none. Only sparse
+	// arrays skip any words.
+      virtual unsigned next_stored(unsigned idx) const;
+
     protected:
       struct v4cell {
 	    union {
@@ -628,6 +725,59 @@ class vvp_vector4array_sa : public vvp_vector4array_t {
       v4cell* array_;
 };
 
+/*
+ * Statically allocated vvp_vector4array_t of narrow words, which are
+ * packed into the smallest WORD type that holds them instead of a
+ * v4cell each. A 4-state array keeps two WORDs (the a and b bits) per
+ * word, and a 2-state array keeps only the a bits, which start as 0,
+ * and drops X and Z bits that are written to it.
+ */
+template <class WORD, bool TWO_STATE> class vvp_vector4array_packed
+      : public vvp_vector4array_t {
+
+    public:
+      vvp_vector4array_packed(unsigned width, unsigned words);
+      ~vvp_vector4array_packed();
+
+      vvp_vector4_t get_word(unsigned idx) const;
+      void set_word(unsigned idx, const vvp_vector4_t&that);
+
+    private:
+      WORD*abits_;
+      WORD*bbits_;
+};
+
+/*
+ * Sparse vvp_vector4array_t for very large memories. The words are
+ * kept in pages that are allocated when a word in them is first
+ * written, so the memory used follows the words that the simulation
+ * touches instead of the declared size. Words of pages that were never
+ * written read as X, or as 0 if the array is 2-state, in which case X
+ * and Z bits that are written also become 0.
+ */
+class vvp_vector4array_sparse : public vvp_vector4array_t {
+
+    public:
+      vvp_vector4array_sparse(unsigned width, unsigned words, bool two_state);
+      ~vvp_vector4array_sparse();
+
+      vvp_vector4_t get_word(unsigned idx) const;
+      void set_word(unsigned idx, const vvp_vector4_t&that);
+      unsigned next_stored(unsigned idx) const;
+
+      unsigned pages_used() const { return pages_used_; }
+
+      enum { PAGE_BITS = 10, PAGE_WORDS = 1 << PAGE_BITS };
+
+    private:
+      unsigned page_count_() const
+	    { return (words_ >> PAGE_BITS) + ((words_ & (PAGE_WORDS-1))? 1 : 0); }
+
+      bool two_state_;
+      unsigned pages_used_;
+      v4cell**pages_;
+};
+
 /*
  * Automatically allocated vvp_vector4array_t
  */
@@ -824,6 +974,8 @@ class vvp_scalar_t {
 	// so allow vvp_vector8_t access to the raw encoding so that
 	// it can do compact vectoring of vvp_scalar_t objects.
       friend class vvp_vector8_t;
+      friend class vvp_checkpoint_out;
+      friend class vvp_checkpoint_in;
       explicit vvp_scalar_t(unsigned char val) : value_(val) { }
       unsigned char raw() const { return value_; }
 
@@ -1173,6 +1325,44 @@ class vvp_net_t {
 #endif
 };
 
+/*
+ * Call the fun for every vvp_net_t that has been allocated so far, in
+ * the order they were allocated. This is for passes that need to look
+ * at the netlist as a whole once it is linked.
+ */
+extern void vvp_net_for_each(void (*fun)(vvp_net_t*net, void*cd), void*cd);
+
+/*
+ * Get the position of the net in the order that vvp_net_for_each
+ * visits the nets, and the net at a position. Checkpoints use these
+ * to refer to nets. vvp_net_index returns (size_t)-1 for a net that
+ * was not allocated from the net tables (for example an automatic
+ * net), and vvp_net_at returns nil if there is no such net.
+ */
+extern size_t vvp_net_index(const vvp_net_t*net);
+extern vvp_net_t*vvp_net_at(size_t idx);
+
+/*
+ * A table of all the nets allocated so far, sorted by address. Passes
+ * over the linked netlist use this to keep their own data about each
+ * net in vectors indexed by the position of the net in the table.
+ */
+class vvp_net_table_t {
+
+    public:
+      vvp_net_table_t();
+
+      size_t size() const { return nets_.size(); }
+      vvp_net_t* operator[] (size_t idx) const { return nets_[idx]; }
+
+	// Return the position of the net in the table, or size() if
+	// the net is not in the table.
+      size_t index(const vvp_net_t*net) const;
+
+    private:
+      std::vector<vvp_net_t*> nets_;
+};
+
 /*
  * Instances of this class represent the functionality of a
  * node. vvp_net_t objects hold pointers to the vvp_net_fun_t
@@ -1234,6 +1424,18 @@ class vvp_net_fun_t {
 	// do something about it.
       virtual void force_flag(bool run_now);
 
+	// Write the state of the functor to a checkpoint, or read it
+	// back, for the functors whose state is more than a copy of
+	// their inputs (see checkpoint.h). save_state returns false if
+	// there is nothing to save, which is the default. restore_state
+	// reads what save_state wrote, and must not send any output
+	// right away.
+      virtual bool save_state(vvp_checkpoint_out&out) const;
+      virtual void restore_state(vvp_net_t*net, vvp_checkpoint_in&in);
+	// Functors that schedule themselves as events return the
+	// event here, so that a checkpoint can save the pending events.
+      virtual vvp_gen_event_s*checkpoint_event();
+
    protected:
       void recv_vec4_pv_(vvp_net_ptr_t p, const vvp_vector4_t&bit,
 			 unsigned base, unsigned vwid, vvp_context_t context);
@@ -1312,6 +1514,9 @@ class vvp_net_fil_t  : public vvp_vpi_callback {
       virtual void force_fil_vec8(const vvp_vector8_t&val, const vvp_vector2_t&mask) =0;
       virtual void force_fil_real(double val, const vvp_vector2_t&mask) =0;
 
+	// True if any bit of the net is forced.
+      bool is_forced() const { return !test_force_mask_is_zero(); }
+
     public: // These objects are only permallocated.
       static void* operator new(std::size_t size) { return heap_.alloc(size); }
       static void operator delete(void*); // not implemented
@@ -1392,6 +1597,8 @@ class vvp_fun_concat  : public vvp_net_fun_t {
     private:
       unsigned wid_[4];
       vvp_vector4_t val_;
+	// Nothing is skipped until the output is first sent.
+      bool sent_;
 };
 
 class vvp_fun_concat8  : public vvp_net_fun_t {
@@ -1590,13 +1797,23 @@ class vvp_wide_fun_t : public vvp_net_fun_t {
 };
 
 
+/*
+ * With the profiler on (vvp -P), the send functions count each value
+ * that they deliver by the class of the receiving functor.
+ */
+extern bool profile_flag;
+extern void profile_recv(vvp_net_fun_t*fun);
+
 inline void vvp_send_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&val, vvp_context_t context)
 {
       while (class vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next_val = cur->port[ptr.port()];
 
-	    if (cur->fun)
+	    if (cur->fun) {
+		  if (profile_flag)
+			profile_recv(cur->fun);
 		  cur->fun->recv_vec4(ptr, val, context);
+	    }
 
 	    ptr = next_val;
       }
@@ -1611,8 +1828,11 @@ inline void vvp_send_string(vvp_net_ptr_t ptr, const std::string&val, vvp_contex
       while (vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next_val = cur->port[ptr.port()];
 
-	    if (cur->fun)
+	    if (cur->fun) {
+		  if (profile_flag)
+			profile_recv(cur->fun);
 		  cur->fun->recv_string(ptr, val, context);
+	    }
 
 	    ptr = next_val;
       }
@@ -1623,8 +1843,11 @@ inline void vvp_send_object(vvp_net_ptr_t ptr, vvp_object_t val, vvp_context_t c
       while (vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next_val = cur->port[ptr.port()];
 
-	    if (cur->fun)
+	    if (cur->fun) {
+		  if (profile_flag)
+			profile_recv(cur->fun);
 		  cur->fun->recv_object(ptr, val, context);
+	    }
 
 	    ptr = next_val;
       }
@@ -1655,8 +1878,11 @@ inline void vvp_send_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&val,
       while (class vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next_val = cur->port[ptr.port()];
 
-	    if (cur->fun)
+	    if (cur->fun) {
+		  if (profile_flag)
+			profile_recv(cur->fun);
 		  cur->fun->recv_vec4_pv(ptr, val, base, vwid, context);
+	    }
 
 	    ptr = next_val;
       }
@@ -1668,8 +1894,11 @@ inline void vvp_send_vec8_pv(vvp_net_ptr_t ptr, const vvp_vector8_t&val,
       while (class vvp_net_t*cur = ptr.ptr()) {
 	    vvp_net_ptr_t next_val = cur->port[ptr.port()];
 
-	    if (cur->fun)
+	    if (cur->fun) {
+		  if (profile_flag)
+			profile_recv(cur->fun);
 		  cur->fun->recv_vec8_pv(ptr, val, base, vwid);
+	    }
 
 	    ptr = next_val;
       }
@@ -1717,6 +1946,32 @@ inline void vvp_net_t::send_vec4_pv(const vvp_vector4_t&val,
       }
 }
 
+/*
+ * A functor that computes its output afresh each time its inputs
+ * change can send the output through one of these. It remembers the
+ * last value sent and drops a value that is the same, so that the
+ * recomputed output does not ripple through the fanout for nothing.
+ * The first value is always sent.
+ */
+extern unsigned long count_unchanged_sends;
+
+class vvp_send_cache_vec4 {
+
+    public:
+      inline void send(vvp_net_t*net, const vvp_vector4_t&val)
+      {
+	    if (sent_.size() != 0 && sent_.eeq(val)) {
+		  count_unchanged_sends += 1;
+		  return;
+	    }
+	    sent_ = val;
+	    net->send_vec4(val, 0);
+      }
+
+    private:
+      vvp_vector4_t sent_;
+};
+
 inline void vvp_net_t::send_vec8(const vvp_vector8_t&val)
 {
       if (fil == 0) {
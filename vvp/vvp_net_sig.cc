@@ -331,6 +331,38 @@ const vvp_vector4_t& vvp_fun_signal4_sa::vec4_unfiltered_value() const
       return bits4_;
 }
 
+vvp_fun_signal2_sa::vvp_fun_signal2_sa(unsigned wid)
+: vvp_fun_signal4_sa(wid, BIT4_0)
+{
+}
+
+void vvp_fun_signal2_sa::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
+				   vvp_context_t context)
+{
+      if (! bit.has_xz()) {
+	    vvp_fun_signal4_sa::recv_vec4(ptr, bit, context);
+	    return;
+      }
+
+      vvp_vector4_t tmp (bit);
+      tmp.cast2();
+      vvp_fun_signal4_sa::recv_vec4(ptr, tmp, context);
+}
+
+void vvp_fun_signal2_sa::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
+				      unsigned base, unsigned vwid,
+				      vvp_context_t context)
+{
+      if (! bit.has_xz()) {
+	    vvp_fun_signal4_sa::recv_vec4_pv(ptr, bit, base, vwid, context);
+	    return;
+      }
+
+      vvp_vector4_t tmp (bit);
+      tmp.cast2();
+      vvp_fun_signal4_sa::recv_vec4_pv(ptr, tmp, base, vwid, context);
+}
+
 vvp_fun_signal4_aa::vvp_fun_signal4_aa(unsigned wid, vvp_bit4_t init)
 {
       context_idx_ = vpip_add_item_to_context(this, vpip_peek_context_scope());
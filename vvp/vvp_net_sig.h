@@ -73,6 +73,11 @@ class vvp_fun_signal_base : public vvp_net_fun_t {
       void deassign();
       void deassign_pv(unsigned base, unsigned wid);
 
+	// True if any part of the signal is continuously assigned by
+	// a procedural assign.
+      bool is_assigned() const
+      { return continuous_assign_active_ || assign_mask_.size() > 0 || cassign_link; }
+
     public:
 
 	/* The %cassign/link instruction needs a place to write the
@@ -154,6 +159,23 @@ class vvp_fun_signal4_sa : public vvp_fun_signal_vec {
       vvp_vector4_t bits4_;
 };
 
+/*
+ * Statically allocated 2-state vector variable. This is the
+ * vvp_fun_signal4_sa, except that X and Z bits that are written to
+ * it are changed to 0 before they are stored, so its value never has
+ * X or Z bits, and the operations on it never take the 4-state paths.
+ */
+class vvp_fun_signal2_sa : public vvp_fun_signal4_sa {
+
+    public:
+      explicit vvp_fun_signal2_sa(unsigned wid);
+
+      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                     vvp_context_t);
+      void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+			unsigned base, unsigned vwid, vvp_context_t);
+};
+
 /*
  * Automatically allocated vvp_fun_signal4.
  */
@@ -0,0 +1,410 @@
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "vvp_vector4_kernels.h"
+
+/*
+ * The AVX2 kernels are only built for x86-64 hosts with a compiler
+ * that supports per-function target attributes, so that the rest of
+ * vvp is still compiled for the baseline instruction set. SSE2 is part
+ * of that baseline, so the scalar loops already get whatever the
+ * compiler can do with it.
+ */
+#if defined(__GNUC__) && defined(__x86_64__) && SIZEOF_UNSIGNED_LONG == 8
+# define VVP_VECTOR4_AVX2 1
+# include  <immintrin.h>
+#endif
+
+const unsigned WORD_BITS = 8*sizeof(unsigned long);
+
+/*
+ * Per-word versions of the operations. The scalar kernels are loops
+ * over these, and the SIMD kernels use them for the words left over
+ * after the last full SIMD register.
+ */
+static inline void and_word(unsigned long&da, unsigned long&db,
+			    unsigned long sa, unsigned long sb)
+{
+      unsigned long tmp1 = da | db;
+      unsigned long tmp2 = sa | sb;
+      db = (tmp1 & sb) | (tmp2 & db);
+      da = tmp1 & tmp2;
+}
+
+static inline void or_word(unsigned long&da, unsigned long&db,
+			   unsigned long sa, unsigned long sb)
+{
+      unsigned long tmp = da | db | sa | sb;
+      db = ((~da | db) & sb) | ((~sa | sb) & db);
+      da = tmp;
+}
+
+static inline void xor_word(unsigned long&da, unsigned long&db,
+			    unsigned long sa, unsigned long sb)
+{
+      unsigned long xz = db | sb;
+      da = (da ^ sa) | xz;
+      db = xz;
+}
+
+static inline unsigned long funnel_word(const unsigned long*src, unsigned off)
+{
+      return (src[0] >> off) | (src[1] << (WORD_BITS - off));
+}
+
+static void and_words_scalar(unsigned long*da, unsigned long*db,
+			     const unsigned long*sa, const unsigned long*sb,
+			     unsigned cnt)
+{
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1)
+	    and_word(da[idx], db[idx], sa[idx], sb[idx]);
+}
+
+static void or_words_scalar(unsigned long*da, unsigned long*db,
+			    const unsigned long*sa, const unsigned long*sb,
+			    unsigned cnt)
+{
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1)
+	    or_word(da[idx], db[idx], sa[idx], sb[idx]);
+}
+
+static void xor_words_scalar(unsigned long*da, unsigned long*db,
+			     const unsigned long*sa, const unsigned long*sb,
+			     unsigned cnt)
+{
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1)
+	    xor_word(da[idx], db[idx], sa[idx], sb[idx]);
+}
+
+static void invert_words_scalar(unsigned long*da, const unsigned long*db,
+				unsigned cnt)
+{
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1)
+	    da[idx] = ~da[idx] | db[idx];
+}
+
+static bool equal_words_scalar(const unsigned long*a, const unsigned long*b,
+			       unsigned cnt)
+{
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1) {
+	    if (a[idx] != b[idx])
+		  return false;
+      }
+      return true;
+}
+
+static bool any_words_scalar(const unsigned long*a, unsigned cnt)
+{
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1) {
+	    if (a[idx])
+		  return true;
+      }
+      return false;
+}
+
+static bool any_zero_words_scalar(const unsigned long*a, const unsigned long*b,
+				  unsigned cnt)
+{
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1) {
+	    if (~(a[idx] | b[idx]))
+		  return true;
+      }
+      return false;
+}
+
+static bool any_one_words_scalar(const unsigned long*a, const unsigned long*b,
+				 unsigned cnt)
+{
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1) {
+	    if (a[idx] & ~b[idx])
+		  return true;
+      }
+      return false;
+}
+
+static unsigned long xor_fold_words_scalar(const unsigned long*a, unsigned cnt)
+{
+      unsigned long res = 0;
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1)
+	    res ^= a[idx];
+      return res;
+}
+
+static bool copy_words_scalar(unsigned long*dst, const unsigned long*src,
+			      unsigned cnt)
+{
+      bool diff_flag = false;
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1) {
+	    if (dst[idx] != src[idx]) {
+		  diff_flag = true;
+		  dst[idx] = src[idx];
+	    }
+      }
+      return diff_flag;
+}
+
+static bool funnel_words_scalar(unsigned long*dst, const unsigned long*src,
+				unsigned cnt, unsigned off)
+{
+      bool diff_flag = false;
+      for (unsigned idx = 0 ; idx < cnt ; idx += 1) {
+	    unsigned long tmp = funnel_word(src+idx, off);
+	    if (dst[idx] != tmp) {
+		  diff_flag = true;
+		  dst[idx] = tmp;
+	    }
+      }
+      return diff_flag;
+}
+
+#ifdef VVP_VECTOR4_AVX2
+
+# define AVX2 __attribute__((target("avx2")))
+
+/* Number of unsigned long words in an AVX2 register. */
+const unsigned AVX2_WORDS = 4;
+
+static inline AVX2 __m256i load4(const unsigned long*ptr)
+{
+      return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+}
+
+static inline AVX2 void store4(unsigned long*ptr, __m256i val)
+{
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), val);
+}
+
+static AVX2 void and_words_avx2(unsigned long*da, unsigned long*db,
+				const unsigned long*sa, const unsigned long*sb,
+				unsigned cnt)
+{
+      unsigned idx = 0;
+      for ( ; idx+AVX2_WORDS <= cnt ; idx += AVX2_WORDS) {
+	    __m256i va = load4(da+idx);
+	    __m256i vb = load4(db+idx);
+	    __m256i wa = load4(sa+idx);
+	    __m256i wb = load4(sb+idx);
+	    __m256i tmp1 = _mm256_or_si256(va, vb);
+	    __m256i tmp2 = _mm256_or_si256(wa, wb);
+	    store4(db+idx, _mm256_or_si256(_mm256_and_si256(tmp1, wb),
+					   _mm256_and_si256(tmp2, vb)));
+	    store4(da+idx, _mm256_and_si256(tmp1, tmp2));
+      }
+      for ( ; idx < cnt ; idx += 1)
+	    and_word(da[idx], db[idx], sa[idx], sb[idx]);
+}
+
+static AVX2 void or_words_avx2(unsigned long*da, unsigned long*db,
+			       const unsigned long*sa, const unsigned long*sb,
+			       unsigned cnt)
+{
+      unsigned idx = 0;
+      for ( ; idx+AVX2_WORDS <= cnt ; idx += AVX2_WORDS) {
+	    __m256i va = load4(da+idx);
+	    __m256i vb = load4(db+idx);
+	    __m256i wa = load4(sa+idx);
+	    __m256i wb = load4(sb+idx);
+	    __m256i tmp = _mm256_or_si256(_mm256_or_si256(va, vb),
+					  _mm256_or_si256(wa, wb));
+	      // (~va | vb) & wb is (~va & wb) | (vb & wb), and
+	      // likewise for the other term.
+	    __m256i lft = _mm256_or_si256(_mm256_andnot_si256(va, wb),
+					  _mm256_and_si256(vb, wb));
+	    __m256i rgt = _mm256_or_si256(_mm256_andnot_si256(wa, vb),
+					  _mm256_and_si256(wb, vb));
+	    store4(db+idx, _mm256_or_si256(lft, rgt));
+	    store4(da+idx, tmp);
+      }
+      for ( ; idx < cnt ; idx += 1)
+	    or_word(da[idx], db[idx], sa[idx], sb[idx]);
+}
+
+static AVX2 void xor_words_avx2(unsigned long*da, unsigned long*db,
+				const unsigned long*sa, const unsigned long*sb,
+				unsigned cnt)
+{
+      unsigned idx = 0;
+      for ( ; idx+AVX2_WORDS <= cnt ; idx += AVX2_WORDS) {
+	    __m256i xz = _mm256_or_si256(load4(db+idx), load4(sb+idx));
+	    __m256i va = _mm256_xor_si256(load4(da+idx), load4(sa+idx));
+	    store4(da+idx, _mm256_or_si256(va, xz));
+	    store4(db+idx, xz);
+      }
+      for ( ; idx < cnt ; idx += 1)
+	    xor_word(da[idx], db[idx], sa[idx], sb[idx]);
+}
+
+static AVX2 void invert_words_avx2(unsigned long*da, const unsigned long*db,
+				   unsigned cnt)
+{
+      const __m256i ones = _mm256_set1_epi64x(-1);
+      unsigned idx = 0;
+      for ( ; idx+AVX2_WORDS <= cnt ; idx += AVX2_WORDS) {
+	    __m256i va = _mm256_xor_si256(load4(da+idx), ones);
+	    store4(da+idx, _mm256_or_si256(va, load4(db+idx)));
+      }
+      for ( ; idx < cnt ; idx += 1)
+	    da[idx] = ~da[idx] | db[idx];
+}
+
+static AVX2 bool equal_words_avx2(const unsigned long*a, const unsigned long*b,
+				  unsigned cnt)
+{
+      unsigned idx = 0;
+      for ( ; idx+AVX2_WORDS <= cnt ; idx += AVX2_WORDS) {
+	    __m256i tmp = _mm256_xor_si256(load4(a+idx), load4(b+idx));
+	    if (! _mm256_testz_si256(tmp, tmp))
+		  return false;
+      }
+      return equal_words_scalar(a+idx, b+idx, cnt-idx);
+}
+
+static AVX2 bool any_words_avx2(const unsigned long*a, unsigned cnt)
+{
+      unsigned idx = 0;
+      for ( ; idx+AVX2_WORDS <= cnt ; idx += AVX2_WORDS) {
+	    __m256i tmp = load4(a+idx);
+	    if (! _mm256_testz_si256(tmp, tmp))
+		  return true;
+      }
+      return any_words_scalar(a+idx, cnt-idx);
+}
+
+static AVX2 bool any_zero_words_avx2(const unsigned long*a, const unsigned long*b,
+				     unsigned cnt)
+{
+      const __m256i ones = _mm256_set1_epi64x(-1);
+      unsigned idx = 0;
+      for ( ; idx+AVX2_WORDS <= cnt ; idx += AVX2_WORDS) {
+	      // testc is true if all the bits of ones are set in tmp.
+	    __m256i tmp = _mm256_or_si256(load4(a+idx), load4(b+idx));
+	    if (! _mm256_testc_si256(tmp, ones))
+		  return true;
+      }
+      return any_zero_words_scalar(a+idx, b+idx, cnt-idx);
+}
+
+static AVX2 bool any_one_words_avx2(const unsigned long*a, const unsigned long*b,
+				    unsigned cnt)
+{
+      unsigned idx = 0;
+      for ( ; idx+AVX2_WORDS <= cnt ; idx += AVX2_WORDS) {
+	      // testc(b,a) is true if (~b & a) is zero.
+	    if (! _mm256_testc_si256(load4(b+idx), load4(a+idx)))
+		  return true;
+      }
+      return any_one_words_scalar(a+idx, b+idx, cnt-idx);
+}
+
+static AVX2 unsigned long xor_fold_words_avx2(const unsigned long*a, unsigned cnt)
+{
+      __m256i acc = _mm256_setzero_si256();
+      unsigned idx = 0;
+      for ( ; idx+AVX2_WORDS <= cnt ; idx += AVX2_WORDS)
+	    acc = _mm256_xor_si256(acc, load4(a+idx));
+
+      unsigned long lanes[AVX2_WORDS];
+      store4(lanes, acc);
+      unsigned long res = lanes[0] ^ lanes[1] ^ lanes[2] ^ lanes[3];
+      return res ^ xor_fold_words_scalar(a+idx, cnt-idx);
+}
+
+static AVX2 bool copy_words_avx2(unsigned long*dst, const unsigned long*src,
+				 unsigned cnt)
+{
+      __m256i diff = _mm256_setzero_si256();
+      unsigned idx = 0;
+      for ( ; idx+AVX2_WORDS <= cnt ; idx += AVX2_WORDS) {
+	    __m256i val = load4(src+idx);
+	    diff = _mm256_or_si256(diff, _mm256_xor_si256(val, load4(dst+idx)));
+	    store4(dst+idx, val);
+      }
+      bool diff_flag = ! _mm256_testz_si256(diff, diff);
+      if (copy_words_scalar(dst+idx, src+idx, cnt-idx))
+	    diff_flag = true;
+      return diff_flag;
+}
+
+static AVX2 bool funnel_words_avx2(unsigned long*dst, const unsigned long*src,
+				   unsigned cnt, unsigned off)
+{
+      const __m128i rshift = _mm_cvtsi32_si128(off);
+      const __m128i lshift = _mm_cvtsi32_si128(WORD_BITS - off);
+      __m256i diff = _mm256_setzero_si256();
+      unsigned idx = 0;
+      for ( ; idx+AVX2_WORDS <= cnt ; idx += AVX2_WORDS) {
+	    __m256i lo = _mm256_srl_epi64(load4(src+idx), rshift);
+	    __m256i hi = _mm256_sll_epi64(load4(src+idx+1), lshift);
+	    __m256i val = _mm256_or_si256(lo, hi);
+	    diff = _mm256_or_si256(diff, _mm256_xor_si256(val, load4(dst+idx)));
+	    store4(dst+idx, val);
+      }
+      bool diff_flag = ! _mm256_testz_si256(diff, diff);
+      if (funnel_words_scalar(dst+idx, src+idx, cnt-idx, off))
+	    diff_flag = true;
+      return diff_flag;
+}
+
+# undef AVX2
+#endif
+
+vvp_vector4_kernels_s vvp_vector4_kernels = {
+      &and_words_scalar,
+      &or_words_scalar,
+      &xor_words_scalar,
+      &invert_words_scalar,
+      &equal_words_scalar,
+      &any_words_scalar,
+      &any_zero_words_scalar,
+      &any_one_words_scalar,
+      &xor_fold_words_scalar,
+      &copy_words_scalar,
+      &funnel_words_scalar
+};
+
+const char*vvp_vector4_kernels_name = "scalar";
+
+/*
+ * Pick the kernels to use for this host. This runs during static
+ * initialization, so that the choice is made before any vectors are
+ * built. Anything that runs earlier just gets the scalar kernels.
+ */
+static struct vvp_vector4_kernels_select_s {
+      vvp_vector4_kernels_select_s()
+      {
+#ifdef VVP_VECTOR4_AVX2
+	    __builtin_cpu_init();
+	    if (__builtin_cpu_supports("avx2")) {
+		  vvp_vector4_kernels.and_words      = &and_words_avx2;
+		  vvp_vector4_kernels.or_words       = &or_words_avx2;
+		  vvp_vector4_kernels.xor_words      = &xor_words_avx2;
+		  vvp_vector4_kernels.invert_words   = &invert_words_avx2;
+		  vvp_vector4_kernels.equal_words    = &equal_words_avx2;
+		  vvp_vector4_kernels.any_words      = &any_words_avx2;
+		  vvp_vector4_kernels.any_zero_words = &any_zero_words_avx2;
+		  vvp_vector4_kernels.any_one_words  = &any_one_words_avx2;
+		  vvp_vector4_kernels.xor_fold_words = &xor_fold_words_avx2;
+		  vvp_vector4_kernels.copy_words     = &copy_words_avx2;
+		  vvp_vector4_kernels.funnel_words   = &funnel_words_avx2;
+		  vvp_vector4_kernels_name = "avx2";
+	    }
+#endif
+      }
+} vvp_vector4_kernels_select;
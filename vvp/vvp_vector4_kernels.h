@@ -0,0 +1,83 @@
+#ifndef IVL_vvp_vector4_kernels_H
+#define IVL_vvp_vector4_kernels_H
+/*
+ * Copyright (c) 2026 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * These are the inner loops of the wide vvp_vector4_t operations. They
+ * work on runs of whole abits/bbits words, and the vvp_vector4_t
+ * methods take care of any partial word at the top of a vector. The
+ * table starts out pointing at portable scalar versions, and is
+ * switched at startup to SIMD versions if the host CPU has them.
+ *
+ * The vvp_vector4_t methods only go through this table when it would
+ * work on at least VVP_VECTOR4_KERNEL_WORDS words. Narrower runs are
+ * handled inline, where the cost of the indirect call would dominate.
+ */
+
+const unsigned VVP_VECTOR4_KERNEL_WORDS = 4;
+
+struct vvp_vector4_kernels_s {
+	// Combine the source into the destination with the Verilog
+	// 4-value &, | and ^ operators.
+      void (*and_words)(unsigned long*da, unsigned long*db,
+			const unsigned long*sa, const unsigned long*sb,
+			unsigned cnt);
+      void (*or_words)(unsigned long*da, unsigned long*db,
+		       const unsigned long*sa, const unsigned long*sb,
+		       unsigned cnt);
+      void (*xor_words)(unsigned long*da, unsigned long*db,
+			const unsigned long*sa, const unsigned long*sb,
+			unsigned cnt);
+	// Apply the Verilog ~ operator to the abits, given the bbits.
+      void (*invert_words)(unsigned long*da, const unsigned long*db,
+			   unsigned cnt);
+
+	// Return true if the word runs are identical.
+      bool (*equal_words)(const unsigned long*a, const unsigned long*b,
+			  unsigned cnt);
+	// Return true if any bit in the run is set.
+      bool (*any_words)(const unsigned long*a, unsigned cnt);
+	// Return true if any bit is BIT4_0 (both a and b clear).
+      bool (*any_zero_words)(const unsigned long*a, const unsigned long*b,
+			     unsigned cnt);
+	// Return true if any bit is BIT4_1 (a set and b clear).
+      bool (*any_one_words)(const unsigned long*a, const unsigned long*b,
+			    unsigned cnt);
+	// Return the exclusive OR of all the words in the run.
+      unsigned long (*xor_fold_words)(const unsigned long*a, unsigned cnt);
+
+	// Copy the source run into the destination. Return true if
+	// that changed any destination bits.
+      bool (*copy_words)(unsigned long*dst, const unsigned long*src,
+			 unsigned cnt);
+	// Fill the destination with the source shifted down by off
+	// bits, so that dst[i] is made from src[i] and src[i+1]. The
+	// shift must be 0 < off < word size, and the source must have
+	// cnt+1 words. Return true if any destination bits changed.
+      bool (*funnel_words)(unsigned long*dst, const unsigned long*src,
+			   unsigned cnt, unsigned off);
+};
+
+extern vvp_vector4_kernels_s vvp_vector4_kernels;
+
+/* This is the name of the kernel set in use, for verbose output. */
+extern const char*vvp_vector4_kernels_name;
+
+#endif /* IVL_vvp_vector4_kernels_H */
@@ -186,6 +186,9 @@ void compile_variable(char*label, char*name,
 	    vvp_fun_signal4_aa*tmp = new vvp_fun_signal4_aa(wid, init);
 	    net->fil = tmp;
             net->fun = tmp;
+      } else if (vpi_type_code == vpiIntVar || two_state_flag) {
+	    net->fil = new vvp_wire_vec4(wid, BIT4_0);
+            net->fun = new vvp_fun_signal2_sa(wid);
       } else {
 	    net->fil = new vvp_wire_vec4(wid, init);
             net->fun = new vvp_fun_signal4_sa(wid);